@@ -427,20 +427,33 @@ using FFX_GameTick_pfn          = void (__cdecl *)(float);
       FFX_GameTick_pfn
       UNX_FFX_GameTick_Original = nullptr;
 
-void
-UNX_SpeedStep (void)
+static void
+UNX_StepSpeed (float step)
 {
+  float max_speed,
+        skip_dialog;
+  bool  timing_hacks;
+
+  {
+    const unx_config_view cfg =
+      UNX_ReadConfig ();
+
+    max_speed    =    cfg->cheat.ffx.max_speed;
+    skip_dialog  =    cfg->cheat.ffx.skip_dialog;
+    timing_hacks = (! cfg->cheat.ffx.disable_timing_hacks);
+  }
+
   last_changed.speed = timeGetTime ();
 
-  if (__UNX_speed_mod < config.cheat.ffx.max_speed)
-    __UNX_speed_mod *= config.cheat.ffx.speed_step;
+  if (__UNX_speed_mod < max_speed)
+    __UNX_speed_mod *= step;
   else
     __UNX_speed_mod = 1.0f;
 
 
   static volatile ULONG enabled = FALSE;
 
-  if (__UNX_speed_mod != 1.0f && (! config.cheat.ffx.disable_timing_hacks))
+  if (__UNX_speed_mod != 1.0f && timing_hacks)
   {
     if (! InterlockedCompareExchange (&enabled, TRUE, FALSE))
     {
@@ -457,7 +470,7 @@ UNX_SpeedStep (void)
   }
   
 
-  if (__UNX_speed_mod >= config.cheat.ffx.skip_dialog)
+  if (__UNX_speed_mod >= skip_dialog)
   {
     UNX_FFX_AudioSkip (true);
   } else {
@@ -466,14 +479,16 @@ UNX_SpeedStep (void)
 }
 
 void
-UNX_UpdateSpeedLimit (void)
+UNX_SpeedStep (void)
 {
-  float step = config.cheat.ffx.speed_step;
-               config.cheat.ffx.speed_step = 1.0f;
-
-  UNX_SpeedStep ();
+  UNX_StepSpeed (UNX_ReadConfig ()->cheat.ffx.speed_step);
+}
 
-  config.cheat.ffx.speed_step = step;
+// Re-applies the limits to the current speed without stepping it
+void
+UNX_UpdateSpeedLimit (void)
+{
+  UNX_StepSpeed (1.0f);
 }
 
 void
@@ -551,7 +566,7 @@ unx::CheatManager::Init (void)
     UNX_EnableHook ((LPVOID)((intptr_t)__UNX_base_img_addr + 0x241F60));
 #endif
 
-    UNX_SetSensor (config.cheat.ffx.permanent_sensor);
+    UNX_SetSensor (UNX_ReadConfig ()->cheat.ffx.permanent_sensor);
 
     SetTimer (unx::window.hwnd, CHEAT_TIMER_FFX, 33, nullptr);
 
@@ -594,7 +609,11 @@ UNX_SetPartyAP (bool state)
 {
   last_changed.party_ap = timeGetTime ();
 
-  config.cheat.ffx.entire_party_earns_ap = state;
+  UNX_UpdateConfig ([=](unx_config_s& cfg) -> bool
+  {
+    cfg.cheat.ffx.entire_party_earns_ap = state;
+    return true;
+  });
 }
 
 void
@@ -602,7 +621,11 @@ UNX_TogglePartyAP (void)
 {
   last_changed.party_ap = timeGetTime ();
 
-  config.cheat.ffx.entire_party_earns_ap = (! config.cheat.ffx.entire_party_earns_ap);
+  UNX_UpdateConfig ([](unx_config_s& cfg) -> bool
+  {
+    cfg.cheat.ffx.entire_party_earns_ap = (! cfg.cheat.ffx.entire_party_earns_ap);
+    return true;
+  });
 }
 
 void
@@ -618,13 +641,20 @@ UNX_ToggleFreeLook (void)
 void
 UNX_SetSensor (bool state)
 {
-  if (config.cheat.ffx.permanent_sensor != state)
+  // Compared to what readers see; the control panel changes config first
+  if (UNX_ReadConfig ()->cheat.ffx.permanent_sensor != state)
+  {
     last_changed.sensor = timeGetTime ();
 
-  config.cheat.ffx.permanent_sensor = state;
+    UNX_UpdateConfig ([=](unx_config_s& cfg) -> bool
+    {
+      cfg.cheat.ffx.permanent_sensor = state;
+      return true;
+    });
+  }
 
   ffx.debug_flags->permanent_sensor =
-    (uint8_t)config.cheat.ffx.permanent_sensor;
+    (uint8_t)state;
 }
 
 void
@@ -633,6 +663,8 @@ UNX_ToggleSensor (void)
   if (game_type != GAME_FFX)
     return;
 
+  auto lock = UNX_LockConfig ();
+
   UNX_SetSensor (! config.cheat.ffx.permanent_sensor);
 }
 
@@ -692,8 +724,7 @@ UNX_Quickie (void)
     (sub_7C8650_pfn)((intptr_t)__UNX_base_img_addr + 0x3C8650);
   Menu (0x6);
 
-  extern volatile ULONG schedule_load;
-  InterlockedExchange (&schedule_load, TRUE);
+  unx::WindowManager::PostCommand (unx::GAME_CMD_QUICK_LOAD);
 #endif
 }
 
@@ -729,7 +760,7 @@ UNX_KillMeNow (void)
         }
 
         // Kill
-        SK_GetCommandProcessor ()->ProcessCommandLine ("mem s 392930 1deb");
+        UNX_WriteMem <uint16_t> (0x392930, 0x1deb);
 
         // Spawn thread to restore original instructions
         CreateThread (nullptr, 0,
@@ -738,7 +769,7 @@ UNX_KillMeNow (void)
               {
                 Sleep (5000UL);
 
-                SK_GetCommandProcessor ()->ProcessCommandLine ("mem s 392930 1d7e");
+                UNX_WriteMem <uint16_t> (0x392930, 0x1d7e);
 
                 CloseHandle (GetCurrentThread ());
 
@@ -751,8 +782,7 @@ UNX_KillMeNow (void)
         return true;
       }
 
-      extern volatile ULONG queue_death;
-      InterlockedExchange (&queue_death, TRUE);
+      unx::WindowManager::PostCommand (unx::GAME_CMD_DEATH);
     } break;
 
     case GAME_FFX2:
@@ -761,9 +791,9 @@ UNX_KillMeNow (void)
         ffx2.party [i].vitals.current.HP = 0UL;
       }
 
-      SK_GetCommandProcessor ()->ProcessCommandLine ("mem b 9F7880 1");
+      UNX_WriteMem <uint8_t> (0x9F7880, 1);
       Sleep (33);
-      SK_GetCommandProcessor ()->ProcessCommandLine ("mem b 9F7880 0");
+      UNX_WriteMem <uint8_t> (0x9F7880, 0);
       Sleep (0);
     } break;
   }
@@ -777,18 +807,21 @@ unx::CheatTimer_FFX (void)
   if (game_type != GAME_FFX)
     return;
 
-  if (config.cheat.ffx.permanent_sensor)
-    UNX_SetSensor (config.cheat.ffx.permanent_sensor);
+  const unx_config_view cfg =
+    UNX_ReadConfig ();
+
+  if (cfg->cheat.ffx.permanent_sensor)
+    ffx.debug_flags->permanent_sensor = 1;
 
   DWORD dwProtect;
 
-  if (config.cheat.ffx.playable_seymour) {
+  if (cfg->cheat.ffx.playable_seymour) {
     ffx.party [ffx.characters.Seymour].in_party = 0x11;
   } else {
     ffx.party [ffx.characters.Seymour].in_party = 0x10;
   }
 
-  if (config.cheat.ffx.entire_party_earns_ap && UNX_IsInBattle ()) {
+  if (cfg->cheat.ffx.entire_party_earns_ap && UNX_IsInBattle ()) {
     VirtualProtect (&ffx.battle->participation, 8, PAGE_READWRITE, &dwProtect);
 
       for (int i = 0; i < 7; i++) {
@@ -850,6 +883,9 @@ UNX_SummarizeCheats (DWORD dwTime)
 
   const DWORD status_duration = 2500UL;
 
+  const unx_config_view cfg =
+    UNX_ReadConfig ();
+
   switch (game_type)
   {
     case GAME_FFX:
@@ -857,18 +893,18 @@ UNX_SummarizeCheats (DWORD dwTime)
       if (last_changed.party_ap > dwTime - status_duration)
       {
         summary += "Full Party AP:    ";
-        summary += config.cheat.ffx.entire_party_earns_ap ?
+        summary += cfg->cheat.ffx.entire_party_earns_ap ?
                      "ON\n" : "OFF\n";
       }
 
       if (last_changed.sensor > dwTime - status_duration)
       {
         summary += "Permanent Sensor: ";
-        summary += config.cheat.ffx.permanent_sensor ?
+        summary += cfg->cheat.ffx.permanent_sensor ?
                      "ON\n" : "OFF\n";
       }
 
-      if (last_changed.speed > dwTime - (status_duration * 2) && (! config.cheat.ffx.disable_timing_hacks))
+      if (last_changed.speed > dwTime - (status_duration * 2) && (! cfg->cheat.ffx.disable_timing_hacks))
       {
         char szGameSpeed [128] = { };
 
@@ -44,8 +44,10 @@ namespace unx
   };
 }
 
+extern void UNX_SetPartyAP       (bool state);
 extern void UNX_TogglePartyAP    (void);
 extern void UNX_ToggleSensor     (void);
+extern void UNX_SetSensor        (bool state);
 extern void UNX_UpdateSpeedLimit (void);
 
 #endif /* __UNX__CHEAT_H__ */
\ No newline at end of file
@@ -18,6 +18,86 @@
  *   If not, see <http://www.gnu.org/licenses/>.
  *
 **/
+#include <Windows.h>
+
 #include "command.h"
 
-SK_GetCommandProcessor_pfn SK_GetCommandProcessor = nullptr;
\ No newline at end of file
+SK_GetCommandProcessor_pfn SK_GetCommandProcessor = nullptr;
+
+using SK_CreateVar_pfn = SK_IVariable* (__stdcall *)( SK_IVariable::VariableType  type,
+                                                     void*                       var,
+                                                     SK_IVariableListener       *pListener );
+
+SK_IVariable*
+__stdcall
+UNX_CreateVar ( SK_IVariable::VariableType  type,
+                void*                       var,
+                SK_IVariableListener       *pListener )
+{
+  extern HMODULE hInjectorDLL;
+
+  static auto SK_CreateVar =
+    (SK_CreateVar_pfn)
+      GetProcAddress (hInjectorDLL, "SK_CreateVar");
+
+  if (SK_CreateVar == nullptr)
+    return nullptr;
+
+  return SK_CreateVar (type, var, pListener);
+}
+
+SK_ICommand*
+unx::PreparedCommand::resolve (void)
+{
+  SK_ICommand* cmd =
+    cmd_.load (std::memory_order_acquire);
+
+  if (cmd == nullptr && SK_GetCommandProcessor != nullptr)
+  {
+    cmd = SK_GetCommandProcessor ()->FindCommand (name_);
+
+    cmd_.store (cmd, std::memory_order_release);
+  }
+
+  return cmd;
+}
+
+bool
+unx::PreparedCommand::execute (const char* args)
+{
+  SK_ICommand* cmd = resolve ();
+
+  if (cmd == nullptr)
+    return false;
+
+  return cmd->execute (args).getStatus () != 0;
+}
+
+
+const SK_IVariable*
+unx::PreparedVariable::resolve (void)
+{
+  const SK_IVariable* var =
+    var_.load (std::memory_order_acquire);
+
+  if (var == nullptr && SK_GetCommandProcessor != nullptr)
+  {
+    var = SK_GetCommandProcessor ()->FindVariable (name_);
+
+    var_.store (var, std::memory_order_release);
+  }
+
+  return var;
+}
+
+bool
+unx::PreparedVariable::assign (const char* szValue)
+{
+  if (resolve () == nullptr)
+    return false;
+
+  char szLine [192];
+  snprintf (szLine, sizeof szLine, "%s %s", name_, szValue);
+
+  return SK_GetCommandProcessor ()->ProcessCommandLine (szLine).getStatus () != 0;
+}
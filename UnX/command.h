@@ -27,6 +27,9 @@
 
 #include <locale> // tolower (...)
 #include <algorithm>
+#include <atomic>
+#include <cstdint>
+#include <cstdio>
 
 interface SK_IVariable;
 interface SK_ICommand;
@@ -145,4 +148,102 @@ UNX_CreateVar ( SK_IVariable::VariableType  type,
                 void*                       var,
                 SK_IVariableListener       *pListener = nullptr );
 
+
+//
+// Prepared commands and variables.
+//
+//   ProcessCommandLine splits the line, looks the first word up in SK's
+//     tables and copies everything into an SK_ICommandResult, every call.
+//       These look the name up once SK has it and keep the pointer from
+//         then on; declare them static next to the code that uses them.
+//
+namespace unx
+{
+  class PreparedCommand
+  {
+  public:
+    explicit PreparedCommand (const char* name) : name_ (name) { }
+
+    // False if SK has no such command
+    bool valid   (void) { return resolve () != nullptr; }
+
+    // args is everything after the command word
+    bool execute (const char* args);
+
+    template <typename... _Args>
+    bool executef (const char* fmt, _Args... args)
+    {
+      char szArgs [128];
+      snprintf (szArgs, sizeof szArgs, fmt, args...);
+
+      return execute (szArgs);
+    }
+
+  private:
+    SK_ICommand* resolve (void);
+
+    const char*                 name_;
+    std::atomic <SK_ICommand *> cmd_ { nullptr };
+  };
+
+  //
+  // Reads go straight through the variable's value pointer. A new value is
+  //   still handed to the command processor, since that is the only way to
+  //     reach the listener SK keeps for it, but the line is built on the
+  //       stack and never parsed on this side.
+  //
+  class PreparedVariable
+  {
+  public:
+    explicit PreparedVariable (const char* name) : name_ (name) { }
+
+    const SK_IVariable* get (void) { return resolve (); }
+    bool                valid (void) { return resolve () != nullptr; }
+
+    // False (out untouched) if the variable does not exist or is not a _T
+    template <typename _T>
+    bool read (_T& out)
+    {
+      const SK_IVariable* var = resolve ();
+
+      if (var == nullptr || var->getType () != TypeOf <_T> ())
+        return false;
+
+      out = *(const _T *)var->getValuePointer ();
+
+      return true;
+    }
+
+    bool set  (int         value) { return setf ("%d", value); }
+    bool set  (bool        value) { return setf ("%s", value ? "true" : "false"); }
+    bool set  (float       value) { return setf ("%f", value); }
+    bool set  (const char* value) { return setf ("%s", value); }
+
+    template <typename... _Args>
+    bool setf (const char* fmt, _Args... args)
+    {
+      char szValue [128];
+      snprintf (szValue, sizeof szValue, fmt, args...);
+
+      return assign (szValue);
+    }
+
+  private:
+    const SK_IVariable* resolve (void);
+    bool                assign  (const char* szValue);
+
+    template <typename _T> static constexpr SK_IVariable::VariableType TypeOf (void);
+
+    const char*                         name_;
+    std::atomic <const SK_IVariable *>  var_ { nullptr };
+  };
+
+  template <> constexpr SK_IVariable::VariableType PreparedVariable::TypeOf <bool>    (void) { return SK_IVariable::Boolean; }
+  template <> constexpr SK_IVariable::VariableType PreparedVariable::TypeOf <int>     (void) { return SK_IVariable::Int;     }
+  template <> constexpr SK_IVariable::VariableType PreparedVariable::TypeOf <short>   (void) { return SK_IVariable::Short;   }
+  template <> constexpr SK_IVariable::VariableType PreparedVariable::TypeOf <uint8_t> (void) { return SK_IVariable::Byte;    }
+  template <> constexpr SK_IVariable::VariableType PreparedVariable::TypeOf <float>   (void) { return SK_IVariable::Float;   }
+  template <> constexpr SK_IVariable::VariableType PreparedVariable::TypeOf <double>  (void) { return SK_IVariable::Double;  }
+}
+
 #endif /* __EPSILON_TESTBED__COMMAND_H */
@@ -232,4 +232,16 @@ UNX_InjectMachineCode ( LPVOID  base_addr,
   }
 
   UNX_FlushInstructionCache (base_addr, code_size);
+}
+
+void
+__stdcall
+UNX_WriteMemory (uintptr_t offset, const void* data, size_t len)
+{
+  uint8_t* base_addr =
+    reinterpret_cast <uint8_t *> (GetModuleHandle (nullptr));
+
+  UNX_InjectMachineCode ( base_addr + offset,
+                            const_cast <void *> (data), len,
+                              PAGE_EXECUTE_READWRITE );
 }
\ No newline at end of file
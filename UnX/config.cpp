@@ -25,15 +25,23 @@
 #include "config.h"
 #include "parameter.h"
 #include "ini.h"
+#include "inifile.h"
+#include "schema.h"
+#include "snapshot.h"
+#include "configwatch.h"
 #include "log.h"
 #include "language.h"
 #include "cheat.h"
 #include "input.h"
+#include "window.h"
 
 #include "DLL_VERSION.H"
 
+#include "seqlock.h"
+
 #include <string>
 #include <algorithm>
+#include <mutex>
 
 #include <atlbase.h>
 
@@ -51,6 +59,67 @@ static
 std::wstring UNX_VER_STR = UNX_VERSION_STR_W;
 unx_config_s config;
 
+static_assert ( sizeof (unx_hot_config_s) + sizeof (uint32_t) <= 64,
+                  "Hot config no longer fits in a cache line" );
+
+alignas (64) static unx::SeqLock <unx_hot_config_s> hot_config;
+
+static std::recursive_mutex   config_lock;
+static unx::RCU <unx_config_s> published_config;
+
+// config_lock held, which also keeps the SeqLock down to a single writer
+static void
+UNX_PublishHotConfig (void)
+{
+  unx_hot_config_s hot;
+
+  hot.background_fps  = config.window.background_fps;
+  hot.gamepad_slot    = config.input.gamepad_slot;
+  hot.gamepad_poll_hz = config.input.gamepad_poll_hz;
+  hot.remap_dinput8   = config.input.remap_dinput8;
+  hot.fast_exit       = config.input.fast_exit;
+  hot.fix_bg_input    = config.input.fix_bg_input;
+  hot.trap_alt_tab    = config.input.trap_alt_tab;
+
+  hot_config.publish (hot);
+}
+
+unx_hot_config_s
+UNX_GetHotConfig (void)
+{
+  unx_hot_config_s hot;
+
+  // Publishing is rare and only copies a few bytes
+  while (! hot_config.try_read (hot))
+    YieldProcessor ();
+
+  return hot;
+}
+
+unx_config_view
+UNX_ReadConfig (void)
+{
+  return published_config.read ();
+}
+
+std::unique_lock <std::recursive_mutex>
+UNX_LockConfig (void)
+{
+  return std::unique_lock <std::recursive_mutex> (config_lock);
+}
+
+void
+UNX_PublishConfig (void)
+{
+  std::lock_guard <std::recursive_mutex> lock (config_lock);
+
+  published_config.publish (
+    std::unique_ptr <unx_config_s> (new unx_config_s (config))
+  );
+
+  UNX_PublishHotConfig ();
+}
+
 typedef void (__stdcall *SK_PlugIn_ControlPanelWidget_pfn)(void);
 
 typedef void (WINAPI *SK_DXGI_SetPreferredAdapter_pfn) (int);
@@ -99,75 +168,192 @@ UNX_WideCharToUTF8 (std::wstring in)
   return out;
 }
 
-struct {
-  unx::ParameterBool*    bypass_intel;
-} render;
-
-struct {
-  unx::ParameterBool*    disable_timing_hacks;
-} compatibility;
-
-struct {
-  struct {
-    unx::ParameterBool*  entire_party_earns_ap;
-    unx::ParameterBool*  playable_seymour;
-    unx::ParameterBool*  permanent_sensor;
-    unx::ParameterFloat* max_speed;
-    unx::ParameterFloat* speed_step;
-    unx::ParameterFloat* skip_dialog;
-  } ffx;
-} booster;
-
-struct {
-  unx::ParameterBool*    disable_dpi_scaling;
-} display;
-
-struct {
-} colors;
-
-struct {  
-  unx::ParameterStringW* resource_root;
-  unx::ParameterStringW* gamepad;
-  unx::ParameterStringW* gamepad_hash_ffx;
-  unx::ParameterStringW* gamepad_hash_ffx2;
-  unx::ParameterBool*    dump;
-  unx::ParameterBool*    inject;
-  unx::ParameterBool*    mark;
-  unx::ParameterBool*    cache;
-} textures;
-
-struct {
-  unx::ParameterStringW* voice;
-  unx::ParameterStringW* sfx;
-  unx::ParameterStringW* video;
-  unx::ParameterStringW* timing;
-} language;
-
-struct {
-  unx::ParameterBool*    remap_dinput8;
-  unx::ParameterInt*     gamepad_slot;
-  unx::ParameterBool*    fix_bg_input;
-
-  unx::ParameterBool*    block_left_alt;
-  unx::ParameterBool*    block_left_ctrl;
-  unx::ParameterBool*    block_windows;
-  unx::ParameterBool*    block_all_keys;
-
-  unx::ParameterBool*    four_finger_salute;
-
-  unx::ParameterBool*    fast_exit;
-  unx::ParameterBool*    trap_alt_tab;
-
-  unx::ParameterBool*    filter_ime;
-} input;
-
-struct {
-  unx::ParameterStringW* injector;
-  unx::ParameterStringW* version;
-} sys;
-
-
-unx::ParameterFactory g_ParameterFactory;
+enum {
+  Config_Main,
+  Config_Language,
+  Config_Booster,
+
+  Config_Count
+};
+
+// Settings that only mean something in ffx.exe
+static const uint8_t Schema_FFXOnly  = unx::schema::Flag_User;
+
+// Read once at startup; edits made while the game runs are not applied
+static const uint8_t Schema_Startup  = unx::schema::Flag_User << 1;
+static const uint8_t Schema_LoadOnce = unx::schema::Flag_Load | Schema_Startup;
+
+using unx::schema::Field;
+using unx::schema::Flag_Load;
+using unx::schema::Flag_Store;
+using unx::schema::Flag_LoadStore;
+using unx::schema::Load;
+using unx::schema::Store;
+
+static constexpr unx::schema::field_s config_schema [] =
+{
+  Field (Config_Main,     L"UnX.Display",       L"DisableDPIScaling",   &config.display.disable_dpi_scaling,    Schema_LoadOnce),
+  Field (Config_Main,     L"UnX.Window",        L"BackgroundFPS",       &config.window.background_fps),
+  Field (Config_Main,     L"UnX.Render",        L"BypassIntel",         &config.render.bypass_intel,            Schema_LoadOnce),
+  Field (Config_Main,     L"UnX.Compatibility", L"DisableTimingHacks",  &config.cheat.ffx.disable_timing_hacks),
+
+  Field (Config_Main,     L"UnX.Input",         L"RemapDirectInput",    &config.input.remap_dinput8),
+  Field (Config_Main,     L"UnX.Input",         L"FixBackgroundInput",  &config.input.fix_bg_input),
+  Field (Config_Main,     L"UnX.Input",         L"BlockWindows",        &config.input.block_windows,            Schema_LoadOnce),
+  Field (Config_Main,     L"UnX.Input",         L"FourFingerSalute",    &config.input.four_finger_salute,       Schema_LoadOnce),
+  Field (Config_Main,     L"UnX.Input",         L"GamepadSlot",         &config.input.gamepad_slot,             Schema_LoadOnce),
+  Field (Config_Main,     L"UnX.Input",         L"GamepadPollingRate",  &config.input.gamepad_poll_hz),
+  Field (Config_Main,     L"UnX.Input",         L"FastExit",            &config.input.fast_exit,                Schema_LoadOnce),
+  Field (Config_Main,     L"UnX.Input",         L"TrapAltTab",          &config.input.trap_alt_tab),
+  Field (Config_Main,     L"UnX.Input",         L"FilterIME",           &config.input.filter_ime),
+
+  Field (Config_Main,     L"UnX.Textures",      L"ResourceRoot",        &config.textures.resource_root,         Schema_LoadOnce),
+  Field (Config_Main,     L"UnX.Textures",      L"Dump",                &config.textures.dump,                  Schema_LoadOnce),
+  Field (Config_Main,     L"UnX.Textures",      L"Inject",              &config.textures.inject,                Schema_LoadOnce),
+  Field (Config_Main,     L"UnX.Textures",      L"Cache",               &config.textures.cache,                 Schema_LoadOnce),
+  // Overrides for the button map hashes, if a game update ever changes them
+  Field (Config_Main,     L"UnX.Textures",      L"GamepadHashFFX",      &config.textures.pad.icons.high,        Schema_LoadOnce),
+  Field (Config_Main,     L"UnX.Textures",      L"GamepadHashFFX2",     &config.textures.pad.icons.low,         Schema_LoadOnce),
+
+  // Read back to see what version wrote the file, but always written as this one
+  Field (Config_Main,     L"UnX.System",        L"Version",             &config.system.version,                 Schema_LoadOnce),
+  Field (Config_Main,     L"UnX.System",        L"Version",             &UNX_VER_STR,                           Flag_Store),
+  Field (Config_Main,     L"UnX.System",        L"Injector",            &config.system.injector,                Flag_Store),
+  Field (Config_Main,     L"UnX.System",        L"UpdateCheckInterval", &config.system.update_interval),
+  Field (Config_Main,     L"UnX.System",        L"UpdateCheckTimeout",  &config.system.update_timeout),
+  Field (Config_Main,     L"UnX.System",        L"LastUpdateCheck",     &config.system.last_update_check),
+  Field (Config_Main,     L"UnX.System",        L"UpdateAvailable",     &config.system.update_available),
+  Field (Config_Main,     L"UnX.System",        L"WatchConfig",         &config.system.watch_config),
+  Field (Config_Main,     L"UnX.System",        L"BinaryLog",           &config.system.binary_log,              Schema_LoadOnce),
+
+  Field (Config_Language, L"Language.Master",   L"Voice",               &config.language.voice),
+  Field (Config_Language, L"Language.Master",   L"SoundEffects",        &config.language.sfx),
+  Field (Config_Language, L"Language.Master",   L"Video",               &config.language.video),
+
+  Field (Config_Booster,  L"Boost.FFX",         L"EntirePartyEarnsAP",  &config.cheat.ffx.entire_party_earns_ap, Flag_LoadStore | Schema_FFXOnly),
+  Field (Config_Booster,  L"Boost.FFX",         L"GrantPermanentSensor", &config.cheat.ffx.permanent_sensor,      Flag_LoadStore | Schema_FFXOnly),
+  Field (Config_Booster,  L"SpeedHack.FFX",     L"MaxSpeed",            &config.cheat.ffx.max_speed,             Flag_LoadStore | Schema_FFXOnly),
+  Field (Config_Booster,  L"SpeedHack.FFX",     L"SpeedStep",           &config.cheat.ffx.speed_step,            Flag_LoadStore | Schema_FFXOnly),
+  Field (Config_Booster,  L"SpeedHack.FFX",     L"SkipDialogAtSpeed",   &config.cheat.ffx.skip_dialog,           Flag_LoadStore | Schema_FFXOnly),
+  Field (Config_Booster,  L"Fun.FFX",           L"PlayableSeymour",     &config.cheat.ffx.playable_seymour,      Flag_LoadStore | Schema_FFXOnly)
+};
+
+static unx::INIFile* config_files [Config_Count] = { };
+
+typedef const wchar_t* (__stdcall *SK_GetConfigPath_pfn)(void);
+SK_GetConfigPath_pfn SK_GetConfigPath = nullptr;
+
+static uint8_t
+UNX_ConfigSkipFlags (void)
+{
+  static const bool ffx =
+    StrStrIW (UNX_GetExecutableName (), L"ffx.exe") != nullptr;
+
+  return ffx ? 0 : Schema_FFXOnly;
+}
+
+// Resolves lazily; none of the INIs are parsed until something needs them
+static void
+UNX_OpenConfigFiles (void)
+{
+  config_files [Config_Main]     = UNX_GetINIFile (dll_ini);
+  config_files [Config_Language] = UNX_GetINIFile (language_ini);
+  config_files [Config_Booster]  = UNX_GetINIFile (booster_ini);
+}
+
+
+//
+// Startup snapshot
+//
+//   Every setting UnX reads at startup (UnX_Gamepad.ini's included), as
+//     resolved by the last startup that parsed the INIs; see snapshot.h.
+//       Per-executable, because the FFX-only settings and the language
+//         overrides depend on it.
+//
+static bool from_snapshot = false;
+
+static std::wstring
+UNX_SnapshotPath (const std::wstring& name)
+{
+  return std::wstring (SK_GetConfigPath ()) + name + L"_" +
+                         UNX_GetExecutableName () + L".snapshot";
+}
+
+static void
+UNX_SnapshotStamps (const std::wstring& name, unx::snapshot::stamp_s (&stamps) [4])
+{
+  const std::wstring root (SK_GetConfigPath ());
+
+  stamps [0] = unx::snapshot::Stamp ((root + name + L".ini").c_str ());
+  stamps [1] = unx::snapshot::Stamp ((root + name + L"_Language.ini").c_str ());
+  stamps [2] = unx::snapshot::Stamp ((root + name + L"_Booster.ini").c_str ());
+  stamps [3] = unx::snapshot::Stamp ((root +        L"UnX_Gamepad.ini").c_str ());
+}
+
+static size_t
+UNX_SnapshotTables (unx::snapshot::table_s (&tables) [4])
+{
+  tables [0] = { config_schema, sizeof (config_schema) / sizeof (config_schema [0]),
+                   UNX_ConfigSkipFlags () };
+
+  return 1 + unx::InputManager::GetSnapshotTables (&tables [1], 3);
+}
+
+static bool
+UNX_LoadConfigSnapshot (const std::wstring& name)
+{
+  std::vector <uint8_t> data;
+
+  if (! unx::INIFile::read_file (UNX_SnapshotPath (name).c_str (), data))
+    return false;
+
+  unx::snapshot::stamp_s stamps [4];
+  unx::snapshot::table_s tables [4];
+
+  UNX_SnapshotStamps (name, stamps);
+
+  const size_t   count  = UNX_SnapshotTables (tables);
+  const uint64_t layout = unx::snapshot::Layout (tables, count, UNX_VER_STR);
+
+  const unx::snapshot::result_e result =
+    unx::snapshot::Read ( data.data (), data.size (), tables, count, layout,
+                            stamps, 4 );
+
+  if (result == unx::snapshot::result_e::Corrupt)
+    dll_log->Log (L"[ Snapshot ] '%s' is corrupt; ignoring it", UNX_SnapshotPath (name).c_str ());
+
+  return result == unx::snapshot::result_e::Ok;
+}
+
+bool
+UNX_ConfigFromSnapshot (void)
+{
+  return from_snapshot;
+}
+
+void
+UNX_SaveConfigSnapshot (std::wstring name)
+{
+  // Nothing could have changed since it was written
+  if (from_snapshot)
+    return;
+
+  unx::snapshot::stamp_s stamps [4];
+  unx::snapshot::table_s tables [4];
+
+  // Stamped after the writes UnX_LoadConfig and InputManager::Init made
+  UNX_FlushINIWrites ();
+  UNX_SnapshotStamps (name, stamps);
+
+  const size_t count = UNX_SnapshotTables (tables);
+
+  UNX_WriteFileAsync (
+    UNX_SnapshotPath (name).c_str (),
+      unx::snapshot::Write ( tables, count,
+                               unx::snapshot::Layout (tables, count, UNX_VER_STR),
+                                 stamps, 4 )
+  );
+}
 
 bool
 UNX_SetupLowLevelRender (void)
@@ -241,9 +427,6 @@ UNX_SetupTexMgmt (void)
   return false;
 }
 
-typedef const wchar_t* (__stdcall *SK_GetConfigPath_pfn)(void);
-SK_GetConfigPath_pfn SK_GetConfigPath = nullptr;
-
 bool
 UNX_LoadConfig (std::wstring name)
 {
@@ -267,8 +450,6 @@ UNX_LoadConfig (std::wstring name)
 
   dll_ini = UNX_CreateINI (wszFullName);
 
-  bool empty = dll_ini->get_sections ().empty ();
-
   lstrcatW (wszLanguage, SK_GetConfigPath ());
   lstrcatW (wszLanguage,       name.c_str ());
   lstrcatW (wszLanguage,    L"_Language.ini");
@@ -281,393 +462,51 @@ UNX_LoadConfig (std::wstring name)
 
   booster_ini = UNX_CreateINI (wszBooster);
 
-  //
-  // Create Parameters
-  //
-  display.disable_dpi_scaling =
-    static_cast <unx::ParameterBool *>
-      (g_ParameterFactory.create_parameter <bool> (
-        L"Disable DPI Scaling")
-      );
-  display.disable_dpi_scaling->register_to_ini (
-    dll_ini,
-      L"UnX.Display",
-        L"DisableDPIScaling" );
-
-  render.bypass_intel =
-    static_cast <unx::ParameterBool *>
-      (g_ParameterFactory.create_parameter <bool> (
-        L"Bypass Intel GPUs")
-      );
-  render.bypass_intel->register_to_ini (
-    dll_ini,
-      L"UnX.Render",
-        L"BypassIntel" );
-
-
-  compatibility.disable_timing_hacks =
-    dynamic_cast <unx::ParameterBool *>
-      (g_ParameterFactory.create_parameter <bool> (
-        L"Disable Timeskip Feature for more accurate debug logs")
-      );
-  compatibility.disable_timing_hacks->register_to_ini (
-    dll_ini,
-      L"UnX.Compatibility",
-        L"DisableTimingHacks"
-  );
-
-
-  language.voice =
-    static_cast <unx::ParameterStringW *>
-      (g_ParameterFactory.create_parameter <std::wstring> (
-        L"Voiceover Language")
-      );
-  language.voice->register_to_ini (
-    language_ini,
-      L"Language.Master",
-        L"Voice" );
-
-  language.sfx =
-    static_cast <unx::ParameterStringW *>
-      (g_ParameterFactory.create_parameter <std::wstring> (
-        L"Sound Effect Language")
-      );
-  language.sfx->register_to_ini (
-    language_ini,
-      L"Language.Master",
-        L"SoundEffects" );
-
-  language.video =
-    static_cast <unx::ParameterStringW *>
-      (g_ParameterFactory.create_parameter <std::wstring> (
-        L"Video Language")
-      );
-  language.video->register_to_ini (
-    language_ini,
-      L"Language.Master",
-        L"Video" );
-
-
-
-  input.remap_dinput8 =
-    static_cast <unx::ParameterBool *>
-      (g_ParameterFactory.create_parameter <bool> (
-        L"Allow button remapping")
-      );
-  input.remap_dinput8->register_to_ini (
-    dll_ini,
-      L"UnX.Input",
-        L"RemapDirectInput" );
-
-  input.fix_bg_input =
-    static_cast <unx::ParameterBool *>
-      (g_ParameterFactory.create_parameter <bool> (
-        L"Prevent DirectInput Nonsense in Background")
-      );
-  input.fix_bg_input->register_to_ini (
-    dll_ini,
-      L"UnX.Input",
-        L"FixBackgroundInput" );
-
-  input.block_left_alt =
-    static_cast <unx::ParameterBool *>
-      (g_ParameterFactory.create_parameter <bool> (
-        L"Block Left Alt Key")
-      );
-  input.block_left_alt->register_to_ini (
-    dll_ini,
-      L"UnX.Input",
-        L"BlockLeftAlt" );
-
-  input.block_left_ctrl =
-    static_cast <unx::ParameterBool *>
-      (g_ParameterFactory.create_parameter <bool> (
-        L"Block Left Ctrl Key")
-      );
-  input.block_left_ctrl->register_to_ini (
-    dll_ini,
-      L"UnX.Input",
-        L"BlockLeftCtrl" );
-
-  input.block_windows =
-    static_cast <unx::ParameterBool *>
-      (g_ParameterFactory.create_parameter <bool> (
-        L"Block Windows Key")
-      );
-  input.block_windows->register_to_ini (
-    dll_ini,
-      L"UnX.Input",
-        L"BlockWindows" );
-
-  input.block_all_keys =
-    static_cast <unx::ParameterBool *>
-      (g_ParameterFactory.create_parameter <bool> (
-        L"Block All Keys")
-      );
-  input.block_all_keys->register_to_ini (
-    dll_ini,
-      L"UnX.Input",
-        L"BlockAllKeys" );
-
-  input.four_finger_salute =
-    static_cast <unx::ParameterBool *>
-      (g_ParameterFactory.create_parameter <bool> (
-        L"Classic Final Fantasy Four-Finger Salute Reinvisioned")
-      );
-  input.four_finger_salute->register_to_ini (
-    dll_ini,
-      L"UnX.Input",
-        L"FourFingerSalute" );
-
-  input.gamepad_slot =
-    static_cast <unx::ParameterInt *>
-      (g_ParameterFactory.create_parameter <int> (
-        L"Gamepad slot to test during cursor mgmt")
-      );
-  input.gamepad_slot->register_to_ini (
-    dll_ini,
-      L"UnX.Input",
-        L"GamepadSlot" );
-
-  input.fast_exit =
-    static_cast <unx::ParameterBool *>
-      (g_ParameterFactory.create_parameter <bool> (
-        L"Exit Without Confirmation")
-      );
-  input.fast_exit->register_to_ini (
-    dll_ini,
-      L"UnX.Input",
-        L"FastExit" );
-
-  input.trap_alt_tab =
-    static_cast <unx::ParameterBool *>
-      (g_ParameterFactory.create_parameter <bool> (
-        L"Prevent Game from Receiving Alt+Tab Info")
-      );
-  input.trap_alt_tab->register_to_ini (
-    dll_ini,
-      L"UnX.Input",
-        L"TrapAltTab" );
-
-  input.filter_ime =
-    static_cast <unx::ParameterBool *>
-      (g_ParameterFactory.create_parameter <bool> (
-        L"Disable IME Messages, which appear to be the cause of some crashes.")
-      );
-  input.filter_ime->register_to_ini (
-    dll_ini,
-      L"UnX.Input",
-        L"FilterIME" );
-
-
-  textures.resource_root =
-    static_cast <unx::ParameterStringW *>
-      (g_ParameterFactory.create_parameter <std::wstring> (
-        L"Root of all texture resources; possibly of all evil too...")
-      );
-  textures.resource_root->register_to_ini (
-    dll_ini,
-      L"UnX.Textures",
-        L"ResourceRoot" );
-
-  textures.dump =
-    static_cast <unx::ParameterBool *>
-      (g_ParameterFactory.create_parameter <bool> (
-        L"Dump All Textures")
-    );
-  textures.dump->register_to_ini (
-    dll_ini,
-      L"UnX.Textures",
-        L"Dump" );
-
-  textures.inject =
-    static_cast <unx::ParameterBool *>
-      (g_ParameterFactory.create_parameter <bool> (
-        L"Inject All Textures in <Res_Root>/inject/<hash>.dds")
-    );
-  textures.inject->register_to_ini (
-    dll_ini,
-      L"UnX.Textures",
-        L"Inject" );
-
-  textures.cache =
-    static_cast <unx::ParameterBool *>
-      (g_ParameterFactory.create_parameter <bool> (
-        L"Cache all texture memory")
-    );
-  textures.cache->register_to_ini (
-    dll_ini,
-      L"UnX.Textures",
-        L"Cache" );
-
-
-  booster.ffx.entire_party_earns_ap =
-    static_cast <unx::ParameterBool *>
-      (g_ParameterFactory.create_parameter <bool> (
-        L"Give everyone in the current party AP")
-    );
-  booster.ffx.entire_party_earns_ap->register_to_ini (
-    booster_ini,
-      L"Boost.FFX",
-        L"EntirePartyEarnsAP" );
-
-  booster.ffx.permanent_sensor =
-    static_cast <unx::ParameterBool *>
-      (g_ParameterFactory.create_parameter <bool> (
-        L"Grant the Sensor ability no matter what weapon is equipped")
-    );
-  booster.ffx.permanent_sensor->register_to_ini (
-    booster_ini,
-      L"Boost.FFX",
-        L"GrantPermanentSensor" );
-
-  booster.ffx.max_speed =
-    static_cast <unx::ParameterFloat *>
-      (g_ParameterFactory.create_parameter <float> (
-        L"Maximum Speed Boost")
-    );
-  booster.ffx.max_speed->register_to_ini (
-    booster_ini,
-      L"SpeedHack.FFX",
-        L"MaxSpeed" );
-
-  booster.ffx.speed_step =
-    static_cast <unx::ParameterFloat *>
-      (g_ParameterFactory.create_parameter <float> (
-        L"Amount to multiply speed by")
-    );
-  booster.ffx.speed_step->register_to_ini (
-    booster_ini,
-      L"SpeedHack.FFX",
-        L"SpeedStep" );
-
-  booster.ffx.skip_dialog =
-    static_cast <unx::ParameterFloat *>
-      (g_ParameterFactory.create_parameter <float> (
-        L"Speed at which dialog is skipped")
-    );
-  booster.ffx.skip_dialog->register_to_ini (
-    booster_ini,
-      L"SpeedHack.FFX",
-        L"SkipDialogAtSpeed" );
-
-  booster.ffx.playable_seymour =
-    static_cast <unx::ParameterBool *>
-      (g_ParameterFactory.create_parameter <bool> (
-        L"Make Seymour a playable character")
-    );
-  booster.ffx.playable_seymour->register_to_ini (
-    booster_ini,
-      L"Fun.FFX",
-        L"PlayableSeymour" );
-
-
-  sys.version =
-    static_cast <unx::ParameterStringW *>
-      (g_ParameterFactory.create_parameter <std::wstring> (
-        L"Software Version")
-      );
-  sys.version->register_to_ini (
-    dll_ini,
-      L"UnX.System",
-        L"Version" );
-
-  sys.injector =
-    static_cast <unx::ParameterStringW *>
-      (g_ParameterFactory.create_parameter <std::wstring> (
-        L"Injector DLL")
-      );
-  sys.injector->register_to_ini (
-    dll_ini,
-      L"UnX.System",
-        L"Injector" );
-
-
-  //
-  // Load Parameters
-  //
-  display.disable_dpi_scaling->load (config.display.disable_dpi_scaling);
-
-  if (! language.voice->load (config.language.voice))
-    language.voice->set_value (config.language.voice);
+  // A snapshot only exists once the INIs were written, so it is never empty
+  bool empty = false;
 
-  unx::ParameterStringW* voice_override =
-    (unx::ParameterStringW *)
-      g_ParameterFactory.create_parameter <std::wstring> (
-        L"App-Specific Voice Language Preference");
+  from_snapshot =
+    UNX_LoadConfigSnapshot (name);
 
-  voice_override->register_to_ini (
-      language_ini,
-        UNX_GetExecutableName (),
-          L"Voice" );
-
-  std::wstring tmp_str;
-
-  if (voice_override->load (tmp_str)) {
-    if (tmp_str.length ())   config.language.voice = tmp_str;
-  } else {
-    voice_override->store (L"");
-  }
-
-
-  if (! language.sfx->load (config.language.sfx))
-    language.sfx->set_value (config.language.sfx);
-
-
-  unx::ParameterStringW* sfx_override =
-    (unx::ParameterStringW *)
-      g_ParameterFactory.create_parameter <std::wstring> (
-        L"App-Specific SFX Language Preference");
-
-  sfx_override->register_to_ini (
-      language_ini,
-        UNX_GetExecutableName (),
-          L"SoundEffects" );
-
-  if (sfx_override->load (tmp_str)) {
-    if (tmp_str.length ())   config.language.sfx = tmp_str;
-  } else {
-    sfx_override->store (L"");
-  }
+  if (! from_snapshot)
+  {
+    empty = dll_ini->get_sections ().empty ();
 
+    UNX_OpenConfigFiles ();
 
-  if (! language.video->load (config.language.video))
-    language.video->set_value (config.language.video);
+    Load (config_schema, config_files, UNX_ConfigSkipFlags ());
 
-  unx::ParameterStringW* fmv_override =
-    (unx::ParameterStringW *)
-      g_ParameterFactory.create_parameter <std::wstring> (
-        L"App-Specific FMV Language Preference");
+    //
+    // App-Specific language preferences; an empty value (the default) defers
+    //   to Language.Master.
+    //
+    const struct {
+      const wchar_t* key;
+      std::wstring*  value;
+    } lang_overrides [] = {
+      { L"Voice",        &config.language.voice },
+      { L"SoundEffects", &config.language.sfx   },
+      { L"Video",        &config.language.video }
+    };
+
+    unx::INIFile* lang =
+      config_files [Config_Language];
+
+    const unx::INIFile::section_id app_lang =
+      lang->get_section (UNX_GetExecutableName ());
+
+    for (const auto& it : lang_overrides)
+    {
+      std::wstring_view pref;
 
-  fmv_override->register_to_ini (
-      language_ini,
-        UNX_GetExecutableName (),
-          L"Video" );
+      if (! lang->find_value (app_lang, it.key, pref))
+        lang->add_key_value  (app_lang, it.key, L"");
 
-  if (fmv_override->load (tmp_str)) {
-    if (tmp_str.length ())   config.language.video = tmp_str;
-  } else {
-    fmv_override->store (L"");
+      else if (pref.length ())
+        it.value->assign (pref);
+    }
   }
 
-  input.remap_dinput8->load (config.input.remap_dinput8);
-  input.gamepad_slot->load  (config.input.gamepad_slot);
-  input.fix_bg_input->load  (config.input.fix_bg_input);
-
-  input.block_windows->load (config.input.block_windows);
-  //input.block_left_alt->load  (config.input.block_left_alt);
-  //input.block_left_ctrl->load (config.input.block_left_ctrl);
-  //input.block_all_keys->load  (config.input.block_all_keys);
-
-  input.four_finger_salute->load (config.input.four_finger_salute);
-
-  input.fast_exit->load    (config.input.fast_exit);
-  input.trap_alt_tab->load (config.input.trap_alt_tab);
-  input.filter_ime->load   (config.input.filter_ime);
-
-
-  compatibility.disable_timing_hacks->load (config.cheat.ffx.disable_timing_hacks);
-
 
 #if 1
   // Force BG input fix off if this is disabled
@@ -679,26 +518,13 @@ UNX_LoadConfig (std::wstring name)
     config.input.fast_exit = true;
 #endif
 
-
-  extern wchar_t* UNX_GetExecutableName (void);
-  if (StrStrIW (UNX_GetExecutableName (), L"ffx.exe"))
+  if (UNX_ConfigSkipFlags () & Schema_FFXOnly)
   {
-    booster.ffx.entire_party_earns_ap->load (config.cheat.ffx.entire_party_earns_ap);
-    booster.ffx.permanent_sensor->load      (config.cheat.ffx.permanent_sensor);
-    booster.ffx.playable_seymour->load      (config.cheat.ffx.playable_seymour);
-
-    booster.ffx.max_speed->load   (config.cheat.ffx.max_speed);
-    booster.ffx.speed_step->load  (config.cheat.ffx.speed_step);
-    booster.ffx.skip_dialog->load (config.cheat.ffx.skip_dialog);
-} else {
     config.cheat.ffx.speed_step = 0.0f;
     config.cheat.ffx.max_speed  = 1.0f;
   }
 
-  sys.version->load  (config.system.version);
-  //sys.injector->load (config.system.injector);
-
-  render.bypass_intel->load (config.render.bypass_intel);
+  UNX_PublishConfig ();
 
   if ( (config.render.bypass_intel) &&
        UNX_SetupLowLevelRender () )
@@ -712,11 +538,6 @@ UNX_LoadConfig (std::wstring name)
 
   if (UNX_SetupTexMgmt ())
   {
-    textures.resource_root->load (config.textures.resource_root);
-    textures.dump->load          (config.textures.dump);
-    textures.inject->load        (config.textures.inject);
-    textures.cache->load         (config.textures.cache);
-
     SK_D3D11_SetResourceRoot (config.textures.resource_root.c_str ());
     SK_D3D11_EnableTexDump   (config.textures.dump);
     SK_D3D11_EnableTexInject (config.textures.inject);
@@ -730,7 +551,9 @@ UNX_LoadConfig (std::wstring name)
       SK_D3D11_PopulateResourceList ();
   }
 
-  UNX_SaveConfig (name);
+  // Nothing to write back; the files have not even been read
+  if (! from_snapshot)
+    UNX_SaveConfig (name);
 
   if (empty)
     return false;
@@ -741,43 +564,23 @@ UNX_LoadConfig (std::wstring name)
 #include <imgui/imgui.h>
 #pragma comment (lib, "F:\\SteamLibrary\\steamapps\\common\\FINAL FANTASY FFX&FFX-2 HD Remaster\\dxgi.lib")
 
-void
-UNX_SaveConfig (std::wstring name, bool close_config)
+static void
+UNX_WriteINI (iSK_INI* pINI, const wchar_t* wszPath, bool async)
 {
-  input.remap_dinput8->store        (config.input.remap_dinput8);
-
-  //input.block_windows->store        (config.input.block_windows);
-  input.fix_bg_input->store         (config.input.fix_bg_input);
-
-  input.trap_alt_tab->store         (config.input.trap_alt_tab);
-  input.filter_ime->store           (config.input.filter_ime);
-
-
-
-  ((unx::iParameter *)language.sfx)->set_value_str (config.language.sfx);
-  ((unx::iParameter *)language.sfx)->store         (                   );
-
-  ((unx::iParameter *)language.voice)->set_value_str (config.language.voice);
-  ((unx::iParameter *)language.voice)->store         (                     );
+  if (async)
+    UNX_SaveINIAsync (pINI, wszPath);
+  else
+    pINI->write      (wszPath);
+}
 
-  ((unx::iParameter *)language.video)->set_value_str (config.language.video);
-  ((unx::iParameter *)language.video)->store         (                     );
+static void
+UNX_StoreConfig (const std::wstring& name, bool async)
+{
+  auto lock = UNX_LockConfig ();
 
-  extern wchar_t* UNX_GetExecutableName (void);
-  if (StrStrIW (UNX_GetExecutableName (), L"ffx.exe"))
-  {
-    compatibility.disable_timing_hacks->store (config.cheat.ffx.disable_timing_hacks);
-
-    booster.ffx.entire_party_earns_ap->store  (config.cheat.ffx.entire_party_earns_ap);
-    booster.ffx.permanent_sensor->store       (config.cheat.ffx.permanent_sensor);
-    booster.ffx.playable_seymour->store       (config.cheat.ffx.playable_seymour);
-    booster.ffx.max_speed->store              (config.cheat.ffx.max_speed);
-    booster.ffx.speed_step->store             (config.cheat.ffx.speed_step);
-    booster.ffx.skip_dialog->store            (config.cheat.ffx.skip_dialog);
-  }
+  UNX_OpenConfigFiles ();
 
-  sys.version->store      (UNX_VER_STR);
-  sys.injector->store     (config.system.injector);
+  Store (config_schema, config_files, UNX_ConfigSkipFlags ());
 
   wchar_t wszFullName [ MAX_PATH + 2 ] = { L'\0' };
   wchar_t wszLanguage [ MAX_PATH + 2 ] = { L'\0' };
@@ -787,42 +590,176 @@ UNX_SaveConfig (std::wstring name, bool close_config)
   lstrcatW (wszFullName,       name.c_str ());
   lstrcatW (wszFullName,             L".ini");
 
-  dll_ini->write (wszFullName);
+  UNX_WriteINI (dll_ini, wszFullName, async);
 
   lstrcatW (wszLanguage, SK_GetConfigPath ());
   lstrcatW (wszLanguage,       name.c_str ());
   lstrcatW (wszLanguage,    L"_Language.ini");
 
-  language_ini->write (wszLanguage);
+  UNX_WriteINI (language_ini, wszLanguage, async);
 
   lstrcatW (wszBooster, SK_GetConfigPath ());
   lstrcatW (wszBooster,       name.c_str ());
   lstrcatW (wszBooster,     L"_Booster.ini");
 
-  booster_ini->write (wszBooster);
+  UNX_WriteINI (booster_ini, wszBooster, async);
+}
+
+void
+UNX_SaveConfig (std::wstring name, bool close_config)
+{
+  UNX_StoreConfig (name, false);
 
   if (close_config)
   {
-    // Actually, this is somewhat invalid -- DO NOT FREE MEMORY THAT WAS
-    //                                       ALLOCATED IN A DIFFERENT DLL
-    //                             (unless compiled under the EXACT same environment)!
+    for (auto& file : config_files)
+      file = nullptr;
+
+    // These are UnX's own INI objects now, so they can actually be freed
     if (dll_ini != nullptr) {
-      //delete dll_ini;
+      dll_ini->Release ();
       dll_ini = nullptr;
     }
 
     if (language_ini != nullptr) {
-      //delete language_ini;
+      language_ini->Release ();
       language_ini = nullptr;
     }
 
     if (booster_ini != nullptr) {
-      //delete booster_ini;
+      booster_ini->Release ();
       booster_ini = nullptr;
     }
   }
 }
 
+void
+UNX_QueueSaveConfig (std::wstring name)
+{
+  UNX_StoreConfig (name, true);
+}
+
+
+//
+// Hot reload
+//
+//   The watcher thread only reads the files; the render thread reparses the
+//     one that changed and applies the settings that differ, through the
+//       same functions the control panel uses.
+//
+enum {
+  Watch_Main,
+  Watch_Booster,
+  Watch_Gamepad
+};
+
+// Never destroyed, for the same reason as the INI writer (see ini.cpp)
+static unx::ConfigWatcher* config_watcher = nullptr;
+
+static void
+UNX_ConfigFileChanged (size_t file)
+{
+  unx::WindowManager::PostCommand (unx::GAME_CMD_RELOAD_CONFIG, (uint32_t)file);
+}
+
+static void
+UNX_ConfigFileWritten (const wchar_t* path, const std::vector <uint8_t>& data)
+{
+  config_watcher->expect (path, data);
+}
+
+void
+UNX_WatchConfig (std::wstring name)
+{
+  if (config_watcher != nullptr || (! config.system.watch_config))
+    return;
+
+  const std::wstring root (SK_GetConfigPath ());
+
+  config_watcher =
+    new unx::ConfigWatcher (UNX_ConfigFileChanged);
+
+  // Added in Watch_* order
+  config_watcher->add (root + name + L".ini");
+  config_watcher->add (root + name + L"_Booster.ini");
+  config_watcher->add (root +        L"UnX_Gamepad.ini");
+
+  UNX_SetINIWriteHook (UNX_ConfigFileWritten);
+
+  if (! config_watcher->start ())
+  {
+    UNX_SetINIWriteHook (nullptr);
+
+    dll_log->Log (L"[Hot Reload] Could not watch '%s' for changes", root.c_str ());
+  }
+}
+
+void
+UNX_ReloadConfig (uint32_t file)
+{
+  std::vector <uint8_t> data;
+
+  if (config_watcher == nullptr || (! config_watcher->take (file, data)))
+    return;
+
+  if (file == Watch_Gamepad)
+  {
+    unx::InputManager::ReloadGamepadConfig (data);
+    return;
+  }
+
+  iSK_INI*      pINI   = file == Watch_Main ? dll_ini     : booster_ini;
+  const uint8_t source = file == Watch_Main ? Config_Main : Config_Booster;
+
+  // Closed on the way out
+  if (pINI == nullptr)
+    return;
+
+  auto lock = UNX_LockConfig ();
+
+  UNX_ReloadINI (pINI, data);
+  UNX_OpenConfigFiles ();
+
+  std::vector <const unx::schema::field_s *> changed;
+
+  unx::schema::LoadChanges ( config_schema, source, *config_files [source],
+                               UNX_ConfigSkipFlags () | Schema_Startup,
+                                 &changed );
+
+  // Same rule as UNX_LoadConfig
+  if (! config.input.fast_exit)
+    config.input.fix_bg_input = false;
+
+  UNX_PublishConfig ();
+
+  bool speed  = false,
+       sensor = false;
+
+  std::wstring value;
+
+  for (const auto* field : changed)
+  {
+    unx::schema::Format (*field, value);
+
+    dll_log->Log ( L"[Hot Reload] %s: [%s] %s = %s",
+                     pINI->get_filename (), field->section,
+                       field->key, value.c_str () );
+
+    speed  |= ( field->value == &config.cheat.ffx.max_speed   ||
+                field->value == &config.cheat.ffx.speed_step  ||
+                field->value == &config.cheat.ffx.skip_dialog ||
+                field->value == &config.cheat.ffx.disable_timing_hacks );
+    sensor |=   field->value == &config.cheat.ffx.permanent_sensor;
+  }
+
+  // Both poke at game memory that only exists once the game is identified
+  if (game_type == GAME_FFX)
+  {
+    if (speed)  UNX_UpdateSpeedLimit ();
+    if (sensor) UNX_SetSensor        (config.cheat.ffx.permanent_sensor);
+  }
+}
+
 unx::ParameterStringW* unx_speedstep;
 unx::ParameterStringW* unx_kickstart;
 unx::ParameterStringW* unx_timestop;
@@ -959,6 +896,10 @@ UNX_ControlPanelWidget (void)
     first = false;
   }
 
+  // The widgets below edit config in place; anything they change is
+  //   published as soon as it changes.
+  auto lock = UNX_LockConfig ();
+
 
   static 
     const char* szLabel = (game_type & GAME_FFX) ? "Final Fantasy X HD Remaster" :
@@ -1000,7 +941,7 @@ UNX_ControlPanelWidget (void)
         if (voice_lang != orig_voice)
         {
           changed_now = true;
-          unx::LanguageManager::ApplyPatch (Voice);
+          unx::WindowManager::PostCommand (unx::GAME_CMD_APPLY_LANGUAGE, Voice);
         }
       }
 
@@ -1014,7 +955,7 @@ UNX_ControlPanelWidget (void)
         if (sfx_lang != orig_sfx)
         {
           changed_now = true;
-          unx::LanguageManager::ApplyPatch (SoundEffect);
+          unx::WindowManager::PostCommand (unx::GAME_CMD_APPLY_LANGUAGE, SoundEffect);
         }
       }
 
@@ -1028,7 +969,7 @@ UNX_ControlPanelWidget (void)
         if (fmv_lang != orig_fmv)
         {
           changed_now = true;
-          unx::LanguageManager::ApplyPatch (Video);
+          unx::WindowManager::PostCommand (unx::GAME_CMD_APPLY_LANGUAGE, Video);
         }
       }
 
@@ -1036,7 +977,8 @@ UNX_ControlPanelWidget (void)
 
       if (changed_now)
       {
-        UNX_SaveConfig ();
+        UNX_PublishConfig   ();
+        UNX_QueueSaveConfig ();
         changed = true;
       }
 
@@ -1079,9 +1021,11 @@ UNX_ControlPanelWidget (void)
         {
           param->store   (binding->human_readable);
 
+          unx::InputManager::RebuildKeybinds ();
+
           extern iSK_INI* pad_cfg;
 
-          pad_cfg->write (pad_cfg->get_filename ());
+          UNX_SaveINIAsync (pad_cfg);
 
           return true;
         }
@@ -1170,7 +1114,7 @@ UNX_ControlPanelWidget (void)
 
             extern iSK_INI* pad_cfg;
             
-            pad_cfg->write (pad_cfg->get_filename ());
+            UNX_SaveINIAsync (pad_cfg);
           
             return true;
           }
@@ -1330,12 +1274,11 @@ UNX_ControlPanelWidget (void)
 
         for ( auto it : gamepads )
         {
-          extern unx::ParameterStringW* texture_set;
-          extern iSK_INI*               pad_cfg;
-          static std::wstring           original = texture_set->get_value ();
+          extern iSK_INI*     pad_cfg;
+          static std::wstring original = gamepad.tex_set;
 
           bool selected =
-            texture_set->get_value () == it.name;
+            gamepad.tex_set == it.name;
 
           if (selected && (! pTex))
             pTex = it.pTex;
@@ -1344,9 +1287,10 @@ UNX_ControlPanelWidget (void)
           {
             if (selected)
             {
-              gamepad.tex_set   = it.name;
-              texture_set->store (it.name);
-              pad_cfg->write     (pad_cfg->get_filename ());
+              gamepad.tex_set = it.name;
+
+              unx::InputManager::StoreGamepadConfig ();
+              UNX_SaveINIAsync                      (pad_cfg);
 
               changed = (original != it.name);
 
@@ -1411,6 +1355,45 @@ UNX_ControlPanelWidget (void)
         ImGui::TreePop ();
       }
 
+      if (ImGui::CollapsingHeader ("Input Latency"))
+      {
+        ImGui::TreePush ("");
+
+        auto LatencyRow = [](const char* szStage, const unx::LatencyHistogram& hist)
+        {
+          ImGui::Text       ("%s",      szStage);                                 ImGui::NextColumn ();
+          ImGui::Text       ("%llu",    hist.count ());                           ImGui::NextColumn ();
+          ImGui::Text       ("%.2f ms", (double)hist.percentile (0.50) / 1000.0); ImGui::NextColumn ();
+          ImGui::Text       ("%.2f ms", (double)hist.percentile (0.95) / 1000.0); ImGui::NextColumn ();
+          ImGui::Text       ("%.2f ms", (double)hist.percentile (0.99) / 1000.0); ImGui::NextColumn ();
+        };
+
+        ImGui::Columns    (5);
+        ImGui::Text       ("Stage"); ImGui::NextColumn ();
+        ImGui::Text       ("Count"); ImGui::NextColumn ();
+        ImGui::Text       ("p50");   ImGui::NextColumn ();
+        ImGui::Text       ("p95");   ImGui::NextColumn ();
+        ImGui::Text       ("p99");   ImGui::NextColumn ();
+        ImGui::Separator  (     );
+
+        LatencyRow        ("Poll",     input_latency.poll);
+        LatencyRow        ("Dispatch", input_latency.dispatch);
+        LatencyRow        ("Present",  input_latency.present);
+        LatencyRow        ("Total",    input_latency.total);
+
+        ImGui::Columns    (1);
+
+        if (ImGui::Button ("Reset"))
+        {
+          input_latency.poll.reset     ();
+          input_latency.dispatch.reset ();
+          input_latency.present.reset  ();
+          input_latency.total.reset    ();
+        }
+
+        ImGui::TreePop ();
+      }
+
       ImGui::PopStyleColor (3);
       ImGui::TreePop       ( );
     }
@@ -1457,6 +1440,7 @@ UNX_ControlPanelWidget (void)
           if (changed)
           {
             dirty = true;
+            UNX_PublishConfig    ();
             UNX_UpdateSpeedLimit ();
           }
 
@@ -1470,15 +1454,13 @@ UNX_ControlPanelWidget (void)
           if (ImGui::Checkbox ("Entire Party Earns AP", &config.cheat.ffx.entire_party_earns_ap))
           {
             dirty = true;
-            UNX_TogglePartyAP (  );
-            UNX_TogglePartyAP (  );
+            UNX_SetPartyAP (config.cheat.ffx.entire_party_earns_ap);
           }
 
           if (ImGui::Checkbox ("Grant Permanent Sensor", &config.cheat.ffx.permanent_sensor))
           {
             dirty = true;
-            UNX_ToggleSensor  (  );
-            UNX_ToggleSensor  (  );
+            UNX_SetSensor  (config.cheat.ffx.permanent_sensor);
           }
 
           ImGui::TreePop      (  );
@@ -1486,9 +1468,14 @@ UNX_ControlPanelWidget (void)
 
         if (ImGui::CollapsingHeader ("Misc."))
         {
-          dirty = true;
           ImGui::TreePush ("");
-          ImGui::Checkbox ("Seymour As Playable Character", &config.cheat.ffx.playable_seymour);
+
+          if (ImGui::Checkbox ("Seymour As Playable Character", &config.cheat.ffx.playable_seymour))
+          {
+            dirty = true;
+            UNX_PublishConfig ();
+          }
+
           ImGui::TreePop  (  );
         }
 
@@ -1496,7 +1483,7 @@ UNX_ControlPanelWidget (void)
         ImGui::TreePop       ( );
 
         if (dirty)
-          UNX_SaveConfig ();
+          UNX_QueueSaveConfig ();
       }
     }
 
@@ -21,7 +21,10 @@
 #ifndef __UNX__CONFIG_H__
 #define __UNX__CONFIG_H__
 
+#include "rcu.h"
+
 #include <Windows.h>
+#include <mutex>
 #include <string>
 
 extern std::wstring UNX_VER_STR;
@@ -38,6 +41,10 @@ struct unx_config_s
     bool    start_fullscreen    = true;
   } display;
 
+  struct {
+    float   background_fps      = 30.0f; // Limit while inactive, 0 = none
+  } window;
+
   struct {
     struct {
       bool  entire_party_earns_ap = false;
@@ -124,6 +131,7 @@ struct unx_config_s
 
     bool four_finger_salute = true;
     int  gamepad_slot       = -1;
+    int  gamepad_poll_hz    = 250; // Background poller rate (Hz)
 
     bool trap_alt_tab       = false;
 
@@ -136,13 +144,101 @@ struct unx_config_s
             version            = UNX_VER_STR;
     std::wstring
             injector           = L"dxgi.dll";
+
+    int     update_interval    = 24;    // Hours between checks, < 0 = never
+    int     update_timeout     = 15;    // Seconds
+    int64_t last_update_check  = 0;     // time (), written back after a check
+    bool    update_available   = false; //   ... and what it found
+
+    bool    watch_config       = true;  // Apply edits made while running
+    bool    binary_log         = false; // Bulk log lines go to UnX.trace
   } system;
 };
 
+//
+// The master copy; only ever changed by whoever holds UNX_LockConfig (the
+//   loader, hot reload, the control panel, cheat toggles). Code that runs
+//     on any other thread reads a published copy instead, see below.
+//
 extern unx_config_s config;
 
+//
+// Copies of the settings that hooks read on every message, frame or poll.
+//
+//   config interleaves these with strings and texture hashes, spreading them
+//     over a dozen cache lines; this block (and the sequence number that
+//       guards it) fits in one. Hooks read it through UNX_GetHotConfig and
+//         never see a half-applied change. Published along with the rest
+//           of the config by UNX_PublishConfig.
+//
+struct unx_hot_config_s
+{
+  float background_fps  = 30.0f;
+  int   gamepad_slot    = -1;
+  int   gamepad_poll_hz = 250;
+
+  bool  remap_dinput8   = true;
+  bool  fast_exit       = true;
+  bool  fix_bg_input    = false;
+  bool  trap_alt_tab    = false;
+};
+
+unx_hot_config_s UNX_GetHotConfig     (void);
+
+//
+// Everything else, as an immutable copy of config that stays valid for as
+//   long as the view is held; hold it briefly and never across a frame.
+//     Reading never locks and never waits for a writer.
+//
+using unx_config_view = unx::RCU <unx_config_s>::read_guard;
+
+unx_config_view UNX_ReadConfig (void);
+
+// Recursive; never taken by anything that only reads
+std::unique_lock <std::recursive_mutex>
+                UNX_LockConfig    (void);
+
+// Makes the current state of config visible to readers (takes the lock)
+void            UNX_PublishConfig (void);
+
+//
+// Runs fn on config with the lock held, and publishes if fn returns true.
+//
+template <typename _Fn>
+bool
+UNX_UpdateConfig (_Fn&& fn)
+{
+  auto lock = UNX_LockConfig ();
+
+  if (! fn (config))
+    return false;
+
+  UNX_PublishConfig ();
+
+  return true;
+}
+
 bool UNX_LoadConfig (std::wstring name         = L"UnX");
 void UNX_SaveConfig (std::wstring name         = L"UnX",
                      bool         close_config = false);
 
+// Same as UNX_SaveConfig, but the files are written from a background thread;
+//   for anything that runs inside a frame (i.e. the control panel).
+void UNX_QueueSaveConfig (std::wstring name = L"UnX");
+
+// Starts watching UnX.ini, UnX_Booster.ini and UnX_Gamepad.ini, once the
+//   gamepad config is loaded too
+void UNX_WatchConfig     (std::wstring name = L"UnX");
+
+// Render thread; applies whatever changed in a file the watcher reported
+void UNX_ReloadConfig    (uint32_t file);
+
+// True if UNX_LoadConfig took every setting from the startup snapshot, in
+//   which case nothing else should read the INIs during startup either
+bool UNX_ConfigFromSnapshot (void);
+
+// Once all of the startup settings are loaded; does nothing if they came
+//   from the snapshot in the first place
+void UNX_SaveConfigSnapshot (std::wstring name = L"UnX");
+
 #endif /* __UNX__CONFIG_H__ */
\ No newline at end of file
@@ -0,0 +1,490 @@
+/**
+ * This file is part of UnX.
+ *
+ * UnX is free software : you can redistribute it
+ * and/or modify it under the terms of the GNU General Public License
+ * as published by The Free Software Foundation, either version 3 of
+ * the License, or (at your option) any later version.
+ *
+ * UnX is distributed in the hope that it will be useful,
+ *
+ * But WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with UnX.
+ *
+ *   If not, see <http://www.gnu.org/licenses/>.
+ *
+**/
+#include "configwatch.h"
+#include "inifile.h"
+
+#ifdef _WIN32
+# include <Windows.h>
+#elif defined (__linux__)
+# include <poll.h>
+# include <sys/inotify.h>
+# include <unistd.h>
+# include <fcntl.h>
+#else
+# include <chrono>
+# include <condition_variable>
+#endif
+
+struct unx::ConfigWatcher::backend_s
+{
+#ifdef _WIN32
+  HANDLE                stop = nullptr;
+  std::vector <HANDLE>  dirs;
+#elif defined (__linux__)
+  int                   notify  = -1;
+  int                   stop [2] = { -1, -1 };
+#else
+  std::mutex              lock;
+  std::condition_variable signal;
+  bool                    stopping = false;
+#endif
+};
+
+#ifndef _WIN32
+static std::string
+UNX_NarrowPath (const std::wstring& path)
+{
+  std::string out;
+
+  for (wchar_t wc : path)
+  {
+    const uint32_t cp = (uint32_t)wc;
+
+    if (cp < 0x80)
+      out.push_back ((char)cp);
+
+    else if (cp < 0x800)
+    {
+      out.push_back ((char)(0xC0 |  (cp >> 6)));
+      out.push_back ((char)(0x80 |  (cp        & 0x3F)));
+    }
+
+    else if (cp < 0x10000)
+    {
+      out.push_back ((char)(0xE0 |  (cp >> 12)));
+      out.push_back ((char)(0x80 | ((cp >> 6)  & 0x3F)));
+      out.push_back ((char)(0x80 |  (cp        & 0x3F)));
+    }
+
+    else
+    {
+      out.push_back ((char)(0xF0 |  (cp >> 18)));
+      out.push_back ((char)(0x80 | ((cp >> 12) & 0x3F)));
+      out.push_back ((char)(0x80 | ((cp >> 6)  & 0x3F)));
+      out.push_back ((char)(0x80 |  (cp        & 0x3F)));
+    }
+  }
+
+  return out;
+}
+#endif
+
+static std::wstring
+UNX_ParentDir (const std::wstring& path)
+{
+  const size_t sep =
+    path.find_last_of (L"\\/");
+
+  if (sep == std::wstring::npos)
+    return L".";
+
+  if (sep == 0)
+    return path.substr (0, 1);
+
+  return path.substr (0, sep);
+}
+
+static bool
+UNX_SamePath (const std::wstring& a, const std::wstring& b)
+{
+#ifdef _WIN32
+  return _wcsicmp (a.c_str (), b.c_str ()) == 0;
+#else
+  return a == b;
+#endif
+}
+
+
+uint64_t
+unx::ConfigWatcher::Hash (const uint8_t* data, size_t len)
+{
+  // FNV-1a; only has to tell one revision of a small file from another
+  uint64_t hash = 0xcbf29ce484222325ULL;
+
+  for (size_t i = 0; i < len; i++)
+  {
+    hash ^= data [i];
+    hash *= 0x100000001b3ULL;
+  }
+
+  return hash;
+}
+
+unx::ConfigWatcher::ConfigWatcher (changed_fn changed, uint32_t debounce_ms) :
+  changed_     (changed),
+  debounce_ms_ (debounce_ms)
+{
+}
+
+unx::ConfigWatcher::~ConfigWatcher (void)
+{
+  stop ();
+}
+
+size_t
+unx::ConfigWatcher::find (const std::wstring& path) const
+{
+  for (size_t i = 0; i < files_.size (); i++)
+  {
+    if (UNX_SamePath (files_ [i].path, path))
+      return i;
+  }
+
+  return (size_t)-1;
+}
+
+size_t
+unx::ConfigWatcher::add (const std::wstring& path)
+{
+  std::lock_guard <std::mutex> guard (lock_);
+
+  const size_t existing =
+    find (path);
+
+  if (existing != (size_t)-1)
+    return existing;
+
+  file_s file;
+         file.path = path;
+
+  files_.push_back (std::move (file));
+
+  const std::wstring dir =
+    UNX_ParentDir (path);
+
+  bool known = false;
+
+  for (const auto& it : dirs_)
+    known |= UNX_SamePath (it, dir);
+
+  if (! known)
+    dirs_.push_back (dir);
+
+  return files_.size () - 1;
+}
+
+bool
+unx::ConfigWatcher::start (void)
+{
+  if (backend_ != nullptr)
+    return true;
+
+  // What is on disk right now has already been loaded
+  for (auto& file : files_)
+  {
+    std::vector <uint8_t> data;
+
+    const bool exists =
+      unx::INIFile::read_file (file.path.c_str (), data);
+
+    std::lock_guard <std::mutex> guard (lock_);
+
+    file.exists = exists;
+    file.hash   = Hash (data.data (), data.size ());
+  }
+
+  backend_ = new backend_s;
+
+  size_t watched = 0;
+
+#ifdef _WIN32
+  backend_->stop =
+    CreateEventW (nullptr, TRUE, FALSE, nullptr);
+
+  for (const auto& dir : dirs_)
+  {
+    if (backend_->dirs.size () >= MAXIMUM_WAIT_OBJECTS - 1)
+      break;
+
+    HANDLE hChange =
+      FindFirstChangeNotificationW ( dir.c_str (), FALSE,
+                                       FILE_NOTIFY_CHANGE_FILE_NAME  |
+                                       FILE_NOTIFY_CHANGE_LAST_WRITE |
+                                       FILE_NOTIFY_CHANGE_SIZE );
+
+    if (hChange != INVALID_HANDLE_VALUE)
+      backend_->dirs.push_back (hChange);
+  }
+
+  watched = backend_->dirs.size ();
+#elif defined (__linux__)
+  backend_->notify =
+    inotify_init1 (IN_NONBLOCK | IN_CLOEXEC);
+
+  if (backend_->notify != -1 && pipe2 (backend_->stop, O_CLOEXEC) == 0)
+  {
+    for (const auto& dir : dirs_)
+    {
+      if ( inotify_add_watch ( backend_->notify, UNX_NarrowPath (dir).c_str (),
+                                 IN_CLOSE_WRITE | IN_MOVED_TO | IN_CREATE |
+                                 IN_DELETE      | IN_MOVED_FROM ) != -1 )
+        watched++;
+    }
+  }
+#else
+  // Polled once a second
+  watched = dirs_.size ();
+#endif
+
+  if (watched == 0)
+  {
+    stop ();
+    return false;
+  }
+
+  thread_ = std::thread (&ConfigWatcher::run, this);
+
+  return true;
+}
+
+void
+unx::ConfigWatcher::stop (void)
+{
+  if (backend_ == nullptr)
+    return;
+
+#ifdef _WIN32
+  if (backend_->stop != nullptr)
+    SetEvent (backend_->stop);
+#elif defined (__linux__)
+  if (backend_->stop [1] != -1)
+  {
+    const char    wake    = 0;
+    const ssize_t written = write (backend_->stop [1], &wake, 1);
+
+    (void)written;
+  }
+#else
+  {
+    std::lock_guard <std::mutex> guard (backend_->lock);
+    backend_->stopping = true;
+  }
+
+  backend_->signal.notify_all ();
+#endif
+
+  if (thread_.joinable ())
+      thread_.join ();
+
+#ifdef _WIN32
+  for (HANDLE hChange : backend_->dirs)
+    FindCloseChangeNotification (hChange);
+
+  if (backend_->stop != nullptr)
+    CloseHandle (backend_->stop);
+#elif defined (__linux__)
+  if (backend_->notify  != -1) close (backend_->notify);
+  if (backend_->stop [0] != -1) close (backend_->stop [0]);
+  if (backend_->stop [1] != -1) close (backend_->stop [1]);
+#endif
+
+  delete backend_;
+         backend_ = nullptr;
+}
+
+//
+// > 0 something changed, 0 timed out, < 0 stopping
+//
+int
+unx::ConfigWatcher::wait (int timeout_ms)
+{
+  backend_s* backend = backend_;
+
+#ifdef _WIN32
+  HANDLE handles [MAXIMUM_WAIT_OBJECTS];
+  DWORD  count = 0;
+
+  handles [count++] = backend->stop;
+
+  for (HANDLE hChange : backend->dirs)
+    handles [count++] = hChange;
+
+  const DWORD dwWait =
+    WaitForMultipleObjects ( count, handles, FALSE,
+                               timeout_ms < 0 ? INFINITE : (DWORD)timeout_ms );
+
+  if (dwWait == WAIT_TIMEOUT)
+    return 0;
+
+  if (dwWait == WAIT_OBJECT_0 || dwWait >= WAIT_OBJECT_0 + count)
+    return -1;
+
+  FindNextChangeNotification (handles [dwWait - WAIT_OBJECT_0]);
+
+  return 1;
+#elif defined (__linux__)
+  pollfd fds [2] = {
+    { backend->stop [0], POLLIN, 0 },
+    { backend->notify,   POLLIN, 0 }
+  };
+
+  const int ready =
+    poll (fds, 2, timeout_ms);
+
+  if (ready == 0)
+    return 0;
+
+  if (ready < 0 || (fds [0].revents & POLLIN))
+    return -1;
+
+  // Which file it was does not matter; every file is hashed anyway
+  alignas (inotify_event) char events [4096];
+
+  while (read (backend->notify, events, sizeof events) > 0)
+    ;
+
+  return 1;
+#else
+  std::unique_lock <std::mutex> guard (backend->lock);
+
+  backend->signal.wait_for ( guard, std::chrono::milliseconds (timeout_ms < 0 ? 1000 : timeout_ms),
+                               [backend] { return backend->stopping; } );
+
+  return backend->stopping ? -1 : (timeout_ms < 0 ? 1 : 0);
+#endif
+}
+
+void
+unx::ConfigWatcher::run (void)
+{
+  // Editors save in several steps; wait until they are done, but do not
+  //   let a file that is being rewritten constantly starve the others.
+  static const int MaxQuietWaits = 8;
+
+  for (;;)
+  {
+    int status =
+      wait (-1);
+
+    if (status < 0)
+      break;
+
+    {
+      std::lock_guard <std::mutex> guard (lock_);
+      stats_.wakeups++;
+    }
+
+    for (int i = 0; i < MaxQuietWaits && status > 0; i++)
+      status = wait ((int)debounce_ms_);
+
+    if (status < 0)
+      break;
+
+    scan ();
+  }
+}
+
+void
+unx::ConfigWatcher::scan (void)
+{
+  std::vector <uint8_t> data;
+
+  for (size_t i = 0; i < files_.size (); i++)
+  {
+    const bool     exists = unx::INIFile::read_file (files_ [i].path.c_str (), data);
+    const uint64_t hash   = Hash (data.data (), data.size ());
+
+    {
+      std::lock_guard <std::mutex> guard (lock_);
+
+      file_s& file = files_ [i];
+
+      if (! exists)
+      {
+        // Deleted (or mid-replace); whatever comes back gets compared
+        //   against the last contents that were seen
+        continue;
+      }
+
+      if (file.exists && file.hash == hash)
+      {
+        file.writing = false;
+        continue;
+      }
+
+      // UnX's own write has not replaced the file yet
+      if (file.writing && file.before == hash)
+        continue;
+
+      file.exists  = true;
+      file.hash    = hash;
+      file.writing = false;
+      file.data.swap (data);
+      file.pending = true;
+
+      stats_.changed++;
+    }
+
+    changed_ (i);
+  }
+}
+
+void
+unx::ConfigWatcher::expect (const std::wstring& path, const std::vector <uint8_t>& data)
+{
+  std::lock_guard <std::mutex> guard (lock_);
+
+  const size_t idx =
+    find (path);
+
+  if (idx == (size_t)-1)
+    return;
+
+  file_s& file = files_ [idx];
+
+  if (! file.writing)
+  {
+    file.before  = file.hash;
+    file.writing = file.exists;
+  }
+
+  file.hash    = Hash (data.data (), data.size ());
+  file.exists  = true;
+
+  // An edit that was not picked up yet is about to be overwritten
+  file.pending = false;
+  file.data.clear ();
+
+  stats_.expected++;
+}
+
+bool
+unx::ConfigWatcher::take (size_t file, std::vector <uint8_t>& out)
+{
+  std::lock_guard <std::mutex> guard (lock_);
+
+  if (file >= files_.size () || (! files_ [file].pending))
+    return false;
+
+  out.swap (files_ [file].data);
+
+  files_ [file].data.clear ();
+  files_ [file].pending = false;
+
+  return true;
+}
+
+unx::ConfigWatcher::stats_s
+unx::ConfigWatcher::stats (void)
+{
+  std::lock_guard <std::mutex> guard (lock_);
+  return stats_;
+}
@@ -0,0 +1,121 @@
+/**
+ * This file is part of UnX.
+ *
+ * UnX is free software : you can redistribute it
+ * and/or modify it under the terms of the GNU General Public License
+ * as published by The Free Software Foundation, either version 3 of
+ * the License, or (at your option) any later version.
+ *
+ * UnX is distributed in the hope that it will be useful,
+ *
+ * But WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with UnX.
+ *
+ *   If not, see <http://www.gnu.org/licenses/>.
+ *
+**/
+#ifndef __UNX__CONFIGWATCH_H__
+#define __UNX__CONFIGWATCH_H__
+
+#include <cstdint>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+namespace unx
+{
+  //
+  // Watches a handful of config files for changes made by somebody else.
+  //
+  //   The directories holding them are watched (editors and UnX itself
+  //     replace files by renaming over them), and once things have been
+  //       quiet for the debounce period, every file whose contents hash
+  //         differently from last time is read and reported.
+  //
+  //   Writes UnX makes itself are announced through expect (), so that they
+  //     are not mistaken for edits and read back.
+  //
+  //   ReadDirectoryChanges would be overkill for three files; Windows uses
+  //     change notification handles, Linux inotify.
+  //
+  class ConfigWatcher
+  {
+  public:
+    // Called on the watcher thread; take () fetches what changed
+    using changed_fn = void (*)(size_t file);
+
+    explicit ConfigWatcher (changed_fn changed, uint32_t debounce_ms = 250);
+   ~ConfigWatcher (void);
+
+    ConfigWatcher            (const ConfigWatcher&) = delete;
+    ConfigWatcher& operator= (const ConfigWatcher&) = delete;
+
+    // Before start (); returns the id the file is reported by
+    size_t   add     (const std::wstring& path);
+
+    // Reads every file once (so that what is there now is not reported)
+    //   and starts watching; false if nothing could be watched.
+    bool     start   (void);
+
+    // Not safe under loader lock
+    void     stop    (void);
+
+    // Any thread; the contents of a file UnX is about to write. Until the
+    //   new contents show up, the old ones are not reported either.
+    void     expect  (const std::wstring& path, const std::vector <uint8_t>& data);
+
+    // Newest contents of a file that was reported; false if there is
+    //   nothing new since the last take ()
+    bool     take    (size_t file, std::vector <uint8_t>& out);
+
+    struct stats_s {
+      uint64_t wakeups  = 0;
+      uint64_t changed  = 0; // Reported
+      uint64_t expected = 0; // Written by UnX
+    };
+
+    stats_s  stats   (void);
+
+    static uint64_t Hash (const uint8_t* data, size_t len);
+
+  private:
+    struct file_s {
+      std::wstring          path;
+      uint64_t              hash    = 0;
+      bool                  exists  = false;
+
+      // Contents before an expected write, until that write lands
+      uint64_t              before  = 0;
+      bool                  writing = false;
+
+      std::vector <uint8_t> data;
+      bool                  pending = false;
+    };
+
+    void     run     (void);
+    int      wait    (int timeout_ms);
+    void     scan    (void);
+    size_t   find    (const std::wstring& path) const;
+
+    changed_fn                      changed_;
+    uint32_t                        debounce_ms_;
+
+    std::mutex                      lock_;
+    std::vector <file_s>            files_;
+    std::vector <std::wstring>      dirs_;
+    stats_s                         stats_;
+
+    // Platform wait object(s); see configwatch.cpp
+    struct backend_s;
+    backend_s*                      backend_ = nullptr;
+
+    std::thread                     thread_;
+  };
+}
+
+#endif /* __UNX__CONFIGWATCH_H__ */
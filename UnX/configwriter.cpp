@@ -0,0 +1,240 @@
+/**
+ * This file is part of UnX.
+ *
+ * UnX is free software : you can redistribute it
+ * and/or modify it under the terms of the GNU General Public License
+ * as published by The Free Software Foundation, either version 3 of
+ * the License, or (at your option) any later version.
+ *
+ * UnX is distributed in the hope that it will be useful,
+ *
+ * But WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with UnX.
+ *
+ *   If not, see <http://www.gnu.org/licenses/>.
+ *
+**/
+#include "configwriter.h"
+#include "threads.h"
+
+#include <algorithm>
+
+unx::ConfigWriter::ConfigWriter (write_fn write, uint32_t debounce_ms, uint32_t max_delay_ms) :
+  write_     (write),
+  debounce_  (debounce_ms),
+  max_delay_ (max_delay_ms)
+{
+}
+
+unx::ConfigWriter::~ConfigWriter (void)
+{
+  stop ();
+}
+
+void
+unx::ConfigWriter::queue (const std::wstring& path, std::vector <uint8_t> data)
+{
+  auto snapshot =
+    std::make_shared <const std::vector <uint8_t>> (std::move (data));
+
+  {
+    std::lock_guard <std::mutex> guard (lock_);
+
+    const clock::time_point now = clock::now ();
+
+    if (pending_.empty ())
+      first_ = now;
+
+    last_ = now;
+
+    auto it = pending_.find (path);
+
+    if (it != pending_.end ())
+    {
+      it->second.data       = std::move (snapshot);
+      it->second.generation = ++generation_;
+
+      stats_.coalesced++;
+    }
+
+    else
+      pending_.emplace (path, pending_s { std::move (snapshot), ++generation_ });
+
+    stats_.queued++;
+
+    if ((! thread_.joinable ()) && (! stopping_))
+      thread_ = std::thread (&ConfigWriter::run, this);
+  }
+
+  signal_.notify_one ();
+}
+
+bool
+unx::ConfigWriter::begin_io (std::unique_lock <std::mutex>& guard, std::chrono::milliseconds wait)
+{
+  if (! io_idle_.wait_for (guard, wait, [this] { return ! io_busy_; }))
+  {
+    // Writing alongside a live writer would share its temp file; only take
+    //   over if the writer thread is gone for good.
+    if (! (io_writer_ && ThreadHasExited (thread_, returned_)))
+      return false;
+  }
+
+  io_busy_   = true;
+  io_writer_ = false;
+
+  return true;
+}
+
+void
+unx::ConfigWriter::end_io (void)
+{
+  {
+    std::lock_guard <std::mutex> guard (lock_);
+    io_busy_   = false;
+    io_writer_ = false;
+  }
+
+  io_idle_.notify_all ();
+}
+
+// Caller has gone through begin_io
+size_t
+unx::ConfigWriter::write (void)
+{
+  std::map <std::wstring, pending_s> batch;
+
+  {
+    std::lock_guard <std::mutex> guard (lock_);
+    batch = pending_;
+  }
+
+  size_t written = 0;
+
+  for (const auto& it : batch)
+  {
+    const bool ok =
+      write_ (it.first, *it.second.data);
+
+    std::lock_guard <std::mutex> guard (lock_);
+
+    if (ok)
+    {
+      stats_.written++;
+      written++;
+
+      // Only forget it if nothing newer was queued in the meantime
+      auto cur = pending_.find (it.first);
+
+      if (cur != pending_.end () && cur->second.generation == it.second.generation)
+        pending_.erase (cur);
+    }
+
+    else
+      stats_.failed++;
+  }
+
+  return written;
+}
+
+size_t
+unx::ConfigWriter::flush (uint32_t flush_wait_ms)
+{
+  {
+    std::unique_lock <std::mutex> guard (lock_);
+
+    if (! begin_io (guard, std::chrono::milliseconds (flush_wait_ms)))
+      return 0;
+  }
+
+  const size_t written =
+    write ();
+
+  end_io ();
+
+  return written;
+}
+
+void
+unx::ConfigWriter::run (void)
+{
+  std::unique_lock <std::mutex> guard (lock_);
+
+  while (! stopping_)
+  {
+    if (pending_.empty ())
+    {
+      signal_.wait (guard);
+      continue;
+    }
+
+    // Quiet for the debounce period, or waited long enough already
+    const clock::time_point due =
+      std::min (last_ + debounce_, first_ + max_delay_);
+
+    if (clock::now () < due)
+    {
+      signal_.wait_until (guard, due);
+      continue;
+    }
+
+    // A flush () on another thread is writing; it will take care of it
+    if (io_busy_)
+    {
+      io_idle_.wait (guard);
+      continue;
+    }
+
+    begin_io (guard, std::chrono::milliseconds::zero ());
+    io_writer_ = true;
+
+    // Anything queued while this batch is written starts a new burst
+    first_ = last_ = clock::now ();
+
+    guard.unlock ();
+    write        ();
+    end_io       ();
+    guard.lock   ();
+
+    // A failed write stays queued; try again after another debounce period
+    //   instead of spinning on it.
+    if (! pending_.empty ())
+      first_ = last_ = clock::now ();
+  }
+
+  returned_ = true;
+}
+
+void
+unx::ConfigWriter::stop (void)
+{
+  {
+    std::lock_guard <std::mutex> guard (lock_);
+    stopping_ = true;
+  }
+
+  signal_.notify_all ();
+
+  if (thread_.joinable ())
+    thread_.join ();
+
+  flush ();
+}
+
+size_t
+unx::ConfigWriter::pending (void)
+{
+  std::lock_guard <std::mutex> guard (lock_);
+  return pending_.size ();
+}
+
+unx::ConfigWriter::stats_s
+unx::ConfigWriter::stats (void)
+{
+  std::lock_guard <std::mutex> guard (lock_);
+  return stats_;
+}
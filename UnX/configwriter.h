@@ -0,0 +1,121 @@
+/**
+ * This file is part of UnX.
+ *
+ * UnX is free software : you can redistribute it
+ * and/or modify it under the terms of the GNU General Public License
+ * as published by The Free Software Foundation, either version 3 of
+ * the License, or (at your option) any later version.
+ *
+ * UnX is distributed in the hope that it will be useful,
+ *
+ * But WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with UnX.
+ *
+ *   If not, see <http://www.gnu.org/licenses/>.
+ *
+**/
+#ifndef __UNX__CONFIGWRITER_H__
+#define __UNX__CONFIGWRITER_H__
+
+#include <chrono>
+#include <condition_variable>
+#include <cstdint>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+namespace unx
+{
+  //
+  // Debounced background file writer.
+  //
+  //   Callers hand over an immutable snapshot of a file's contents; the
+  //     writer waits until submissions have been quiet for the debounce
+  //       period (or max_delay has passed since the first one) and then
+  //         writes the newest snapshot of each file once.
+  //
+  //   A snapshot stays queued until it is on disk, so flush () can still
+  //     write it if the writer thread was killed mid-write (process exit).
+  //
+  class ConfigWriter
+  {
+  public:
+    using snapshot_t = std::shared_ptr <const std::vector <uint8_t>>;
+    using write_fn   = bool (*)(const std::wstring& path, const std::vector <uint8_t>& data);
+
+    ConfigWriter (write_fn write, uint32_t debounce_ms = 500, uint32_t max_delay_ms = 2000);
+   ~ConfigWriter (void);
+
+    ConfigWriter            (const ConfigWriter&) = delete;
+    ConfigWriter& operator= (const ConfigWriter&) = delete;
+
+    // Any thread; replaces whatever was still queued for the same path
+    void     queue   (const std::wstring& path, std::vector <uint8_t> data);
+
+    // Any thread; writes everything queued right now on the calling thread.
+    //   Returns the number of files written.
+    //
+    //   Waits at most flush_wait_ms for a write already in progress, then
+    //     gives up and returns 0, unless the writer thread was killed
+    //       mid-write (process exit) and will never finish it.
+    size_t   flush   (uint32_t flush_wait_ms = 2000);
+
+    // Stops the writer thread (after flushing); not safe under loader lock
+    void     stop    (void);
+
+    size_t   pending (void);
+
+    struct stats_s {
+      uint64_t queued    = 0;
+      uint64_t coalesced = 0; // Snapshots replaced before they were written
+      uint64_t written   = 0;
+      uint64_t failed    = 0;
+    };
+
+    stats_s  stats   (void);
+
+  private:
+    using clock = std::chrono::steady_clock;
+
+    struct pending_s {
+      snapshot_t data;
+      uint64_t   generation;
+    };
+
+    void     run     (void);
+    size_t   write   (void);
+    bool     begin_io(std::unique_lock <std::mutex>& guard, std::chrono::milliseconds wait);
+    void     end_io  (void);
+
+    write_fn                          write_;
+    std::chrono::milliseconds         debounce_;
+    std::chrono::milliseconds         max_delay_;
+
+    std::mutex                        lock_;
+    std::condition_variable           signal_;
+    std::map <std::wstring, pending_s>
+                                      pending_;
+    uint64_t                          generation_ = 0;
+    clock::time_point                 first_;
+    clock::time_point                 last_;
+    stats_s                           stats_;
+    bool                              stopping_   = false;
+
+    // Only one thread writes files at a time, or two could share a temp file
+    std::condition_variable           io_idle_;
+    bool                              io_busy_    = false;
+    bool                              io_writer_  = false; // io_busy_ is the writer thread's
+    bool                              returned_   = false; // run () is done
+
+    std::thread                       thread_;
+  };
+}
+
+#endif /* __UNX__CONFIGWRITER_H__ */
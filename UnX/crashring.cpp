@@ -0,0 +1,329 @@
+/**
+ * This file is part of UnX.
+ *
+ * UnX is free software : you can redistribute it
+ * and/or modify it under the terms of the GNU General Public License
+ * as published by The Free Software Foundation, either version 3 of
+ * the License, or (at your option) any later version.
+ *
+ * UnX is distributed in the hope that it will be useful,
+ *
+ * But WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with UnX.
+ *
+ *   If not, see <http://www.gnu.org/licenses/>.
+ *
+**/
+#include "crashring.h"
+#include "inifile.h"
+
+#include <algorithm>
+#include <cstdio>
+#include <cstring>
+#include <string>
+#include <utility>
+#include <vector>
+
+#ifdef _WIN32
+# include <Windows.h>
+#else
+# include <fcntl.h>
+# include <sys/mman.h>
+# include <unistd.h>
+#endif
+
+static const char     UNX_RingMagic [4] = { 'U', 'N', 'X', 'C' };
+static const uint32_t UNX_LineMagic     = 0x4C584E55; // "UNXL"
+
+static size_t
+UNX_RecordCells (uint32_t len)
+{
+  return ( sizeof (unx::CrashRing::record_s) + len * sizeof (wchar_t) +
+             unx::CrashRing::CellSize - 1 ) / unx::CrashRing::CellSize;
+}
+
+#ifndef _WIN32
+static std::string
+UNX_NarrowPath (const wchar_t* path)
+{
+  std::vector <uint8_t> narrow;
+  unx::INIFile::encode_utf8 (path, narrow);
+
+  return std::string (narrow.begin (), narrow.end ());
+}
+#endif
+
+
+bool
+unx::CrashRing::open (const wchar_t* path, size_t bytes)
+{
+  close (false);
+
+  if (bytes < CellSize * 2)
+    return false;
+
+  cells_ = bytes / CellSize - 1;
+  size_  = (size_t)(cells_ + 1) * CellSize;
+
+#ifdef _WIN32
+  HANDLE file =
+    CreateFileW ( path, GENERIC_READ | GENERIC_WRITE, FILE_SHARE_READ, nullptr,
+                    OPEN_ALWAYS, FILE_ATTRIBUTE_NORMAL, nullptr );
+
+  if (file == INVALID_HANDLE_VALUE)
+    return false;
+
+  // Grows (or keeps) the file to exactly size_ bytes
+  LARGE_INTEGER end;
+  end.QuadPart = (LONGLONG)size_;
+
+  SetFilePointerEx (file, end, nullptr, FILE_BEGIN);
+  SetEndOfFile     (file);
+
+  HANDLE map =
+    CreateFileMappingW (file, nullptr, PAGE_READWRITE, 0, (DWORD)size_, nullptr);
+
+  void* view = map != nullptr ?
+    MapViewOfFile (map, FILE_MAP_ALL_ACCESS, 0, 0, size_) : nullptr;
+
+  if (view == nullptr)
+  {
+    if (map != nullptr)
+      CloseHandle (map);
+
+    CloseHandle (file);
+
+    return false;
+  }
+
+  file_ = file;
+  map_  = map;
+#else
+  int fd =
+    ::open (UNX_NarrowPath (path).c_str (), O_RDWR | O_CREAT, 0644);
+
+  if (fd < 0)
+    return false;
+
+  void* view = ftruncate (fd, (off_t)size_) == 0 ?
+    mmap (nullptr, size_, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0) : MAP_FAILED;
+
+  if (view == MAP_FAILED)
+  {
+    ::close (fd);
+    return false;
+  }
+
+  fd_ = fd;
+#endif
+
+  view_   = (uint8_t  *)view;
+  data_   = view_ + CellSize;
+  header_ = (header_s *)view_;
+
+  const bool compatible =
+    memcmp (header_->magic, UNX_RingMagic, 4) == 0 &&
+    header_->version   == Version                  &&
+    header_->char_size == sizeof (wchar_t)         &&
+    header_->cells     == cells_;
+
+  // New, resized or from some other build; nothing in it can be trusted
+  if (! compatible)
+  {
+    memset (view_, 0, size_);
+    memcpy (header_->magic, UNX_RingMagic, 4);
+
+    header_->version   = Version;
+    header_->char_size = sizeof (wchar_t);
+    header_->cells     = (uint32_t)cells_;
+    header_->head.store (0);
+  }
+
+  header_->session = header_->head.load ();
+  header_->clean   = 0;
+
+  return true;
+}
+
+void
+unx::CrashRing::copy_in (uint64_t pos, size_t offset, const void* src, size_t len)
+{
+  const size_t total = (size_t)cells_ * CellSize;
+  const size_t start = ((size_t)(pos % cells_) * CellSize + offset) % total;
+  const size_t first = std::min (len, total - start);
+
+  memcpy (data_ + start, src,                          first);
+  memcpy (data_,         (const uint8_t *)src + first, len - first);
+}
+
+bool
+unx::CrashRing::write (const wchar_t* text, size_t len)
+{
+  if (view_ == nullptr)
+    return false;
+
+  const size_t max_len =
+    ((size_t)cells_ * CellSize - sizeof (record_s)) / sizeof (wchar_t);
+
+  if (len > max_len)
+      len = max_len;
+
+  const uint64_t pos =
+    header_->head.fetch_add (UNX_RecordCells ((uint32_t)len), std::memory_order_relaxed);
+
+  record_s* rec = (record_s *)cell (pos);
+
+  rec->magic = UNX_LineMagic;
+  rec->len   = (uint32_t)len;
+
+  copy_in (pos, sizeof (record_s), text, len * sizeof (wchar_t));
+
+  rec->pos.store (pos, std::memory_order_release);
+
+  return true;
+}
+
+void
+unx::CrashRing::close (bool clean)
+{
+  if (view_ == nullptr)
+    return;
+
+  header_->clean = clean ? 1 : 0;
+
+#ifdef _WIN32
+  UnmapViewOfFile (view_);
+  CloseHandle     ((HANDLE)map_);
+  CloseHandle     ((HANDLE)file_);
+
+  map_  = nullptr;
+  file_ = nullptr;
+#else
+  munmap  (view_, size_);
+  ::close (fd_);
+
+  fd_ = -1;
+#endif
+
+  view_   = nullptr;
+  data_   = nullptr;
+  header_ = nullptr;
+}
+
+
+size_t
+unx::CrashRing::Recover (const wchar_t* ring_path, const wchar_t* text_path)
+{
+#ifdef _WIN32
+  FILE* in = _wfopen (ring_path, L"rb");
+#else
+  FILE* in = fopen (UNX_NarrowPath (ring_path).c_str (), "rb");
+#endif
+
+  if (in == nullptr)
+    return 0;
+
+  std::vector <uint8_t> file;
+  uint8_t               chunk [65536];
+  size_t                read;
+
+  while ((read = fread (chunk, 1, sizeof chunk, in)) > 0)
+    file.insert (file.end (), chunk, chunk + read);
+
+  fclose (in);
+
+  if (file.size () < CellSize * 2)
+    return 0;
+
+  // A plain copy of the mapping; read the header without its atomic
+  char     magic [4];
+  uint16_t version;
+  uint8_t  char_size, clean;
+  uint32_t cells;
+  uint64_t session, head;
+
+  memcpy (magic,      &file [offsetof (header_s, magic)],     4);
+  memcpy (&version,   &file [offsetof (header_s, version)],   sizeof version);
+  memcpy (&char_size, &file [offsetof (header_s, char_size)], sizeof char_size);
+  memcpy (&clean,     &file [offsetof (header_s, clean)],     sizeof clean);
+  memcpy (&cells,     &file [offsetof (header_s, cells)],     sizeof cells);
+  memcpy (&session,   &file [offsetof (header_s, session)],   sizeof session);
+  memcpy (&head,      &file [offsetof (header_s, head)],      sizeof head);
+
+  if ( memcmp (magic, UNX_RingMagic, 4) != 0 || version != Version ||
+       char_size != sizeof (wchar_t)          || cells   == 0       ||
+       file.size () < ((size_t)cells + 1) * CellSize || clean )
+    return 0;
+
+  const uint8_t* data  = file.data () + CellSize;
+  const size_t   total = (size_t)cells * CellSize;
+
+  //
+  // Only cells handed out since the session started and not yet reused
+  //   can hold a line; a stale header anywhere else is from an older lap.
+  //
+  const uint64_t oldest =
+    std::max (session, head > cells ? head - cells : 0);
+
+  std::vector <std::pair <uint64_t, uint32_t>> lines; // (pos, len)
+
+  for (uint32_t i = 0; i < cells; i++)
+  {
+    uint32_t magic_, len;
+    uint64_t pos;
+
+    memcpy (&magic_, data + (size_t)i * CellSize + offsetof (record_s, magic), sizeof magic_);
+    memcpy (&len,    data + (size_t)i * CellSize + offsetof (record_s, len),   sizeof len);
+    memcpy (&pos,    data + (size_t)i * CellSize + offsetof (record_s, pos),   sizeof pos);
+
+    if ( magic_     != UNX_LineMagic || pos % cells != i ||
+         pos        <  oldest        || pos         >= head )
+      continue;
+
+    if ( len > (total - sizeof (record_s)) / sizeof (wchar_t) ||
+         pos + UNX_RecordCells (len) > head )
+      continue;
+
+    lines.emplace_back (pos, len);
+  }
+
+  if (lines.empty ())
+    return 0;
+
+  std::sort (lines.begin (), lines.end ());
+
+  std::vector <uint8_t> out;
+  std::wstring          text;
+
+  for (const auto& [pos, len] : lines)
+  {
+    const size_t start = ((size_t)(pos % cells) * CellSize + sizeof (record_s)) % total;
+    const size_t bytes = len * sizeof (wchar_t);
+    const size_t first = std::min (bytes, total - start);
+
+    text.resize (len);
+
+    memcpy ((uint8_t *)text.data (),         data + start, first);
+    memcpy ((uint8_t *)text.data () + first, data,         bytes - first);
+
+    unx::INIFile::encode_utf8 (text, out);
+  }
+
+#ifdef _WIN32
+  FILE* dst = _wfopen (text_path, L"wb");
+#else
+  FILE* dst = fopen (UNX_NarrowPath (text_path).c_str (), "wb");
+#endif
+
+  if (dst == nullptr)
+    return 0;
+
+  fwrite (out.data (), 1, out.size (), dst);
+  fclose (dst);
+
+  return lines.size ();
+}
@@ -0,0 +1,122 @@
+/**
+ * This file is part of UnX.
+ *
+ * UnX is free software : you can redistribute it
+ * and/or modify it under the terms of the GNU General Public License
+ * as published by The Free Software Foundation, either version 3 of
+ * the License, or (at your option) any later version.
+ *
+ * UnX is distributed in the hope that it will be useful,
+ *
+ * But WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with UnX.
+ *
+ *   If not, see <http://www.gnu.org/licenses/>.
+ *
+**/
+#ifndef __UNX__CRASHRING_H__
+#define __UNX__CRASHRING_H__
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+
+//
+// Crash-resilient copy of the most recent log lines.
+//
+//   A fixed-size file mapped into memory and used as a ring. Lines are
+//     copied into the mapping, nothing else; once the copy is done the
+//       line belongs to the OS, which writes it out even if the process
+//         dies right after (a crash, or fast exit's TerminateProcess). No
+//           fflush, no syscall, no lock.
+//
+//   Space is handed out in 64-byte cells by a single fetch_add on a counter
+//     that lives in the file. A record is committed by storing its absolute
+//       cell index in its header last, so a line that was being written when
+//         the process died is simply not there afterwards.
+//
+//   Only lines of the current session count; on a clean exit close () marks
+//     the file so the next start knows there is nothing to recover.
+//
+//   A writer stalled for as long as it takes everyone else to go all the
+//     way around the ring can garble a newer line; at 1 MiB that is some
+//       thousands of lines, far more than this DLL logs in one go.
+//
+namespace unx
+{
+  class CrashRing
+  {
+  public:
+    static const size_t   CellSize    = 64;
+    static const size_t   DefaultSize = 1024 * 1024;  // Bytes, header included
+    static const uint16_t Version     = 1;
+
+    CrashRing (void) = default;
+   ~CrashRing (void) { close (false); }
+
+    CrashRing            (const CrashRing&) = delete;
+    CrashRing& operator= (const CrashRing&) = delete;
+
+    // Starts a new session; lines from the last one are overwritten from here on
+    bool   open  (const wchar_t* path, size_t bytes = DefaultSize);
+
+    // Any thread, never blocks; lines longer than the ring are cut
+    bool   write (const wchar_t* text, size_t len);
+
+    // clean = the same lines made it into the real log
+    void   close (bool clean = true);
+
+    bool   is_open (void) const { return view_ != nullptr; }
+
+    //
+    // Writes the lines of the last session to text_path (UTF-8), if it did
+    //   not end with close (true). Call before open, which starts over.
+    //     Returns the number of lines recovered.
+    //
+    static size_t Recover (const wchar_t* ring_path, const wchar_t* text_path);
+
+    struct header_s {
+      char                   magic [4];     // "UNXC"
+      uint16_t               version;
+      uint8_t                char_size;     // sizeof (wchar_t) of the writer
+      uint8_t                clean;
+      uint32_t               cells;         // After the header
+      uint32_t               reserved;
+      uint64_t               session;       // First cell of this session
+      std::atomic <uint64_t> head;          // Cells handed out, ever
+    };
+
+    struct record_s {
+      uint32_t               magic;         // 'UNXL'
+      uint32_t               len;           // Characters
+      std::atomic <uint64_t> pos;           // Absolute cell index; stored last
+    };
+
+    static_assert ( sizeof (header_s) <= CellSize, "Header must fit in a cell" );
+    static_assert ( std::atomic <uint64_t>::is_always_lock_free,
+                      "Ring counters are shared through a file mapping" );
+
+  private:
+    uint8_t* cell    (uint64_t pos) const { return data_ + (pos % cells_) * CellSize; }
+    void     copy_in (uint64_t pos, size_t offset, const void* src, size_t len);
+
+    uint8_t*  view_   = nullptr;
+    uint8_t*  data_   = nullptr;
+    header_s* header_ = nullptr;
+    uint64_t  cells_  = 0;
+    size_t    size_   = 0;
+
+#ifdef _WIN32
+    void*     file_   = nullptr;  // HANDLE
+    void*     map_    = nullptr;
+#else
+    int       fd_     = -1;
+#endif
+  };
+}
+
+#endif /* __UNX__CRASHRING_H__ */
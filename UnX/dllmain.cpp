@@ -23,6 +23,7 @@
 #include <comdef.h>
 
 #include "config.h"
+#include "ini.h"
 #include "log.h"
 #include "hook.h"
 #include "command.h"
@@ -87,6 +88,9 @@ DeferredDllMain (       HMODULE  hModSpecialK,
   //   for debug purposes.
   config.system.injector = injector_name;
 
+  if (config.system.binary_log)
+    UNX_OpenTrace (L"logs/UnX.trace");
+
 
   SKX_SetPluginName = 
     (SKX_SetPluginName_pfn)
@@ -119,6 +123,11 @@ DeferredDllMain (       HMODULE  hModSpecialK,
     unx::InputManager::Init    ();
     unx::WindowManager::Init   ();
 
+    // Everything that reads the config is set up; remember what it came to
+    //   for the next start, and pick up edits from here on
+    UNX_SaveConfigSnapshot ();
+    UNX_WatchConfig        ();
+
     if (MH_OK == UNX_ApplyQueuedHooks ())
       return TRUE;
   }
@@ -170,6 +179,10 @@ DllMain (HMODULE hModule,
         UNX_UnInit_MinHook ();
         UNX_SaveConfig     ();
 
+        // Anything the control panel queued that did not make it out yet
+        UNX_FlushINIWrites ();
+        UNX_CloseTrace     ();
+
         dll_log->LogEx ( false, L"============ (Version: v %s) "
                                 L"============\n",
                                   UNX_VER_STR.c_str () );
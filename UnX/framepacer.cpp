@@ -0,0 +1,74 @@
+/**
+ * This file is part of UnX.
+ *
+ * UnX is free software : you can redistribute it
+ * and/or modify it under the terms of the GNU General Public License
+ * as published by The Free Software Foundation, either version 3 of
+ * the License, or (at your option) any later version.
+ *
+ * UnX is distributed in the hope that it will be useful,
+ *
+ * But WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with UnX.
+ *
+ *   If not, see <http://www.gnu.org/licenses/>.
+ *
+**/
+#include "framepacer.h"
+
+uint64_t
+unx::FramePacer::pace (float fps)
+{
+  if (fps <= 0.0f)
+  {
+    reset ();
+    return 0;
+  }
+
+  const uint64_t interval =
+    (uint64_t)(1000000.0 / (double)fps + 0.5);
+
+  if (interval != interval_)
+  {
+    interval_ = interval;
+    reset ();
+  }
+
+  const uint64_t start = clock_->now ();
+        uint64_t now   = start;
+
+  // First frame of a new schedule goes out immediately
+  if (next_ == 0)
+  {
+    next_ = now + interval_;
+    return 0;
+  }
+
+  // Already late; if it is by more than a whole frame, start over from now
+  //   rather than letting a burst of frames through to catch up.
+  if (now >= next_)
+  {
+    next_ = (now - next_ > interval_) ? now   + interval_ :
+                                        next_ + interval_;
+    return 0;
+  }
+
+  while (now < next_)
+  {
+    if (! clock_->sleep (next_))
+    {
+      reset ();
+      return clock_->now () - start;
+    }
+
+    now = clock_->now ();
+  }
+
+  next_ += interval_;
+
+  return now - start;
+}
@@ -0,0 +1,62 @@
+/**
+ * This file is part of UnX.
+ *
+ * UnX is free software : you can redistribute it
+ * and/or modify it under the terms of the GNU General Public License
+ * as published by The Free Software Foundation, either version 3 of
+ * the License, or (at your option) any later version.
+ *
+ * UnX is distributed in the hope that it will be useful,
+ *
+ * But WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with UnX.
+ *
+ *   If not, see <http://www.gnu.org/licenses/>.
+ *
+**/
+#ifndef __UNX__FRAMEPACER_H__
+#define __UNX__FRAMEPACER_H__
+
+#include <cstdint>
+
+namespace unx
+{
+  //
+  // Caps the rate at which pace () returns.
+  //
+  //   Time comes from an injected clock so the scheduling can be driven by a
+  //     simulated one; the Win32 clock lives with the present hook.
+  //
+  class FramePacer
+  {
+  public:
+    struct clock_s {
+      // Microseconds, monotonic
+      virtual uint64_t now   (void)           = 0;
+
+      // Wait until (or shortly before) the deadline; false if interrupted
+      virtual bool     sleep (uint64_t until) = 0;
+    };
+
+    explicit FramePacer (clock_s* clock) : clock_ (clock) { }
+
+    // Call once per frame; returns the number of microseconds spent waiting.
+    //   fps <= 0 means unlimited.
+    uint64_t pace  (float fps);
+
+    // Drop the schedule so the next call to pace () starts a new one; done
+    //   whenever the limit stops applying and on interruption.
+    void     reset (void) { next_ = 0; }
+
+  private:
+    clock_s* clock_;
+    uint64_t interval_ = 0;
+    uint64_t next_     = 0;  // Deadline of the next frame, 0 = unscheduled
+  };
+}
+
+#endif /* __UNX__FRAMEPACER_H__ */
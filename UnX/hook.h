@@ -21,6 +21,10 @@
 #ifndef __UNX__HOOK_H__
 #define __UNX__HOOK_H__
 
+#include <cstddef>
+#include <cstdint>
+#include <type_traits>
+
 // MinHook Error Codes.
 typedef enum MH_STATUS
 {
@@ -129,4 +133,24 @@ extern void*
 __stdcall
 UNX_ScanAlignedEx (const void* pattern, size_t len, const void* mask, void* after = nullptr, int align = 1);
 
+
+//
+// What SK's "mem <type> <offset> <value>" console command does, without the
+//   console: offset is relative to the executable's base address, and the
+//     page is unprotected for the write (so code can be patched as well).
+//
+void
+__stdcall
+UNX_WriteMemory (uintptr_t offset, const void* data, size_t len);
+
+template <typename _T>
+void
+UNX_WriteMem (uintptr_t offset, _T value)
+{
+  static_assert ( std::is_trivially_copyable <_T>::value,
+                    "UNX_WriteMem writes the bytes of the value as-is" );
+
+  UNX_WriteMemory (offset, &value, sizeof (_T));
+}
+
 #endif /* __UNX__HOOK_H__ */
\ No newline at end of file
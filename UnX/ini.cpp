@@ -23,31 +23,409 @@
 #include <windows.h>
 
 #include "ini.h"
-iSK_INI*
-__stdcall
-UNX_CreateINI (const wchar_t* const wszName)
+#include "inifile.h"
+#include "configwriter.h"
+
+#include <atomic>
+#include <cstdarg>
+#include <deque>
+
+class UNX_INI;
+
+class UNX_INISection : public iSK_INISection
+{
+public:
+  UNX_INISection (UNX_INI* ini, unx::INIFile::section_id id) : ini_ (ini),
+                                                                id_  (id) { }
+
+  /*** IUnknown methods ***/
+  STDMETHOD  (       QueryInterface)(THIS_ REFIID riid, void** ppvObj) override;
+  STDMETHOD_ (ULONG, AddRef)        (THIS) override;
+  STDMETHOD_ (ULONG, Release)       (THIS) override;
+
+  STDMETHOD_ (std::wstring&, get_value)    (const wchar_t* key) override;
+  STDMETHOD_ (void,          set_name)     (const wchar_t* name_) override;
+  STDMETHOD_ (bool,          contains_key) (const wchar_t* key) override;
+  STDMETHOD_ (void,          add_key_value)(const wchar_t* key, const wchar_t* value) override;
+  STDMETHOD_ (bool,          remove_key)   (const wchar_t* key) override;
+  STDMETHOD_ (bool,          set_value)    (const wchar_t* key, const wchar_t* value) override;
+
+private:
+  UNX_INI*                 ini_;
+  unx::INIFile::section_id id_;
+
+  // Handed out for keys that do not exist, the way SK did
+  std::wstring             invalid_;
+};
+
+class UNX_INI : public iSK_INI
 {
-  extern HMODULE hInjectorDLL;
+public:
+  // Nothing is read until somebody looks at the contents; a startup that
+  //   gets its settings from the config snapshot never needs them.
+  UNX_INI (const wchar_t* filename) : name_ (filename) { }
 
-  using  SK_CreateINI_pfn = iSK_INI* (__stdcall *)(const wchar_t* const wszName);
-  static SK_CreateINI_pfn SK_CreateINI = nullptr;
+  /*** IUnknown methods ***/
+  STDMETHOD  (       QueryInterface)(THIS_ REFIID riid, void** ppvObj) override;
+  STDMETHOD_ (ULONG, AddRef)        (THIS) override;
+  STDMETHOD_ (ULONG, Release)       (THIS) override;
 
-  if (SK_CreateINI == nullptr)
+  STDMETHOD_ (void, parse)  (THIS) override;
+  STDMETHOD_ (void, import) (THIS_ const wchar_t* import_data) override;
+  STDMETHOD_ (void, write)  (THIS_ const wchar_t* fname) override;
+
+  STDMETHOD_ (_TSectionMap&,   get_sections)    (THIS) override;
+  STDMETHOD_ (iSK_INISection&, get_section)     (const wchar_t* section) override;
+  STDMETHOD_ (bool,            contains_section)(const wchar_t* section) override;
+  STDMETHOD_ (bool,            remove_section)  (const wchar_t* section) override;
+
+  STDMETHOD_ (iSK_INISection&, get_section_f)   ( THIS_ _In_z_ _Printf_format_string_
+                                                  wchar_t const* const _Format,
+                                                                       ... ) override;
+  STDMETHOD_ (const wchar_t*,  get_filename)    (THIS) const override;
+
+  unx::INIFile& file (void)
   {
-    SK_CreateINI =
-      (SK_CreateINI_pfn)
-        GetProcAddress (
-          hInjectorDLL,
-            "SK_CreateINI"
-        );
+    if (! loaded_)
+      parse ();
+
+    return file_;
   }
 
-  iSK_INI* pINI = SK_CreateINI (wszName);
+  void          queue_write (const wchar_t* fname);
+  void          reload      (const std::vector <uint8_t>& data);
 
-  if (pINI != nullptr) {
-    return pINI;
-  } else {
-    // ASSERT: WHAT THE HELL?!
-    return nullptr;
+private:
+  iSK_INISection& wrap (unx::INIFile::section_id id);
+
+  std::wstring                   name_;
+  unx::INIFile                   file_;
+
+  // One wrapper per engine section id. parse () and reload () drop them
+  //   along with every string get_value () has handed out, so neither an
+  //     iSK_INISection& nor a get_value () reference may be held across a
+  //       (hot) reload; look them up again instead.
+  std::deque  <UNX_INISection>   wrappers_;
+  std::vector <iSK_INISection *> ordered_;
+
+  bool                           loaded_ = false;
+
+  volatile LONG                  refs_   = 1;
+};
+
+
+HRESULT
+STDMETHODCALLTYPE
+UNX_INISection::QueryInterface (REFIID riid, void** ppvObj)
+{
+  if (IsEqualGUID (riid, IID_SK_INISection) || IsEqualGUID (riid, IID_IUnknown))
+  {
+    AddRef ();
+    *ppvObj = this;
+
+    return S_OK;
   }
-}
\ No newline at end of file
+
+  return E_NOINTERFACE;
+}
+
+// Sections belong to their file
+ULONG STDMETHODCALLTYPE UNX_INISection::AddRef  (void) { return ini_->AddRef  (); }
+ULONG STDMETHODCALLTYPE UNX_INISection::Release (void) { return ini_->Release (); }
+
+std::wstring&
+STDMETHODCALLTYPE
+UNX_INISection::get_value (const wchar_t* key)
+{
+  std::wstring* val =
+    ini_->file ().value_ref (id_, key);
+
+  if (val != nullptr)
+    return *val;
+
+  invalid_.clear ();
+
+  return invalid_;
+}
+
+void
+STDMETHODCALLTYPE
+UNX_INISection::set_name (const wchar_t* name_)
+{
+  ini_->file ().rename_section (id_, name_);
+}
+
+bool
+STDMETHODCALLTYPE
+UNX_INISection::contains_key (const wchar_t* key)
+{
+  return ini_->file ().contains_key (id_, key);
+}
+
+void
+STDMETHODCALLTYPE
+UNX_INISection::add_key_value (const wchar_t* key, const wchar_t* value)
+{
+  ini_->file ().add_key_value (id_, key, value);
+}
+
+bool
+STDMETHODCALLTYPE
+UNX_INISection::remove_key (const wchar_t* key)
+{
+  return ini_->file ().remove_key (id_, key);
+}
+
+bool
+STDMETHODCALLTYPE
+UNX_INISection::set_value (const wchar_t* key, const wchar_t* value)
+{
+  return ini_->file ().set_value (id_, key, value);
+}
+
+
+HRESULT
+STDMETHODCALLTYPE
+UNX_INI::QueryInterface (REFIID riid, void** ppvObj)
+{
+  if (IsEqualGUID (riid, IID_SK_INI) || IsEqualGUID (riid, IID_IUnknown))
+  {
+    AddRef ();
+    *ppvObj = this;
+
+    return S_OK;
+  }
+
+  return E_NOINTERFACE;
+}
+
+ULONG
+STDMETHODCALLTYPE
+UNX_INI::AddRef (void)
+{
+  return InterlockedIncrement (&refs_);
+}
+
+ULONG
+STDMETHODCALLTYPE
+UNX_INI::Release (void)
+{
+  ULONG refs =
+    InterlockedDecrement (&refs_);
+
+  if (refs == 0)
+    delete this;
+
+  return refs;
+}
+
+void
+STDMETHODCALLTYPE
+UNX_INI::parse (void)
+{
+  loaded_ = true;
+
+  wrappers_.clear ();
+  file_.load      (name_.c_str ());
+}
+
+void
+STDMETHODCALLTYPE
+UNX_INI::import (const wchar_t* import_data)
+{
+  file ().import (import_data);
+}
+
+static std::atomic <UNX_INIWriteHook_pfn> write_hook { nullptr };
+
+static bool
+UNX_WriteINIData (const wchar_t* path, const std::vector <uint8_t>& data)
+{
+  const UNX_INIWriteHook_pfn hook =
+    write_hook.load (std::memory_order_acquire);
+
+  if (hook != nullptr)
+      hook (path, data);
+
+  return unx::INIFile::write_file (path, data);
+}
+
+//
+// Never destroyed; its thread may still be parked when the DLL detaches, and
+//   joining it under the loader lock would deadlock.
+//
+static unx::ConfigWriter*
+UNX_GetINIWriter (void)
+{
+  // Cheap to create; the thread only starts with the first queued write
+  static unx::ConfigWriter* writer =
+    new unx::ConfigWriter (
+      [](const std::wstring& path, const std::vector <uint8_t>& data) -> bool
+      {
+        return UNX_WriteINIData (path.c_str (), data);
+      }
+    );
+
+  return writer;
+}
+
+void
+STDMETHODCALLTYPE
+UNX_INI::write (const wchar_t* fname)
+{
+  // Anything still queued is older than what is about to be written
+  UNX_FlushINIWrites ();
+
+  // Saving back to where it came from can be skipped if nothing changed;
+  //   anywhere else gets a full copy.
+  const bool same_file =
+    (! _wcsicmp (fname, name_.c_str ()));
+
+  // Never loaded, so nothing can have changed
+  if (same_file && ((! loaded_) || (! file_.dirty ())))
+    return;
+
+  if (UNX_WriteINIData (fname, file ().serialize ()) && same_file)
+    file_.mark_clean ();
+}
+
+void
+UNX_INI::queue_write (const wchar_t* fname)
+{
+  if (fname == nullptr)
+      fname = name_.c_str ();
+
+  if (! _wcsicmp (fname, name_.c_str ()))
+  {
+    if ((! loaded_) || (! file_.dirty ()))
+      return;
+
+    UNX_GetINIWriter ()->queue (fname, file_.serialize ());
+
+    file_.mark_clean ();
+  }
+
+  else
+    UNX_GetINIWriter ()->queue (fname, file ().serialize ());
+}
+
+void
+UNX_INI::reload (const std::vector <uint8_t>& data)
+{
+  loaded_ = true;
+
+  wrappers_.clear ();
+  file_.parse     (data.data (), data.size ());
+}
+
+iSK_INISection&
+UNX_INI::wrap (unx::INIFile::section_id id)
+{
+  while (wrappers_.size () <= id)
+    wrappers_.emplace_back (this, (unx::INIFile::section_id)wrappers_.size ());
+
+  return wrappers_ [id];
+}
+
+iSK_INI::_TSectionMap&
+STDMETHODCALLTYPE
+UNX_INI::get_sections (void)
+{
+  ordered_.clear ();
+
+  for (auto id : file ().sections ())
+    ordered_.push_back (&wrap (id));
+
+  return ordered_;
+}
+
+iSK_INISection&
+STDMETHODCALLTYPE
+UNX_INI::get_section (const wchar_t* section)
+{
+  return wrap (file ().get_section (section));
+}
+
+bool
+STDMETHODCALLTYPE
+UNX_INI::contains_section (const wchar_t* section)
+{
+  return file ().find_section (section) != unx::INIFile::npos;
+}
+
+bool
+STDMETHODCALLTYPE
+UNX_INI::remove_section (const wchar_t* section)
+{
+  return file ().remove_section (section);
+}
+
+iSK_INISection&
+STDMETHODCALLTYPE
+UNX_INI::get_section_f ( _In_z_ _Printf_format_string_
+                         wchar_t const* const _Format,
+                                              ... )
+{
+  wchar_t wszFormatted [128] = { };
+
+  va_list   _ArgList;
+  va_start (_ArgList, _Format);
+  _vsnwprintf_s (wszFormatted, _TRUNCATE, _Format, _ArgList);
+  va_end   (_ArgList);
+
+  return get_section (wszFormatted);
+}
+
+const wchar_t*
+STDMETHODCALLTYPE
+UNX_INI::get_filename (void) const
+{
+  return name_.c_str ();
+}
+
+
+iSK_INI*
+__stdcall
+UNX_CreateINI (const wchar_t* const wszName)
+{
+  return new UNX_INI (wszName);
+}
+
+unx::INIFile*
+UNX_GetINIFile (iSK_INI* pINI)
+{
+  return pINI != nullptr ? &static_cast <UNX_INI *> (pINI)->file () : nullptr;
+}
+
+void
+UNX_SaveINIAsync (iSK_INI* pINI, const wchar_t* fname)
+{
+  // Every iSK_INI in UnX comes from UNX_CreateINI
+  if (pINI != nullptr)
+    static_cast <UNX_INI *> (pINI)->queue_write (fname);
+}
+
+void
+UNX_ReloadINI (iSK_INI* pINI, const std::vector <uint8_t>& data)
+{
+  if (pINI != nullptr)
+    static_cast <UNX_INI *> (pINI)->reload (data);
+}
+
+void
+UNX_WriteFileAsync (const wchar_t* path, std::vector <uint8_t> data)
+{
+  UNX_GetINIWriter ()->queue (path, std::move (data));
+}
+
+void
+UNX_FlushINIWrites (void)
+{
+  UNX_GetINIWriter ()->flush ();
+}
+
+void
+UNX_SetINIWriteHook (UNX_INIWriteHook_pfn hook)
+{
+  write_hook.store (hook, std::memory_order_release);
+}
@@ -21,8 +21,8 @@
 #ifndef __UNX__INI_H__
 #define __UNX__INI_H__
 
+#include <cstdint>
 #include <string>
-#include <unordered_map>
 #include <vector>
 
 #include <Unknwnbase.h>
@@ -31,33 +31,26 @@
 static const GUID IID_SK_INISection = 
 { 0xb526d074, 0x2f4d, 0x4bae, { 0xb6, 0xec, 0x11, 0xcb, 0x37, 0x79, 0xb1, 0x99 } };
 
+//
+// Same interfaces Special K exposes through SK_CreateINI (method order is
+//   kept), but UnX now provides its own implementation; see ini.cpp.
+//
 interface iSK_INISection : public IUnknown
 {
-public:
-  iSK_INISection (void) = default;
-
-  iSK_INISection (const wchar_t* section_name) {
-    name = section_name;
-  }
-
   /*** IUnknown methods ***/
-  STDMETHOD  (       QueryInterface)(THIS_ REFIID riid, void** ppvObj);
-  STDMETHOD_ (ULONG, AddRef)        (THIS);
-  STDMETHOD_ (ULONG, Release)       (THIS);
-
-  STDMETHOD_ (std::wstring&, get_value)    (const wchar_t* key);
-  STDMETHOD_ (void,          set_name)     (const wchar_t* name_);
-  STDMETHOD_ (bool,          contains_key) (const wchar_t* key);
-  STDMETHOD_ (void,          add_key_value)(const wchar_t* key, const wchar_t* value);
-  STDMETHOD_ (bool,          remove_key)   (const wchar_t* key);
-
-  //protected:
-  //private:
-  std::wstring                                    name;
-  std::unordered_map <std::wstring, std::wstring> keys;
-  std::vector        <std::wstring>               ordered_keys;
-
-  ULONG                                           refs = 0;
+  STDMETHOD  (       QueryInterface)(THIS_ REFIID riid, void** ppvObj) PURE;
+  STDMETHOD_ (ULONG, AddRef)        (THIS) PURE;
+  STDMETHOD_ (ULONG, Release)       (THIS) PURE;
+
+  STDMETHOD_ (std::wstring&, get_value)    (const wchar_t* key) PURE;
+  STDMETHOD_ (void,          set_name)     (const wchar_t* name_) PURE;
+  STDMETHOD_ (bool,          contains_key) (const wchar_t* key) PURE;
+  STDMETHOD_ (void,          add_key_value)(const wchar_t* key, const wchar_t* value) PURE;
+  STDMETHOD_ (bool,          remove_key)   (const wchar_t* key) PURE;
+
+  // UnX only: adds or overwrites, and marks the section dirty if the value
+  //   changed (returns false if it did not)
+  STDMETHOD_ (bool,          set_value)    (const wchar_t* key, const wchar_t* value) PURE;
 };
 
 // {DD2B1E00-6C14-4659-8B45-FCEF1BC2C724}
@@ -66,62 +59,61 @@ static const GUID IID_SK_INI =
 
 interface iSK_INI : public IUnknown
 {
+  // Sections in file order
   using _TSectionMap =
-    const std::unordered_map <std::wstring, iSK_INISection>;
-
-   iSK_INI (const wchar_t* filename);
-  ~iSK_INI (void);
-
+    const std::vector <iSK_INISection *>;
 
   /*** IUnknown methods ***/
-  STDMETHOD  (       QueryInterface)(THIS_ REFIID riid, void** ppvObj);
-  STDMETHOD_ (ULONG, AddRef)        (THIS);
-  STDMETHOD_ (ULONG, Release)       (THIS);
+  STDMETHOD  (       QueryInterface)(THIS_ REFIID riid, void** ppvObj) PURE;
+  STDMETHOD_ (ULONG, AddRef)        (THIS) PURE;
+  STDMETHOD_ (ULONG, Release)       (THIS) PURE;
 
-  STDMETHOD_ (void, parse)  (THIS);
-  STDMETHOD_ (void, import) (THIS_ const wchar_t* import_data);
-  STDMETHOD_ (void, write)  (THIS_ const wchar_t* fname);
+  STDMETHOD_ (void, parse)  (THIS) PURE;
+  STDMETHOD_ (void, import) (THIS_ const wchar_t* import_data) PURE;
+  // Skipped if nothing changed and fname is the file that was loaded
+  STDMETHOD_ (void, write)  (THIS_ const wchar_t* fname) PURE;
 
-  STDMETHOD_ (_TSectionMap&,   get_sections)    (THIS);
-  STDMETHOD_ (iSK_INISection&, get_section)     (const wchar_t* section);
-  STDMETHOD_ (bool,            contains_section)(const wchar_t* section);
-  STDMETHOD_ (bool,            remove_section)  (const wchar_t* section);
+  STDMETHOD_ (_TSectionMap&,   get_sections)    (THIS) PURE;
+  STDMETHOD_ (iSK_INISection&, get_section)     (const wchar_t* section) PURE;
+  STDMETHOD_ (bool,            contains_section)(const wchar_t* section) PURE;
+  STDMETHOD_ (bool,            remove_section)  (const wchar_t* section) PURE;
 
   STDMETHOD_ (iSK_INISection&, get_section_f)   ( THIS_ _In_z_ _Printf_format_string_
                                                   wchar_t const* const _Format,
-                                                                       ... );
-  STDMETHOD_ (const wchar_t*,  get_filename)    (THIS) const;
-
-protected:
-private:
-  FILE*     fINI    = nullptr;
-
-  wchar_t*  wszName = nullptr;
-  wchar_t*  wszData = nullptr;
-
-  std::unordered_map <
-    std::wstring, iSK_INISection
-  >         sections;
-
-  // Preserve insertion order so that we write the INI file in the
-  //   same order we read it. Otherwise things get jumbled around
-  //     arbitrarily as the map is re-hashed.
-  std::vector <std::wstring>
-            ordered_sections;
-
-  // Preserve File Encoding
-  enum CharacterEncoding {
-    INI_INVALID = 0x00,
-    INI_UTF8    = 0x01,
-    INI_UTF16LE = 0x02,
-    INI_UTF16BE = 0x04 // Not natively supported, but can be converted
-  } encoding_;
-
-  ULONG     refs = 0;
+                                                                       ... ) PURE;
+  STDMETHOD_ (const wchar_t*,  get_filename)    (THIS) const PURE;
 };
 
 iSK_INI*
 __stdcall
 UNX_CreateINI (const wchar_t* const wszName);
 
+namespace unx { class INIFile; }
+
+// The engine behind an iSK_INI, for code that would rather not go through
+//   the COM interface (i.e. table-driven config loading)
+unx::INIFile* UNX_GetINIFile (iSK_INI* pINI);
+
+// Serializes right away and writes from a background thread once changes
+//   stop coming in for a moment; fname defaults to the file that was loaded.
+void UNX_SaveINIAsync   (iSK_INI* pINI, const wchar_t* fname = nullptr);
+
+// Any other file UnX keeps next to its INIs, through the same writer thread
+void UNX_WriteFileAsync (const wchar_t* path, std::vector <uint8_t> data);
+
+// Writes anything UNX_SaveINIAsync still has queued, on the calling thread
+void UNX_FlushINIWrites (void);
+
+// Replaces the contents of pINI with data (its file, read by somebody else)
+//   as if it had just been loaded
+void UNX_ReloadINI      (iSK_INI* pINI, const std::vector <uint8_t>& data);
+
+// Sees the contents of every INI file UnX writes, just before they are
+//   written and on whichever thread writes them; lets the config watcher
+//     tell UnX's own writes apart from edits.
+using UNX_INIWriteHook_pfn =
+  void (*)(const wchar_t* path, const std::vector <uint8_t>& data);
+
+void UNX_SetINIWriteHook (UNX_INIWriteHook_pfn hook);
+
 #endif
@@ -0,0 +1,1229 @@
+/**
+ * This file is part of UnX.
+ *
+ * UnX is free software : you can redistribute it
+ * and/or modify it under the terms of the GNU General Public License
+ * as published by The Free Software Foundation, either version 3 of
+ * the License, or (at your option) any later version.
+ *
+ * UnX is distributed in the hope that it will be useful,
+ *
+ * But WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with UnX.
+ *
+ *   If not, see <http://www.gnu.org/licenses/>.
+ *
+**/
+#include "inifile.h"
+
+#include <cstring>
+
+#ifdef _WIN32
+# include <Windows.h>
+# include <io.h>
+#else
+# include <fcntl.h>
+# include <sys/mman.h>
+# include <sys/stat.h>
+# include <unistd.h>
+# include <cstdio>
+#endif
+
+
+//
+// Text encoding
+//
+//   wchar_t is UTF-16 on Windows and UTF-32 elsewhere; both are handled so
+//     that the engine can be built and measured off of Windows.
+//
+namespace
+{
+  const bool WideIsUTF16 = (sizeof (wchar_t) == 2);
+
+  inline void
+  UNX_PutCodepoint (uint32_t cp, wchar_t*& out)
+  {
+    if (WideIsUTF16 && cp > 0xFFFF)
+    {
+      cp -= 0x10000;
+      *out++ = (wchar_t)(0xD800 + (cp >> 10));
+      *out++ = (wchar_t)(0xDC00 + (cp & 0x3FF));
+    }
+
+    else
+      *out++ = (wchar_t)cp;
+  }
+
+  // Returns the number of wchar_t written; out must hold len units
+  size_t
+  UNX_DecodeUTF8 (const uint8_t* in, size_t len, wchar_t* out)
+  {
+    wchar_t*       dst = out;
+    const uint8_t* end = in + len;
+
+    while (in < end)
+    {
+      // Runs of ASCII are by far the common case
+      if (*in < 0x80)
+      {
+        *dst++ = (wchar_t)*in++;
+        continue;
+      }
+
+      uint32_t cp;
+      int      extra;
+
+           if ((*in & 0xE0) == 0xC0) { cp = *in & 0x1F; extra = 1; }
+      else if ((*in & 0xF0) == 0xE0) { cp = *in & 0x0F; extra = 2; }
+      else if ((*in & 0xF8) == 0xF0) { cp = *in & 0x07; extra = 3; }
+      else                           { ++in; *dst++ = (wchar_t)0xFFFD; continue; }
+
+      if (end - in <= extra)
+      {
+        *dst++ = (wchar_t)0xFFFD;
+        break;
+      }
+
+      ++in;
+
+      bool valid = true;
+
+      for (int i = 0; i < extra; i++, in++)
+      {
+        if ((*in & 0xC0) != 0x80) { valid = false; break; }
+        cp = (cp << 6) | (*in & 0x3F);
+      }
+
+      UNX_PutCodepoint (valid && cp <= 0x10FFFF ? cp : 0xFFFD, dst);
+    }
+
+    return dst - out;
+  }
+
+  size_t
+  UNX_DecodeUTF16 (const uint8_t* in, size_t len, bool big_endian, wchar_t* out)
+  {
+    wchar_t* dst   = out;
+    size_t   units = len / 2;
+
+    if (WideIsUTF16 && (! big_endian))
+    {
+      memcpy (out, in, units * 2);
+      return units;
+    }
+
+    for (size_t i = 0; i < units; i++)
+    {
+      uint32_t u = big_endian ? ((uint32_t)in [i * 2] << 8) | in [i * 2 + 1] :
+                                ((uint32_t)in [i * 2 + 1] << 8) | in [i * 2];
+
+      if ((! WideIsUTF16) && u >= 0xD800 && u < 0xDC00 && i + 1 < units)
+      {
+        uint32_t lo = big_endian ? ((uint32_t)in [i * 2 + 2] << 8) | in [i * 2 + 3] :
+                                   ((uint32_t)in [i * 2 + 3] << 8) | in [i * 2 + 2];
+
+        if (lo >= 0xDC00 && lo < 0xE000)
+        {
+          u = 0x10000 + ((u - 0xD800) << 10) + (lo - 0xDC00);
+          ++i;
+        }
+      }
+
+      *dst++ = (wchar_t)u;
+    }
+
+    return dst - out;
+  }
+
+  // Reads one code point and advances; lone surrogates pass through as-is
+  inline uint32_t
+  UNX_NextCodepoint (const wchar_t*& in, const wchar_t* end)
+  {
+    uint32_t cp = (uint32_t)*in++;
+
+    if ( WideIsUTF16 && cp >= 0xD800 && cp < 0xDC00 && in < end &&
+         (uint32_t)*in >= 0xDC00 && (uint32_t)*in < 0xE000 )
+    {
+      cp = 0x10000 + ((cp - 0xD800) << 10) + ((uint32_t)*in++ - 0xDC00);
+    }
+
+    return cp;
+  }
+
+  void
+  UNX_EncodeUTF8 (std::wstring_view text, std::vector <uint8_t>& out)
+  {
+    const wchar_t* in  = text.data ();
+    const wchar_t* end = in + text.size ();
+
+    while (in < end)
+    {
+      if ((uint32_t)*in < 0x80)
+      {
+        out.push_back ((uint8_t)*in++);
+        continue;
+      }
+
+      uint32_t cp = UNX_NextCodepoint (in, end);
+
+      if (cp < 0x800)
+      {
+        out.push_back ((uint8_t)(0xC0 |  (cp >> 6)));
+        out.push_back ((uint8_t)(0x80 |  (cp        & 0x3F)));
+      }
+
+      else if (cp < 0x10000)
+      {
+        out.push_back ((uint8_t)(0xE0 |  (cp >> 12)));
+        out.push_back ((uint8_t)(0x80 | ((cp >> 6)  & 0x3F)));
+        out.push_back ((uint8_t)(0x80 |  (cp        & 0x3F)));
+      }
+
+      else
+      {
+        out.push_back ((uint8_t)(0xF0 |  (cp >> 18)));
+        out.push_back ((uint8_t)(0x80 | ((cp >> 12) & 0x3F)));
+        out.push_back ((uint8_t)(0x80 | ((cp >> 6)  & 0x3F)));
+        out.push_back ((uint8_t)(0x80 |  (cp        & 0x3F)));
+      }
+    }
+  }
+
+  void
+  UNX_EncodeUTF16 (std::wstring_view text, bool big_endian, std::vector <uint8_t>& out)
+  {
+    const wchar_t* in  = text.data ();
+    const wchar_t* end = in + text.size ();
+
+    auto put = [&] (uint32_t u)
+    {
+      out.push_back ((uint8_t)(big_endian ? (u >> 8) : (u & 0xFF)));
+      out.push_back ((uint8_t)(big_endian ? (u & 0xFF) : (u >> 8)));
+    };
+
+    while (in < end)
+    {
+      uint32_t cp = WideIsUTF16 ? (uint32_t)*in++ :
+                                  UNX_NextCodepoint (in, end);
+
+      if (cp > 0xFFFF)
+      {
+        cp -= 0x10000;
+        put (0xD800 + (cp >> 10));
+        put (0xDC00 + (cp & 0x3FF));
+      }
+
+      else
+        put (cp);
+    }
+  }
+
+  inline bool
+  UNX_IsSpace (wchar_t ch)
+  {
+    return ch == L' ' || ch == L'\t' || ch == L'\r' || ch == L'\n';
+  }
+
+  inline std::wstring_view
+  UNX_Trim (std::wstring_view str)
+  {
+    size_t begin = 0;
+    size_t end   = str.size ();
+
+    while (begin < end && UNX_IsSpace (str [begin]))   ++begin;
+    while (end > begin && UNX_IsSpace (str [end - 1])) --end;
+
+    return str.substr (begin, end - begin);
+  }
+}
+
+
+//
+// Arena
+//
+wchar_t*
+unx::INIFile::arena_s::alloc (size_t count)
+{
+  if (count == 0)
+    count = 1;
+
+  // Big requests (the decoded file) get a chunk of their own
+  if (count > ChunkSize / 4)
+  {
+    chunks_.emplace_back (new wchar_t [count]);
+    return chunks_.back ().get ();
+  }
+
+  if (count > left_)
+  {
+    chunks_.emplace_back (new wchar_t [ChunkSize]);
+
+    next_ = chunks_.back ().get ();
+    left_ = ChunkSize;
+  }
+
+  wchar_t* ret = next_;
+
+  next_ += count;
+  left_ -= count;
+
+  return ret;
+}
+
+std::wstring_view
+unx::INIFile::arena_s::intern (std::wstring_view str)
+{
+  if (str.empty ())
+    return std::wstring_view ();
+
+  wchar_t* mem = alloc (str.size ());
+  memcpy (mem, str.data (), str.size () * sizeof (wchar_t));
+
+  return std::wstring_view (mem, str.size ());
+}
+
+
+//
+// Hash index
+//
+uint32_t
+unx::INIFile::hash_of (std::wstring_view str)
+{
+  uint32_t h = 2166136261UL;
+
+  for (wchar_t ch : str)
+  {
+    h ^= (uint32_t)ch;
+    h *= 16777619UL;
+  }
+
+  return h;
+}
+
+template <typename _Item, typename _Eq>
+uint32_t
+unx::INIFile::index_find ( const index_s& idx, const std::vector <_Item>& items,
+                           uint32_t hash, _Eq&& eq )
+{
+  if (idx.slots.empty ())
+    return npos;
+
+  const size_t mask = idx.slots.size () - 1;
+
+  for (size_t i = hash & mask; ; i = (i + 1) & mask)
+  {
+    const uint32_t slot = idx.slots [i];
+
+    if (slot == 0)
+      return npos;
+
+    const _Item& item = items [slot - 1];
+
+    if (item.hash == hash && (! item.erased) && eq (item))
+      return slot - 1;
+  }
+}
+
+template <typename _Item>
+void
+unx::INIFile::index_insert (index_s& idx, const std::vector <_Item>& items, uint32_t pos)
+{
+  // Keep the load factor under 1/2
+  if ((idx.used + 1) * 2 > idx.slots.size ())
+  {
+    size_t size = idx.slots.empty () ? 16 : idx.slots.size () * 2;
+
+    idx.slots.assign (size, 0);
+    idx.used = 0;
+
+    for (uint32_t i = 0; i < pos; i++)
+    {
+      if (! items [i].erased)
+        index_insert (idx, items, i);
+    }
+  }
+
+  const size_t mask = idx.slots.size () - 1;
+
+  for (size_t i = items [pos].hash & mask; ; i = (i + 1) & mask)
+  {
+    if (idx.slots [i] == 0)
+    {
+      idx.slots [i] = pos + 1;
+      idx.used++;
+      return;
+    }
+  }
+}
+
+template <typename _Item>
+void
+unx::INIFile::index_build (index_s& idx, const std::vector <_Item>& items)
+{
+  idx.clear ();
+
+  for (uint32_t i = 0; i < (uint32_t)items.size (); i++)
+  {
+    if (! items [i].erased)
+      index_insert (idx, items, i);
+  }
+}
+
+
+//
+// Loading / saving
+//
+unx::INIFile::INIFile (void) = default;
+
+void
+unx::INIFile::clear (void)
+{
+  sections_.clear       ();
+  section_index_.clear  ();
+  owned_.clear          ();
+  watched_.clear        ();
+  arena_.clear          ();
+
+  live_sections_ = 0;
+  dirty_         = false;
+
+  epoch_++;
+}
+
+bool
+unx::INIFile::load (const wchar_t* path)
+{
+  clear ();
+
+#ifdef _WIN32
+  HANDLE hFile =
+    CreateFileW ( path, GENERIC_READ, FILE_SHARE_READ | FILE_SHARE_WRITE,
+                    nullptr, OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL, nullptr );
+
+  if (hFile == INVALID_HANDLE_VALUE)
+    return false;
+
+  LARGE_INTEGER size = { };
+  GetFileSizeEx (hFile, &size);
+
+  if (size.QuadPart == 0)
+  {
+    CloseHandle (hFile);
+    return true;
+  }
+
+  HANDLE hMap =
+    CreateFileMappingW (hFile, nullptr, PAGE_READONLY, 0, 0, nullptr);
+
+  const uint8_t* data = hMap != nullptr ?
+    (const uint8_t *)MapViewOfFile (hMap, FILE_MAP_READ, 0, 0, 0) : nullptr;
+
+  if (data != nullptr)
+  {
+    parse (data, (size_t)size.QuadPart);
+    UnmapViewOfFile (data);
+  }
+
+  if (hMap != nullptr)
+    CloseHandle (hMap);
+
+  CloseHandle (hFile);
+
+  return data != nullptr;
+#else
+  std::vector <uint8_t> narrow;
+  UNX_EncodeUTF8 (path, narrow);
+  narrow.push_back ('\0');
+
+  int fd = open ((const char *)narrow.data (), O_RDONLY);
+
+  if (fd < 0)
+    return false;
+
+  struct stat st = { };
+  fstat (fd, &st);
+
+  if (st.st_size == 0)
+  {
+    close (fd);
+    return true;
+  }
+
+  void* data =
+    mmap (nullptr, (size_t)st.st_size, PROT_READ, MAP_PRIVATE, fd, 0);
+
+  close (fd);
+
+  if (data == MAP_FAILED)
+    return false;
+
+  parse ((const uint8_t *)data, (size_t)st.st_size);
+  munmap (data, (size_t)st.st_size);
+
+  return true;
+#endif
+}
+
+void
+unx::INIFile::parse (const uint8_t* data, size_t len)
+{
+  clear ();
+
+  size_t skip = 0;
+
+       if (len >= 2 && data [0] == 0xFF && data [1] == 0xFE)
+    { encoding_ = Encoding_UTF16LE; skip = 2; }
+  else if (len >= 2 && data [0] == 0xFE && data [1] == 0xFF)
+    { encoding_ = Encoding_UTF16BE; skip = 2; }
+  else if (len >= 3 && data [0] == 0xEF && data [1] == 0xBB && data [2] == 0xBF)
+    { encoding_ = Encoding_UTF8BOM; skip = 3; }
+  else
+    // No BOM; a NUL in the second byte is a good sign of BOM-less UTF-16LE
+    encoding_ = (len >= 2 && data [1] == 0x00) ? Encoding_UTF16LE :
+                                                 Encoding_UTF8;
+
+  data += skip;
+  len  -= skip;
+
+  // Decoding never produces more units than there are input bytes
+  wchar_t* text  = arena_.alloc (len);
+  size_t   units = 0;
+
+  if (encoding_ == Encoding_UTF16LE || encoding_ == Encoding_UTF16BE)
+    units = UNX_DecodeUTF16 (data, len, encoding_ == Encoding_UTF16BE, text);
+  else
+    units = UNX_DecodeUTF8  (data, len, text);
+
+  parse_text (std::wstring_view (text, units), false);
+
+  // What was just read is what is on disk
+  mark_clean ();
+}
+
+void
+unx::INIFile::import (std::wstring_view text)
+{
+  // Imported text is usually a temporary; give it a home in the arena
+  wchar_t* copy = arena_.alloc (text.size ());
+  memcpy (copy, text.data (), text.size () * sizeof (wchar_t));
+
+  parse_text (std::wstring_view (copy, text.size ()), true);
+}
+
+void
+unx::INIFile::parse_text (std::wstring_view text, bool overwrite)
+{
+  section_s* sec = nullptr;
+  size_t     pos = 0;
+
+  while (pos < text.size ())
+  {
+    size_t eol = text.find (L'\n', pos);
+
+    if (eol == std::wstring_view::npos)
+        eol = text.size ();
+
+    std::wstring_view line =
+      UNX_Trim (text.substr (pos, eol - pos));
+
+    pos = eol + 1;
+
+    if (line.empty () || line [0] == L';' || line [0] == L'#')
+      continue;
+
+    if (line [0] == L'[')
+    {
+      size_t close = line.find (L']');
+
+      if (close != std::wstring_view::npos)
+      {
+        sec = &sections_ [get_section (line.substr (1, close - 1))];
+        continue;
+      }
+    }
+
+    size_t eq = line.find (L'=');
+
+    // Keys outside of any section have nowhere to go
+    if (eq == std::wstring_view::npos || sec == nullptr)
+      continue;
+
+    add_entry ( *sec, UNX_Trim (line.substr (0, eq)),
+                      UNX_Trim (line.substr (eq + 1)), overwrite );
+  }
+}
+
+std::vector <uint8_t>
+unx::INIFile::serialize (void) const
+{
+  std::wstring text;
+
+  for (const auto& sec : sections_)
+  {
+    if (sec.erased)
+      continue;
+
+    text.append (L"[");
+    text.append (sec.name.data (), sec.name.size ());
+    text.append (L"]\r\n");
+
+    for (const auto& ent : sec.entries)
+    {
+      if (ent.erased)
+        continue;
+
+      std::wstring_view val = value_of (ent);
+
+      text.append (ent.key.data (), ent.key.size ());
+      text.append (L"=");
+      text.append (val.data (),     val.size ());
+      text.append (L"\r\n");
+    }
+
+    text.append (L"\r\n");
+  }
+
+  std::vector <uint8_t> out;
+  out.reserve (text.size () * 2 + 3);
+
+  switch (encoding_)
+  {
+    case Encoding_UTF16LE:
+      out.push_back (0xFF); out.push_back (0xFE);
+      UNX_EncodeUTF16 (text, false, out);
+      break;
+
+    case Encoding_UTF16BE:
+      out.push_back (0xFE); out.push_back (0xFF);
+      UNX_EncodeUTF16 (text, true, out);
+      break;
+
+    case Encoding_UTF8BOM:
+      out.push_back (0xEF); out.push_back (0xBB); out.push_back (0xBF);
+      UNX_EncodeUTF8 (text, out);
+      break;
+
+    default:
+      UNX_EncodeUTF8 (text, out);
+      break;
+  }
+
+  return out;
+}
+
+bool
+unx::INIFile::write (const wchar_t* path) const
+{
+  return write_file (path, serialize ());
+}
+
+bool
+unx::INIFile::write_file (const wchar_t* path, const std::vector <uint8_t>& data)
+{
+  std::wstring tmp (path);
+               tmp.append (L".tmp");
+
+#ifdef _WIN32
+  FILE* fp = _wfopen (tmp.c_str (), L"wb");
+#else
+  std::vector <uint8_t> narrow,
+                        narrow_tmp;
+
+  UNX_EncodeUTF8 (path, narrow);
+  UNX_EncodeUTF8 (tmp,  narrow_tmp);
+
+  narrow.push_back     ('\0');
+  narrow_tmp.push_back ('\0');
+
+  FILE* fp = fopen ((const char *)narrow_tmp.data (), "wb");
+#endif
+
+  if (fp == nullptr)
+    return false;
+
+  // The data has to be on disk before the rename, or a crash could still
+  //   leave an empty file behind under the real name.
+  bool ok =
+    fwrite (data.data (), 1, data.size (), fp) == data.size () &&
+    fflush (fp) == 0;
+
+#ifdef _WIN32
+  ok = ok && _commit (_fileno (fp)) == 0;
+#else
+  ok = ok && fsync   (fileno (fp))  == 0;
+#endif
+
+  ok = (fclose (fp) == 0) && ok;
+
+#ifdef _WIN32
+  if (ok)
+    ok = MoveFileExW ( tmp.c_str (), path, MOVEFILE_REPLACE_EXISTING |
+                                           MOVEFILE_WRITE_THROUGH ) != FALSE;
+
+  if (! ok)
+    DeleteFileW (tmp.c_str ());
+#else
+  if (ok)
+    ok = rename ( (const char *)narrow_tmp.data (),
+                  (const char *)narrow.data     () ) == 0;
+
+  if (! ok)
+    unlink ((const char *)narrow_tmp.data ());
+#endif
+
+  return ok;
+}
+
+bool
+unx::INIFile::read_file (const wchar_t* path, std::vector <uint8_t>& data)
+{
+  data.clear ();
+
+#ifdef _WIN32
+  HANDLE hFile =
+    CreateFileW ( path, GENERIC_READ, FILE_SHARE_READ | FILE_SHARE_WRITE,
+                    nullptr, OPEN_EXISTING, FILE_FLAG_SEQUENTIAL_SCAN, nullptr );
+
+  if (hFile == INVALID_HANDLE_VALUE)
+    return false;
+
+  LARGE_INTEGER size = { };
+  GetFileSizeEx (hFile, &size);
+
+  DWORD dwRead = 0;
+  bool  ok     = size.QuadPart < 0x7FFFFFFF;
+
+  if (ok && size.QuadPart > 0)
+  {
+    data.resize ((size_t)size.QuadPart);
+
+    ok = ReadFile (hFile, data.data (), (DWORD)data.size (), &dwRead, nullptr) &&
+           dwRead == data.size ();
+  }
+
+  CloseHandle (hFile);
+#else
+  std::vector <uint8_t> narrow;
+  UNX_EncodeUTF8 (path, narrow);
+  narrow.push_back ('\0');
+
+  int fd = open ((const char *)narrow.data (), O_RDONLY);
+
+  if (fd < 0)
+    return false;
+
+  struct stat st = { };
+  fstat (fd, &st);
+
+  data.resize ((size_t)st.st_size);
+
+  size_t done = 0;
+  bool   ok   = true;
+
+  while (ok && done < data.size ())
+  {
+    const ssize_t got =
+      read (fd, data.data () + done, data.size () - done);
+
+    ok    = got > 0;
+    done += ok ? (size_t)got : 0;
+  }
+
+  close (fd);
+#endif
+
+  if (! ok)
+    data.clear ();
+
+  return ok;
+}
+
+void
+unx::INIFile::encode_utf8 (std::wstring_view text, std::vector <uint8_t>& out)
+{
+  UNX_EncodeUTF8 (text, out);
+}
+
+bool
+unx::INIFile::stat_file (const wchar_t* path, uint64_t& size, int64_t& mtime)
+{
+  size  = 0;
+  mtime = 0;
+
+#ifdef _WIN32
+  WIN32_FILE_ATTRIBUTE_DATA attrs = { };
+
+  if (! GetFileAttributesExW (path, GetFileExInfoStandard, &attrs))
+    return false;
+
+  size  = ((uint64_t)attrs.nFileSizeHigh        << 32) | attrs.nFileSizeLow;
+  mtime = ((int64_t) attrs.ftLastWriteTime.dwHighDateTime << 32) |
+                     attrs.ftLastWriteTime.dwLowDateTime;
+#else
+  std::vector <uint8_t> narrow;
+  UNX_EncodeUTF8 (path, narrow);
+  narrow.push_back ('\0');
+
+  struct stat st = { };
+
+  if (stat ((const char *)narrow.data (), &st) != 0)
+    return false;
+
+  size  = (uint64_t)st.st_size;
+  mtime = (int64_t) st.st_mtim.tv_sec * 1000000000LL + st.st_mtim.tv_nsec;
+#endif
+
+  return true;
+}
+
+bool
+unx::INIFile::save (const wchar_t* path)
+{
+  if (! dirty ())
+    return true;
+
+  if (! write (path))
+    return false;
+
+  mark_clean ();
+
+  return true;
+}
+
+bool
+unx::INIFile::dirty (void) const
+{
+  if (dirty_)
+    return true;
+
+  for (const auto& sec : sections_)
+  {
+    if (sec.dirty && (! sec.erased))
+      return true;
+  }
+
+  for (const auto& watched : watched_)
+  {
+    const entry_s& ent =
+      sections_ [watched.first].entries [watched.second];
+    const owned_s& own = owned_ [ent.owned - 1];
+
+    if ((! ent.erased) && own.value != own.saved)
+      return true;
+  }
+
+  return false;
+}
+
+bool
+unx::INIFile::section_dirty (section_id id) const
+{
+  const section_s& sec = sections_ [id];
+
+  if (sec.dirty)
+    return true;
+
+  for (const auto& watched : watched_)
+  {
+    if (watched.first != id)
+      continue;
+
+    const entry_s& ent = sec.entries [watched.second];
+    const owned_s& own = owned_ [ent.owned - 1];
+
+    if ((! ent.erased) && own.value != own.saved)
+      return true;
+  }
+
+  return false;
+}
+
+void
+unx::INIFile::mark_clean (void)
+{
+  for (auto& sec : sections_)
+    sec.dirty = false;
+
+  for (const auto& watched : watched_)
+  {
+    const entry_s& ent = sections_ [watched.first].entries [watched.second];
+    owned_s&       own = owned_ [ent.owned - 1];
+
+    if (own.saved != own.value)
+        own.saved.assign (own.value);
+  }
+
+  dirty_ = false;
+}
+
+
+//
+// Sections
+//
+std::vector <unx::INIFile::section_id>
+unx::INIFile::sections (void) const
+{
+  std::vector <section_id> ids;
+  ids.reserve (live_sections_);
+
+  for (section_id i = 0; i < (section_id)sections_.size (); i++)
+  {
+    if (! sections_ [i].erased)
+      ids.push_back (i);
+  }
+
+  return ids;
+}
+
+unx::INIFile::section_id
+unx::INIFile::find_section (std::wstring_view name) const
+{
+  return
+    index_find ( section_index_, sections_, hash_of (name),
+                   [&] (const section_s& sec) { return sec.name == name; } );
+}
+
+unx::INIFile::section_id
+unx::INIFile::get_section (std::wstring_view name)
+{
+  section_id id = find_section (name);
+
+  if (id != npos)
+    return id;
+
+  section_s sec;
+  sec.name = arena_.intern (name);
+  sec.hash = hash_of       (name);
+
+  sections_.push_back (std::move (sec));
+
+  id = (section_id)sections_.size () - 1;
+
+  index_insert (section_index_, sections_, id);
+  live_sections_++;
+
+  return id;
+}
+
+bool
+unx::INIFile::remove_section (std::wstring_view name)
+{
+  section_id id = find_section (name);
+
+  if (id == npos)
+    return false;
+
+  section_s& sec = sections_ [id];
+
+  sec.erased = true;
+  sec.entries.clear ();
+  sec.index.clear   ();
+  sec.live = 0;
+
+  live_sections_--;
+  dirty_ = true;
+  epoch_++;
+
+  for (size_t i = 0; i < watched_.size (); )
+  {
+    if (watched_ [i].first == id)
+    {
+      watched_ [i] = watched_.back ();
+      watched_.pop_back ();
+    }
+
+    else
+      ++i;
+  }
+
+  index_build (section_index_, sections_);
+
+  return true;
+}
+
+std::wstring_view
+unx::INIFile::section_name (section_id sec) const
+{
+  return sections_ [sec].name;
+}
+
+void
+unx::INIFile::rename_section (section_id id, std::wstring_view name)
+{
+  section_s& sec = sections_ [id];
+
+  // iParameter::store renames on every call; most of the time to itself
+  if (sec.name == name)
+    return;
+
+  sec.name = arena_.intern (name);
+  sec.hash = hash_of       (name);
+
+  index_build (section_index_, sections_);
+
+  dirty_ = true;
+  epoch_++;
+}
+
+
+//
+// Keys
+//
+std::wstring_view
+unx::INIFile::value_of (const entry_s& ent) const
+{
+  if (ent.owned != 0)
+    return owned_ [ent.owned - 1].value;
+
+  return ent.raw;
+}
+
+const unx::INIFile::entry_s*
+unx::INIFile::find_entry (const section_s& sec, std::wstring_view key) const
+{
+  uint32_t idx =
+    index_find ( sec.index, sec.entries, hash_of (key),
+                   [&] (const entry_s& ent) { return ent.key == key; } );
+
+  return idx != npos ? &sec.entries [idx] : nullptr;
+}
+
+unx::INIFile::entry_s*
+unx::INIFile::find_entry (section_s& sec, std::wstring_view key)
+{
+  return
+    const_cast <entry_s *> (
+      static_cast <const INIFile *> (this)->find_entry (
+        static_cast <const section_s &> (sec), key )
+    );
+}
+
+void
+unx::INIFile::add_entry ( section_s& sec, std::wstring_view key,
+                          std::wstring_view value, bool overwrite )
+{
+  entry_s* existing = find_entry (sec, key);
+
+  if (existing != nullptr)
+  {
+    if ((! overwrite) || value_of (*existing) == value)
+      return;
+
+    if (existing->owned != 0)
+      owned_ [existing->owned - 1].value.assign (value.data (), value.size ());
+    else
+      existing->raw = value;
+
+    sec.dirty = true;
+
+    return;
+  }
+
+  entry_s ent;
+  ent.key  = key;
+  ent.raw  = value;
+  ent.hash = hash_of (key);
+
+  sec.entries.push_back (ent);
+
+  index_insert (sec.index, sec.entries, (uint32_t)sec.entries.size () - 1);
+  sec.live++;
+
+  sec.dirty = true;
+}
+
+size_t
+unx::INIFile::key_count (section_id sec) const
+{
+  return sections_ [sec].live;
+}
+
+bool
+unx::INIFile::contains_key (section_id sec, std::wstring_view key) const
+{
+  return find_entry (sections_ [sec], key) != nullptr;
+}
+
+std::wstring_view
+unx::INIFile::value (section_id sec, std::wstring_view key) const
+{
+  const entry_s* ent =
+    find_entry (sections_ [sec], key);
+
+  return ent != nullptr ? value_of (*ent) : std::wstring_view ();
+}
+
+bool
+unx::INIFile::find_value (section_id sec, std::wstring_view key, std::wstring_view& out) const
+{
+  const entry_s* ent =
+    find_entry (sections_ [sec], key);
+
+  if (ent == nullptr)
+    return false;
+
+  out = value_of (*ent);
+
+  return true;
+}
+
+std::wstring*
+unx::INIFile::value_ref (section_id sec, std::wstring_view key)
+{
+  entry_s* ent =
+    find_entry (sections_ [sec], key);
+
+  if (ent == nullptr)
+    return nullptr;
+
+  if (ent->owned == 0)
+  {
+    owned_.push_back ({ std::wstring (ent->raw), std::wstring (ent->raw) });
+
+    ent->owned = (uint32_t)owned_.size ();
+
+    watched_.emplace_back ( sec,
+      (uint32_t)(ent - sections_ [sec].entries.data ()) );
+  }
+
+  return &owned_ [ent->owned - 1].value;
+}
+
+bool
+unx::INIFile::add_key_value (section_id sec, std::wstring_view key, std::wstring_view value)
+{
+  if (contains_key (sec, key))
+    return false;
+
+  add_entry ( sections_ [sec], arena_.intern (key),
+                               arena_.intern (value), false );
+
+  return true;
+}
+
+bool
+unx::INIFile::assign_entry (section_id sec, entry_s& ent, std::wstring_view value)
+{
+  if (value_of (ent) == value)
+    return false;
+
+  if (ent.owned != 0)
+    owned_ [ent.owned - 1].value.assign (value.data (), value.size ());
+  else
+    ent.raw = arena_.intern (value);
+
+  sections_ [sec].dirty = true;
+
+  return true;
+}
+
+bool
+unx::INIFile::set_value (section_id sec, std::wstring_view key, std::wstring_view value)
+{
+  entry_s* ent =
+    find_entry (sections_ [sec], key);
+
+  if (ent != nullptr)
+    return assign_entry (sec, *ent, value);
+
+  add_entry ( sections_ [sec], arena_.intern (key),
+                               arena_.intern (value), false );
+
+  return true;
+}
+
+bool
+unx::INIFile::remove_key (section_id id, std::wstring_view key)
+{
+  section_s& sec = sections_ [id];
+  entry_s*   ent = find_entry (sec, key);
+
+  if (ent == nullptr)
+    return false;
+
+  ent->erased = true;
+  sec.live--;
+  sec.dirty = true;
+
+  epoch_++;
+
+  index_build (sec.index, sec.entries);
+
+  return true;
+}
+
+
+unx::INIFile::key_handle_s
+unx::INIFile::handle (std::wstring_view section, std::wstring_view key)
+{
+  key_handle_s h;
+  h.section = section;
+  h.key     = key;
+
+  resolve (h, false);
+
+  return h;
+}
+
+bool
+unx::INIFile::resolve (key_handle_s& key, bool create)
+{
+  if (key.epoch == epoch_ && key.entry != npos)
+    return true;
+
+  if (key.epoch != epoch_)
+  {
+    key.epoch = epoch_;
+    key.sec   = npos;
+    key.entry = npos;
+  }
+
+  // A missing section may have been added since the last try
+  if (key.sec == npos)
+  {
+    key.sec = create ? get_section  (key.section)
+                     : find_section (key.section);
+
+    if (key.sec == npos)
+      return false;
+  }
+
+  const section_s& sec = sections_ [key.sec];
+
+  key.entry =
+    index_find ( sec.index, sec.entries, hash_of (key.key),
+                   [&] (const entry_s& ent) { return ent.key == key.key; } );
+
+  return key.entry != npos;
+}
+
+bool
+unx::INIFile::find_value (key_handle_s& key, std::wstring_view& out)
+{
+  if (! resolve (key, false))
+    return false;
+
+  out = value_of (sections_ [key.sec].entries [key.entry]);
+
+  return true;
+}
+
+bool
+unx::INIFile::set_value (key_handle_s& key, std::wstring_view value)
+{
+  if (resolve (key, true))
+    return assign_entry (key.sec, sections_ [key.sec].entries [key.entry], value);
+
+  section_s& sec = sections_ [key.sec];
+
+  add_entry ( sec, arena_.intern (key.key),
+                   arena_.intern (value), false );
+
+  key.entry = (uint32_t)sec.entries.size () - 1;
+
+  return true;
+}
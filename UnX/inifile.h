@@ -0,0 +1,278 @@
+/**
+ * This file is part of UnX.
+ *
+ * UnX is free software : you can redistribute it
+ * and/or modify it under the terms of the GNU General Public License
+ * as published by The Free Software Foundation, either version 3 of
+ * the License, or (at your option) any later version.
+ *
+ * UnX is distributed in the hope that it will be useful,
+ *
+ * But WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with UnX.
+ *
+ *   If not, see <http://www.gnu.org/licenses/>.
+ *
+**/
+#ifndef __UNX__INIFILE_H__
+#define __UNX__INIFILE_H__
+
+#include <cstddef>
+#include <cstdint>
+#include <deque>
+#include <memory>
+#include <string>
+#include <string_view>
+#include <vector>
+
+namespace unx
+{
+  //
+  // INI storage engine behind iSK_INI.
+  //
+  //   The file is mapped, decoded once into an arena and then only ever
+  //     referenced through string views; a value is copied out of the arena
+  //       the first time somebody asks for a mutable reference to it.
+  //
+  //   Sections and keys keep insertion order in flat vectors, with an
+  //     open-addressed hash index on the side for lookups.
+  //
+  //   Every change marks its section dirty, so saving a file that nothing
+  //     touched is free, and files are replaced atomically (temp file +
+  //       rename) so that a crash mid-write cannot leave a truncated INI.
+  //
+  //   Nothing here depends on Win32; see ini.cpp for the COM wrapper.
+  //
+  class INIFile
+  {
+  public:
+    enum encoding_e : uint8_t {
+      Encoding_UTF8    = 0x01, // No BOM
+      Encoding_UTF8BOM = 0x02,
+      Encoding_UTF16LE = 0x04,
+      Encoding_UTF16BE = 0x08  // Not native, but converted in both directions
+    };
+
+    using section_id = uint32_t;
+    static const section_id npos = 0xFFFFFFFFUL;
+
+    INIFile (void);
+
+    INIFile            (const INIFile&) = delete;
+    INIFile& operator= (const INIFile&) = delete;
+
+    // Replaces the contents; a missing / empty file leaves the INI empty
+    bool                 load           (const wchar_t* path);
+    void                 parse          (const uint8_t* data, size_t len);
+
+    // Merges text into the INI; values that already exist are overwritten
+    void                 import         (std::wstring_view text);
+
+    // Always writes, through a temp file that replaces path
+    bool                 write          (const wchar_t* path) const;
+
+    // The temp file + replace used by write, for data serialized earlier
+    static bool          write_file     (const wchar_t* path, const std::vector <uint8_t>& data);
+
+    // The whole file in one read; false if it does not exist
+    static bool          read_file      (const wchar_t* path, std::vector <uint8_t>& data);
+
+    // Size and last write time (in platform units, only good for comparing)
+    static bool          stat_file      (const wchar_t* path, uint64_t& size, int64_t& mtime);
+
+    // The encoder write uses; appends to out
+    static void          encode_utf8    (std::wstring_view text, std::vector <uint8_t>& out);
+
+    // Writes only if something changed since the last load / save
+    bool                 save           (const wchar_t* path);
+
+    bool                 dirty          (void) const;
+    bool                 section_dirty  (section_id sec) const;
+    void                 mark_clean     (void);
+    std::vector <uint8_t>
+                         serialize      (void)                const;
+
+    encoding_e           encoding       (void) const { return encoding_; }
+    void                 set_encoding   (encoding_e enc) { encoding_ = enc; }
+
+
+    //
+    // Sections
+    //
+    size_t               section_count  (void) const { return live_sections_; }
+
+    // Live sections in file order
+    std::vector <section_id>
+                         sections       (void) const;
+
+    section_id           find_section   (std::wstring_view name) const;
+    section_id           get_section    (std::wstring_view name); // Creates
+    bool                 remove_section (std::wstring_view name);
+
+    std::wstring_view    section_name   (section_id sec) const;
+    void                 rename_section (section_id sec, std::wstring_view name);
+
+
+    //
+    // Keys
+    //
+    size_t               key_count      (section_id sec) const;
+    bool                 contains_key   (section_id sec, std::wstring_view key) const;
+
+    // Empty view if the key does not exist
+    std::wstring_view    value          (section_id sec, std::wstring_view key) const;
+    // Same, but tells a missing key apart from an empty value
+    bool                 find_value     (section_id sec, std::wstring_view key,
+                                         std::wstring_view& out)                const;
+
+    // nullptr if the key does not exist; the reference stays valid until
+    //   the key or its section is removed, or the file is loaded / parsed
+    //     again. Writes through it cannot be seen as they happen, so the
+    //       value is compared on the next dirty check.
+    std::wstring*        value_ref      (section_id sec, std::wstring_view key);
+
+    // Does nothing if the key already exists (returns false)
+    bool                 add_key_value  (section_id sec, std::wstring_view key,
+                                                         std::wstring_view value);
+    // Adds or overwrites; false if the value was already the same
+    bool                 set_value      (section_id sec, std::wstring_view key,
+                                                         std::wstring_view value);
+    bool                 remove_key     (section_id sec, std::wstring_view key);
+
+
+    //
+    // Resolved keys
+    //
+    //   A handle remembers where its key was found, so repeated access skips
+    //     hashing the names. Removing a section / key, renaming a section or
+    //       reloading the file makes every handle look its key up again.
+    //
+    struct key_handle_s {
+      std::wstring_view  section;        // Not owned; must outlive the handle
+      std::wstring_view  key;
+
+      section_id         sec   = npos;
+      uint32_t           entry = npos;   // npos until the key exists
+      uint32_t           epoch = 0;
+    };
+
+    key_handle_s         handle         (std::wstring_view section, std::wstring_view key);
+
+    bool                 find_value     (key_handle_s& key, std::wstring_view& out);
+    // Creates the section and key if necessary; false if the value was the same
+    bool                 set_value      (key_handle_s& key, std::wstring_view value);
+
+    // Keys of one section in file order
+    template <typename _Fn>
+    void                 for_each_key   (section_id sec, _Fn&& fn) const
+    {
+      for (const auto& ent : sections_ [sec].entries)
+      {
+        if (! ent.erased)
+          fn (ent.key, value_of (ent));
+      }
+    }
+
+  private:
+    struct entry_s {
+      std::wstring_view key;
+      std::wstring_view raw;           // Arena text, if never made mutable
+      uint32_t          hash;
+      uint32_t          owned  = 0;    // 1-based index into owned_, 0 = raw
+      bool              erased = false;
+    };
+
+    // A value handed out through value_ref (), and its text as of the last
+    //   save so that writes made through the reference can be caught.
+    //     mark_clean () copies one into the other in place; saving again and
+    //       again never allocates more than the longest value did.
+    struct owned_s {
+      std::wstring      value;
+      std::wstring      saved;
+    };
+
+    // Open-addressed; slots hold 1-based indices, 0 = empty
+    struct index_s {
+      std::vector <uint32_t> slots;
+      uint32_t               used = 0;
+
+      void     clear  (void) { slots.clear (); used = 0; }
+    };
+
+    struct section_s {
+      std::wstring_view      name;
+      uint32_t               hash;
+      bool                   erased = false;
+
+      std::vector <entry_s>  entries;
+      index_s                index;
+      uint32_t               live   = 0;
+      bool                   dirty  = false;
+    };
+
+    // Chunked bump allocator for wchar_t; nothing is freed until clear ()
+    class arena_s {
+    public:
+      wchar_t*          alloc  (size_t count);
+      std::wstring_view intern (std::wstring_view str);
+      void              clear  (void) { chunks_.clear (); left_ = 0; next_ = nullptr; }
+
+    private:
+      static const size_t ChunkSize = 16384;
+
+      std::vector <std::unique_ptr <wchar_t []>> chunks_;
+      wchar_t*                                   next_ = nullptr;
+      size_t                                     left_ = 0;
+    };
+
+    static uint32_t          hash_of      (std::wstring_view str);
+
+    std::wstring_view        value_of     (const entry_s& ent) const;
+
+    const entry_s*           find_entry   (const section_s& sec, std::wstring_view key) const;
+    entry_s*                 find_entry   (section_s&       sec, std::wstring_view key);
+
+    void                     add_entry    (section_s& sec, std::wstring_view key,
+                                           std::wstring_view value, bool overwrite);
+    bool                     assign_entry (section_id sec, entry_s& ent, std::wstring_view value);
+    bool                     resolve      (key_handle_s& key, bool create);
+
+    template <typename _Item, typename _Eq>
+    static uint32_t          index_find   (const index_s& idx, const std::vector <_Item>& items,
+                                           uint32_t hash, _Eq&& eq);
+    template <typename _Item>
+    static void              index_insert (index_s& idx, const std::vector <_Item>& items,
+                                           uint32_t pos);
+    template <typename _Item>
+    static void              index_build  (index_s& idx, const std::vector <_Item>& items);
+
+    void                     clear        (void);
+    void                     parse_text   (std::wstring_view text, bool overwrite);
+
+    encoding_e               encoding_ = Encoding_UTF16LE;
+    arena_s                  arena_;
+
+    std::vector <section_s>  sections_;
+    index_s                  section_index_;
+    size_t                   live_sections_ = 0;
+
+    // Sections added / removed / renamed since the last save
+    bool                     dirty_         = false;
+
+    // Bumped whenever a key_handle_s could be left pointing at the wrong thing
+    uint32_t                 epoch_         = 1;
+
+    // (section, entry) of every value handed out through value_ref ()
+    std::vector <std::pair <section_id, uint32_t>>
+                             watched_;
+
+    // Values that have been handed out as mutable strings
+    std::deque  <owned_s>    owned_;
+  };
+}
+
+#endif /* __UNX__INIFILE_H__ */
@@ -37,8 +37,18 @@
 #include "window.h"
 #include "hook.h"
 #include "parameter.h"
+#include "inifile.h"
+#include "schema.h"
+#include "snapshot.h"
 
 #include "input.h"
+#include "seqlock.h"
+#include "lockfree.h"
+#include "remap.h"
+#include "keymap.h"
+#include "keynames.h"
+#include "cheat.h"
+#include "replay.h"
 
 #include <cstdint>
 #include <queue>
@@ -54,7 +64,125 @@ using SK_GetGameWindow_pfn = HWND (WINAPI *)(void);
       SK_GetGameWindow_pfn SK_GetGameWindow;
 
 unx_gamepad_s          gamepad;
-unx::ParameterStringW* texture_set;
+
+
+//
+// UnX_Gamepad.ini, minus keybinds and combos (those stay parameters; the
+//   dialogs that edit them store through the parameter they are bound to).
+//
+using unx::schema::Field;
+
+// Gamepad.Remap holds button indices, gamepad.remap.buttons the enum values
+enum {
+  PadRemap_A,  PadRemap_B,  PadRemap_X,     PadRemap_Y,
+  PadRemap_LB, PadRemap_RB, PadRemap_LT,    PadRemap_RT,
+  PadRemap_LS, PadRemap_RS, PadRemap_Start, PadRemap_Back,
+
+  PadRemap_Count
+};
+
+extern iSK_INI* pad_cfg;
+
+static int  pad_remap_idx [PadRemap_Count] = { };
+
+// Read only for the sake of writing it back; see InputManager::Init
+static bool pad_uses_xinput                = true;
+
+static constexpr unx::schema::field_s pad_schema [] =
+{
+  Field (0, L"Gamepad.Type",   L"TextureSet",        &gamepad.tex_set),
+  Field (0, L"Gamepad.Type",   L"UsesXInput",        &pad_uses_xinput),
+
+  Field (0, L"Gamepad.Replay", L"Mode",              &gamepad.replay.mode),
+  Field (0, L"Gamepad.Replay", L"File",              &gamepad.replay.file),
+  Field (0, L"Gamepad.Replay", L"Loop",              &gamepad.replay.loop),
+
+  Field (0, L"Gamepad.Legacy", L"AxisDeadZone",      &gamepad.axis.dead_zone),
+  Field (0, L"Gamepad.Legacy", L"AxisResponseCurve", &gamepad.axis.curve),
+
+  Field (0, L"Gamepad.Remap",  L"XInput_A",          &pad_remap_idx [PadRemap_A]),
+  Field (0, L"Gamepad.Remap",  L"XInput_B",          &pad_remap_idx [PadRemap_B]),
+  Field (0, L"Gamepad.Remap",  L"XInput_X",          &pad_remap_idx [PadRemap_X]),
+  Field (0, L"Gamepad.Remap",  L"XInput_Y",          &pad_remap_idx [PadRemap_Y]),
+  Field (0, L"Gamepad.Remap",  L"XInput_Start",      &pad_remap_idx [PadRemap_Start]),
+  Field (0, L"Gamepad.Remap",  L"XInput_Back",       &pad_remap_idx [PadRemap_Back]),
+  Field (0, L"Gamepad.Remap",  L"XInput_LB",         &pad_remap_idx [PadRemap_LB]),
+  Field (0, L"Gamepad.Remap",  L"XInput_RB",         &pad_remap_idx [PadRemap_RB]),
+  Field (0, L"Gamepad.Remap",  L"XInput_LT",         &pad_remap_idx [PadRemap_LT]),
+  Field (0, L"Gamepad.Remap",  L"XInput_RT",         &pad_remap_idx [PadRemap_RT]),
+  Field (0, L"Gamepad.Remap",  L"XInput_LS",         &pad_remap_idx [PadRemap_LS]),
+  Field (0, L"Gamepad.Remap",  L"XInput_RS",         &pad_remap_idx [PadRemap_RS])
+};
+
+// Keybinds and combos load through their parameters (see Init); this only
+//   describes them, so that the config snapshot can carry them too.
+static constexpr unx::schema::field_s pad_bindings [] =
+{
+  Field (0, L"UNX.Keybinds",  L"CycleSpeedBoost",       &keybinds.SpeedStep.human_readable),
+  Field (0, L"UNX.Keybinds",  L"KickStart",             &keybinds.KickStart.human_readable),
+  Field (0, L"UNX.Keybinds",  L"ToggleTimeStop",        &keybinds.TimeStop.human_readable),
+  Field (0, L"UNX.Keybinds",  L"ToggleFreeLook",        &keybinds.FreeLook.human_readable),
+  Field (0, L"UNX.Keybinds",  L"TogglePermanentSensor", &keybinds.Sensor.human_readable),
+  Field (0, L"UNX.Keybinds",  L"ToggleFullPartyAP",     &keybinds.FullAP.human_readable),
+  Field (0, L"UNX.Keybinds",  L"ToggleVSYNC",           &keybinds.VSYNC.human_readable),
+  Field (0, L"UNX.Keybinds",  L"SoftReset",             &keybinds.SoftReset.human_readable),
+
+  Field (0, L"Gamepad.PC",    L"SpeedBoost",            &gamepad.speedboost.unparsed),
+  Field (0, L"Gamepad.PC",    L"KickStart",             &gamepad.kickstart.unparsed),
+  Field (0, L"Gamepad.PC",    L"F1",                    &gamepad.f1.unparsed),
+  Field (0, L"Gamepad.PC",    L"F2",                    &gamepad.f2.unparsed),
+  Field (0, L"Gamepad.PC",    L"F3",                    &gamepad.f3.unparsed),
+  Field (0, L"Gamepad.PC",    L"F4",                    &gamepad.f4.unparsed),
+  Field (0, L"Gamepad.PC",    L"F5",                    &gamepad.f5.unparsed),
+  Field (0, L"Gamepad.PC",    L"ESC",                   &gamepad.esc.unparsed),
+  Field (0, L"Gamepad.PC",    L"Fullscreen",            &gamepad.fullscreen.unparsed),
+  Field (0, L"Gamepad.Steam", L"Screenshot",            &gamepad.screenshot.unparsed),
+  Field (0, L"Gamepad.PC",    L"SoftReset",             &gamepad.softreset.unparsed)
+};
+
+size_t
+unx::InputManager::GetSnapshotTables (unx::snapshot::table_s* tables, size_t max)
+{
+  const unx::snapshot::table_s pad_tables [] = {
+    { pad_schema,   sizeof (pad_schema)   / sizeof (pad_schema   [0]), 0 },
+    { pad_bindings, sizeof (pad_bindings) / sizeof (pad_bindings [0]), 0 }
+  };
+
+  size_t count = 0;
+
+  for (const auto& table : pad_tables)
+  {
+    if (count < max)
+      tables [count++] = table;
+  }
+
+  return count;
+}
+
+static int*
+UNX_PadRemapButton (int remap)
+{
+  auto& btn = gamepad.remap.buttons;
+
+  int* const buttons [PadRemap_Count] = {
+    &btn.A,  &btn.B,  &btn.X,  &btn.Y,
+    &btn.LB, &btn.RB, &btn.LT, &btn.RT,
+    &btn.LS, &btn.RS, &btn.START, &btn.BACK
+  };
+
+  return buttons [remap];
+}
+
+void
+unx::InputManager::StoreGamepadConfig (void)
+{
+  for (int i = 0; i < PadRemap_Count; i++)
+    pad_remap_idx [i] = gamepad.remap.enumToIndex (*UNX_PadRemapButton (i));
+
+  unx::INIFile* files [] = { UNX_GetINIFile (pad_cfg) };
+
+  unx::schema::Store (pad_schema, files);
+}
 
 ///////////////////////////////////////////////////////////////////////////////
 //
@@ -86,6 +214,35 @@ SK_Input_GetDI8Keyboard_pfn SK_Input_GetDI8Keyboard   = nullptr;
 IDirectInputDevice8_GetDeviceState_pfn
         IDirectInputDevice8_GetDeviceState_Original   = nullptr;
 
+// Both built once in InputManager::Init
+static unx::remap::joy_remap_s di8_remap;
+static unx::remap::key_mask_s  di8_background_keys;
+
+// Axis-mapped buttons are thresholded in raw units, which depend on the
+//   range the game gave each axis.
+static void
+UNX_DI8_ReadAxisRanges (LPDIRECTINPUTDEVICE8W pDev)
+{
+  static const DWORD axis_ofs [unx::remap::MaxAxes] = {
+    DIJOFS_X,  DIJOFS_Y,  DIJOFS_Z,
+    DIJOFS_RX, DIJOFS_RY, DIJOFS_RZ
+  };
+
+  for (int i = 0; i < unx::remap::MaxAxes; i++)
+  {
+    DIPROPRANGE range                   = { };
+                range.diph.dwSize       = sizeof DIPROPRANGE;
+                range.diph.dwHeaderSize = sizeof DIPROPHEADER;
+                range.diph.dwObj        = axis_ofs [i];
+                range.diph.dwHow        = DIPH_BYOFFSET;
+
+    if (SUCCEEDED (pDev->GetProperty (DIPROP_RANGE, &range.diph)))
+      unx::remap::SetAxisRange (&di8_remap, i, range.lMin, range.lMax);
+    else
+      unx::remap::SetAxisRange (&di8_remap, i, 0,          65535);
+  }
+}
+
 
 // I don't care about joysticks, let them continue working while
 //   the window does not have focus...
@@ -120,17 +277,18 @@ IDirectInputDevice8_GetDeviceState_Detour ( LPDIRECTINPUTDEVICE8W      This,
 
       else
       {
-        DIJOYSTATE2  in  = *out;
+        static LPDIRECTINPUTDEVICE8W pLastDev = nullptr;
 
-        for (int i = 0; i < 12; i++)
+        if (di8_remap.axis_count > 0 && This != pLastDev)
         {
-          // Negative values are for axes, we cannot remap those yet
-          if (gamepad.remap.map [ i ] >= 0)
-          {
-            out->rgbButtons [ i ] = 
-              in.rgbButtons [ gamepad.remap.map [ i ] ];
-          }
+          UNX_DI8_ReadAxisRanges (This);
+          pLastDev = This;
         }
+
+        // lX ... lRz are the first six LONGs of DIJOYSTATE2
+        unx::remap::ApplyJoyRemap ( di8_remap,
+                                      (const int32_t *)&out->lX,
+                                        out->rgbButtons );
       }
     }
   }
@@ -144,19 +302,13 @@ IDirectInputDevice8_GetDeviceState_Detour ( LPDIRECTINPUTDEVICE8W      This,
 
     else
     {
-      memcpy (lpvData, SK_Input_GetDI8Keyboard ()->state, cbData);
-
-      ((uint8_t *)lpvData) [DIK_LALT]   = 0x0;
-      ((uint8_t *)lpvData) [DIK_RALT]   = 0x0;
-      ((uint8_t *)lpvData) [DIK_TAB]    = 0x0;
-      ((uint8_t *)lpvData) [DIK_ESCAPE] = 0x0;
-      ((uint8_t *)lpvData) [DIK_UP]     = 0x0;
-      ((uint8_t *)lpvData) [DIK_DOWN]   = 0x0;
-      ((uint8_t *)lpvData) [DIK_LEFT]   = 0x0;
-      ((uint8_t *)lpvData) [DIK_RIGHT]  = 0x0;
-      ((uint8_t *)lpvData) [DIK_RETURN] = 0x0;
-      ((uint8_t *)lpvData) [DIK_LMENU]  = 0x0;
-      ((uint8_t *)lpvData) [DIK_RMENU]  = 0x0;
+      // Anything past the 256 scan codes is passed through unmasked
+      if (cbData > sizeof di8_background_keys.keep)
+        memcpy (lpvData, SK_Input_GetDI8Keyboard ()->state, cbData);
+
+      unx::remap::ApplyKeyMask ( di8_background_keys,
+                                   SK_Input_GetDI8Keyboard ()->state,
+                                     (uint8_t *)lpvData, cbData );
     }
   }
 
@@ -202,11 +354,14 @@ WINAPI
 XInputGetState_Detour ( _In_  DWORD         dwUserIndex,
                         _Out_ XINPUT_STATE *pState )
 {
-  if (! config.input.remap_dinput8)
+  const unx_hot_config_s hot =
+    UNX_GetHotConfig ();
+
+  if (! hot.remap_dinput8)
     return XInputGetState_Original (dwUserIndex, pState);
 
-  int slot = config.input.gamepad_slot == -1 ?
-               0 : config.input.gamepad_slot;
+  int slot = hot.gamepad_slot == -1 ?
+               0 : hot.gamepad_slot;
 
   DWORD dwRet = XInputGetState_Original (slot, pState);
 
@@ -241,10 +396,9 @@ using SK_PluginKeyPress_pfn = void (CALLBACK *)( BOOL Control,
 void
 UNX_KickStart (void)
 {
-  SK_ICommandResult result = 
-    SK_GetCommandProcessor ()->ProcessCommandLine ("Window.OverrideRes");
+  static unx::PreparedVariable override_res ("Window.OverrideRes");
 
-  if (result.getVariable () != nullptr)
+  if (override_res.valid ())
   {
     CreateThread (nullptr, 0, [] (LPVOID) ->
     DWORD
@@ -252,16 +406,11 @@ UNX_KickStart (void)
       RECT client;
       GetClientRect (unx::window.hwnd, &client);
 
-      SK_GetCommandProcessor ()->ProcessCommandLine (
-        "Window.OverrideRes 640x480 "
-      );
-      SK_GetCommandProcessor ()->ProcessCommandFormatted (
-        "Window.OverrideRes %lux%lu ",
-          client.right  - client.left,
-          client.bottom - client.top );
-      SK_GetCommandProcessor ()->ProcessCommandLine (
-        "Window.OverrideRes 0x0 "
-      );
+      override_res.set  ("640x480");
+      override_res.setf ( "%lux%lu",
+                            client.right  - client.left,
+                            client.bottom - client.top );
+      override_res.set  ("0x0");
 
       CloseHandle (GetCurrentThread ());
 
@@ -272,23 +421,113 @@ UNX_KickStart (void)
 
 UNX_Keybindings keybinds;
 
+struct {
+  HANDLE hThread   = nullptr;
+  HANDLE hWake     = nullptr; // Device arrival / removal; poll right away
+  HANDLE hShutdown = nullptr;
+} gamepad_poller;
+
+struct {
+  HANDLE hThread   = nullptr;
+  HANDLE hWork     = nullptr; // Something was queued
+  HANDLE hShutdown = nullptr;
+} input_executor;
+
 
-std::unordered_map <std::wstring, BYTE> humanKeyNameToVirtKeyCode;
-std::unordered_map <BYTE, std::wstring> virtKeyCodeToHumanKeyName;
 
 #define SK_MakeKeyMask(vKey,ctrl,shift,alt) \
   (UINT)((vKey) | (((ctrl) != 0) <<  9) |   \
                   (((shift)!= 0) << 10) |   \
                   (((alt)  != 0) << 11))
 
+//
+// Whatever the OS calls each key on the current keyboard layout.
+//
+//   Only needed for keys that have no canonical name, and for bindings
+//     saved by older versions (which stored these names), so it is not
+//       built until something misses the canonical table.
+//
+static const wchar_t*
+UNX_LocalizedKeyName (BYTE vKey)
+{
+  static wchar_t names [256][32] = { };
+  static bool    init            = false;
+
+  if (! init)
+  {
+    init = true;
+
+    for (int i = 0; i < 0xFF; i++)
+    {
+      if ( i == VK_CONTROL  || i == VK_MENU     ||
+           i == VK_SHIFT    || i == VK_OEM_PLUS || i == VK_OEM_MINUS ||
+           i == VK_LSHIFT   || i == VK_RSHIFT   ||
+           i == VK_LCONTROL || i == VK_RCONTROL ||
+           i == VK_LMENU    || i == VK_RMENU )
+      {
+        continue;
+      }
+
+      unsigned int scanCode =
+        ( MapVirtualKey (i, 0) & 0xFF );
+
+                    BYTE buf [256] = { };
+      unsigned short int temp      =  0;
+
+      bool asc = (i <= 32);
+
+      if (! asc && i != VK_DIVIDE)
+         asc = ToAscii ( i, scanCode, buf, &temp, 1 );
+
+      scanCode            <<= 16;
+      scanCode   |= ( 0x1 <<  25  );
+
+      if (! asc)
+        scanCode |= ( 0x1 << 24   );
+
+      GetKeyNameText ( scanCode,
+                         names [i],
+                           32 );
+    }
+  }
+
+  return names [vKey][0] != L'\0' ? names [vKey] :
+                                     nullptr;
+}
+
+static BYTE
+UNX_KeyFromName (const wchar_t* wszName)
+{
+  BYTE vKey =
+    unx::keys::VirtualKeyFromName (wszName);
+
+  if (vKey != 0)
+    return vKey;
+
+  for (int i = 1; i < 0xFF; i++)
+  {
+    const wchar_t* wszLocal =
+      UNX_LocalizedKeyName ((BYTE)i);
+
+    if (wszLocal != nullptr && (! wcscmp (wszLocal, wszName)))
+      return (BYTE)i;
+  }
+
+  return 0;
+}
+
 void
 SK_Keybind::update (void)
 {
   human_readable = L"";
 
-  std::wstring key_name = virtKeyCodeToHumanKeyName [(BYTE)(vKey & 0xFF)];
+  const wchar_t* key_name =
+    unx::keys::CanonicalName ((BYTE)(vKey & 0xFF));
+
+  if (key_name == nullptr)
+    key_name = UNX_LocalizedKeyName ((BYTE)(vKey & 0xFF));
 
-  if (! key_name.length ())
+  if (key_name == nullptr)
     return;
 
   std::queue <std::wstring> words;
@@ -321,111 +560,6 @@ SK_Keybind::parse (void)
 {
   vKey = 0x00;
 
-  static bool init = false;
-
-  if (! init)
-  {
-    init = true;
-
-    for (int i = 0; i < 0xFF; i++)
-    {
-      wchar_t name [32] = { };
-
-      switch (i)
-      {
-        case VK_F1:     wcscat (name, L"F1");           break;
-        case VK_F2:     wcscat (name, L"F2");           break;
-        case VK_F3:     wcscat (name, L"F3");           break;
-        case VK_F4:     wcscat (name, L"F4");           break;
-        case VK_F5:     wcscat (name, L"F5");           break;
-        case VK_F6:     wcscat (name, L"F6");           break;
-        case VK_F7:     wcscat (name, L"F7");           break;
-        case VK_F8:     wcscat (name, L"F8");           break;
-        case VK_F9:     wcscat (name, L"F9");           break;
-        case VK_F10:    wcscat (name, L"F10");          break;
-        case VK_F11:    wcscat (name, L"F11");          break;
-        case VK_F12:    wcscat (name, L"F12");          break;
-        case VK_F13:    wcscat (name, L"F13");          break;
-        case VK_F14:    wcscat (name, L"F14");          break;
-        case VK_F15:    wcscat (name, L"F15");          break;
-        case VK_F16:    wcscat (name, L"F16");          break;
-        case VK_F17:    wcscat (name, L"F17");          break;
-        case VK_F18:    wcscat (name, L"F18");          break;
-        case VK_F19:    wcscat (name, L"F19");          break;
-        case VK_F20:    wcscat (name, L"F20");          break;
-        case VK_F21:    wcscat (name, L"F21");          break;
-        case VK_F22:    wcscat (name, L"F22");          break;
-        case VK_F23:    wcscat (name, L"F23");          break;
-        case VK_F24:    wcscat (name, L"F24");          break;
-        case VK_PRINT:  wcscat (name, L"Print Screen"); break;
-        case VK_SCROLL: wcscat (name, L"Scroll Lock");  break;
-        case VK_PAUSE:  wcscat (name, L"Pause Break");  break;
-
-        default:
-        {
-          unsigned int scanCode =
-            ( MapVirtualKey (i, 0) & 0xFF );
-
-                        BYTE buf [256] = { };
-          unsigned short int temp      =  0;
-          
-          bool asc = (i <= 32);
-
-          if (! asc && i != VK_DIVIDE)
-             asc = ToAscii ( i, scanCode, buf, &temp, 1 );
-
-          scanCode            <<= 16;
-          scanCode   |= ( 0x1 <<  25  );
-
-          if (! asc)
-            scanCode |= ( 0x1 << 24   );
-    
-          GetKeyNameText ( scanCode,
-                             name,
-                               32 );
-        } break;
-      }
-
-    
-      if ( i != VK_CONTROL  && i != VK_MENU     &&
-           i != VK_SHIFT    && i != VK_OEM_PLUS && i != VK_OEM_MINUS &&
-           i != VK_LSHIFT   && i != VK_RSHIFT   &&
-           i != VK_LCONTROL && i != VK_RCONTROL &&
-           i != VK_LMENU    && i != VK_RMENU )
-      {
-
-        humanKeyNameToVirtKeyCode.emplace (name, (BYTE)i);
-        virtKeyCodeToHumanKeyName.emplace ((BYTE)i, name);
-      }
-    }
-    
-    humanKeyNameToVirtKeyCode.emplace (L"Plus",        (BYTE)VK_OEM_PLUS);
-    humanKeyNameToVirtKeyCode.emplace (L"Minus",       (BYTE)VK_OEM_MINUS);
-    humanKeyNameToVirtKeyCode.emplace (L"Ctrl",        (BYTE)VK_CONTROL);
-    humanKeyNameToVirtKeyCode.emplace (L"Alt",         (BYTE)VK_MENU);
-    humanKeyNameToVirtKeyCode.emplace (L"Shift",       (BYTE)VK_SHIFT);
-    humanKeyNameToVirtKeyCode.emplace (L"Left Shift",  (BYTE)VK_LSHIFT);
-    humanKeyNameToVirtKeyCode.emplace (L"Right Shift", (BYTE)VK_RSHIFT);
-    humanKeyNameToVirtKeyCode.emplace (L"Left Alt",    (BYTE)VK_LMENU);
-    humanKeyNameToVirtKeyCode.emplace (L"Right Alt",   (BYTE)VK_RMENU);
-    humanKeyNameToVirtKeyCode.emplace (L"Left Ctrl",   (BYTE)VK_LCONTROL);
-    humanKeyNameToVirtKeyCode.emplace (L"Right Ctrl",  (BYTE)VK_RCONTROL);
-    
-    virtKeyCodeToHumanKeyName.emplace ((BYTE)VK_CONTROL,   L"Ctrl");
-    virtKeyCodeToHumanKeyName.emplace ((BYTE)VK_MENU,      L"Alt");
-    virtKeyCodeToHumanKeyName.emplace ((BYTE)VK_SHIFT,     L"Shift");
-    virtKeyCodeToHumanKeyName.emplace ((BYTE)VK_OEM_PLUS,  L"Plus");
-    virtKeyCodeToHumanKeyName.emplace ((BYTE)VK_OEM_MINUS, L"Minus");
-    virtKeyCodeToHumanKeyName.emplace ((BYTE)VK_LSHIFT,    L"Left Shift");
-    virtKeyCodeToHumanKeyName.emplace ((BYTE)VK_RSHIFT,    L"Right Shift");
-    virtKeyCodeToHumanKeyName.emplace ((BYTE)VK_LMENU,     L"Left Alt");
-    virtKeyCodeToHumanKeyName.emplace ((BYTE)VK_RMENU,     L"Right Alt");  
-    virtKeyCodeToHumanKeyName.emplace ((BYTE)VK_LCONTROL,  L"Left Ctrl"); 
-    virtKeyCodeToHumanKeyName.emplace ((BYTE)VK_RCONTROL,  L"Right Ctrl");
-
-    init = true;
-  }
-
   wchar_t wszKeyBind [128] = { };
 
   lstrcatW (wszKeyBind, human_readable.c_str ());
@@ -439,12 +573,12 @@ SK_Keybind::parse (void)
 
   if (wszTok == nullptr)
   {
-    vKey = humanKeyNameToVirtKeyCode [wszKeyBind];
+    vKey = UNX_KeyFromName (wszKeyBind);
   }
 
   while (wszTok)
   {
-    BYTE vKey_ = humanKeyNameToVirtKeyCode [wszTok];
+    BYTE vKey_ = UNX_KeyFromName (wszTok);
 
     if (vKey_ == VK_CONTROL)
       modifiers.ctrl  = true;
@@ -461,91 +595,153 @@ SK_Keybind::parse (void)
   masked_code = SK_MakeKeyMask (vKey & 0xFF, modifiers.ctrl, modifiers.shift, modifiers.alt);
 }
 
-void
-CALLBACK
-SK_UNX_PluginKeyPress ( BOOL Control,
-                        BOOL Shift,
-                        BOOL Alt,
-                        BYTE vkCode )
+//
+// Keyboard actions; bound to keys through keybind_dispatch
+//
+static void
+UNX_Keybind_SpeedStep (void)
 {
-  extern __declspec (dllimport) bool SK_ImGui_Visible;
-
-  // Don't trigger keybindings while we are setting them ;)
-  if (SK_ImGui_Visible)
-    return;
+  extern void UNX_SpeedStep (); 
+              UNX_SpeedStep ();
+}
 
+static void
+UNX_Keybind_KickStart (void)
+{
+  UNX_KickStart ();
+}
 
-  auto masked_key =
-    SK_MakeKeyMask (vkCode & 0xFF, Control, Shift, Alt);
+static void
+UNX_Keybind_TimeStop (void)
+{
+  extern void UNX_TimeStop (void);
+              UNX_TimeStop ();
+}
 
-  if (masked_key == keybinds.SpeedStep.masked_code)
-  {
-    extern void UNX_SpeedStep (); 
-                UNX_SpeedStep ();
-  }
+static void
+UNX_Keybind_FullAP (void)
+{
+  extern void UNX_TogglePartyAP (void);
+              UNX_TogglePartyAP ();
+}
 
-  else if (masked_key == keybinds.KickStart.masked_code)
-  {
-    UNX_KickStart ();
-  }
+static void
+UNX_Keybind_Sensor (void)
+{
+  extern void UNX_ToggleSensor (void);
+              UNX_ToggleSensor ();
+}
 
-  else if (masked_key == keybinds.TimeStop.masked_code)
-  {
-    extern void UNX_TimeStop (void);
-                UNX_TimeStop ();
-  }
+static void
+UNX_Keybind_FreeLook (void)
+{
+  extern void UNX_ToggleFreeLook (void);
+              UNX_ToggleFreeLook ();
+}
 
-  else if (masked_key == keybinds.FullAP.masked_code)
-  {
-    extern void UNX_TogglePartyAP (void);
-                UNX_TogglePartyAP ();
-  }
+// FFX Soft Reset
+static void
+UNX_Keybind_SoftReset (void)
+{
+  extern bool UNX_KillMeNow (void);
+              UNX_KillMeNow ();
+}
 
-  else if (masked_key == keybinds.Sensor.masked_code)
-  {
-    extern void UNX_ToggleSensor (void);
-                UNX_ToggleSensor ();
-  }
+static void
+UNX_Keybind_VSYNC (void)
+{
+  // Looked up once; reading the value does not need the command parser
+  static unx::PreparedVariable present_interval ("PresentationInterval");
 
-  else if (masked_key == keybinds.FreeLook.masked_code)
-  {
-    extern void UNX_ToggleFreeLook (void);
-                UNX_ToggleFreeLook ();
-  }
+  int interval = 1;
 
-  // FFX Soft Reset
-  else if (masked_key == keybinds.SoftReset.masked_code)
+  if (! present_interval.read (interval))
   {
-    extern bool UNX_KillMeNow (void);
-                UNX_KillMeNow ();
-  }
+    const SK_IVariable* var = present_interval.get ();
 
-  else if (masked_key == keybinds.VSYNC.masked_code)
-  {
-    SK_ICommandResult result = 
-      SK_GetCommandProcessor ()->ProcessCommandLine ("PresentationInterval");
+    if (var == nullptr)
+      return;
 
     uint32_t dwLen = 4;
     char szPresent [4];
 
-    result.getVariable ()->getValueString (szPresent, &dwLen);
+    var->getValueString (szPresent, &dwLen);
 
-    if (strcmp (szPresent, "0"))
-      SK_GetCommandProcessor ()->ProcessCommandLine ("PresentationInterval 0");
-    else
-      SK_GetCommandProcessor ()->ProcessCommandLine ("PresentationInterval 1");
+    interval = strcmp (szPresent, "0") ? 1 : 0;
   }
 
-  //else if (vkCode == 'U') {
-  //  extern void UNX_FFX2_UnitTest (void);
-  //  UNX_FFX2_UnitTest ();
-  //}
+  present_interval.set (interval != 0 ? 0 : 1);
+}
+
+static void
+UNX_Keybind_Quickie (void)
+{
+  extern void UNX_Quickie (void);
+  UNX_Quickie ();
+}
+
+static unx::KeyDispatchTable keybind_dispatch;
+
+void
+unx::InputManager::RebuildKeybinds (void)
+{
+  //
+  // Every binding is live in both games (the FFX-only handlers check
+  //   game_type themselves). The order is the old if / else chain's, so a
+  //     key bound twice still goes to the same action.
+  //
+  static const struct {
+    SK_Keybind*                       binding;
+    unx::KeyDispatchTable::handler_fn handler;
+  } actions [] = {
+    { &keybinds.SpeedStep, UNX_Keybind_SpeedStep },
+    { &keybinds.KickStart, UNX_Keybind_KickStart },
+    { &keybinds.TimeStop,  UNX_Keybind_TimeStop  },
+    { &keybinds.FullAP,    UNX_Keybind_FullAP    },
+    { &keybinds.Sensor,    UNX_Keybind_Sensor    },
+    { &keybinds.FreeLook,  UNX_Keybind_FreeLook  },
+    { &keybinds.SoftReset, UNX_Keybind_SoftReset },
+    { &keybinds.VSYNC,     UNX_Keybind_VSYNC     }
+  };
+
+  std::vector <unx::KeyDispatchTable::binding_s> table;
+                                                 table.reserve (sizeof (actions) / sizeof (actions [0]) + 2);
+
+  for (auto& action : actions)
+    table.push_back ({ action.binding->masked_code, action.handler });
+
+  // Not user-configurable, and loses to anything the user bound; Alt was
+  //   never checked, so Ctrl+Alt+Shift+Q works too
+  table.push_back ({ SK_MakeKeyMask ('Q', true, true, false), UNX_Keybind_Quickie });
+  table.push_back ({ SK_MakeKeyMask ('Q', true, true, true),  UNX_Keybind_Quickie });
 
-  else if (Control && Shift && vkCode == 'Q')
+  size_t shadowed =
+    keybind_dispatch.rebuild (table.data (), table.size ());
+
+  if (shadowed > 0)
   {
-    extern void UNX_Quickie (void);
-    UNX_Quickie ();
+    dll_log->Log ( L"[ Keybinds ] %lu binding(s) share a key with an earlier one "
+                   L"and will never fire", (unsigned long)shadowed );
   }
+}
+
+void
+CALLBACK
+SK_UNX_PluginKeyPress ( BOOL Control,
+                        BOOL Shift,
+                        BOOL Alt,
+                        BYTE vkCode )
+{
+  extern __declspec (dllimport) bool SK_ImGui_Visible;
+
+  // Don't trigger keybindings while we are setting them ;)
+  if (SK_ImGui_Visible)
+    return;
+
+
+  keybind_dispatch.dispatch (
+    SK_MakeKeyMask (vkCode & 0xFF, Control, Shift, Alt)
+  );
 
   SK_PluginKeyPress_Original (Control, Shift, Alt, vkCode);
 }
@@ -581,6 +777,9 @@ unx::InputManager::Init (void)
       ).c_str ()
     );
 
+  // Everything below that reads UnX_Gamepad.ini was already filled in
+  const bool from_snapshot = UNX_ConfigFromSnapshot ();
+
   auto LoadKeybind =
     [&](SK_Keybind* binding, wchar_t* ini_name) ->
       auto
@@ -591,13 +790,17 @@ unx::InputManager::Init (void)
 
         ret->register_to_ini ( pad_cfg, L"UNX.Keybinds", ini_name );
 
-        if (! ret->load (binding->human_readable))
+        if (! from_snapshot)
         {
-          binding->parse ();
-          ret->store     (binding->human_readable);
+          if (! ret->load (binding->human_readable))
+          {
+            binding->parse ();
+            ret->store     (binding->human_readable);
+          }
+
+          binding->human_readable = ret->get_value ();
         }
 
-        binding->human_readable = ret->get_value ();
         binding->parse ();
 
         return ret;
@@ -612,27 +815,42 @@ unx::InputManager::Init (void)
   unx_VSYNC      = LoadKeybind (&keybinds.VSYNC,           L"ToggleVSYNC");
   unx_soft_reset = LoadKeybind (&keybinds.SoftReset,       L"SoftReset");
 
-  texture_set =
-    (unx::ParameterStringW *)factory.create_parameter <std::wstring> (L"Texture Set");
-  texture_set->register_to_ini (pad_cfg, L"Gamepad.Type", L"TextureSet");
+  RebuildKeybinds ();
 
-  if (! texture_set->load (gamepad.tex_set))
+  if (! from_snapshot)
   {
-    gamepad.tex_set = L"PlayStation_Glossy";
+    for (int i = 0; i < PadRemap_Count; i++)
+      pad_remap_idx [i] = gamepad.remap.enumToIndex (*UNX_PadRemapButton (i));
+
+    unx::INIFile* pad_files [] = { UNX_GetINIFile (pad_cfg) };
 
-    texture_set->store (gamepad.tex_set);
+    unx::schema::Load (pad_schema, pad_files);
   }
 
-  if ( texture_set->get_value ().length () )
+  // v 0.9.2:
+  //
+  //   * DirectInput -> XInput is currently broken, so UsesXInput is ignored.
+  //
+  gamepad.legacy = false;
+  //gamepad.legacy = (! pad_uses_xinput);
+
+  //if (gamepad.legacy)
   {
-    config.textures.gamepad =
-      texture_set->get_value ();
+    for (int i = 0; i < PadRemap_Count; i++)
+      *UNX_PadRemapButton (i) = gamepad.remap.indexToEnum (pad_remap_idx [i]);
+  }
 
-    //if (textures.gamepad_hash_ffx->load ())
-      //wscanf (L"0x%x", &config.textures.pad.icons.high);
+  // Writes back anything that was missing
+  if (! from_snapshot)
+    StoreGamepadConfig ();
 
-    //if (textures.gamepad_hash_ffx2->load ())
-      //wscanf (L"0x%x", &config.textures.pad.icons.low);
+  if ( gamepad.tex_set.length () )
+  {
+    UNX_UpdateConfig ([](unx_config_s& cfg) -> bool
+    {
+      cfg.textures.gamepad = gamepad.tex_set;
+      return true;
+    });
 
     wchar_t wszPadRoot [MAX_PATH] = { };
 
@@ -640,14 +858,14 @@ unx::InputManager::Init (void)
     lstrcatW (wszPadRoot, config.textures.gamepad.c_str ());
     lstrcatW (wszPadRoot, L"\\");
 
-    dll_log->Log (L"[Button Map] Button Pack: %s", wszPadRoot);
+    UNX_LOG (L"[Button Map] Button Pack: %s", wszPadRoot);
 
     wchar_t wszPadIcons [MAX_PATH] = { };
 
     lstrcatW (wszPadIcons, wszPadRoot);
     lstrcatW (wszPadIcons, L"ButtonMap.dds");
 
-    dll_log->Log (L"[Button Map] Button Map:  %s", wszPadIcons);
+    UNX_LOG (L"[Button Map] Button Map:  %s", wszPadIcons);
 
     SK_D3D11_AddTexHash ( wszPadIcons,
                             config.textures.pad.icons.high,
@@ -690,21 +908,21 @@ unx::InputManager::Init (void)
         {
           if (i > 0)
           {
-            dll_log->LogEx
+            UNX_LOG_EX
                         ( false, L"\n" );
           }
 
-          dll_log->LogEx ( true, L"[Button Map] Button %10s: '%#38s' ( %08x :: ",
-                           wszButtons [i / pad_lods],
-                             wszPadButton,
-                               hash );
+          UNX_LOG_EX ( true, L"[Button Map] Button %10s: '%#38s' ( %08x :: ",
+                       wszButtons [i / pad_lods],
+                         wszPadButton,
+                           hash );
 
           new_button = false;
         }
 
         else
         {
-          dll_log->LogEx ( false, L"%08x )", hash );
+          UNX_LOG_EX ( false, L"%08x )", hash );
         }
 
         SK_D3D11_AddTexHash (
@@ -715,147 +933,7 @@ unx::InputManager::Init (void)
       }
     }
 
-    dll_log->LogEx ( false, L"\n" );
-  }
-
-
-  auto* supports_XInput = 
-    (unx::ParameterBool *)factory.create_parameter <bool> (L"Disable XInput?");
-  supports_XInput->register_to_ini (pad_cfg, L"Gamepad.Type", L"UsesXInput");
-
-  if (((unx::iParameter *)supports_XInput)->load ())
-  {
-    // v 0.9.2:
-    //
-    //   * DirectInput -> XInput is currently broken, so just disable this.
-    //
-    gamepad.legacy = false;
-    //gamepad.legacy = (! supports_XInput->get_value ());
-  } else {
-    supports_XInput->store (true);
-  }
-
-  //if (gamepad.legacy)
-  {
-    auto* A     = (unx::ParameterInt *)factory.create_parameter <int> (L"A");
-    A->register_to_ini (pad_cfg, L"Gamepad.Remap", L"XInput_A");
-
-    if (((unx::iParameter *)A)->load ())
-    {
-      gamepad.remap.buttons.A = (gamepad.remap.indexToEnum (A->get_value ()));
-    } else {
-      A->store (gamepad.remap.enumToIndex (gamepad.remap.buttons.A));
-    }
-
-    auto* B     = (unx::ParameterInt *)factory.create_parameter <int> (L"B");
-    B->register_to_ini (pad_cfg, L"Gamepad.Remap", L"XInput_B");
-
-    if (((unx::iParameter *)B)->load ())
-    {
-      gamepad.remap.buttons.B = (gamepad.remap.indexToEnum (B->get_value ()));
-    } else {
-      B->store (gamepad.remap.enumToIndex (gamepad.remap.buttons.B));
-    }
-
-    auto* X     = (unx::ParameterInt *)factory.create_parameter <int> (L"X");
-    X->register_to_ini (pad_cfg, L"Gamepad.Remap", L"XInput_X");
-
-    if (((unx::iParameter *)X)->load ())
-    {
-      gamepad.remap.buttons.X = (gamepad.remap.indexToEnum (X->get_value ()));
-    } else {
-      X->store (gamepad.remap.enumToIndex (gamepad.remap.buttons.X));
-    }
-
-    auto* Y     = (unx::ParameterInt *)factory.create_parameter <int> (L"Y");
-    Y->register_to_ini (pad_cfg, L"Gamepad.Remap", L"XInput_Y");
-
-    if (((unx::iParameter *)Y)->load ())
-    {
-      gamepad.remap.buttons.Y = (gamepad.remap.indexToEnum (Y->get_value ()));
-    } else {
-      Y->store (gamepad.remap.enumToIndex (gamepad.remap.buttons.Y));
-    }
-
-    auto* START = (unx::ParameterInt *)factory.create_parameter <int> (L"START");
-    START->register_to_ini (pad_cfg, L"Gamepad.Remap", L"XInput_Start");
-
-    if (((unx::iParameter *)START)->load ())
-    {
-      gamepad.remap.buttons.START = (gamepad.remap.indexToEnum (START->get_value ()));
-    } else {
-      START->store (gamepad.remap.enumToIndex (gamepad.remap.buttons.START));
-    }
-
-    auto* BACK  = (unx::ParameterInt *)factory.create_parameter <int> (L"BACK");
-    BACK->register_to_ini (pad_cfg, L"Gamepad.Remap", L"XInput_Back");
-
-    if (((unx::iParameter *)BACK)->load ())
-    {
-      gamepad.remap.buttons.BACK = (gamepad.remap.indexToEnum (BACK->get_value ()));
-    } else {
-      BACK->store (gamepad.remap.enumToIndex (gamepad.remap.buttons.BACK));
-    }
-
-    auto* LB    = (unx::ParameterInt *)factory.create_parameter <int> (L"LB");
-    LB->register_to_ini (pad_cfg, L"Gamepad.Remap", L"XInput_LB");
-
-    if (((unx::iParameter *)LB)->load ())
-    {
-      gamepad.remap.buttons.LB = (gamepad.remap.indexToEnum (LB->get_value ()));
-    } else {
-      LB->store (gamepad.remap.enumToIndex (gamepad.remap.buttons.LB));
-    }
-
-    auto* RB    = (unx::ParameterInt *)factory.create_parameter <int> (L"RB");
-    RB->register_to_ini (pad_cfg, L"Gamepad.Remap", L"XInput_RB");
-
-    if (((unx::iParameter *)RB)->load ())
-    {
-      gamepad.remap.buttons.RB = (gamepad.remap.indexToEnum (RB->get_value ()));
-    } else {
-      RB->store (gamepad.remap.enumToIndex (gamepad.remap.buttons.RB));
-    }
-
-    auto* LT    = (unx::ParameterInt *)factory.create_parameter <int> (L"LT");
-    LT->register_to_ini (pad_cfg, L"Gamepad.Remap", L"XInput_LT");
-
-    if (((unx::iParameter *)LT)->load ())
-    {
-      gamepad.remap.buttons.LT = (gamepad.remap.indexToEnum (LT->get_value ()));
-    } else {
-      LT->store (gamepad.remap.enumToIndex (gamepad.remap.buttons.LT));
-    }
-
-    auto* RT    = (unx::ParameterInt *)factory.create_parameter <int> (L"RT");
-    RT->register_to_ini (pad_cfg, L"Gamepad.Remap", L"XInput_RT");
-
-    if (((unx::iParameter *)RT)->load ())
-    {
-      gamepad.remap.buttons.RT = (gamepad.remap.indexToEnum (RT->get_value ()));
-    } else {
-      RT->store (gamepad.remap.enumToIndex (gamepad.remap.buttons.RT));
-    }
-
-    auto* LS    = (unx::ParameterInt *)factory.create_parameter <int> (L"LS");
-    LS->register_to_ini (pad_cfg, L"Gamepad.Remap", L"XInput_LS");
-
-    if (((unx::iParameter *)LS)->load ())
-    {
-      gamepad.remap.buttons.LS = (gamepad.remap.indexToEnum (LS->get_value ()));
-    } else {
-      LS->store (gamepad.remap.enumToIndex (gamepad.remap.buttons.LS));
-    }
-
-    auto* RS    = (unx::ParameterInt *)factory.create_parameter <int> (L"RS");
-    RS->register_to_ini (pad_cfg, L"Gamepad.Remap", L"XInput_RS");
-
-    if (((unx::iParameter *)RS)->load ())
-    {
-      gamepad.remap.buttons.RS = (gamepad.remap.indexToEnum (RS->get_value ()));
-    } else {
-      RS->store (gamepad.remap.enumToIndex (gamepad.remap.buttons.RS));
-    }
+    UNX_LOG_EX ( false, L"\n" );
   }
 
 
@@ -940,7 +1018,7 @@ unx::InputManager::Init (void)
 
   combo_Speed->register_to_ini (pad_cfg, L"Gamepad.PC", L"SpeedBoost");
 
-  if (! combo_Speed->load (gamepad.speedboost.unparsed))
+  if ((! from_snapshot) && (! combo_Speed->load (gamepad.speedboost.unparsed)))
   {
     combo_Speed->store (
       (gamepad.speedboost.unparsed = L"Select+L2+Cross")
@@ -949,7 +1027,7 @@ unx::InputManager::Init (void)
 
   combo_Kickstart->register_to_ini (pad_cfg, L"Gamepad.PC", L"KickStart");
 
-  if (! combo_Kickstart->load (gamepad.kickstart.unparsed))
+  if ((! from_snapshot) && (! combo_Kickstart->load (gamepad.kickstart.unparsed)))
   {
     combo_Kickstart->store (
       (gamepad.kickstart.unparsed = L"L1+L2+Up")
@@ -959,7 +1037,7 @@ unx::InputManager::Init (void)
 
   combo_F1->register_to_ini (pad_cfg, L"Gamepad.PC", L"F1");
 
-  if (! combo_F1->load (gamepad.f1.unparsed))
+  if ((! from_snapshot) && (! combo_F1->load (gamepad.f1.unparsed)))
   {
     combo_F1->store (
       (gamepad.f1.unparsed = L"Select+Cross")
@@ -969,7 +1047,7 @@ unx::InputManager::Init (void)
 
   combo_F2->register_to_ini (pad_cfg, L"Gamepad.PC", L"F2");
 
-  if (! combo_F2->load (gamepad.f2.unparsed))
+  if ((! from_snapshot) && (! combo_F2->load (gamepad.f2.unparsed)))
   {
     combo_F2->store (
       (gamepad.f1.unparsed = L"Select+Circle")
@@ -979,7 +1057,7 @@ unx::InputManager::Init (void)
 
   combo_F3->register_to_ini (pad_cfg, L"Gamepad.PC", L"F3");
 
-  if (! combo_F3->load (gamepad.f3.unparsed))
+  if ((! from_snapshot) && (! combo_F3->load (gamepad.f3.unparsed)))
   {
     combo_F3->store (
       (gamepad.f3.unparsed = L"Select+Square")
@@ -989,7 +1067,7 @@ unx::InputManager::Init (void)
 
   combo_F4->register_to_ini (pad_cfg, L"Gamepad.PC", L"F4");
 
-  if (! combo_F4->load (gamepad.f4.unparsed))
+  if ((! from_snapshot) && (! combo_F4->load (gamepad.f4.unparsed)))
   {
     combo_F4->store (
       (gamepad.f4.unparsed = L"Select+L1")
@@ -999,7 +1077,7 @@ unx::InputManager::Init (void)
 
   combo_F5->register_to_ini (pad_cfg, L"Gamepad.PC", L"F5");
 
-  if (! combo_F5->load (gamepad.f5.unparsed))
+  if ((! from_snapshot) && (! combo_F5->load (gamepad.f5.unparsed)))
   {
     combo_F5->store (
       (gamepad.f5.unparsed = L"Select+R1")
@@ -1009,7 +1087,7 @@ unx::InputManager::Init (void)
 
   combo_ESC->register_to_ini (pad_cfg, L"Gamepad.PC", L"ESC");
 
-  if (! combo_ESC->load (gamepad.esc.unparsed))
+  if ((! from_snapshot) && (! combo_ESC->load (gamepad.esc.unparsed)))
   {
     combo_ESC->store (
       (gamepad.esc.unparsed = L"L2+R2+Select")
@@ -1019,7 +1097,7 @@ unx::InputManager::Init (void)
 
   combo_Fullscreen->register_to_ini (pad_cfg, L"Gamepad.PC", L"Fullscreen");
 
-  if (! combo_Fullscreen->load (gamepad.fullscreen.unparsed))
+  if ((! from_snapshot) && (! combo_Fullscreen->load (gamepad.fullscreen.unparsed)))
   {
     combo_Fullscreen->store (
       (gamepad.fullscreen.unparsed = L"L2+L3")
@@ -1029,7 +1107,7 @@ unx::InputManager::Init (void)
 
   combo_SS->register_to_ini (pad_cfg, L"Gamepad.Steam", L"Screenshot");
 
-  if (! combo_SS->load (gamepad.screenshot.unparsed))
+  if ((! from_snapshot) && (! combo_SS->load (gamepad.screenshot.unparsed)))
   {
     combo_SS->store (
       (gamepad.screenshot.unparsed = L"Select+R3")
@@ -1038,7 +1116,7 @@ unx::InputManager::Init (void)
 
   combo_SoftReset->register_to_ini (pad_cfg, L"Gamepad.PC", L"SoftReset");
 
-  if (! combo_SoftReset->load (gamepad.softreset.unparsed))
+  if ((! from_snapshot) && (! combo_SoftReset->load (gamepad.softreset.unparsed)))
   {
     combo_SoftReset->store (
       (gamepad.softreset.unparsed = L"L1+L2+R1+R2+Select+Start")
@@ -1076,14 +1154,67 @@ unx::InputManager::Init (void)
       ) - 1;
   }
 
-  SK_XInput_PollController =
-    (SK_XInput_PollController_pfn)
-      GetProcAddress ( GetModuleHandle (config.system.injector.c_str ()),
-                         "SK_XInput_PollController" );
+  const uint32_t rejected =
+    unx::remap::BuildJoyRemap (gamepad.remap.map, &di8_remap);
 
-  UNX_CreateDLLHook2 ( config.system.injector.c_str (),
-                       "SK_PluginKeyPress",
-                         SK_UNX_PluginKeyPress,
+  for (int i = 0; i < unx::remap::MaxRemappedButtons; i++)
+  {
+    if (rejected & (1UL << i))
+    {
+      dll_log->Log ( L"[ Input Ex ] DirectInput remap for button %i has no "
+                     L"source (%i); left unmapped",
+                       i, gamepad.remap.map [i] );
+    }
+  }
+
+  // Keys the game must not see held while it is in the background
+  static const uint8_t background_keys [] = {
+    DIK_LALT,   DIK_RALT,   DIK_TAB,    DIK_ESCAPE,
+    DIK_UP,     DIK_DOWN,   DIK_LEFT,   DIK_RIGHT,
+    DIK_RETURN, DIK_LMENU,  DIK_RMENU
+  };
+
+  unx::remap::BuildKeyMask ( background_keys,
+                               sizeof background_keys,
+                                 &di8_background_keys );
+
+  SK_XInput_PollController =
+    (SK_XInput_PollController_pfn)
+      GetProcAddress ( GetModuleHandle (config.system.injector.c_str ()),
+                         "SK_XInput_PollController" );
+
+  if (SK_XInput_PollController != nullptr || gamepad.legacy)
+  {
+    extern DWORD WINAPI UNX_GamepadPollThread (LPVOID);
+
+    gamepad_poller.hShutdown =
+      CreateEvent (nullptr, TRUE,  FALSE, nullptr);
+    gamepad_poller.hWake     =
+      CreateEvent (nullptr, FALSE, FALSE, nullptr);
+
+    gamepad_poller.hThread =
+      CreateThread ( nullptr, 0,
+                       UNX_GamepadPollThread,
+                         nullptr,
+                           0x00, nullptr );
+
+    extern DWORD WINAPI UNX_InputExecutorThread (LPVOID);
+
+    input_executor.hShutdown =
+      CreateEvent (nullptr, TRUE,  FALSE, nullptr);
+    input_executor.hWork     =
+      CreateEvent (nullptr, FALSE, FALSE, nullptr);
+
+    input_executor.hThread =
+      CreateThread ( nullptr, 0,
+                       UNX_InputExecutorThread,
+                         nullptr,
+                           0x00, nullptr );
+  }
+
+  UNX_CreateDLLHook2 ( config.system.injector.c_str (),
+                       "SK_PluginKeyPress",
+                         SK_UNX_PluginKeyPress,
               (LPVOID *)&SK_PluginKeyPress_Original );
 
   UNX_ApplyQueuedHooks ();
@@ -1094,6 +1225,140 @@ unx::InputManager::Init (void)
 void
 unx::InputManager::Shutdown (void)
 {
+  LogLatency ();
+
+  // The loader lock is held at this point, so the poll thread is told to
+  //   stop but never waited on.
+  if (gamepad_poller.hShutdown != nullptr)
+    SetEvent (gamepad_poller.hShutdown);
+
+  if (gamepad_poller.hThread != nullptr)
+  {
+    CloseHandle (gamepad_poller.hThread);
+                 gamepad_poller.hThread = nullptr;
+  }
+
+  if (input_executor.hShutdown != nullptr)
+    SetEvent (input_executor.hShutdown);
+
+  if (input_executor.hThread != nullptr)
+  {
+    CloseHandle (input_executor.hThread);
+                 input_executor.hThread = nullptr;
+  }
+}
+
+void
+unx::InputManager::ReloadGamepadConfig (const std::vector <uint8_t>& data)
+{
+  extern void UNX_SetupSpecialButtons (void);
+
+  if (pad_cfg == nullptr)
+    return;
+
+  UNX_ReloadINI (pad_cfg, data);
+
+  //
+  // Keybinds and combos are parameters bound to pad_cfg; their handles see
+  //   the reload and look their keys up again.
+  //
+  const struct {
+    unx::ParameterStringW* param;
+    SK_Keybind*            binding;
+    const wchar_t*         name;
+  } binds [] = {
+    { unx_speedstep,  &keybinds.SpeedStep, L"CycleSpeedBoost"       },
+    { unx_kickstart,  &keybinds.KickStart, L"KickStart"             },
+    { unx_timestop,   &keybinds.TimeStop,  L"ToggleTimeStop"        },
+    { unx_freelook,   &keybinds.FreeLook,  L"ToggleFreeLook"        },
+    { unx_sensor,     &keybinds.Sensor,    L"TogglePermanentSensor" },
+    { unx_fullap,     &keybinds.FullAP,    L"ToggleFullPartyAP"     },
+    { unx_VSYNC,      &keybinds.VSYNC,     L"ToggleVSYNC"           },
+    { unx_soft_reset, &keybinds.SoftReset, L"SoftReset"             }
+  };
+
+  UNX_GamepadCombo* const combos [] = {
+    &gamepad.f1,         &gamepad.f2,         &gamepad.f3,         &gamepad.f4,
+    &gamepad.f5,         &gamepad.screenshot, &gamepad.fullscreen, &gamepad.esc,
+    &gamepad.speedboost, &gamepad.kickstart,  &gamepad.softreset
+  };
+
+  bool         rebind  = false,
+               rebuild = false;
+  std::wstring value;
+
+  for (const auto& it : binds)
+  {
+    if ( it.param != nullptr && it.param->load (value) &&
+           value != it.binding->human_readable )
+    {
+      dll_log->Log ( L"[Hot Reload] Keybind %s: %s -> %s",
+                       it.name,
+                         it.binding->human_readable.c_str (), value.c_str () );
+
+      it.binding->human_readable = value;
+      it.binding->parse ();
+
+      rebind = true;
+    }
+  }
+
+  for (auto* combo : combos)
+  {
+    if ( combo->config_parameter != nullptr && combo->config_parameter->load (value) &&
+           value != combo->unparsed )
+    {
+      dll_log->Log ( L"[Hot Reload] Combo %hs: %s -> %s",
+                       combo->combo_name.c_str (),
+                         combo->unparsed.c_str (), value.c_str () );
+
+      combo->unparsed = value;
+
+      rebuild = true;
+    }
+  }
+
+  // Compared in the form they are stored in
+  for (int i = 0; i < PadRemap_Count; i++)
+    pad_remap_idx [i] = gamepad.remap.enumToIndex (*UNX_PadRemapButton (i));
+
+  std::vector <const unx::schema::field_s *> changed;
+
+  unx::INIFile* pad_file =
+    UNX_GetINIFile (pad_cfg);
+
+  unx::schema::LoadChanges (pad_schema, 0, *pad_file, 0, &changed);
+
+  for (const auto* field : changed)
+  {
+    unx::schema::Format (*field, value);
+
+    const bool remap =
+      field->value >= (void *)&pad_remap_idx [0] &&
+      field->value <  (void *)&pad_remap_idx [PadRemap_Count];
+
+    // The button names follow the texture set; the icons themselves, the
+    //   DirectInput remap table and the legacy axis tables are only built
+    //     at startup.
+    const bool live =
+      field->value == &gamepad.tex_set;
+
+    if (remap)
+      *UNX_PadRemapButton ((int)((int *)field->value - pad_remap_idx)) =
+        gamepad.remap.indexToEnum (*(int *)field->value);
+
+    rebuild |= live;
+
+    dll_log->Log ( L"[Hot Reload] Gamepad: [%s] %s = %s%s",
+                     field->section, field->key, value.c_str (),
+                       live ? L"" : L" (after a restart)" );
+  }
+
+  if (rebind)
+    RebuildKeybinds ();
+
+  if (rebuild)
+    UNX_SetupSpecialButtons ();
 }
 
 
@@ -1112,6 +1377,10 @@ unx::InputManager::Shutdown (void)
 #define XINPUT_GAMEPAD_LEFT_TRIGGER   0x10000
 #define XINPUT_GAMEPAD_RIGHT_TRIGGER  0x20000
 
+static_assert ( XINPUT_GAMEPAD_LEFT_TRIGGER  == unx::PadCombo_LeftTrigger &&
+                XINPUT_GAMEPAD_RIGHT_TRIGGER == unx::PadCombo_RightTrigger,
+                  "Combo trigger bits must match unx::PadComboHeld" );
+
 #define XINPUT_GAMEPAD_A              0x1000
 #define XINPUT_GAMEPAD_B              0x2000
 #define XINPUT_GAMEPAD_X              0x4000
@@ -1349,12 +1618,14 @@ struct combo_button_s {
   {
     last_state = state;
 
+    unx::pad_state_s pad;
+                     pad.buttons       = xi_gamepad.wButtons;
+                     pad.left_trigger  = xi_gamepad.bLeftTrigger;
+                     pad.right_trigger = xi_gamepad.bRightTrigger;
+                     pad.connected     = (xi_ret == 0);
+
     state =
-      (xi_ret == 0                                  &&
-       combo->buttons != 0                          &&
-       ((! (combo->buttons & XINPUT_GAMEPAD_LEFT_TRIGGER))  || xi_gamepad.bLeftTrigger  > 130) &&
-       ((! (combo->buttons & XINPUT_GAMEPAD_RIGHT_TRIGGER)) || xi_gamepad.bRightTrigger > 130) &&
-       xi_gamepad.wButtons == (WORD)combo->buttons);
+      unx::PadComboHeld (combo->buttons, pad);
 
     if (wasJustPressed ())
       time_activated = dwTimeNow;
@@ -1383,36 +1654,429 @@ struct combo_button_s {
   DWORD time_released;
 };
 
+// X, Y, Z, U, V, R; rebuilt whenever a device's caps are (re-)read
+static unx::remap::axis_table_s legacy_axes [unx::remap::MaxAxes];
+
+static void
+UNX_BuildLegacyAxisTables (const JOYCAPSW& caps)
+{
+  const UINT ranges [unx::remap::MaxAxes][2] = {
+    { caps.wXmin, caps.wXmax }, { caps.wYmin, caps.wYmax },
+    { caps.wZmin, caps.wZmax }, { caps.wUmin, caps.wUmax },
+    { caps.wVmin, caps.wVmax }, { caps.wRmin, caps.wRmax }
+  };
+
+  for (int i = 0; i < unx::remap::MaxAxes; i++)
+  {
+    unx::remap::BuildAxisTable ( &legacy_axes [i],
+                                   (int32_t)ranges [i][0],
+                                   (int32_t)ranges [i][1],
+                                     gamepad.axis.dead_zone,
+                                     gamepad.axis.curve );
+  }
+}
+
+// Returns the axis number (0-5) for remap enums that refer to an axis
+static int
+UNX_LegacyAxisIndex (int axis)
+{
+  int idx =
+    unx_gamepad_s::remap_s::enumToIndex (axis);
+
+  return (idx <= -1 && idx >= -unx::remap::MaxAxes) ? (-idx - 1) : -1;
+}
+
+static int32_t
+UNX_LegacyAxisRaw (int idx, const JOYINFOEX& joy_ex)
+{
+  switch (idx)
+  {
+    case 0:  return (int32_t)joy_ex.dwXpos;
+    case 1:  return (int32_t)joy_ex.dwYpos;
+    case 2:  return (int32_t)joy_ex.dwZpos;
+    case 3:  return (int32_t)joy_ex.dwUpos;
+    case 4:  return (int32_t)joy_ex.dwVpos;
+    default: return (int32_t)joy_ex.dwRpos;
+  }
+}
+
 BYTE
-UNX_PollAxis (int axis, const JOYINFOEX& joy_ex, const JOYCAPSW& caps)
+UNX_PollAxis (int axis, const JOYINFOEX& joy_ex)
+{
+  const int idx =
+    UNX_LegacyAxisIndex (axis);
+
+  if (idx < 0)
+    return (joy_ex.dwButtons & axis) ? 255 : 0;
+
+  return
+    unx::remap::AxisValue (legacy_axes [idx], UNX_LegacyAxisRaw (idx, joy_ex));
+}
+
+// Same as UNX_PollAxis (...) > 190, without normalizing anything
+bool
+UNX_PollAxisPressed (int axis, const JOYINFOEX& joy_ex)
 {
-#pragma warning (push)
-#pragma warning (disable: 4244)
+  const int idx =
+    UNX_LegacyAxisIndex (axis);
+
+  if (idx < 0)
+    return (joy_ex.dwButtons & axis) != 0;
+
+  return
+    unx::remap::AxisPressed (legacy_axes [idx], UNX_LegacyAxisRaw (idx, joy_ex));
+}
+
+
+// Microseconds on the QPC timebase; used for all of the input latency stats
+uint64_t
+UNX_LatencyNow (void)
+{
+  static LARGE_INTEGER freq = { };
+
+  if (freq.QuadPart == 0)
+    QueryPerformanceFrequency (&freq);
+
+  LARGE_INTEGER now;
+  QueryPerformanceCounter (&now);
+
+  return
+    (uint64_t)(now.QuadPart / freq.QuadPart) * 1000000ULL +
+    (uint64_t)(now.QuadPart % freq.QuadPart) * 1000000ULL / freq.QuadPart;
+}
+
+unx_input_latency_s input_latency;
+
+// The first scancode sent since the last Present; cleared by NotifyPresent
+static std::atomic <uint64_t> pending_make_sampled { 0ULL };
+static std::atomic <uint64_t> pending_make_sent    { 0ULL };
+
+struct unx_gamepad_sample_s {
+  DWORD        xi_ret        = ERROR_DEVICE_NOT_CONNECTED;
+  XINPUT_STATE xi_state      = { };
+  DWORD        dwTimeSampled = 0UL;
+  uint64_t     usSampled     = 0ULL;
+};
+
+// Written by the poll thread, read (wait-free) on the render thread
+static unx::SeqLock <unx_gamepad_sample_s> gamepad_sample;
+
+DWORD
+UNX_SampleGamepad (int slot, XINPUT_STATE* pState)
+{
+  if (SK_XInput_PollController != nullptr && (! gamepad.legacy))
+  {
+    if (SK_XInput_PollController (slot, pState))
+      return 0;
+
+    pState->Gamepad = { };
+
+    return ERROR_DEVICE_NOT_CONNECTED;
+  }
+
+  static JOYCAPSW caps = { };
+
+  JOYINFOEX joy_ex { };
+            joy_ex.dwSize  = sizeof JOYINFOEX;
+            joy_ex.dwFlags = JOY_RETURNALL      | JOY_RETURNPOVCTS |
+                             JOY_RETURNCENTERED | JOY_USEDEADZONE;
+
+  // joyGetNumDevs is cheap; don't let joyGetPosEx probe for a driver
+  //   that is not there on every poll.
+  if ( (! joyGetNumDevs ()) ||
+          joyGetPosEx (JOYSTICKID1, &joy_ex) != JOYERR_NOERROR )
+  {
+    // Whatever shows up in this slot next may be a different device, so
+    //   re-read its caps once it is connected.
+    caps.wMaxButtons = 0;
+    pState->Gamepad  = { };
+
+    return ERROR_DEVICE_NOT_CONNECTED;
+  }
+
+  if (! caps.wMaxButtons)
+  {
+    joyGetDevCaps (JOYSTICKID1, &caps, sizeof JOYCAPSW);
+
+    UNX_BuildLegacyAxisTables (caps);
+  }
+
+  pState->Gamepad.bLeftTrigger  = 0;//joy_ex.dwUpos > 0;
+  pState->Gamepad.bRightTrigger = 0;//joy_ex.dwVpos > 0;
+
+  pState->Gamepad.wButtons = 0;
+
+  if (UNX_PollAxisPressed (gamepad.remap.buttons.A, joy_ex))
+    pState->Gamepad.wButtons |= XINPUT_GAMEPAD_A;
+  if (UNX_PollAxisPressed (gamepad.remap.buttons.B, joy_ex))
+    pState->Gamepad.wButtons |= XINPUT_GAMEPAD_B;
+  if (UNX_PollAxisPressed (gamepad.remap.buttons.X, joy_ex))
+    pState->Gamepad.wButtons |= XINPUT_GAMEPAD_X;
+  if (UNX_PollAxisPressed (gamepad.remap.buttons.Y, joy_ex))
+    pState->Gamepad.wButtons |= XINPUT_GAMEPAD_Y;
+
+  if (UNX_PollAxisPressed (gamepad.remap.buttons.START, joy_ex))
+    pState->Gamepad.wButtons |= XINPUT_GAMEPAD_START;
+  if (UNX_PollAxisPressed (gamepad.remap.buttons.BACK, joy_ex))
+    pState->Gamepad.wButtons |= XINPUT_GAMEPAD_BACK;
+
+  pState->Gamepad.bLeftTrigger =
+    UNX_PollAxis (gamepad.remap.buttons.LT, joy_ex);
+
+  pState->Gamepad.bRightTrigger =
+    UNX_PollAxis (gamepad.remap.buttons.RT, joy_ex);
+
+  if (UNX_PollAxisPressed (gamepad.remap.buttons.LB, joy_ex))
+    pState->Gamepad.wButtons |= XINPUT_GAMEPAD_LEFT_SHOULDER;
+  if (UNX_PollAxisPressed (gamepad.remap.buttons.RB, joy_ex))
+    pState->Gamepad.wButtons |= XINPUT_GAMEPAD_RIGHT_SHOULDER;
+
+  if (UNX_PollAxisPressed (gamepad.remap.buttons.LS, joy_ex))
+    pState->Gamepad.wButtons |= XINPUT_GAMEPAD_LEFT_THUMB;
+  if (UNX_PollAxisPressed (gamepad.remap.buttons.RS, joy_ex))
+    pState->Gamepad.wButtons |= XINPUT_GAMEPAD_RIGHT_THUMB;
+
+  if (joy_ex.dwPOV == JOY_POVFORWARD)
+    pState->Gamepad.wButtons |= XINPUT_GAMEPAD_DPAD_UP;
+  if (joy_ex.dwPOV & JOY_POVBACKWARD)
+    pState->Gamepad.wButtons |= XINPUT_GAMEPAD_DPAD_DOWN;
+  if (joy_ex.dwPOV & JOY_POVLEFT)
+    pState->Gamepad.wButtons |= XINPUT_GAMEPAD_DPAD_LEFT;
+  if (joy_ex.dwPOV & JOY_POVRIGHT)
+    pState->Gamepad.wButtons |= XINPUT_GAMEPAD_DPAD_RIGHT;
+
+  return 0;
+}
+
+static void
+UNX_PadStateFromXInput (DWORD xi_ret, const XINPUT_STATE& xi_state, unx::pad_state_s* pad)
+{
+  pad->buttons       = xi_state.Gamepad.wButtons;
+  pad->left_trigger  = xi_state.Gamepad.bLeftTrigger;
+  pad->right_trigger = xi_state.Gamepad.bRightTrigger;
+  pad->thumb_lx      = xi_state.Gamepad.sThumbLX;
+  pad->thumb_ly      = xi_state.Gamepad.sThumbLY;
+  pad->thumb_rx      = xi_state.Gamepad.sThumbRX;
+  pad->thumb_ry      = xi_state.Gamepad.sThumbRY;
+  pad->connected     = (xi_ret == 0);
+}
+
+static DWORD
+UNX_PadStateToXInput (const unx::pad_state_s& pad, XINPUT_STATE* xi_state)
+{
+  xi_state->Gamepad.wButtons      = pad.buttons;
+  xi_state->Gamepad.bLeftTrigger  = pad.left_trigger;
+  xi_state->Gamepad.bRightTrigger = pad.right_trigger;
+  xi_state->Gamepad.sThumbLX      = pad.thumb_lx;
+  xi_state->Gamepad.sThumbLY      = pad.thumb_ly;
+  xi_state->Gamepad.sThumbRX      = pad.thumb_rx;
+  xi_state->Gamepad.sThumbRY      = pad.thumb_ry;
+
+  return pad.connected ? 0 : ERROR_DEVICE_NOT_CONNECTED;
+}
+
+static std::wstring
+UNX_GetReplayPath (void)
+{
+  if (! PathIsRelativeW (gamepad.replay.file.c_str ()))
+    return gamepad.replay.file;
+
+  return std::wstring (SK_GetConfigPath ()) + gamepad.replay.file;
+}
+
+//
+// Polling a disconnected controller is slow enough to show up in frame time,
+//   so all of the device I/O happens on this thread. The render thread only
+//     ever reads whatever sample was published last.
+//
+DWORD
+WINAPI
+UNX_GamepadPollThread (LPVOID)
+{
+  SetThreadPriority (GetCurrentThread (), THREAD_PRIORITY_ABOVE_NORMAL);
+  timeBeginPeriod   (1);
+
+  unx_gamepad_sample_s sample;
+
+  HANDLE hEvents [2] = { gamepad_poller.hShutdown,
+                         gamepad_poller.hWake };
+
+  //
+  // Record: every sample below is also written to the replay file.
+  // Replay: the file stands in for the controller until it runs out.
+  //
+  //   Both see exactly what UNX_PollInput sees (for WinMM pads that is the
+  //     state after button / axis remapping), so a replay drives the combo
+  //       logic the same way the original session did.
+  //
+  unx::InputRecorder recorder;
+  unx::InputReplay   replay;
+  unx::pad_state_s   replay_pad;
+  bool               replaying     = false;
+  uint64_t           usReplayStart = 0ULL;
+
+  if (! _wcsicmp (gamepad.replay.mode.c_str (), L"Record"))
+  {
+    recorder.open ( _wfopen (UNX_GetReplayPath ().c_str (), L"wb"),
+                      config.input.gamepad_poll_hz,
+                        gamepad.legacy ? unx::ReplayFlag_Legacy : 0 );
 
-  switch (unx_gamepad_s::remap_s::enumToIndex (axis))
+    dll_log->Log ( L"[ Gamepad  ] Recording to '%s' %s",
+                     UNX_GetReplayPath ().c_str (),
+                       recorder.is_open () ? L"" : L"(FAILED)" );
+  }
+
+  else if (! _wcsicmp (gamepad.replay.mode.c_str (), L"Replay"))
   {
-    case -1:
-      return 255 * ((float)(joy_ex.dwXpos - caps.wXmin) /
-                       (float)(caps.wXmax - caps.wXmin));
-    case -2:
-      return 255 * ((float)(joy_ex.dwYpos - caps.wYmin) /
-                       (float)(caps.wYmax - caps.wYmin));
-    case -3:
-      return 255 * ((float)(joy_ex.dwZpos - caps.wZmin) /
-                       (float)(caps.wZmax - caps.wZmin));
-    case -4:
-      return 255 * ((float)(joy_ex.dwUpos - caps.wUmin) /
-                       (float)(caps.wUmax - caps.wUmin));
-    case -5:
-      return 255 * ((float)(joy_ex.dwVpos - caps.wVmin) /
-                       (float)(caps.wVmax - caps.wVmin));
-    case -6:
-      return 255 * ((float)(joy_ex.dwRpos - caps.wRmin) /
-                       (float)(caps.wRmax - caps.wRmin));
-    default:
-      return 255 * ((joy_ex.dwButtons & axis) ? 1 : 0);
+    replaying =
+      replay.load (_wfopen (UNX_GetReplayPath ().c_str (), L"rb"));
+
+    dll_log->Log ( L"[ Gamepad  ] Replaying '%s' %s",
+                     UNX_GetReplayPath ().c_str (),
+                       replaying ? L"" : L"(FAILED)" );
   }
-#pragma warning (pop)
+
+  DWORD dwWait = WAIT_TIMEOUT;
+
+  while (dwWait != WAIT_OBJECT_0)
+  {
+    const unx_hot_config_s hot =
+      UNX_GetHotConfig ();
+
+    // Nothing consumes the samples while the window is inactive
+    if (unx::window.active)
+    {
+      int slot = hot.gamepad_slot;
+      if (slot == -1)
+          slot = 0;
+
+      XINPUT_STATE xi_state = { };
+      DWORD        xi_ret   = ERROR_DEVICE_NOT_CONNECTED;
+
+      if (replaying)
+      {
+        if (usReplayStart == 0ULL)
+            usReplayStart = UNX_LatencyNow ();
+
+        if (! replay.advance (UNX_LatencyNow () - usReplayStart, &replay_pad))
+        {
+          if (gamepad.replay.loop)
+          {
+            replay.rewind ();
+            usReplayStart = 0ULL;
+          }
+
+          else
+          {
+            replaying = false;
+            dll_log->Log (L"[ Gamepad  ] Replay finished");
+          }
+        }
+
+        xi_ret =
+          UNX_PadStateToXInput (replay_pad, &xi_state);
+      }
+
+      else
+      {
+        xi_ret =
+          UNX_SampleGamepad (slot, &xi_state);
+
+        if (recorder.is_open ())
+        {
+          unx::pad_state_s pad;
+          UNX_PadStateFromXInput (xi_ret, xi_state, &pad);
+
+          recorder.append (UNX_LatencyNow (), pad);
+        }
+      }
+
+      if (xi_ret != sample.xi_ret)
+      {
+        dll_log->Log ( L"[ Gamepad  ] Slot %i: %s",
+                         slot,
+                           xi_ret == 0 ? L"Connected" :
+                                         L"Disconnected" );
+      }
+
+      sample.xi_ret        = xi_ret;
+      sample.xi_state      = xi_state;
+      sample.dwTimeSampled = timeGetTime ();
+      sample.usSampled     = UNX_LatencyNow ();
+
+      gamepad_sample.publish (sample);
+    }
+
+    int hz = hot.gamepad_poll_hz;
+
+    if (hz < 1)    hz = 1;
+    if (hz > 1000) hz = 1000;
+
+    // Also while inactive; the tail of the recording must not wait for the
+    //   next sample, or for a close () that DLL detach never gets to.
+    recorder.sync (UNX_LatencyNow ());
+
+    dwWait =
+      WaitForMultipleObjects (2, hEvents, FALSE, 1000UL / hz);
+  }
+
+  recorder.close ();
+
+  timeEndPeriod (1);
+
+  return 0;
+}
+
+void
+unx::InputManager::NotifyPresent (void)
+{
+  const uint64_t usSent =
+    pending_make_sent.load ();
+
+  if (usSent == 0ULL)
+    return;
+
+  const uint64_t usSampled =
+    pending_make_sampled.load ();
+
+  const uint64_t usNow = UNX_LatencyNow ();
+
+  input_latency.present.record (usNow - usSent);
+
+  if (usSampled != 0ULL)
+    input_latency.total.record (usNow - usSampled);
+
+  pending_make_sent.store (0ULL);
+}
+
+void
+unx::InputManager::LogLatency (void)
+{
+  auto LogStage = [](const wchar_t* wszName, const unx::LatencyHistogram& hist)
+  {
+    if (hist.count () == 0)
+      return;
+
+    dll_log->Log ( L"[ Latency  ] %-10s  n=%-6llu  p50=%7.2f ms  p95=%7.2f ms  "
+                                      L"p99=%7.2f ms  max=%7.2f ms",
+                     wszName, hist.count (),
+                       (double)hist.percentile (0.50) / 1000.0,
+                       (double)hist.percentile (0.95) / 1000.0,
+                       (double)hist.percentile (0.99) / 1000.0,
+                       (double)hist.max        (    ) / 1000.0 );
+  };
+
+  LogStage (L"Poll",     input_latency.poll);
+  LogStage (L"Dispatch", input_latency.dispatch);
+  LogStage (L"Present",  input_latency.present);
+  LogStage (L"Total",    input_latency.total);
+}
+
+void
+unx::InputManager::NotifyDeviceChange (void)
+{
+  if (gamepad_poller.hWake != nullptr)
+    SetEvent (gamepad_poller.hWake);
 }
 
 
@@ -1434,6 +2098,154 @@ UNX_PollAxis (int axis, const JOYINFOEX& joy_ex, const JOYCAPSW& caps)
 };
 
 
+//
+// Detecting a combo is cheap, acting on one is not (SendMessage, Steam,
+//   memory patches, thread creation ...), so UNX_PollInput only records what
+//     happened and the executor thread does the work.
+//
+enum class unx_input_action_e : uint8_t {
+  Scancode,   // vk
+  KillMeNow,  // Game Over in battle, otherwise close the game
+  SpeedStep,
+  KickStart,
+  Screenshot
+};
+
+struct unx_input_event_s {
+  unx_input_action_e action;
+  BYTE               vk;
+  uint64_t           usSampled;  // When the poll thread read the controller
+  uint64_t           usDetected; // When UNX_PollInput saw the combo
+};
+
+static unx::MPSCQueue <unx_input_event_s, 64> input_events;
+static volatile LONG                          input_events_dropped = 0L;
+
+void
+UNX_ExecuteInputEvent (const unx_input_event_s& ev)
+{
+  const uint64_t usStart =
+    UNX_LatencyNow ();
+
+  if (ev.usSampled != 0ULL)
+    input_latency.poll.record     (ev.usDetected - ev.usSampled);
+
+  input_latency.dispatch.record   (usStart       - ev.usDetected);
+
+  switch (ev.action)
+  {
+    case unx_input_action_e::Scancode:
+    {
+      // The break is sent by a captureless lambda, so each key is spelled out
+      switch (ev.vk)
+      {
+        case VK_ESCAPE: UNX_SendScancode (VK_ESCAPE, 0x01, 0x81); break;
+        case VK_F1:     UNX_SendScancode (VK_F1,     0x3b, 0xbb); break;
+        case VK_F2:     UNX_SendScancode (VK_F2,     0x3c, 0xbc); break;
+        case VK_F3:     UNX_SendScancode (VK_F3,     0x3d, 0xbd); break;
+        case VK_F4:     UNX_SendScancode (VK_F4,     0x3e, 0xbe); break;
+        case VK_F5:     UNX_SendScancode (VK_F5,     0x3f, 0xbf); break;
+        case VK_MENU:   UNX_SendScancode (VK_MENU,   0x38, 0xb8); break;
+        case VK_RETURN: UNX_SendScancode (VK_RETURN, 0x1c, 0x9c); break;
+      }
+
+      // The rest of the trip is measured at the next Present
+      uint64_t none = 0ULL;
+
+      if (pending_make_sent.compare_exchange_strong (none, UNX_LatencyNow ()))
+        pending_make_sampled.store (ev.usSampled);
+    } break;
+
+    case unx_input_action_e::KillMeNow:
+    {
+      extern bool UNX_KillMeNow (void);
+
+      // If in battle, trigger a Game Over screen, otherwise restart the
+      //   entire game.
+      if (! UNX_KillMeNow ())
+      {
+        SendMessage (SK_GetGameWindow (), WM_CLOSE, 0, 0);
+      }
+    } break;
+
+    case unx_input_action_e::SpeedStep:
+    {
+      extern void UNX_SpeedStep (); 
+      UNX_SpeedStep ();
+    } break;
+
+    case unx_input_action_e::KickStart:
+    {
+      UNX_KickStart ();
+    } break;
+
+    case unx_input_action_e::Screenshot:
+    {
+      using SK_SteamAPI_TakeScreenshot_pfn = bool (__stdcall *)(void);
+
+      static SK_SteamAPI_TakeScreenshot_pfn
+        SK_SteamAPI_TakeScreenshot =
+          (SK_SteamAPI_TakeScreenshot_pfn)
+            GetProcAddress (
+                     GetModuleHandle ( config.system.injector.c_str () ),
+                       "SK_SteamAPI_TakeScreenshot"
+            );
+
+      if (SK_SteamAPI_TakeScreenshot != nullptr)
+        SK_SteamAPI_TakeScreenshot ();
+    } break;
+  }
+}
+
+void
+UNX_QueueInputEvent (unx_input_action_e action, BYTE vk = 0, uint64_t usSampled = 0ULL)
+{
+  unx_input_event_s ev = { action, vk, usSampled, UNX_LatencyNow () };
+
+  // No executor (thread creation failed); behave the way we always did
+  if (input_executor.hThread == nullptr)
+  {
+    UNX_ExecuteInputEvent (ev);
+    return;
+  }
+
+  if (input_events.try_push (ev))
+    SetEvent (input_executor.hWork);
+
+  else
+    InterlockedIncrement (&input_events_dropped);
+}
+
+DWORD
+WINAPI
+UNX_InputExecutorThread (LPVOID)
+{
+  HANDLE hEvents [2] = { input_executor.hShutdown,
+                         input_executor.hWork };
+
+  while (WaitForMultipleObjects (2, hEvents, FALSE, INFINITE) != WAIT_OBJECT_0)
+  {
+    unx_input_event_s ev;
+
+    while (input_events.try_pop (ev))
+    {
+      UNX_ExecuteInputEvent (ev);
+    }
+
+    LONG dropped =
+      InterlockedExchange (&input_events_dropped, 0L);
+
+    if (dropped > 0)
+    {
+      dll_log->Log ( L"[ Input Ex ] Event queue overflowed, %li action(s) dropped",
+                       dropped );
+    }
+  }
+
+  return 0;
+}
+
+
 void
 UNX_PollInput (void)
 {
@@ -1460,15 +2272,7 @@ UNX_PollInput (void)
   static combo_button_s kickstart  ( &gamepad.kickstart  );
   static combo_button_s softreset  ( &gamepad.softreset  );
 
-#define XI_POLL_INTERVAL 500UL
-
-         DWORD dwTimeNow    = timeGetTime ();
-  static DWORD xi_ret       = ERROR_DEVICE_NOT_CONNECTED;
-  static DWORD last_xi_poll = dwTimeNow;// - (XI_POLL_INTERVAL + 1UL);
-
-  int slot = config.input.gamepad_slot;
-  if (slot == -1)
-      slot = 0;
+  DWORD dwTimeNow = timeGetTime ();
 
   // Do Not Handle Input While We Do Not Have Focus
   if (! unx::window.active)
@@ -1477,102 +2281,12 @@ UNX_PollInput (void)
   }
 
 
-  XINPUT_STATE xi_state = {   };
-  bool         success  = false;
-
-  if (SK_XInput_PollController != nullptr && (! gamepad.legacy))
-  {
-    // This function is actually a performance hazard when no controllers
-    //   are plugged in, so ... throttle the sucker.
-    if (  xi_ret == 0 ||
-         (last_xi_poll < dwTimeNow - XI_POLL_INTERVAL) )
-    {
-           success = SK_XInput_PollController (slot, &xi_state);
-      last_xi_poll = dwTimeNow;
-
-      if (! success)
-      {
-        xi_state.Gamepad = {                        };
-        xi_ret           = ERROR_DEVICE_NOT_CONNECTED;
-      } else
-        xi_ret   =   0;
-    }
-  }
-
-  else
-  {
-    if (  xi_ret == 0 ||
-         (last_xi_poll < dwTimeNow - XI_POLL_INTERVAL) )
-    {
-      if (! joyGetNumDevs ())
-      {
-        xi_ret = ERROR_DEVICE_NOT_CONNECTED;
-      }
-
-      else
-      {
-        static JOYCAPSW caps = { };
-
-        if (! caps.wMaxButtons)
-          joyGetDevCaps (JOYSTICKID1, &caps, sizeof JOYCAPSW);
-
-        xi_ret = 0;
-
-        JOYINFOEX joy_ex { };
-                  joy_ex.dwSize  = sizeof JOYINFOEX;
-                  joy_ex.dwFlags = JOY_RETURNALL      | JOY_RETURNPOVCTS |
-                                   JOY_RETURNCENTERED | JOY_USEDEADZONE;
-
-        joyGetPosEx (JOYSTICKID1, &joy_ex);
-
-        xi_state.Gamepad.bLeftTrigger  = 0;//joy_ex.dwUpos > 0;
-        xi_state.Gamepad.bRightTrigger = 0;//joy_ex.dwVpos > 0;
-
-        xi_state.Gamepad.wButtons = 0;
-
-        if (UNX_PollAxis (gamepad.remap.buttons.A, joy_ex, caps) > 190)
-          xi_state.Gamepad.wButtons |= XINPUT_GAMEPAD_A;
-        if (UNX_PollAxis (gamepad.remap.buttons.B, joy_ex, caps) > 190)
-          xi_state.Gamepad.wButtons |= XINPUT_GAMEPAD_B;
-        if (UNX_PollAxis (gamepad.remap.buttons.X, joy_ex, caps) > 190)
-          xi_state.Gamepad.wButtons |= XINPUT_GAMEPAD_X;
-        if (UNX_PollAxis (gamepad.remap.buttons.Y, joy_ex, caps) > 190)
-          xi_state.Gamepad.wButtons |= XINPUT_GAMEPAD_Y;
-
-        if (UNX_PollAxis (gamepad.remap.buttons.START, joy_ex, caps) > 190)
-          xi_state.Gamepad.wButtons |= XINPUT_GAMEPAD_START;
-        if (UNX_PollAxis (gamepad.remap.buttons.BACK, joy_ex, caps) > 190)
-          xi_state.Gamepad.wButtons |= XINPUT_GAMEPAD_BACK;
-
-        xi_state.Gamepad.bLeftTrigger =
-          UNX_PollAxis (gamepad.remap.buttons.LT, joy_ex, caps);
-
-        xi_state.Gamepad.bRightTrigger =
-          UNX_PollAxis (gamepad.remap.buttons.RT, joy_ex, caps);
-
-        if (UNX_PollAxis (gamepad.remap.buttons.LB, joy_ex, caps) > 190)
-          xi_state.Gamepad.wButtons |= XINPUT_GAMEPAD_LEFT_SHOULDER;
-        if (UNX_PollAxis (gamepad.remap.buttons.RB, joy_ex, caps) > 190)
-          xi_state.Gamepad.wButtons |= XINPUT_GAMEPAD_RIGHT_SHOULDER;
-
-        if (UNX_PollAxis (gamepad.remap.buttons.LS, joy_ex, caps) > 190)
-          xi_state.Gamepad.wButtons |= XINPUT_GAMEPAD_LEFT_THUMB;
-        if (UNX_PollAxis (gamepad.remap.buttons.RS, joy_ex, caps) > 190)
-          xi_state.Gamepad.wButtons |= XINPUT_GAMEPAD_RIGHT_THUMB;
-
-        if (joy_ex.dwPOV == JOY_POVFORWARD)
-          xi_state.Gamepad.wButtons |= XINPUT_GAMEPAD_DPAD_UP;
-        if (joy_ex.dwPOV & JOY_POVBACKWARD)
-          xi_state.Gamepad.wButtons |= XINPUT_GAMEPAD_DPAD_DOWN;
-        if (joy_ex.dwPOV & JOY_POVLEFT)
-          xi_state.Gamepad.wButtons |= XINPUT_GAMEPAD_DPAD_LEFT;
-        if (joy_ex.dwPOV & JOY_POVRIGHT)
-          xi_state.Gamepad.wButtons |= XINPUT_GAMEPAD_DPAD_RIGHT;
-      }
+  // If the poll thread happens to be mid-publish, keep last frame's sample
+  static unx_gamepad_sample_s sample;
+         gamepad_sample.try_read (sample);
 
-      last_xi_poll = dwTimeNow;
-    }
-  }
+  DWORD        xi_ret   = sample.xi_ret;
+  XINPUT_STATE xi_state = sample.xi_state;
 
   if (xi_state.Gamepad.bLeftTrigger > 30)
     xi_state.Gamepad.wButtons |= XINPUT_GAMEPAD_LEFT_TRIGGER;
@@ -1621,14 +2335,7 @@ UNX_PollInput (void)
 
   if (four_finger)
   {
-    extern bool UNX_KillMeNow (void);
-
-    // If in battle, trigger a Game Over screen, otherwise restart the
-    //   entire game.
-    if (! UNX_KillMeNow ())
-    {
-      SendMessage (SK_GetGameWindow (), WM_CLOSE, 0, 0);
-    }
+    UNX_QueueInputEvent (unx_input_action_e::KillMeNow, 0, sample.usSampled);
 
     return;
   }
@@ -1647,7 +2354,7 @@ UNX_PollInput (void)
 
   if (esc.wasJustPressed ())
   {
-    UNX_SendScancode (VK_ESCAPE, 0x01, 0x81);
+    UNX_QueueInputEvent (unx_input_action_e::Scancode, VK_ESCAPE, sample.usSampled);
   }
 
   else if (esc.wasJustReleased ())
@@ -1661,41 +2368,29 @@ UNX_PollInput (void)
   {
     if (speedboost.wasJustPressed ())
     {
-      extern void UNX_SpeedStep (); 
-      UNX_SpeedStep ();
+      UNX_QueueInputEvent (unx_input_action_e::SpeedStep, 0, sample.usSampled);
     }
   }
 
-  else if (f1.wasJustPressed ()) { UNX_SendScancode (VK_F1, 0x3b, 0xbb); }
-  else if (f2.wasJustPressed ()) { UNX_SendScancode (VK_F2, 0x3c, 0xbc); }
-  else if (f3.wasJustPressed ()) { UNX_SendScancode (VK_F3, 0x3d, 0xbd); }
-  else if (f4.wasJustPressed ()) { UNX_SendScancode (VK_F4, 0x3e, 0xbe); }
-  else if (f5.wasJustPressed ()) { UNX_SendScancode (VK_F5, 0x3f, 0xbf); }
+  else if (f1.wasJustPressed ()) { UNX_QueueInputEvent (unx_input_action_e::Scancode, VK_F1, sample.usSampled); }
+  else if (f2.wasJustPressed ()) { UNX_QueueInputEvent (unx_input_action_e::Scancode, VK_F2, sample.usSampled); }
+  else if (f3.wasJustPressed ()) { UNX_QueueInputEvent (unx_input_action_e::Scancode, VK_F3, sample.usSampled); }
+  else if (f4.wasJustPressed ()) { UNX_QueueInputEvent (unx_input_action_e::Scancode, VK_F4, sample.usSampled); }
+  else if (f5.wasJustPressed ()) { UNX_QueueInputEvent (unx_input_action_e::Scancode, VK_F5, sample.usSampled); }
 
   else if (full.wasJustPressed ())
   {
-    UNX_SendScancode (VK_MENU,   0x38, 0xb8);
-    UNX_SendScancode (VK_RETURN, 0x1c, 0x9c);
+    UNX_QueueInputEvent (unx_input_action_e::Scancode, VK_MENU,   sample.usSampled);
+    UNX_QueueInputEvent (unx_input_action_e::Scancode, VK_RETURN, sample.usSampled);
   }
 
   else if (kickstart.wasJustPressed ())
   {
-    UNX_KickStart ();
+    UNX_QueueInputEvent (unx_input_action_e::KickStart, 0, sample.usSampled);
   }
 
   else if (sshot.wasJustPressed ())
   {
-    using SK_SteamAPI_TakeScreenshot_pfn = bool (__stdcall *)(void);
-
-    static SK_SteamAPI_TakeScreenshot_pfn
-      SK_SteamAPI_TakeScreenshot =
-        (SK_SteamAPI_TakeScreenshot_pfn)
-          GetProcAddress (
-                   GetModuleHandle ( config.system.injector.c_str () ),
-                     "SK_SteamAPI_TakeScreenshot"
-          );
-
-    if (SK_SteamAPI_TakeScreenshot != nullptr)
-      SK_SteamAPI_TakeScreenshot ();
+    UNX_QueueInputEvent (unx_input_action_e::Screenshot, 0, sample.usSampled);
   }
 }
\ No newline at end of file
@@ -22,8 +22,10 @@
 #define __UNX__INPUT_H__
 
 #include "command.h"
+#include "latency.h"
 
 #include <string>
+#include <vector>
 
 struct SK_Keybind
 {
@@ -102,6 +104,19 @@ struct unx_gamepad_s {
   std::wstring tex_set = L"PlayStation_Glossy";
   bool         legacy  = false;
 
+  // Legacy (WinMM) axes only; XInput does its own dead zone handling
+  struct axis_s {
+    float      dead_zone = 0.0f; // Fraction of travel ignored at rest
+    float      curve     = 1.0f; // Response exponent, 1.0 = linear
+  } axis;
+
+  // Capture / replay of the polled controller state
+  struct replay_s {
+    std::wstring mode = L"Off";             // Off, Record or Replay
+    std::wstring file = L"UnX_Gamepad.rec"; // Relative to the config dir
+    bool         loop = false;
+  } replay;
+
   UNX_GamepadCombo f1         { "F1"                };
   UNX_GamepadCombo f2         { "F2"                };
   UNX_GamepadCombo f3         { "F3"                };
@@ -194,12 +209,43 @@ struct unx_gamepad_s {
 } extern gamepad;
 
 
+// Gamepad combo -> emulated key, each stage in microseconds
+struct unx_input_latency_s {
+  unx::LatencyHistogram poll;     // Controller sampled  -> combo detected
+  unx::LatencyHistogram dispatch; // Combo detected      -> action executed
+  unx::LatencyHistogram present;  // Scancode make sent  -> next Present
+  unx::LatencyHistogram total;    // Controller sampled  -> next Present
+} extern input_latency;
+
+
 namespace unx
 {
+  namespace snapshot { struct table_s; }
+
   namespace InputManager
   {
     void Init     ();
     void Shutdown ();
+
+    // Wakes the gamepad poll thread (e.g. WM_DEVICECHANGE)
+    void NotifyDeviceChange ();
+
+    // Call after any keybind changes
+    void RebuildKeybinds ();
+
+    // Puts the gamepad settings back into UnX_Gamepad.ini (not saved)
+    void StoreGamepadConfig ();
+
+    // Render thread; UnX_Gamepad.ini was edited, data is its new contents
+    void ReloadGamepadConfig (const std::vector <uint8_t>& data);
+
+    // Everything UnX_Gamepad.ini resolves to, for the config snapshot;
+    //   returns the number of tables (at most max)
+    size_t GetSnapshotTables (unx::snapshot::table_s* tables, size_t max);
+
+    // Closes out the latency trace of any key sent since the last frame
+    void NotifyPresent ();
+    void LogLatency    ();
   }
 }
 
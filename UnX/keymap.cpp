@@ -0,0 +1,64 @@
+/**
+ * This file is part of UnX.
+ *
+ * UnX is free software : you can redistribute it
+ * and/or modify it under the terms of the GNU General Public License
+ * as published by The Free Software Foundation, either version 3 of
+ * the License, or (at your option) any later version.
+ *
+ * UnX is distributed in the hope that it will be useful,
+ *
+ * But WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with UnX.
+ *
+ *   If not, see <http://www.gnu.org/licenses/>.
+ *
+**/
+#include "keymap.h"
+
+unx::KeyDispatchTable::KeyDispatchTable (void)
+{
+  for (auto& table : tables_)
+    for (auto& handler : table)
+      handler = nullptr;
+
+  active_.store (0, std::memory_order_relaxed);
+}
+
+size_t
+unx::KeyDispatchTable::rebuild (const binding_s* bindings, size_t count)
+{
+  const int   next  = 1 - active_.load (std::memory_order_relaxed);
+  handler_fn* table = tables_ [next];
+
+  for (uint32_t i = 0; i < Size; i++)
+    table [i] = nullptr;
+
+  size_t shadowed = 0;
+
+  for (size_t i = 0; i < count; i++)
+  {
+    const binding_s& binding = bindings [i];
+
+    // Unbound (vk 0) or out-of-range codes never dispatch anything
+    if (binding.handler == nullptr || (binding.masked_code & 0xFF) == 0 ||
+                                       binding.masked_code >= Size)
+      continue;
+
+    if (table [binding.masked_code] != nullptr)
+    {
+      ++shadowed;
+      continue;
+    }
+
+    table [binding.masked_code] = binding.handler;
+  }
+
+  active_.store (next, std::memory_order_release);
+
+  return shadowed;
+}
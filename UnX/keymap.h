@@ -0,0 +1,88 @@
+/**
+ * This file is part of UnX.
+ *
+ * UnX is free software : you can redistribute it
+ * and/or modify it under the terms of the GNU General Public License
+ * as published by The Free Software Foundation, either version 3 of
+ * the License, or (at your option) any later version.
+ *
+ * UnX is distributed in the hope that it will be useful,
+ *
+ * But WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with UnX.
+ *
+ *   If not, see <http://www.gnu.org/licenses/>.
+ *
+**/
+#ifndef __UNX__KEYMAP_H__
+#define __UNX__KEYMAP_H__
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+
+namespace unx
+{
+  //
+  // Direct-mapped keybind dispatch.
+  //
+  //   A key mask (vk | ctrl << 9 | shift << 10 | alt << 11) indexes straight
+  //     into a table of handlers, so a key press costs the same no matter how
+  //       many actions are bound.
+  //
+  //   Two tables are kept; rebuild () fills the one not in use and then flips
+  //     to it, so lookups from the window thread never see a half-built table.
+  //     Rebuilds themselves must not run concurrently.
+  //
+  class KeyDispatchTable
+  {
+  public:
+    using handler_fn = void (*)(void);
+
+    static const uint32_t Size = 4096;
+
+    struct binding_s {
+      uint32_t   masked_code;
+      handler_fn handler;
+    };
+
+    KeyDispatchTable (void);
+
+    // Earlier bindings win when two of them share a key mask; returns the
+    //   number of bindings that were shadowed this way.
+    size_t     rebuild (const binding_s* bindings, size_t count);
+
+    handler_fn lookup  (uint32_t masked_code) const
+    {
+      if (masked_code >= Size)
+        return nullptr;
+
+      return
+        tables_ [active_.load (std::memory_order_acquire)][masked_code];
+    }
+
+    bool       dispatch (uint32_t masked_code) const
+    {
+      handler_fn handler =
+        lookup (masked_code);
+
+      if (handler != nullptr)
+      {
+        handler ();
+        return true;
+      }
+
+      return false;
+    }
+
+  private:
+    handler_fn         tables_ [2][Size];
+    std::atomic <int>  active_;
+  };
+}
+
+#endif /* __UNX__KEYMAP_H__ */
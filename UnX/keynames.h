@@ -0,0 +1,251 @@
+/**
+ * This file is part of UnX.
+ *
+ * UnX is free software : you can redistribute it
+ * and/or modify it under the terms of the GNU General Public License
+ * as published by The Free Software Foundation, either version 3 of
+ * the License, or (at your option) any later version.
+ *
+ * UnX is distributed in the hope that it will be useful,
+ *
+ * But WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with UnX.
+ *
+ *   If not, see <http://www.gnu.org/licenses/>.
+ *
+**/
+#ifndef __UNX__KEYNAMES_H__
+#define __UNX__KEYNAMES_H__
+
+#include <cstdint>
+
+//
+// Canonical (US English, layout independent) key names for keybinds.
+//
+//   Everything is resolved at compile-time: VK -> name is a switch, and
+//     name -> VK goes through a perfect hash whose seed was picked offline
+//       and is re-checked by static_assert below. Neither direction
+//         allocates, and a miss never adds anything to the table.
+//
+//   Names the OS gives keys on non-US layouts are not in here; see
+//     UNX_LocalizedKeyName (...) in input.cpp for that.
+//
+namespace unx
+{
+  namespace keys
+  {
+    constexpr const wchar_t*
+    CanonicalName (uint8_t vk)
+    {
+      switch (vk)
+      {
+        case 0x08: return L"Backspace";      // VK_BACK
+        case 0x09: return L"Tab";            // VK_TAB
+        case 0x0D: return L"Enter";          // VK_RETURN
+        case 0x10: return L"Shift";          // VK_SHIFT
+        case 0x11: return L"Ctrl";           // VK_CONTROL
+        case 0x12: return L"Alt";            // VK_MENU
+        case 0x13: return L"Pause Break";    // VK_PAUSE
+        case 0x14: return L"Caps Lock";      // VK_CAPITAL
+        case 0x1B: return L"Esc";            // VK_ESCAPE
+        case 0x20: return L"Space";          // VK_SPACE
+        case 0x21: return L"Page Up";        // VK_PRIOR
+        case 0x22: return L"Page Down";      // VK_NEXT
+        case 0x23: return L"End";            // VK_END
+        case 0x24: return L"Home";           // VK_HOME
+        case 0x25: return L"Left";           // VK_LEFT
+        case 0x26: return L"Up";             // VK_UP
+        case 0x27: return L"Right";          // VK_RIGHT
+        case 0x28: return L"Down";           // VK_DOWN
+        case 0x2C: return L"Print Screen";   // VK_SNAPSHOT
+        case 0x2D: return L"Insert";         // VK_INSERT
+        case 0x2E: return L"Delete";         // VK_DELETE
+        case 0x30: return L"0";              // '0'
+        case 0x31: return L"1";              // '1'
+        case 0x32: return L"2";              // '2'
+        case 0x33: return L"3";              // '3'
+        case 0x34: return L"4";              // '4'
+        case 0x35: return L"5";              // '5'
+        case 0x36: return L"6";              // '6'
+        case 0x37: return L"7";              // '7'
+        case 0x38: return L"8";              // '8'
+        case 0x39: return L"9";              // '9'
+        case 0x41: return L"A";              // 'A'
+        case 0x42: return L"B";              // 'B'
+        case 0x43: return L"C";              // 'C'
+        case 0x44: return L"D";              // 'D'
+        case 0x45: return L"E";              // 'E'
+        case 0x46: return L"F";              // 'F'
+        case 0x47: return L"G";              // 'G'
+        case 0x48: return L"H";              // 'H'
+        case 0x49: return L"I";              // 'I'
+        case 0x4A: return L"J";              // 'J'
+        case 0x4B: return L"K";              // 'K'
+        case 0x4C: return L"L";              // 'L'
+        case 0x4D: return L"M";              // 'M'
+        case 0x4E: return L"N";              // 'N'
+        case 0x4F: return L"O";              // 'O'
+        case 0x50: return L"P";              // 'P'
+        case 0x51: return L"Q";              // 'Q'
+        case 0x52: return L"R";              // 'R'
+        case 0x53: return L"S";              // 'S'
+        case 0x54: return L"T";              // 'T'
+        case 0x55: return L"U";              // 'U'
+        case 0x56: return L"V";              // 'V'
+        case 0x57: return L"W";              // 'W'
+        case 0x58: return L"X";              // 'X'
+        case 0x59: return L"Y";              // 'Y'
+        case 0x5A: return L"Z";              // 'Z'
+        case 0x5B: return L"Left Windows";   // VK_LWIN
+        case 0x5C: return L"Right Windows";  // VK_RWIN
+        case 0x5D: return L"Application";    // VK_APPS
+        case 0x5F: return L"Sleep";          // VK_SLEEP
+        case 0x60: return L"Num 0";          // VK_NUMPAD0
+        case 0x61: return L"Num 1";          // VK_NUMPAD1
+        case 0x62: return L"Num 2";          // VK_NUMPAD2
+        case 0x63: return L"Num 3";          // VK_NUMPAD3
+        case 0x64: return L"Num 4";          // VK_NUMPAD4
+        case 0x65: return L"Num 5";          // VK_NUMPAD5
+        case 0x66: return L"Num 6";          // VK_NUMPAD6
+        case 0x67: return L"Num 7";          // VK_NUMPAD7
+        case 0x68: return L"Num 8";          // VK_NUMPAD8
+        case 0x69: return L"Num 9";          // VK_NUMPAD9
+        case 0x6A: return L"Num *";          // VK_MULTIPLY
+        case 0x6B: return L"Num +";          // VK_ADD
+        case 0x6D: return L"Num -";          // VK_SUBTRACT
+        case 0x6E: return L"Num Del";        // VK_DECIMAL
+        case 0x6F: return L"Num /";          // VK_DIVIDE
+        case 0x70: return L"F1";             // VK_F1
+        case 0x71: return L"F2";             // VK_F2
+        case 0x72: return L"F3";             // VK_F3
+        case 0x73: return L"F4";             // VK_F4
+        case 0x74: return L"F5";             // VK_F5
+        case 0x75: return L"F6";             // VK_F6
+        case 0x76: return L"F7";             // VK_F7
+        case 0x77: return L"F8";             // VK_F8
+        case 0x78: return L"F9";             // VK_F9
+        case 0x79: return L"F10";            // VK_F10
+        case 0x7A: return L"F11";            // VK_F11
+        case 0x7B: return L"F12";            // VK_F12
+        case 0x7C: return L"F13";            // VK_F13
+        case 0x7D: return L"F14";            // VK_F14
+        case 0x7E: return L"F15";            // VK_F15
+        case 0x7F: return L"F16";            // VK_F16
+        case 0x80: return L"F17";            // VK_F17
+        case 0x81: return L"F18";            // VK_F18
+        case 0x82: return L"F19";            // VK_F19
+        case 0x83: return L"F20";            // VK_F20
+        case 0x84: return L"F21";            // VK_F21
+        case 0x85: return L"F22";            // VK_F22
+        case 0x86: return L"F23";            // VK_F23
+        case 0x87: return L"F24";            // VK_F24
+        case 0x90: return L"Num Lock";       // VK_NUMLOCK
+        case 0x91: return L"Scroll Lock";    // VK_SCROLL
+        case 0xA0: return L"Left Shift";     // VK_LSHIFT
+        case 0xA1: return L"Right Shift";    // VK_RSHIFT
+        case 0xA2: return L"Left Ctrl";      // VK_LCONTROL
+        case 0xA3: return L"Right Ctrl";     // VK_RCONTROL
+        case 0xA4: return L"Left Alt";       // VK_LMENU
+        case 0xA5: return L"Right Alt";      // VK_RMENU
+        case 0xBA: return L";";              // VK_OEM_1
+        case 0xBB: return L"Plus";           // VK_OEM_PLUS
+        case 0xBC: return L",";              // VK_OEM_COMMA
+        case 0xBD: return L"Minus";          // VK_OEM_MINUS
+        case 0xBE: return L".";              // VK_OEM_PERIOD
+        case 0xBF: return L"/";              // VK_OEM_2
+        case 0xC0: return L"`";              // VK_OEM_3
+        case 0xDB: return L"[";              // VK_OEM_4
+        case 0xDC: return L"\\";             // VK_OEM_5
+        case 0xDD: return L"]";              // VK_OEM_6
+        case 0xDE: return L"\'";             // VK_OEM_7
+        default:   return nullptr;
+      }
+    }
+
+    // FNV-1a, seeded, with one extra fold so the low bits see the high ones
+    constexpr uint32_t
+    Hash (const wchar_t* name, uint32_t seed)
+    {
+      uint32_t h = 2166136261U ^ seed;
+
+      while (*name != L'\0')
+      {
+        h ^= (uint32_t)(uint16_t)*name++;
+        h *= 16777619U;
+      }
+
+      return h ^ (h >> 15);
+    }
+
+    constexpr bool
+    Equal (const wchar_t* a, const wchar_t* b)
+    {
+      while (*a != L'\0' && *a == *b)
+      {
+        ++a; ++b;
+      }
+
+      return *a == *b;
+    }
+
+    static const uint32_t HashSeed  = 218076;
+    static const uint32_t HashSlots = 512;
+
+    struct hash_table_s {
+      uint8_t vk [HashSlots]; // 0 = empty slot
+      bool    perfect;
+    };
+
+    constexpr hash_table_s
+    BuildHashTable (uint32_t seed)
+    {
+      hash_table_s table { };
+                   table.perfect = true;
+
+      for (int vk = 1; vk < 256; vk++)
+      {
+        const wchar_t* name =
+          CanonicalName ((uint8_t)vk);
+
+        if (name == nullptr)
+          continue;
+
+        const uint32_t slot =
+          Hash (name, seed) & (HashSlots - 1);
+
+        if (table.vk [slot] != 0)
+          table.perfect = false;
+        else
+          table.vk [slot] = (uint8_t)vk;
+      }
+
+      return table;
+    }
+
+    constexpr hash_table_s NameTable = BuildHashTable (HashSeed);
+
+    static_assert ( NameTable.perfect,
+                      "Key name hash collides; pick a new HashSeed" );
+
+    // Returns 0 if the name is not a canonical key name
+    constexpr uint8_t
+    VirtualKeyFromName (const wchar_t* name)
+    {
+      const uint8_t vk =
+        NameTable.vk [Hash (name, HashSeed) & (HashSlots - 1)];
+
+      return (vk != 0 && Equal (CanonicalName (vk), name)) ? vk : 0;
+    }
+
+    static_assert ( VirtualKeyFromName (L"Ctrl")   == 0x11 &&
+                    VirtualKeyFromName (L"Delete") == 0x2E &&
+                    VirtualKeyFromName (L"Bogus")  == 0x00,
+                      "Key name lookup is broken" );
+  }
+}
+
+#endif /* __UNX__KEYNAMES_H__ */
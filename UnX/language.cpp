@@ -71,12 +71,12 @@ UNX_PatchLanguageRef (asset_type_t type, int idx, const char* jp, const char* us
 
   if (dst != nullptr)
   {
-    dll_log->LogEx (true, L"[ Language ] %s%li: %42hs ==> ", wszType, idx, static_cast      <const char *> (dst));
+    UNX_LOG_EX (true, L"[ Language ] %s%li: %42hs ==> ", wszType, idx, static_cast      <const char *> (dst));
 
     VirtualProtect (dst, strlen (reinterpret_cast <const char *> (dst))+1, PAGE_READWRITE, &dwOld);
                          strcpy (reinterpret_cast <char *>       (dst),    reinterpret_cast <const char *> (src));
 
-    dll_log->LogEx (false, L"%hs\n", static_cast <const char *> (dst));
+    UNX_LOG_EX (false, L"%hs\n", static_cast <const char *> (dst));
 #if 0
     extern LPVOID __UNX_base_img_addr;
 
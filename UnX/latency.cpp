@@ -0,0 +1,141 @@
+/**
+ * This file is part of UnX.
+ *
+ * UnX is free software : you can redistribute it
+ * and/or modify it under the terms of the GNU General Public License
+ * as published by The Free Software Foundation, either version 3 of
+ * the License, or (at your option) any later version.
+ *
+ * UnX is distributed in the hope that it will be useful,
+ *
+ * But WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with UnX.
+ *
+ *   If not, see <http://www.gnu.org/licenses/>.
+ *
+**/
+#include "latency.h"
+
+#ifdef _MSC_VER
+# include <intrin.h>
+#endif
+
+static int
+UNX_HighestBit (uint32_t val)
+{
+#ifdef _MSC_VER
+  unsigned long idx = 0;
+  _BitScanReverse (&idx, val);
+
+  return (int)idx;
+#else
+  return 31 - __builtin_clz (val);
+#endif
+}
+
+int
+unx::LatencyHistogram::bucket_for (uint64_t usecs)
+{
+  const uint32_t Linear = 2U << SubBits;
+
+  if (usecs < Linear)
+    return (int)usecs;
+
+  if (usecs > 0xFFFFFFFFULL)
+    return NumBuckets - 1;
+
+  const uint32_t val   = (uint32_t)usecs;
+  const int      shift = UNX_HighestBit (val) - SubBits;
+
+  return ((shift + 1) << SubBits) + (int)((val >> shift) & ((1U << SubBits) - 1));
+}
+
+uint64_t
+unx::LatencyHistogram::bucket_upper (int bucket)
+{
+  const int Linear = 2 << SubBits;
+
+  if (bucket < Linear)
+    return (uint64_t)bucket;
+
+  const int shift = (bucket >> SubBits) - 1;
+  const int sub   =  bucket & ((1 << SubBits) - 1);
+
+  const uint64_t lower =
+    (uint64_t)((1 << SubBits) + sub) << shift;
+
+  return lower + (1ULL << shift) - 1;
+}
+
+void
+unx::LatencyHistogram::record (uint64_t usecs)
+{
+  buckets_ [bucket_for (usecs)].fetch_add (1, std::memory_order_relaxed);
+
+  count_.fetch_add (1,     std::memory_order_relaxed);
+  sum_.fetch_add   (usecs, std::memory_order_relaxed);
+
+  uint64_t prev =
+    max_.load (std::memory_order_relaxed);
+
+  while ( usecs > prev &&
+          (! max_.compare_exchange_weak (prev, usecs, std::memory_order_relaxed)) )
+    ;
+}
+
+void
+unx::LatencyHistogram::reset (void)
+{
+  for (auto& bucket : buckets_)
+    bucket.store (0, std::memory_order_relaxed);
+
+  count_.store (0, std::memory_order_relaxed);
+  sum_.store   (0, std::memory_order_relaxed);
+  max_.store   (0, std::memory_order_relaxed);
+}
+
+uint64_t
+unx::LatencyHistogram::mean (void) const
+{
+  const uint64_t n = count ();
+
+  return n != 0 ? sum_.load (std::memory_order_relaxed) / n : 0;
+}
+
+uint64_t
+unx::LatencyHistogram::percentile (double p) const
+{
+  // Sum the buckets rather than trusting count_; a concurrent record ()
+  //   may have bumped one but not yet the other.
+  uint64_t total = 0;
+
+  for (const auto& bucket : buckets_)
+    total += bucket.load (std::memory_order_relaxed);
+
+  if (total == 0)
+    return 0;
+
+  if (p < 0.0) p = 0.0;
+  if (p > 1.0) p = 1.0;
+
+  uint64_t target = (uint64_t)(p * (double)total + 0.999999);
+
+  if (target == 0)
+      target = 1;
+
+  uint64_t seen = 0;
+
+  for (int i = 0; i < NumBuckets; i++)
+  {
+    seen += buckets_ [i].load (std::memory_order_relaxed);
+
+    if (seen >= target)
+      return bucket_upper (i);
+  }
+
+  return bucket_upper (NumBuckets - 1);
+}
@@ -0,0 +1,67 @@
+/**
+ * This file is part of UnX.
+ *
+ * UnX is free software : you can redistribute it
+ * and/or modify it under the terms of the GNU General Public License
+ * as published by The Free Software Foundation, either version 3 of
+ * the License, or (at your option) any later version.
+ *
+ * UnX is distributed in the hope that it will be useful,
+ *
+ * But WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with UnX.
+ *
+ *   If not, see <http://www.gnu.org/licenses/>.
+ *
+**/
+#ifndef __UNX__LATENCY_H__
+#define __UNX__LATENCY_H__
+
+#include <atomic>
+#include <cstdint>
+
+namespace unx
+{
+  //
+  // Log-bucketed latency histogram (microseconds).
+  //
+  //   Values below 16 get a bucket each, everything above that is split into
+  //     8 buckets per power of two, which bounds the error of any reported
+  //       percentile to 12.5%. Recording is a couple of relaxed atomic adds,
+  //         so any thread may call record () while another one reads.
+  //
+  class LatencyHistogram
+  {
+  public:
+    static const int      SubBits    = 3;
+    static const int      NumBuckets = 8 * (28 + 1) + 8; // Up to 2^32 us
+
+    LatencyHistogram (void) { reset (); }
+
+    void     record     (uint64_t usecs);
+    void     reset      (void);
+
+    uint64_t count      (void) const { return count_.load (std::memory_order_relaxed); }
+    uint64_t max        (void) const { return max_.load   (std::memory_order_relaxed); }
+    uint64_t mean       (void) const;
+
+    // Upper bound of the bucket holding the p-th percentile (0.0 - 1.0);
+    //   0 if nothing has been recorded.
+    uint64_t percentile (double p) const;
+
+    static int      bucket_for   (uint64_t usecs);
+    static uint64_t bucket_upper (int      bucket);
+
+  private:
+    std::atomic <uint32_t> buckets_ [NumBuckets];
+    std::atomic <uint64_t> count_;
+    std::atomic <uint64_t> sum_;
+    std::atomic <uint64_t> max_;
+  };
+}
+
+#endif /* __UNX__LATENCY_H__ */
@@ -0,0 +1,141 @@
+/**
+ * This file is part of UnX.
+ *
+ * UnX is free software : you can redistribute it
+ * and/or modify it under the terms of the GNU General Public License
+ * as published by The Free Software Foundation, either version 3 of
+ * the License, or (at your option) any later version.
+ *
+ * UnX is distributed in the hope that it will be useful,
+ *
+ * But WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with UnX.
+ *
+ *   If not, see <http://www.gnu.org/licenses/>.
+ *
+**/
+#ifndef __UNX__LOCKFREE_H__
+#define __UNX__LOCKFREE_H__
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <type_traits>
+
+namespace unx
+{
+  //
+  // Bounded multi-producer / single-consumer ring.
+  //
+  //   Every cell carries its own sequence number, so producers only contend
+  //     on the tail index and the consumer never touches it. Nothing blocks;
+  //       a full ring makes try_push fail and the caller decides what to drop.
+  //
+  //   _Capacity must be a power of two.
+  //
+  template <typename _T, size_t _Capacity>
+  class MPSCQueue
+  {
+    static_assert ( _Capacity >= 2 && (_Capacity & (_Capacity - 1)) == 0,
+                      "MPSCQueue capacity must be a power of two" );
+    static_assert ( std::is_trivially_copyable <_T>::value,
+                      "MPSCQueue payload must be trivially copyable" );
+
+  public:
+    MPSCQueue (void)
+    {
+      for (size_t i = 0; i < _Capacity; i++)
+        cells_ [i].seq.store (i, std::memory_order_relaxed);
+    }
+
+    MPSCQueue            (const MPSCQueue&) = delete;
+    MPSCQueue& operator= (const MPSCQueue&) = delete;
+
+    // Any thread
+    bool try_push (const _T& val)
+    {
+      return try_emplace ([&val](_T& cell) { cell = val; });
+    }
+
+    //
+    // Any thread; fill (_T&) writes the value straight into its cell, for
+    //   payloads that are mostly unused space and too big to copy whole.
+    //
+    template <typename _Fill>
+    bool try_emplace (_Fill&& fill)
+    {
+      size_t pos =
+        tail_.load (std::memory_order_relaxed);
+
+      for (;;)
+      {
+        cell_s&      cell = cells_ [pos & (_Capacity - 1)];
+        const size_t seq  = cell.seq.load (std::memory_order_acquire);
+
+        const intptr_t diff =
+          (intptr_t)seq - (intptr_t)pos;
+
+        if (diff == 0)
+        {
+          if (tail_.compare_exchange_weak ( pos, pos + 1,
+                                              std::memory_order_relaxed ))
+          {
+            fill (cell.data);
+            cell.seq.store (pos + 1, std::memory_order_release);
+
+            return true;
+          }
+        }
+
+        // The consumer has not gotten this far yet; ring is full
+        else if (diff < 0)
+          return false;
+
+        else
+          pos = tail_.load (std::memory_order_relaxed);
+      }
+    }
+
+    // Consumer thread only
+    bool try_pop (_T& out)
+    {
+      cell_s&      cell = cells_ [head_ & (_Capacity - 1)];
+      const size_t seq  = cell.seq.load (std::memory_order_acquire);
+
+      if ((intptr_t)seq - (intptr_t)(head_ + 1) < 0)
+        return false;
+
+      out = cell.data;
+      cell.seq.store (head_ + _Capacity, std::memory_order_release);
+
+      ++head_;
+
+      return true;
+    }
+
+    // Consumer thread only
+    bool empty (void) const {
+      return tail_.load (std::memory_order_acquire) == head_;
+    }
+
+    static constexpr size_t capacity (void) { return _Capacity; }
+
+  private:
+    struct cell_s {
+      std::atomic <size_t> seq;
+      _T                   data;
+    };
+
+    static constexpr size_t _CacheLine = 64;
+
+    alignas (_CacheLine) cell_s               cells_ [_Capacity];
+    alignas (_CacheLine) std::atomic <size_t> tail_  { 0 };
+    alignas (_CacheLine) size_t               head_  =   0;
+  };
+}
+
+#endif /* __UNX__LOCKFREE_H__ */
@@ -22,34 +22,288 @@
 
 #include <Windows.h>
 #include "log.h"
+#include "logwriter.h"
+#include "crashring.h"
+
+#include <cstdarg>
+#include <cwchar>
+
+iSK_Logger*            dll_log   = nullptr;
+unx::trace::TraceLog* dll_trace = nullptr;
+
+//
+// Formatting happens on the calling thread into a stack record; everything
+//   after that (UTF-8 conversion, the file itself) belongs to the writer.
+//
+class UNX_Log : public iSK_Logger
+{
+public:
+  STDMETHOD  (       QueryInterface)(THIS_ REFIID riid, void** ppvObj) override;
+  STDMETHOD_ (ULONG, AddRef)        (THIS)                             override;
+  STDMETHOD_ (ULONG, Release)       (THIS)                             override;
+
+  STDMETHOD_ (bool, init)(THIS_ const wchar_t* const wszFilename,
+                                const wchar_t* const wszMode ) override;
+  STDMETHOD_ (void, close)(THIS)                               override;
+
+  STDMETHOD_ (void, LogEx)(THIS_ bool                 _Timestamp,
+                              _In_z_ _Printf_format_string_
+                                 wchar_t const* const _Format,
+                                                           ... ) override;
+  STDMETHOD_ (void, Log)  (THIS_ _In_z_ _Printf_format_string_
+                                 wchar_t const* const _Format,
+                                                           ... ) override;
+  STDMETHOD_ (void, Log)  (THIS_ _In_z_ _Printf_format_string_
+                                 char const* const    _Format,
+                                                           ... ) override;
+
+private:
+  using line_s = unx::LogWriter::line_s;
+
+  static size_t timestamp (line_s& line);
+  static void   format    (line_s& line, const wchar_t* fmt, va_list args);
+         void   submit    (line_s& line, bool newline);
+
+  unx::LogWriter writer_;
+  unx::CrashRing ring_;   // The last lines, in case we never get to close
+
+  volatile LONG  refs_ = 1;
+};
+
+
+HRESULT
+STDMETHODCALLTYPE
+UNX_Log::QueryInterface (REFIID riid, void** ppvObj)
+{
+  if (IsEqualGUID (riid, IID_SK_Logger) || IsEqualGUID (riid, IID_IUnknown))
+  {
+    AddRef ();
+    *ppvObj = this;
+
+    return S_OK;
+  }
+
+  return E_NOINTERFACE;
+}
+
+ULONG
+STDMETHODCALLTYPE
+UNX_Log::AddRef (void)
+{
+  return InterlockedIncrement (&refs_);
+}
+
+ULONG
+STDMETHODCALLTYPE
+UNX_Log::Release (void)
+{
+  ULONG refs =
+    InterlockedDecrement (&refs_);
+
+  if (refs == 0)
+    delete this;
+
+  return refs;
+}
+
+bool
+STDMETHODCALLTYPE
+UNX_Log::init (const wchar_t* const wszFilename, const wchar_t* const wszMode)
+{
+  // Special K used to create logs/ for us
+  std::wstring dir (wszFilename);
+  size_t       sep = dir.find_last_of (L"/\\");
+
+  if (sep != std::wstring::npos)
+  {
+    dir.resize (sep);
+    CreateDirectoryW (dir.c_str (), nullptr);
+  }
+
+  bool append =
+    wszMode != nullptr && wcschr (wszMode, L'a') != nullptr;
+
+  if (! writer_.open (wszFilename, append))
+    return false;
+
+  // logs/UnX.log -> logs/UnX.ring, logs/UnX.crash.log
+  std::wstring base (wszFilename);
+  size_t       ext = base.find_last_of (L'.');
+
+  if (ext != std::wstring::npos && (sep == std::wstring::npos || ext > sep))
+    base.resize (ext);
+
+  const std::wstring ring  = base + L".ring";
+  const std::wstring crash = base + L".crash.log";
+
+  const size_t recovered =
+    unx::CrashRing::Recover (ring.c_str (), crash.c_str ());
+
+  ring_.open (ring.c_str ());
+
+  if (recovered > 0)
+  {
+    Log ( L"[Crash Ring] The last session never shut down; its final %zu "
+          L"line(s) are in '%s'", recovered, crash.c_str () );
+  }
+
+  return true;
+}
+
+void
+STDMETHODCALLTYPE
+UNX_Log::close (void)
+{
+  writer_.close ();
+
+  // Everything made it into the log; nothing to recover next time
+  ring_.close (true);
+}
+
+size_t
+UNX_Log::timestamp (line_s& line)
+{
+  SYSTEMTIME stLogTime;
+  GetLocalTime (&stLogTime);
+
+  int len =
+    _snwprintf_s ( line.text, unx::LogWriter::MaxLine, _TRUNCATE,
+                     L"%02u:%02u:%02u.%03u: ",
+                       stLogTime.wHour,   stLogTime.wMinute,
+                       stLogTime.wSecond, stLogTime.wMilliseconds );
+
+  return len > 0 ? (size_t)len : 0;
+}
+
+void
+UNX_Log::format (line_s& line, const wchar_t* fmt, va_list args)
+{
+  const size_t avail =
+    unx::LogWriter::MaxLine - line.len;
+
+  int len =
+    _vsnwprintf_s (line.text + line.len, avail, _TRUNCATE, fmt, args);
+
+  // -1 means it was cut off at avail - 1 characters
+  line.len += len >= 0 ? (uint32_t)len
+                       : (uint32_t)(avail - 1);
+}
+
+void
+UNX_Log::submit (line_s& line, bool newline)
+{
+  if (newline)
+  {
+    if (line.len >= unx::LogWriter::MaxLine)
+        line.len  = unx::LogWriter::MaxLine - 1;
+
+    line.text [line.len++] = L'\n';
+  }
+
+  ring_.write  (line.text, line.len);
+  writer_.push (line);
+}
+
+void
+STDMETHODCALLTYPE
+UNX_Log::LogEx (bool _Timestamp, wchar_t const* const _Format, ...)
+{
+  line_s line;
+  line.len = _Timestamp ? (uint32_t)timestamp (line) : 0;
+
+  va_list _ArgList;
+  va_start (_ArgList, _Format);
+  format   (line, _Format, _ArgList);
+  va_end   (_ArgList);
+
+  submit (line, false);
+}
+
+void
+STDMETHODCALLTYPE
+UNX_Log::Log (wchar_t const* const _Format, ...)
+{
+  line_s line;
+  line.len = (uint32_t)timestamp (line);
+
+  va_list _ArgList;
+  va_start (_ArgList, _Format);
+  format   (line, _Format, _ArgList);
+  va_end   (_ArgList);
+
+  submit (line, true);
+}
+
+void
+STDMETHODCALLTYPE
+UNX_Log::Log (char const* const _Format, ...)
+{
+  // Leaves room for the timestamp; ANSI never widens to more characters
+  char narrow [unx::LogWriter::MaxLine - 16];
+
+  va_list _ArgList;
+  va_start     (_ArgList, _Format);
+  _vsnprintf_s (narrow, _TRUNCATE, _Format, _ArgList);
+  va_end       (_ArgList);
+
+  line_s line;
+  line.len = (uint32_t)timestamp (line);
+
+  int len =
+    MultiByteToWideChar ( CP_ACP, 0, narrow, -1,
+                            line.text + line.len,
+                              (int)(unx::LogWriter::MaxLine - line.len) );
+
+  // Includes the terminator on success; 0 if it did not fit at all
+  if (len > 0)
+    line.len += (uint32_t)len - 1;
+
+  submit (line, true);
+}
 
-iSK_Logger* dll_log = nullptr;
 
 iSK_Logger*
 UNX_CreateLog (const wchar_t* const wszName)
 {
-  extern HMODULE hInjectorDLL;
+  UNX_Log* pLog = new UNX_Log ();
 
-  using  SK_CreateLog_pfn = iSK_Logger* (__stdcall *)(const wchar_t* const wszName);
-  static SK_CreateLog_pfn
-         SK_CreateLog     = nullptr;
+  //
+  // A log that could not be opened still swallows everything sent to it,
+  //   same as the one Special K handed back.
+  //
+  pLog->init (wszName, L"w");
 
-  if (SK_CreateLog == nullptr)
+  return pLog;
+}
+
+
+bool
+UNX_OpenTrace (const wchar_t* const wszName)
+{
+  static unx::trace::TraceLog trace;
+
+  if (! trace.open (wszName))
   {
-    SK_CreateLog =
-      (SK_CreateLog_pfn)
-        GetProcAddress (
-          hInjectorDLL,
-            "SK_CreateLog"
-        );
+    dll_log->Log (L"[  Trace   ] Could not create '%s', logging as text", wszName);
+    return false;
   }
 
-  iSK_Logger* pLog = SK_CreateLog (wszName);
+  dll_log->Log (L"[  Trace   ] Binary log: '%s' (decode with tools/trace_decode)", wszName);
 
-  if (pLog != nullptr) {
-    return pLog;
-  } else {
-    // ASSERT: WHAT THE HELL?!
-    return nullptr;
-  }
-}
\ No newline at end of file
+  dll_trace = &trace;
+
+  return true;
+}
+
+void
+UNX_CloseTrace (void)
+{
+  if (dll_trace == nullptr)
+    return;
+
+  // Lines logged from here on go back to the text log
+  unx::trace::TraceLog* trace = dll_trace;
+  dll_trace                   = nullptr;
+
+  trace->close ();
+}
@@ -26,10 +26,18 @@
 #include <cstdio>
 #include <string>
 
+#include "trace.h"
+
 // {A4BF1773-CAAB-48F3-AD88-C2AB5C23BD6F}
 static const GUID IID_SK_Logger = 
 { 0xa4bf1773, 0xcaab, 0x48f3, { 0xad, 0x88, 0xc2, 0xab, 0x5c, 0x23, 0xbd, 0x6f } };
 
+//
+// Same interface Special K exposes through SK_CreateLog (method order is
+//   kept), but UnX now provides its own implementation; see log.cpp. The
+//     lock, the "lockless" workaround and the periodic fflush are gone along
+//       with the data members that came with them.
+//
 interface iSK_Logger : public IUnknown
 {
   class AutoClose
@@ -55,13 +63,7 @@ interface iSK_Logger : public IUnknown
     return AutoClose (this);
   }
 
-  iSK_Logger (void) {
-    AddRef ();
-  }
-
-  virtual ~iSK_Logger (void) {
-    Release ();
-  }
+  virtual ~iSK_Logger (void) = default;
 
   /*** IUnknown methods ***/
   STDMETHOD  (       QueryInterface)(THIS_ REFIID riid, void** ppvObj) = 0;
@@ -82,27 +84,54 @@ interface iSK_Logger : public IUnknown
   STDMETHOD_ (void, Log)  (THIS_ _In_z_ _Printf_format_string_
                                  char const* const    _Format,
                                                            ... ) = 0;
-
-  FILE*            fLog        = nullptr;
-  std::wstring     name        = L"";
-  bool             silent      = false;
-  bool             initialized = false;
-  int              lines       =   0;
-  CRITICAL_SECTION log_mutex   = {   };
-  ULONG            refs        =   0UL;
-  DWORD            last_flush  =   0;
-  DWORD            flush_freq  =   100; // msecs
-
-public:
-  // Temporary augmentation for log issues during thread suspension
-  bool             lock   (void) { if (! lockless) { EnterCriticalSection (&log_mutex); return true; } return false; }
-  bool             unlock (void) { if (! lockless) { LeaveCriticalSection (&log_mutex); return true; } return false; }
-  bool             lockless    = true;
 };
 
 extern iSK_Logger* dll_log;
 
+//
+// Logging never blocks and never touches the file on the calling thread;
+//   lines are handed to a background writer (see logwriter.h). A line that
+//     does not fit in the queue is dropped and counted in the log instead.
+//
 iSK_Logger*
 UNX_CreateLog (const wchar_t* const wszName);
 
+
+//
+// Binary mode ([UnX.System] BinaryLog): lines logged through the macros
+//   below are recorded as a format id plus raw arguments in a trace file
+//     instead, and tools/trace_decode.cpp renders them after the fact. Use
+//       them where formatting costs more than the line is worth, e.g. one
+//         line per texture or per patched string.
+//
+extern unx::trace::TraceLog* dll_trace;
+
+bool
+UNX_OpenTrace (const wchar_t* const wszName);
+
+void
+UNX_CloseTrace (void);
+
+#define UNX_LOG_EX(_Timestamp, _Format, ...)                                   \
+  do {                                                                         \
+    static unx::trace::site_s _site (_Format);                                 \
+                                                                               \
+    if (dll_trace != nullptr)                                                  \
+      dll_trace->record (_site, (uint8_t)((_Timestamp) ?                       \
+                           unx::trace::Flag_Timestamp : 0), ##__VA_ARGS__);    \
+    else                                                                       \
+      dll_log->LogEx (_Timestamp, _Format, ##__VA_ARGS__);                     \
+  } while (0)
+
+#define UNX_LOG(_Format, ...)                                                  \
+  do {                                                                         \
+    static unx::trace::site_s _site (_Format);                                 \
+                                                                               \
+    if (dll_trace != nullptr)                                                  \
+      dll_trace->record (_site, unx::trace::Flag_Timestamp |                   \
+                                unx::trace::Flag_Newline, ##__VA_ARGS__);      \
+    else                                                                       \
+      dll_log->Log (_Format, ##__VA_ARGS__);                                   \
+  } while (0)
+
 #endif /* __UNX__LOG_H__ */
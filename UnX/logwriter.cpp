@@ -0,0 +1,295 @@
+/**
+ * This file is part of UnX.
+ *
+ * UnX is free software : you can redistribute it
+ * and/or modify it under the terms of the GNU General Public License
+ * as published by The Free Software Foundation, either version 3 of
+ * the License, or (at your option) any later version.
+ *
+ * UnX is distributed in the hope that it will be useful,
+ *
+ * But WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with UnX.
+ *
+ *   If not, see <http://www.gnu.org/licenses/>.
+ *
+**/
+#include "logwriter.h"
+#include "inifile.h"
+#include "threads.h"
+
+#include <chrono>
+#include <cstring>
+#include <cwchar>
+#include <string_view>
+
+static void
+UNX_EncodeLine (const unx::LogWriter::line_s& line, std::vector <uint8_t>& out)
+{
+  unx::INIFile::encode_utf8 (std::wstring_view (line.text, line.len), out);
+}
+
+static void
+UNX_EncodeDropped (uint64_t count, std::vector <uint8_t>& out)
+{
+  char msg [96];
+
+  const int len =
+    snprintf ( msg, sizeof msg, "[  Logger  ] %llu line(s) dropped, log was full\n",
+                 (unsigned long long)count );
+
+  out.insert (out.end (), msg, msg + len);
+}
+
+const unx::LogWriter::encoding_s
+unx::LogWriter::Text = { UNX_EncodeLine, UNX_EncodeDropped };
+
+
+unx::LogWriter::~LogWriter (void)
+{
+  stop  ();
+  close ();
+}
+
+bool
+unx::LogWriter::open (const wchar_t* path, bool append, const encoding_s& encoding)
+{
+  encoding_ = &encoding;
+
+#ifdef _WIN32
+  file_ = _wfopen (path, append ? L"ab" : L"wb");
+#else
+  std::vector <uint8_t> narrow;
+  unx::INIFile::encode_utf8 (path, narrow);
+  narrow.push_back ('\0');
+
+  file_ = fopen ((const char *)narrow.data (), append ? "ab" : "wb");
+#endif
+
+  if (file_ == nullptr)
+    return false;
+
+  if (! thread_.joinable ())
+    thread_ = std::thread (&LogWriter::run, this);
+
+  return true;
+}
+
+bool
+unx::LogWriter::push (const line_s& line)
+{
+  // Only the part of the text that is in use
+  return emplace ([&line](line_s& out)
+  {
+    out.len = line.len;
+    wmemcpy (out.text, line.text, line.len);
+  });
+}
+
+bool
+unx::LogWriter::pushed (bool queued)
+{
+  if (! queued)
+  {
+    stats_.dropped.fetch_add (1, std::memory_order_relaxed);
+    return false;
+  }
+
+  const uint64_t count =
+    stats_.pushed.fetch_add (1, std::memory_order_relaxed) + 1;
+
+  // The writer gets to it within WakeInterval anyway
+  if (count - popped_.load (std::memory_order_relaxed) < Capacity / 2)
+    return true;
+
+  // Pairs with the fence in run (); either the writer sees this line before
+  //   it sleeps, or this sees that it went to sleep.
+  std::atomic_thread_fence (std::memory_order_seq_cst);
+
+  if ( sleeping_.load     (std::memory_order_relaxed) &&
+       sleeping_.exchange (false) )
+    wake_.notify_one ();
+
+  return true;
+}
+
+bool
+unx::LogWriter::push (const wchar_t* text, size_t len)
+{
+  if (len > MaxLine)
+  {
+    len = MaxLine;
+    stats_.truncated.fetch_add (1, std::memory_order_relaxed);
+  }
+
+  return emplace ([=](line_s& out)
+  {
+    out.len = (uint32_t)len;
+    wmemcpy (out.text, text, len);
+  });
+}
+
+size_t
+unx::LogWriter::drain (void)
+{
+  size_t  count = 0;
+  line_s  line;
+
+  batch_.clear ();
+
+  while (ring_.try_pop (line))
+  {
+    encoding_->line (line, batch_);
+    ++count;
+  }
+
+  popped_.fetch_add (count, std::memory_order_relaxed);
+
+  const uint64_t dropped =
+    stats_.dropped.load (std::memory_order_relaxed);
+
+  if (dropped != dropped_reported_)
+  {
+    encoding_->dropped (dropped - dropped_reported_, batch_);
+
+    dropped_reported_ = dropped;
+  }
+
+  if (batch_.empty () || file_ == nullptr)
+    return count;
+
+  fwrite (batch_.data (), 1, batch_.size (), file_);
+  fflush (file_);
+
+  stats_.batches.fetch_add (1,     std::memory_order_relaxed);
+  stats_.written.fetch_add (count, std::memory_order_relaxed);
+
+  return count;
+}
+
+// Polls rather than blocking on consume_, so that a writer thread that was
+//   killed while holding it cannot hang the caller
+bool
+unx::LogWriter::acquire (uint32_t wait_ms)
+{
+  const auto until =
+    std::chrono::steady_clock::now () + std::chrono::milliseconds (wait_ms);
+
+  while (! consume_.try_lock ())
+  {
+    if (std::chrono::steady_clock::now () >= until)
+      return false;
+
+    std::this_thread::sleep_for (std::chrono::milliseconds (1));
+  }
+
+  return true;
+}
+
+// consume_ is held by a writer thread that was killed (process exit) and
+//   nobody else is using the ring, batch_ or file_
+bool
+unx::LogWriter::orphaned (void)
+{
+  return draining_.load () && ThreadHasExited (thread_, false);
+}
+
+size_t
+unx::LogWriter::flush (uint32_t flush_wait_ms)
+{
+  // On timeout, only drain in place of a writer thread that is gone; next
+  //   to a live one this would be a second consumer
+  const bool locked =
+    acquire (flush_wait_ms);
+
+  if ((! locked) && (! orphaned ()))
+    return 0;
+
+  const size_t count =
+    drain ();
+
+  if (locked)
+    consume_.unlock ();
+
+  return count;
+}
+
+void
+unx::LogWriter::run (void)
+{
+  while (! stopping_.load ())
+  {
+    bool empty;
+
+    {
+      std::lock_guard <std::mutex> guard (consume_);
+
+      draining_.store (true);
+
+      drain ();
+
+      sleeping_.store (true);
+      std::atomic_thread_fence (std::memory_order_seq_cst);
+
+      empty = ring_.empty ();
+
+      draining_.store (false);
+    }
+
+    if (! empty)
+    {
+      sleeping_.store (false);
+      continue;
+    }
+
+    std::unique_lock <std::mutex> guard (wake_lock_);
+
+    wake_.wait_for ( guard, std::chrono::milliseconds (WakeInterval),
+                       [this] { return (! sleeping_.load ()) || stopping_.load (); } );
+
+    sleeping_.store (false);
+  }
+}
+
+void
+unx::LogWriter::stop (void)
+{
+  {
+    std::lock_guard <std::mutex> guard (wake_lock_);
+    stopping_.store (true);
+  }
+
+  wake_.notify_all ();
+
+  if (thread_.joinable ())
+    thread_.join ();
+
+  flush ();
+}
+
+void
+unx::LogWriter::close (void)
+{
+  flush ();
+
+  // Same reasoning as flush; leaving the file open beats closing it under
+  //   a writer that is still using it
+  const bool locked =
+    acquire (2000);
+
+  if ((! locked) && (! orphaned ()))
+    return;
+
+  if (file_ != nullptr)
+  {
+    fclose (file_);
+    file_ = nullptr;
+  }
+
+  if (locked)
+    consume_.unlock ();
+}
@@ -0,0 +1,156 @@
+/**
+ * This file is part of UnX.
+ *
+ * UnX is free software : you can redistribute it
+ * and/or modify it under the terms of the GNU General Public License
+ * as published by The Free Software Foundation, either version 3 of
+ * the License, or (at your option) any later version.
+ *
+ * UnX is distributed in the hope that it will be useful,
+ *
+ * But WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with UnX.
+ *
+ *   If not, see <http://www.gnu.org/licenses/>.
+ *
+**/
+#ifndef __UNX__LOGWRITER_H__
+#define __UNX__LOGWRITER_H__
+
+#include "lockfree.h"
+
+#include <atomic>
+#include <condition_variable>
+#include <cstdint>
+#include <cstdio>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+namespace unx
+{
+  //
+  // Asynchronous log file writer.
+  //
+  //   Producers format a line into a fixed-size record and push it into a
+  //     lock-free ring; they never take a lock, never allocate and never
+  //       touch the file, so logging is safe from a hook that runs while
+  //         other threads are suspended. A background thread drains the
+  //           ring in batches, converts them to UTF-8 and writes each batch
+  //             with a single fwrite + fflush.
+  //
+  //   The writer looks at the ring every WakeInterval ms on its own; a
+  //     producer only signals it once the ring is half full, since waking
+  //       a thread costs more than formatting the line did.
+  //
+  //   A full ring drops the line (and counts it) rather than wait.
+  //
+  class LogWriter
+  {
+  public:
+    static const size_t MaxLine  = 384;   // wchar_t, longer lines are cut
+    static const size_t Capacity = 1024;  // Lines
+
+    static constexpr uint32_t WakeInterval = 50;  // ms
+
+    struct line_s {
+      uint32_t len;     // Characters, or bytes for a binary encoding
+
+      union {
+        wchar_t text  [MaxLine];
+        uint8_t bytes [MaxLine * sizeof (wchar_t)];
+      };
+    };
+
+    //
+    // How the writer thread turns queued lines (and the number of lines it
+    //   had to drop) into bytes for the file. Text is UTF-8; a binary log
+    //     such as the trace in trace.h brings its own.
+    //
+    struct encoding_s {
+      void (*line)    (const line_s& line, std::vector <uint8_t>& out);
+      void (*dropped) (uint64_t      count, std::vector <uint8_t>& out);
+    };
+
+    static const encoding_s Text;
+
+    LogWriter (void) = default;
+   ~LogWriter (void);
+
+    LogWriter            (const LogWriter&) = delete;
+    LogWriter& operator= (const LogWriter&) = delete;
+
+    // Truncates (mode "w") or appends to path; before anything is pushed
+    bool     open    (const wchar_t* path, bool append = false,
+                      const encoding_s& encoding = Text);
+
+    // Any thread, never blocks; false if the line was dropped
+    bool     push    (const line_s& line);
+    bool     push    (const wchar_t* text, size_t len);
+
+    // Same, with fill (line_s&) building the line in the queue itself
+    template <typename _Fill>
+    bool     emplace (_Fill&& fill) {
+      return pushed (ring_.try_emplace (fill));
+    }
+
+    //
+    // Any thread; writes everything pushed so far on the calling thread.
+    //
+    //   Waits at most flush_wait_ms for a batch already in progress, then
+    //     gives up and returns 0, unless the writer thread was killed in the
+    //       middle of it (process exit) and will never finish.
+    //
+    size_t   flush   (uint32_t flush_wait_ms = 2000);
+
+    // Flushes and stops the writer thread; not safe under loader lock
+    void     stop    (void);
+
+    // Flushes and closes the file; the writer thread is left parked
+    void     close   (void);
+
+    struct stats_s {
+      std::atomic <uint64_t> pushed    { 0 };
+      std::atomic <uint64_t> dropped   { 0 };  // Ring was full
+      std::atomic <uint64_t> truncated { 0 };
+      std::atomic <uint64_t> batches   { 0 };
+      std::atomic <uint64_t> written   { 0 };  // Lines
+    };
+
+    const stats_s& stats (void) const { return stats_; }
+
+  private:
+    bool     pushed  (bool queued);
+    void     run     (void);
+    size_t   drain   (void);  // consume_ held
+    bool     acquire (uint32_t wait_ms);
+    bool     orphaned(void);
+
+    MPSCQueue <line_s, Capacity> ring_;
+
+    // Producers only wake the writer if it went to sleep with a backlog
+    std::atomic <bool>           sleeping_ { false };
+    std::atomic <uint64_t>       popped_   { 0 };
+    std::mutex                   wake_lock_;
+    std::condition_variable      wake_;
+
+    // Whoever drains the ring (writer thread or flush) is its one consumer
+    std::mutex                   consume_;
+    std::atomic <bool>           draining_ { false }; // Writer thread holds consume_
+    FILE*                        file_     = nullptr;
+    const encoding_s*            encoding_ = &Text;
+    std::vector <uint8_t>        batch_;
+    uint64_t                     dropped_reported_ = 0;
+
+    std::atomic <bool>           stopping_ { false };
+    std::thread                  thread_;
+
+    stats_s                      stats_;
+  };
+}
+
+#endif /* __UNX__LOGWRITER_H__ */
@@ -0,0 +1,175 @@
+/**
+ * This file is part of UnX.
+ *
+ * UnX is free software : you can redistribute it
+ * and/or modify it under the terms of the GNU General Public License
+ * as published by The Free Software Foundation, either version 3 of
+ * the License, or (at your option) any later version.
+ *
+ * UnX is distributed in the hope that it will be useful,
+ *
+ * But WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with UnX.
+ *
+ *   If not, see <http://www.gnu.org/licenses/>.
+ *
+**/
+#ifndef __UNX__MAILBOX_H__
+#define __UNX__MAILBOX_H__
+
+#include "lockfree.h"
+
+#include <atomic>
+#include <cstdint>
+
+namespace unx
+{
+  //
+  // Typed command mailbox.
+  //
+  //   Any thread may post; one thread drains it at a well-defined point (once
+  //     per frame) and runs the handler registered for each command. Posting
+  //       the same command with the same argument more than once before a
+  //         drain runs it only once, which is what the flags this replaces
+  //           used to do. The run is at the place of the last of those posts,
+  //             so A, B, A runs B then A and leaves A in effect.
+  //
+  //   _Commands is the number of distinct command ids (at most 32).
+  //
+  template <size_t _Commands, size_t _Capacity = 64>
+  class CommandMailbox
+  {
+    static_assert (_Commands > 0 && _Commands <= 32, "Too many command ids");
+
+  public:
+    using handler_fn = void     (*)(uint32_t arg);
+    using clock_fn   = uint64_t (*)(void);  // Microseconds
+
+    struct stats_s {
+      std::atomic <uint64_t> posted    { 0 };
+      std::atomic <uint64_t> dropped   { 0 };  // Mailbox full
+      std::atomic <uint64_t> coalesced { 0 };
+      std::atomic <uint64_t> executed  { 0 };
+      std::atomic <uint64_t> wait_max  { 0 };  // Post -> start of execution
+      std::atomic <uint64_t> run_total { 0 };
+      std::atomic <uint64_t> run_max   { 0 };
+    };
+
+    explicit CommandMailbox (clock_fn clock) : clock_ (clock) { }
+
+    // Before the mailbox is first drained
+    void set_handler (uint32_t cmd, handler_fn handler)
+    {
+      if (cmd < _Commands)
+        handlers_ [cmd] = handler;
+    }
+
+    // Any thread
+    bool post (uint32_t cmd, uint32_t arg = 0)
+    {
+      if (cmd >= _Commands)
+        return false;
+
+      stats_ [cmd].posted.fetch_add (1, std::memory_order_relaxed);
+
+      if (! queue_.try_push ({ cmd, arg, clock_ () }))
+      {
+        stats_ [cmd].dropped.fetch_add (1, std::memory_order_relaxed);
+        return false;
+      }
+
+      return true;
+    }
+
+    // Drain thread only; returns the number of handlers that ran
+    size_t drain (void)
+    {
+      // Take everything that is in the mailbox right now before running
+      //   anything, so a handler that posts again is run on the next drain.
+      msg_s  batch [_Capacity];
+      size_t count = 0;
+
+      while (count < _Capacity && queue_.try_pop (batch [count]))
+        ++count;
+
+      // Messages of each command still ahead; most batches never scan
+      uint32_t left [_Commands] = { };
+      size_t   ran              = 0;
+
+      for (size_t i = 0; i < count; i++)
+        ++left [batch [i].cmd];
+
+      for (size_t i = 0; i < count; i++)
+      {
+        const msg_s& msg = batch [i];
+
+        if (--left [msg.cmd] > 0 && posted_again (batch, i, count))
+        {
+          stats_ [msg.cmd].coalesced.fetch_add (1, std::memory_order_relaxed);
+          continue;
+        }
+
+        stats_s& stats = stats_ [msg.cmd];
+
+        const uint64_t start = clock_ ();
+
+        if (handlers_ [msg.cmd] != nullptr)
+            handlers_ [msg.cmd] (msg.arg);
+
+        const uint64_t end   = clock_ ();
+
+        update_max (stats.wait_max, start > msg.posted ? start - msg.posted : 0);
+        update_max (stats.run_max,  end   - start);
+
+        stats.run_total.fetch_add (end - start, std::memory_order_relaxed);
+        stats.executed.fetch_add  (1,           std::memory_order_relaxed);
+
+        ++ran;
+      }
+
+      return ran;
+    }
+
+    const stats_s& stats (uint32_t cmd) const { return stats_ [cmd]; }
+
+    static constexpr size_t commands (void) { return _Commands; }
+
+  private:
+    struct msg_s {
+      uint32_t cmd;
+      uint32_t arg;
+      uint64_t posted;
+    };
+
+    static bool posted_again (const msg_s* batch, size_t i, size_t count)
+    {
+      for (size_t j = i + 1; j < count; j++)
+      {
+        if (batch [j].cmd == batch [i].cmd && batch [j].arg == batch [i].arg)
+          return true;
+      }
+
+      return false;
+    }
+
+    static void update_max (std::atomic <uint64_t>& max, uint64_t val)
+    {
+      uint64_t cur = max.load (std::memory_order_relaxed);
+
+      while ( val > cur &&
+              (! max.compare_exchange_weak (cur, val, std::memory_order_relaxed)) )
+        ;
+    }
+
+    MPSCQueue <msg_s, _Capacity> queue_;
+    clock_fn                     clock_;
+    handler_fn                   handlers_ [_Commands] = { };
+    stats_s                      stats_    [_Commands];
+  };
+}
+
+#endif /* __UNX__MAILBOX_H__ */
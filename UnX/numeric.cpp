@@ -0,0 +1,288 @@
+/**
+ * This file is part of UnX.
+ *
+ * UnX is free software : you can redistribute it
+ * and/or modify it under the terms of the GNU General Public License
+ * as published by The Free Software Foundation, either version 3 of
+ * the License, or (at your option) any later version.
+ *
+ * UnX is distributed in the hope that it will be useful,
+ *
+ * But WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with UnX.
+ *
+ *   If not, see <http://www.gnu.org/licenses/>.
+ *
+**/
+#include "numeric.h"
+
+#include <charconv>
+#include <system_error>
+
+//
+// The v141 (VS2017) STL only has the integer overloads of to_chars and
+//   from_chars; floats fall back to the CRT there, pinned to the C locale.
+//
+#if defined (__cpp_lib_to_chars) && (! defined (UNX_NO_FLOAT_CHARCONV))
+# define UNX_FLOAT_CHARCONV
+#else
+# include <cerrno>
+# include <cmath>
+# include <cstdio>
+# include <cstdlib>
+# ifdef _MSC_VER
+#  include <clocale>
+# endif
+#endif
+
+namespace
+{
+  size_t
+  UNX_Widen (const char* str, const char* end, wchar_t (&out) [unx::num::MaxChars])
+  {
+    size_t len = 0;
+
+    while (str < end && len < unx::num::MaxChars - 1)
+      out [len++] = (wchar_t)*str++;
+
+    out [len] = L'\0';
+
+    return len;
+  }
+
+  // Copies the number part of text into buf; false if it cannot be one
+  bool
+  UNX_Narrow (std::wstring_view text, char (&buf) [64], size_t& len)
+  {
+    while ((! text.empty ()) && (text.front () == L' ' || text.front () == L'\t'))
+      text.remove_prefix (1);
+    while ((! text.empty ()) && (text.back  () == L' ' || text.back  () == L'\t'))
+      text.remove_suffix (1);
+
+    // from_chars takes '-' but not '+'
+    if (text.size () > 1 && text.front () == L'+' && text [1] != L'-')
+      text.remove_prefix (1);
+
+    if (text.empty () || text.size () >= sizeof buf)
+      return false;
+
+    for (size_t i = 0; i < text.size (); i++)
+    {
+      if (text [i] > 0x7f)
+        return false;
+
+      buf [i] = (char)text [i];
+    }
+
+    len = text.size ();
+
+    return true;
+  }
+
+  template <typename _T, typename... _Args>
+  unx::num::result_e
+  UNX_FromChars (std::wstring_view text, _T& out, _Args... args)
+  {
+    char   buf [64];
+    size_t len = 0;
+
+    if (! UNX_Narrow (text, buf, len))
+      return unx::num::result_e::Invalid;
+
+    _T val;
+
+    const std::from_chars_result res =
+      std::from_chars (buf, buf + len, val, args...);
+
+    if (res.ec == std::errc::result_out_of_range)
+      return unx::num::result_e::OutOfRange;
+
+    if (res.ec != std::errc () || res.ptr != buf + len)
+      return unx::num::result_e::Invalid;
+
+    out = val;
+
+    return unx::num::result_e::Ok;
+  }
+
+#ifndef UNX_FLOAT_CHARCONV
+# ifdef _MSC_VER
+  _locale_t
+  UNX_CLocale (void)
+  {
+    static _locale_t c_locale =
+      _create_locale (LC_NUMERIC, "C");
+
+    return c_locale;
+  }
+
+#  define UNX_strtof(str,end)          _strtof_l   ((str), (end), UNX_CLocale ())
+#  define UNX_snprintf(buf,len,fmt,...) _snprintf_l ((buf), (len), (fmt), UNX_CLocale (), __VA_ARGS__)
+# else
+#  define UNX_strtof(str,end)          strtof      ((str), (end))
+#  define UNX_snprintf(buf,len,fmt,...) snprintf    ((buf), (len), (fmt), __VA_ARGS__)
+# endif
+
+  // Same rules as from_chars: no blanks, no hex floats, nothing left over
+  unx::num::result_e
+  UNX_ParseFloat (std::wstring_view text, float& out)
+  {
+    char   buf [64];
+    size_t len = 0;
+
+    if (! UNX_Narrow (text, buf, len))
+      return unx::num::result_e::Invalid;
+
+    buf [len] = '\0';
+
+    for (size_t i = 0; i < len; i++)
+    {
+      if (buf [i] == ' ' || buf [i] == '\t' || buf [i] == 'x' || buf [i] == 'X')
+        return unx::num::result_e::Invalid;
+    }
+
+    char* end = nullptr;
+
+    errno = 0;
+
+    const float val =
+      UNX_strtof (buf, &end);
+
+    if (end != buf + len)
+      return unx::num::result_e::Invalid;
+
+    // ERANGE is also set for denormals, which are fine
+    if (errno == ERANGE && (std::isinf (val) || val == 0.0f))
+      return unx::num::result_e::OutOfRange;
+
+    out = val;
+
+    return unx::num::result_e::Ok;
+  }
+
+  //
+  // The fewest significant digits that read back as the same float; %g drops
+  //   trailing zeros, so anything that needs 6 or fewer comes out of %.6g
+  //
+  char*
+  UNX_FormatFloat (char* buf, size_t size, float val)
+  {
+    int len = 0;
+
+    for (int digits = 6; digits <= 9; digits++)
+    {
+      len =
+        UNX_snprintf (buf, size, "%.*g", digits, (double)val);
+
+      if (len < 0 || (size_t)len >= size)
+        return buf;
+
+      if (UNX_strtof (buf, nullptr) == val)
+        break;
+    }
+
+    return buf + len;
+  }
+#endif
+}
+
+size_t
+unx::num::Format (int val, wchar_t (&out) [MaxChars])
+{
+  char buf [MaxChars];
+
+  return UNX_Widen (buf, std::to_chars (buf, buf + sizeof buf, val).ptr, out);
+}
+
+size_t
+unx::num::Format (int64_t val, wchar_t (&out) [MaxChars])
+{
+  char buf [MaxChars];
+
+  return UNX_Widen (buf, std::to_chars (buf, buf + sizeof buf, val).ptr, out);
+}
+
+size_t
+unx::num::Format (float val, wchar_t (&out) [MaxChars])
+{
+  char  buf [MaxChars];
+#ifdef UNX_FLOAT_CHARCONV
+  char* end =
+    std::to_chars (buf, buf + sizeof buf - 2, val).ptr;
+#else
+  char* end =
+    UNX_FormatFloat (buf, sizeof buf - 2, val);
+#endif
+
+  // "8" reads like an integer setting; the files have always said "8.0"
+  bool whole = true;
+
+  for (const char* p = buf; p < end; p++)
+  {
+    if (*p != '-' && (*p < '0' || *p > '9'))
+      whole = false;
+  }
+
+  if (whole)
+  {
+    *end++ = '.';
+    *end++ = '0';
+  }
+
+  return UNX_Widen (buf, end, out);
+}
+
+size_t
+unx::num::FormatHex (uint32_t val, wchar_t (&out) [MaxChars])
+{
+  static const char digits [] = "0123456789abcdef";
+
+  char buf [10] = { '0', 'x' };
+
+  for (int i = 0; i < 8; i++)
+    buf [2 + i] = digits [(val >> (28 - 4 * i)) & 0xf];
+
+  return UNX_Widen (buf, buf + sizeof buf, out);
+}
+
+unx::num::result_e
+unx::num::Parse (std::wstring_view text, int& out)
+{
+  return UNX_FromChars (text, out, 10);
+}
+
+unx::num::result_e
+unx::num::Parse (std::wstring_view text, int64_t& out)
+{
+  return UNX_FromChars (text, out, 10);
+}
+
+unx::num::result_e
+unx::num::Parse (std::wstring_view text, float& out)
+{
+#ifdef UNX_FLOAT_CHARCONV
+  return UNX_FromChars (text, out, std::chars_format::general);
+#else
+  return UNX_ParseFloat (text, out);
+#endif
+}
+
+unx::num::result_e
+unx::num::ParseHex (std::wstring_view text, uint32_t& out)
+{
+  while ((! text.empty ()) && (text.front () == L' ' || text.front () == L'\t'))
+    text.remove_prefix (1);
+
+  if (text.size () > 2 && text [0] == L'0' && (text [1] == L'x' || text [1] == L'X'))
+    text.remove_prefix (2);
+
+  // A sign after the prefix is not a hash; the '+' would otherwise be skipped
+  if ((! text.empty ()) && (text.front () == L'-' || text.front () == L'+'))
+    return result_e::Invalid;
+
+  return UNX_FromChars (text, out, 16);
+}
@@ -0,0 +1,66 @@
+/**
+ * This file is part of UnX.
+ *
+ * UnX is free software : you can redistribute it
+ * and/or modify it under the terms of the GNU General Public License
+ * as published by The Free Software Foundation, either version 3 of
+ * the License, or (at your option) any later version.
+ *
+ * UnX is distributed in the hope that it will be useful,
+ *
+ * But WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with UnX.
+ *
+ *   If not, see <http://www.gnu.org/licenses/>.
+ *
+**/
+#ifndef __UNX__NUMERIC_H__
+#define __UNX__NUMERIC_H__
+
+#include <cstddef>
+#include <cstdint>
+#include <string_view>
+
+//
+// Number <-> text conversion for config values.
+//
+//   Built on to_chars / from_chars, so the results do not depend on the
+//     C locale and nothing is allocated. Floats are written in the shortest
+//       form that reads back as the same value (toolsets without the float
+//         overloads use the CRT in the C locale instead).
+//
+namespace unx
+{
+  namespace num
+  {
+    enum class result_e {
+      Ok,
+      Invalid,    // Not a number, or trailing garbage
+      OutOfRange  // A number, but it does not fit the type
+    };
+
+    // Buffer size for Format, including the terminator
+    static const size_t MaxChars = 32;
+
+    // Return the length written, not counting the terminator
+    size_t   Format    (int      val, wchar_t (&out) [MaxChars]);
+    size_t   Format    (int64_t  val, wchar_t (&out) [MaxChars]);
+    size_t   Format    (float    val, wchar_t (&out) [MaxChars]); // Whole numbers keep a ".0"
+    size_t   FormatHex (uint32_t val, wchar_t (&out) [MaxChars]); // 0x%08x
+
+    //
+    // Surrounding blanks and a leading '+' are accepted, anything else that
+    //   is not part of the number is not. out is only written on success.
+    //
+    result_e Parse     (std::wstring_view text, int&      out);
+    result_e Parse     (std::wstring_view text, int64_t&  out);
+    result_e Parse     (std::wstring_view text, float&    out);
+    result_e ParseHex  (std::wstring_view text, uint32_t& out);   // 0x is optional
+  }
+}
+
+#endif /* __UNX__NUMERIC_H__ */
@@ -19,17 +19,16 @@
  *
 **/
 #define _CRT_SECURE_NO_WARNINGS
-#define _CRT_NON_CONFORMING_SWPRINTFS
 
 #include "parameter.h"
+#include "numeric.h"
 
 std::wstring
 unx::ParameterInt::get_value_str (void)
 {
-  wchar_t str [32];
-  _itow (value, str, 10);
+  wchar_t str [unx::num::MaxChars];
 
-  return std::wstring (str);
+  return std::wstring (str, unx::num::Format (value, str));
 }
 
 int
@@ -48,7 +47,9 @@ unx::ParameterInt::set_value (int val)
 void
 unx::ParameterInt::set_value_str (std::wstring str)
 {
-  value = _wtoi (str.c_str ());
+  // Unparseable values read as 0, the way _wtoi did
+  if (unx::num::Parse (str, value) != unx::num::result_e::Ok)
+    value = 0;
 }
 
 
@@ -83,10 +84,9 @@ unx::ParameterInt::load (int& ref)
 std::wstring
 unx::ParameterInt64::get_value_str (void)
 {
-  wchar_t str [32];
-  _i64tow (value, str, 10);
+  wchar_t str [unx::num::MaxChars];
 
-  return std::wstring (str);
+  return std::wstring (str, unx::num::Format (value, str));
 }
 
 int64_t
@@ -105,7 +105,8 @@ unx::ParameterInt64::set_value (int64_t val)
 void
 unx::ParameterInt64::set_value_str (std::wstring str)
 {
-  value = _wtoll (str.c_str ());
+  if (unx::num::Parse (str, value) != unx::num::result_e::Ok)
+    value = 0;
 }
 
 
@@ -209,21 +210,9 @@ unx::ParameterBool::load (bool& ref)
 std::wstring
 unx::ParameterFloat::get_value_str (void)
 {
-  wchar_t val_str [16];
-  swprintf (val_str, L"%f", value);
+  wchar_t str [unx::num::MaxChars];
 
-  // Remove trailing 0's after the .
-  size_t len = wcslen (val_str);
-  for (size_t i = (len - 1); i > 1; i--) {
-    if (val_str [i] == L'0' && val_str [i - 1] != L'.')
-      len--;
-    if (val_str [i] != L'0' && val_str [i] != L'\0')
-      break;
-  }
-
-  val_str [len] = L'\0';
-
-  return std::wstring (val_str);
+  return std::wstring (str, unx::num::Format (value, str));
 }
 
 float
@@ -242,7 +231,8 @@ unx::ParameterFloat::set_value (float val)
 void
 unx::ParameterFloat::set_value_str (std::wstring str)
 {
-  value = (float)wcstod (str.c_str (), NULL);
+  if (unx::num::Parse (str, value) != unx::num::result_e::Ok)
+    value = 0.0f;
 }
 
 
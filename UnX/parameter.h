@@ -22,6 +22,7 @@
 #define __UNX__PARAMETER_H__
 
 #include "ini.h"
+#include "inifile.h"
 
 #include <Windows.h>
 #include <vector>
@@ -32,22 +33,25 @@ class iParameter
 {
 public:
   iParameter (void) {
-    ini = nullptr;
+    ini_file = nullptr;
+    ini      = nullptr;
   }
 
+  // The key handle points into ini_section / ini_key
+  iParameter            (const iParameter&) = delete;
+  iParameter& operator= (const iParameter&) = delete;
+
   virtual std::wstring get_value_str (void)             = 0;
   virtual void         set_value_str (std::wstring str) = 0;
   
   // Read value from INI
   bool load (void)
   {
-    if (ini != nullptr) {
-      iSK_INISection& section = ini->get_section (ini_section.c_str ());
+    std::wstring_view value;
 
-      if (section.contains_key (ini_key.c_str ())) {
-        set_value_str (section.get_value (ini_key.c_str ()));
-        return true;
-      }
+    if (bind () && ini->find_value (ini_handle, value)) {
+      set_value_str (std::wstring (value));
+      return true;
     }
 
     return false;
@@ -58,40 +62,44 @@ public:
   {
     bool ret = false;
 
-    if (ini != nullptr) {
-      iSK_INISection& section = ini->get_section (ini_section.c_str ());
-
-      // If this operation actually creates a section, we need to make sure
-      //   that section has a name!
-      section.set_name (ini_section.c_str ());
-
-      if (section.contains_key (ini_key.c_str ())) {
-        section.get_value (ini_key.c_str ()) = get_value_str ().c_str ();
-        ret = true;
-      }
-
-      // Add this key/value if it doesn't already exist.
-      else {
-        section.add_key_value (ini_key.c_str (), get_value_str ().c_str ());
-        ret = true;// +1;
-      }
+    if (bind ()) {
+      // Creates the section and key if they do not exist yet; the section is
+      //   only marked dirty (and rewritten on the next save) if the value
+      //     changed.
+      ini->set_value (ini_handle, get_value_str ());
+      ret = true;
     }
 
     return ret;
   }
 
+  // The file is not touched (or even loaded) until the first load / store
   void register_to_ini (iSK_INI* file, std::wstring section, std::wstring key)
   {
-    ini         = file;
-    ini_section = section;
-    ini_key     = key;
+    ini_file    = file;
+    ini         = nullptr;
+    ini_section = std::move (section);
+    ini_key     = std::move (key);
   }
 
 protected:
 private:
-  iSK_INI*             ini;
-  std::wstring         ini_section;
-  std::wstring         ini_key;
+  bool bind (void)
+  {
+    if (ini == nullptr && ini_file != nullptr)
+    {
+      ini        = UNX_GetINIFile (ini_file);
+      ini_handle = ini->handle    (ini_section, ini_key);
+    }
+
+    return ini != nullptr;
+  }
+
+  iSK_INI*                    ini_file;
+  unx::INIFile*               ini;
+  std::wstring                ini_section;
+  std::wstring                ini_key;
+  unx::INIFile::key_handle_s  ini_handle;
 };
 
 template <typename _T>
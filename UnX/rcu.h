@@ -0,0 +1,227 @@
+/**
+ * This file is part of UnX.
+ *
+ * UnX is free software : you can redistribute it
+ * and/or modify it under the terms of the GNU General Public License
+ * as published by The Free Software Foundation, either version 3 of
+ * the License, or (at your option) any later version.
+ *
+ * UnX is distributed in the hope that it will be useful,
+ *
+ * But WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with UnX.
+ *
+ *   If not, see <http://www.gnu.org/licenses/>.
+ *
+**/
+#ifndef __UNX__RCU_H__
+#define __UNX__RCU_H__
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <utility>
+#include <vector>
+
+namespace unx
+{
+  //
+  // Read-copy-update cell with epoch-based reclamation.
+  //
+  //   Readers get a pointer to an immutable version that stays valid for as
+  //     long as they hold the guard; they never lock and never wait for a
+  //       writer. Writers copy the current version, change the copy and swap
+  //         it in; the version it replaced is freed once no reader can still
+  //           be looking at it, which a writer only ever checks, never waits
+  //             for.
+  //
+  //   A reader occupies one of _Readers slots while it holds a guard, tagged
+  //     with the epoch it started in. Every publish starts a new epoch; what
+  //       was retired in epoch e is safe once no slot is tagged <= e.
+  //
+  template <typename _T, size_t _Readers = 64>
+  class RCU
+  {
+  public:
+    class read_guard
+    {
+    public:
+      read_guard            (const read_guard&) = delete;
+      read_guard& operator= (const read_guard&) = delete;
+
+      read_guard (read_guard&& other) : slot_ (other.slot_), ptr_ (other.ptr_) {
+        other.slot_ = nullptr;
+      }
+
+      ~read_guard (void)
+      {
+        if (slot_ != nullptr)
+          slot_->store (0);
+      }
+
+      const _T* get        (void) const { return  ptr_; }
+      const _T* operator-> (void) const { return  ptr_; }
+      const _T& operator*  (void) const { return *ptr_; }
+
+    private:
+      friend class RCU;
+
+      read_guard (std::atomic <uint64_t>* slot, const _T* ptr) :
+        slot_ (slot), ptr_ (ptr) { }
+
+      std::atomic <uint64_t>* slot_;
+      const _T*               ptr_;
+    };
+
+    RCU (void) : current_ (new _T ()) { }
+
+    RCU            (const RCU&) = delete;
+    RCU& operator= (const RCU&) = delete;
+
+    // Nobody may be reading anymore
+    ~RCU (void)
+    {
+      delete current_.load ();
+
+      for (auto& it : retired_)
+        delete it.ptr;
+    }
+
+    // Any thread; the guard must not outlive the thread or the RCU
+    read_guard read (void) const
+    {
+      std::atomic <uint64_t>* slot =
+        claim (epoch_.load ());
+
+      return read_guard (slot, current_.load ());
+    }
+
+    // Any thread; writers are serialized, readers are never waited for
+    void publish (std::unique_ptr <_T> next)
+    {
+      std::lock_guard <std::mutex> lock (write_lock_);
+
+      retire (current_.exchange (next.release ()));
+    }
+
+    //
+    // Calls fn on a copy of the current version and publishes the copy if fn
+    //   returns true; returns what fn did.
+    //
+    template <typename _Fn>
+    bool update (_Fn&& fn)
+    {
+      std::lock_guard <std::mutex> lock (write_lock_);
+
+      std::unique_ptr <_T> next (
+        new _T (*current_.load ())
+      );
+
+      if (! fn (*next))
+        return false;
+
+      retire (current_.exchange (next.release ()));
+
+      return true;
+    }
+
+    // Frees whatever no reader can see anymore; returns how many are left
+    size_t reclaim (void)
+    {
+      std::lock_guard <std::mutex> lock (write_lock_);
+
+      return collect ();
+    }
+
+    uint64_t epoch (void) const { return epoch_.load (); }
+
+  private:
+    struct retired_s {
+      _T*      ptr;
+      uint64_t epoch;
+    };
+
+    struct alignas (64) slot_s {
+      std::atomic <uint64_t> epoch { 0 };  // 0 = free
+    };
+
+    std::atomic <uint64_t>* claim (uint64_t epoch) const
+    {
+      // Threads start looking in different places, so they rarely collide
+      size_t idx =
+        std::hash <std::thread::id> () (std::this_thread::get_id ()) % _Readers;
+
+      for (;;)
+      {
+        for (size_t i = 0; i < _Readers; i++)
+        {
+          std::atomic <uint64_t>& slot = slots_ [(idx + i) % _Readers].epoch;
+
+          uint64_t free = 0;
+
+          if ( slot.load () == 0 &&
+               slot.compare_exchange_strong (free, epoch) )
+            return &slot;
+        }
+
+        // More readers than slots; one of them is about to finish
+        std::this_thread::yield ();
+      }
+    }
+
+    // write_lock_ held
+    void retire (_T* old)
+    {
+      retired_.push_back ({ old, epoch_.fetch_add (1) });
+
+      collect ();
+    }
+
+    // write_lock_ held
+    size_t collect (void)
+    {
+      uint64_t oldest = UINT64_MAX;
+
+      for (const auto& slot : slots_)
+      {
+        const uint64_t epoch = slot.epoch.load ();
+
+        if (epoch != 0 && epoch < oldest)
+          oldest = epoch;
+      }
+
+      size_t kept = 0;
+
+      for (auto& it : retired_)
+      {
+        if (it.epoch < oldest)
+          delete it.ptr;
+        else
+          retired_ [kept++] = it;
+      }
+
+      retired_.resize (kept);
+
+      return kept;
+    }
+
+    // Everything is sequentially consistent; the reclamation argument above
+    //   relies on a single order of slot claims, epoch bumps and swaps.
+    std::atomic <_T *>             current_;
+    alignas (64)
+    std::atomic <uint64_t>         epoch_   { 1 };
+    mutable slot_s                 slots_ [_Readers];
+
+    std::mutex                     write_lock_;
+    std::vector <retired_s>        retired_;
+  };
+}
+
+#endif /* __UNX__RCU_H__ */
@@ -0,0 +1,277 @@
+/**
+ * This file is part of UnX.
+ *
+ * UnX is free software : you can redistribute it
+ * and/or modify it under the terms of the GNU General Public License
+ * as published by The Free Software Foundation, either version 3 of
+ * the License, or (at your option) any later version.
+ *
+ * UnX is distributed in the hope that it will be useful,
+ *
+ * But WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with UnX.
+ *
+ *   If not, see <http://www.gnu.org/licenses/>.
+ *
+**/
+#include "remap.h"
+
+#include <cmath>
+#include <cstring>
+#include <limits>
+
+#if defined (_M_IX86) || defined (_M_X64) || defined (__i386__) || defined (__x86_64__)
+# define UNX_REMAP_X86
+# include <emmintrin.h>
+# include <tmmintrin.h>
+# ifdef _MSC_VER
+#  include <intrin.h>
+#  define UNX_TARGET_SSSE3
+# else
+#  include <cpuid.h>
+#  define UNX_TARGET_SSSE3 __attribute__ ((target ("ssse3")))
+# endif
+#endif
+
+bool
+unx::remap::HasSSSE3 (void)
+{
+#ifdef UNX_REMAP_X86
+  static const bool ssse3 = [](void) -> bool
+  {
+# ifdef _MSC_VER
+    int regs [4] = { };
+    __cpuid (regs, 1);
+
+    return (regs [2] & (1 << 9)) != 0;
+# else
+    unsigned int a, b, c, d;
+
+    if (! __get_cpuid (1, &a, &b, &c, &d))
+      return false;
+
+    return (c & bit_SSSE3) != 0;
+# endif
+  }();
+
+  return ssse3;
+#else
+  return false;
+#endif
+}
+
+
+uint32_t
+unx::remap::BuildJoyRemap (const int map [MaxRemappedButtons], joy_remap_s* out)
+{
+  uint32_t rejected = 0;
+
+  memset (out, 0, sizeof (joy_remap_s));
+
+  for (int i = 0; i < 16; i++)
+    out->shuffle [i] = (uint8_t)i;
+
+  for (int i = 0; i < MaxRemappedButtons; i++)
+  {
+    if (map [i] >= 0 && map [i] < 16)
+      out->shuffle [i] = (uint8_t)map [i];
+
+    else if (map [i] >= 16 && map [i] < MaxSourceButtons)
+    {
+      out->far_buttons [out->far_count].button = (uint8_t)i;
+      out->far_buttons [out->far_count].source = (uint8_t)map [i];
+
+      out->far_count++;
+    }
+
+    else if (map [i] <= -2 && map [i] >= -(MaxAxes + 1))
+    {
+      out->axes [out->axis_count].button = (uint8_t)i;
+      out->axes [out->axis_count].axis   = (uint8_t)(-map [i] - 2);
+
+      out->axis_count++;
+    }
+
+    // -1 is "not remapped"
+    else if (map [i] != -1)
+      rejected |= 1UL << i;
+  }
+
+  // Until a device tells us otherwise, assume DirectInput's default range
+  for (int i = 0; i < MaxAxes; i++)
+    SetAxisRange (out, i, 0, 65535);
+
+  return rejected;
+}
+
+void
+unx::remap::SetAxisRange (joy_remap_s* remap, int axis, int32_t min, int32_t max, uint8_t threshold)
+{
+  if (axis < 0 || axis >= MaxAxes)
+    return;
+
+  remap->threshold [axis] =
+    min + (int32_t)(((int64_t)max - min) * threshold / 255);
+}
+
+
+// Everything the shuffle does not cover; runs after it, and since the
+//   shuffle only writes the first 16 buttons, far sources are still intact.
+static inline void
+UNX_ApplyJoyRemap_Tail (const unx::remap::joy_remap_s& remap, const int32_t* axes, uint8_t* buttons)
+{
+  for (int i = 0; i < remap.far_count; i++)
+  {
+    const auto& fb = remap.far_buttons [i];
+
+    buttons [fb.button] = buttons [fb.source];
+  }
+
+  for (int i = 0; i < remap.axis_count; i++)
+  {
+    const auto& ab = remap.axes [i];
+
+    buttons [ab.button] =
+      axes [ab.axis] > remap.threshold [ab.axis] ? 0x80 : 0x00;
+  }
+}
+
+void
+unx::remap::ApplyJoyRemap_Scalar (const joy_remap_s& remap, const int32_t* axes, uint8_t* buttons)
+{
+  uint8_t in [16];
+  memcpy (in, buttons, 16);
+
+  for (int i = 0; i < 16; i++)
+    buttons [i] = in [remap.shuffle [i]];
+
+  UNX_ApplyJoyRemap_Tail (remap, axes, buttons);
+}
+
+#ifdef UNX_REMAP_X86
+UNX_TARGET_SSSE3
+static void
+UNX_ApplyJoyRemap_SSSE3 (const unx::remap::joy_remap_s& remap, const int32_t* axes, uint8_t* buttons)
+{
+  const __m128i ctl  = _mm_load_si128  ((const __m128i *)remap.shuffle);
+        __m128i btns = _mm_loadu_si128 ((const __m128i *)buttons);
+
+  _mm_storeu_si128 ((__m128i *)buttons, _mm_shuffle_epi8 (btns, ctl));
+
+  UNX_ApplyJoyRemap_Tail (remap, axes, buttons);
+}
+#endif
+
+void
+unx::remap::ApplyJoyRemap (const joy_remap_s& remap, const int32_t* axes, uint8_t* buttons)
+{
+#ifdef UNX_REMAP_X86
+  if (HasSSSE3 ())
+    return UNX_ApplyJoyRemap_SSSE3 (remap, axes, buttons);
+#endif
+
+  ApplyJoyRemap_Scalar (remap, axes, buttons);
+}
+
+
+void
+unx::remap::BuildKeyMask (const uint8_t* blocked, size_t count, key_mask_s* out)
+{
+  memset (out->keep, 0xff, sizeof out->keep);
+
+  for (size_t i = 0; i < count; i++)
+    out->keep [blocked [i]] = 0x00;
+}
+
+void
+unx::remap::ApplyKeyMask_Scalar (const key_mask_s& mask, const uint8_t* in, uint8_t* out, size_t cb)
+{
+  if (cb > sizeof mask.keep)
+      cb = sizeof mask.keep;
+
+  for (size_t i = 0; i < cb; i++)
+    out [i] = in [i] & mask.keep [i];
+}
+
+void
+unx::remap::ApplyKeyMask (const key_mask_s& mask, const uint8_t* in, uint8_t* out, size_t cb)
+{
+#ifdef UNX_REMAP_X86
+  // SSE2 is the baseline for this DLL; no need for a CPUID check
+  if (cb == sizeof mask.keep)
+  {
+    for (size_t i = 0; i < sizeof mask.keep; i += 16)
+    {
+      __m128i keep = _mm_load_si128  ((const __m128i *)&mask.keep [i]);
+      __m128i data = _mm_loadu_si128 ((const __m128i *)&in        [i]);
+
+      _mm_storeu_si128 ((__m128i *)&out [i], _mm_and_si128 (data, keep));
+    }
+
+    return;
+  }
+#endif
+
+  ApplyKeyMask_Scalar (mask, in, out, cb);
+}
+
+
+void
+unx::remap::BuildAxisTable ( axis_table_s* out, int32_t min, int32_t max,
+                             float dead_zone, float curve,
+                             uint8_t press_threshold )
+{
+  if (max <= min)
+      max  = min + 1;
+
+  if (dead_zone < 0.0f)  dead_zone = 0.0f;
+  if (dead_zone > 0.95f) dead_zone = 0.95f;
+  if (curve     < 0.1f)  curve     = 0.1f;
+  if (curve     > 10.0f) curve     = 10.0f;
+
+  out->min   = min;
+  out->range = max - min;
+
+  // Rounded up so that the far end of the range reaches 255
+  out->scale =
+    (uint32_t)(((255ULL << 16) + out->range - 1) / (uint32_t)out->range);
+
+  for (int n = 0; n < 256; n++)
+  {
+    float t = (float)n / 255.0f;
+
+    if (t <= dead_zone)
+    {
+      out->lut [n] = 0;
+      continue;
+    }
+
+    t = (t - dead_zone) / (1.0f - dead_zone);
+
+    out->lut [n] =
+      (uint8_t)(255.0f * powf (t, curve) + 0.5f);
+  }
+
+  // The table is monotonic, so the first index past the threshold can be
+  //   converted back to the first raw value that lands on it.
+  out->press = std::numeric_limits <int32_t>::max ();
+
+  for (uint32_t n = 0; n < 256; n++)
+  {
+    if (out->lut [n] > press_threshold)
+    {
+      uint64_t d =
+        ((uint64_t)n << 16) / out->scale +
+       (((uint64_t)n << 16) % out->scale != 0);
+
+      if (d <= (uint64_t)out->range)
+        out->press = min + (int32_t)d;
+
+      break;
+    }
+  }
+}
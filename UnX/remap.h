@@ -0,0 +1,142 @@
+/**
+ * This file is part of UnX.
+ *
+ * UnX is free software : you can redistribute it
+ * and/or modify it under the terms of the GNU General Public License
+ * as published by The Free Software Foundation, either version 3 of
+ * the License, or (at your option) any later version.
+ *
+ * UnX is distributed in the hope that it will be useful,
+ *
+ * But WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with UnX.
+ *
+ *   If not, see <http://www.gnu.org/licenses/>.
+ *
+**/
+#ifndef __UNX__REMAP_H__
+#define __UNX__REMAP_H__
+
+#include <cstddef>
+#include <cstdint>
+
+//
+// Remap kernels for the DirectInput GetDeviceState detour.
+//
+//   Everything here is plain data + free functions so that it does not depend
+//     on DirectInput or Win32; the detour builds the tables once and then only
+//       ever calls the Apply functions.
+//
+namespace unx
+{
+  namespace remap
+  {
+    static const int MaxRemappedButtons = 12;
+    static const int MaxAxes            = 6;  // lX, lY, lZ, lRx, lRy, lRz
+    static const int MaxSourceButtons   = 128;// DIJOYSTATE2::rgbButtons
+
+    struct joy_remap_s {
+      // pshufb control; lane i receives source button idx [i]
+      alignas (16) uint8_t shuffle [16];
+
+      // Buttons that are driven by an axis instead of another button
+      struct axis_button_s {
+        uint8_t button;
+        uint8_t axis;
+      } axes [MaxRemappedButtons];
+
+      int     axis_count;
+
+      // Source buttons 16+ are out of the shuffle's reach; copied one by one
+      struct far_button_s {
+        uint8_t button;
+        uint8_t source;
+      } far_buttons [MaxRemappedButtons];
+
+      int     far_count;
+
+      // Raw axis value at which an axis-mapped button is considered held,
+      //   filled in per-device once its DIPROP_RANGE is known.
+      int32_t threshold [MaxAxes];
+    };
+
+    //
+    // map [i] uses the encoding of unx_gamepad_s::remap_s::map; >= 0 is a
+    //   source button, -2 ... -7 are axes X, Y, Z, U (Rx), V (Ry), R (Rz).
+    //
+    //   Returns a mask of the entries (bit i = map [i]) that were out of range
+    //     and left unmapped, so the caller can report them.
+    //
+    uint32_t BuildJoyRemap  (const int map [MaxRemappedButtons], joy_remap_s* out);
+
+    // Threshold is expressed the way the legacy poller does it (0-255 of range)
+    void SetAxisRange       (joy_remap_s* remap, int axis, int32_t min, int32_t max,
+                             uint8_t threshold = 190);
+
+    // buttons must point to MaxSourceButtons bytes; axes to MaxAxes values
+    void ApplyJoyRemap      (const joy_remap_s& remap, const int32_t* axes, uint8_t* buttons);
+
+
+    struct key_mask_s {
+      alignas (16) uint8_t keep [256];
+    };
+
+    void BuildKeyMask       (const uint8_t* blocked, size_t count, key_mask_s* out);
+
+    // out [i] = in [i] & keep [i]; in and out may alias
+    void ApplyKeyMask       (const key_mask_s& mask, const uint8_t* in, uint8_t* out, size_t cb);
+
+
+    //
+    // Fixed-point axis normalization.
+    //
+    //   Raw axis units map to 0-255 through a 16.16 scale, and a 256-entry
+    //     table applies the dead zone and response curve. Button-style
+    //       checks skip all of that and compare the raw value to a threshold
+    //         that was solved for when the table was built.
+    //
+    struct axis_table_s {
+      int32_t  min;
+      int32_t  range;
+      uint32_t scale;  // 16.16, raw units -> 0-255
+      int32_t  press;  // Lowest raw value that reads as pressed
+      uint8_t  lut [256];
+    };
+
+    // dead_zone is a fraction of travel (0.0 - 0.95), curve an exponent
+    void BuildAxisTable     (axis_table_s* out, int32_t min, int32_t max,
+                             float dead_zone = 0.0f, float curve = 1.0f,
+                             uint8_t press_threshold = 190);
+
+    inline uint8_t
+    AxisValue (const axis_table_s& table, int32_t raw)
+    {
+      int32_t d = raw - table.min;
+
+      if (d <= 0)           return table.lut [0];
+      if (d >= table.range) return table.lut [255];
+
+      uint32_t n = ((uint32_t)d * table.scale) >> 16;
+
+      return table.lut [n < 255 ? n : 255];
+    }
+
+    inline bool
+    AxisPressed (const axis_table_s& table, int32_t raw)
+    {
+      return raw >= table.press;
+    }
+
+
+    // Exposed so the scalar paths can be checked against the SIMD ones
+    bool HasSSSE3           (void);
+    void ApplyJoyRemap_Scalar (const joy_remap_s& remap, const int32_t* axes, uint8_t* buttons);
+    void ApplyKeyMask_Scalar  (const key_mask_s& mask, const uint8_t* in, uint8_t* out, size_t cb);
+  }
+}
+
+#endif /* __UNX__REMAP_H__ */
@@ -0,0 +1,334 @@
+/**
+ * This file is part of UnX.
+ *
+ * UnX is free software : you can redistribute it
+ * and/or modify it under the terms of the GNU General Public License
+ * as published by The Free Software Foundation, either version 3 of
+ * the License, or (at your option) any later version.
+ *
+ * UnX is distributed in the hope that it will be useful,
+ *
+ * But WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with UnX.
+ *
+ *   If not, see <http://www.gnu.org/licenses/>.
+ *
+**/
+#include "replay.h"
+
+#include <cstring>
+
+enum {
+  Changed_Buttons   = 0x01,
+  Changed_LT        = 0x02,
+  Changed_RT        = 0x04,
+  Changed_LX        = 0x08,
+  Changed_LY        = 0x10,
+  Changed_RX        = 0x20,
+  Changed_RY        = 0x40,
+  Changed_Connected = 0x80  // No payload, the flag flips it
+};
+
+static void
+UNX_PutU16 (std::vector <uint8_t>& out, uint16_t val)
+{
+  out.push_back ((uint8_t)( val       & 0xFF));
+  out.push_back ((uint8_t)((val >> 8) & 0xFF));
+}
+
+static void
+UNX_PutVarint (std::vector <uint8_t>& out, uint64_t val)
+{
+  do
+  {
+    uint8_t byte = (uint8_t)(val & 0x7F);
+                   val >>= 7;
+
+    out.push_back (byte | (val != 0 ? 0x80 : 0x00));
+  } while (val != 0);
+}
+
+
+bool
+unx::InputRecorder::open (FILE* fp, uint32_t poll_hz, uint16_t flags)
+{
+  close ();
+
+  if (fp == nullptr)
+    return false;
+
+  replay_header_s header = { { 'U', 'N', 'X', 'R' },
+                               ReplayVersion, flags,
+                                 poll_hz, 0 };
+
+  // Written field-by-field so the file is little-endian and unpadded
+  buf_.clear ();
+
+  for (char ch : header.magic)
+    buf_.push_back ((uint8_t)ch);
+
+  UNX_PutU16  (buf_, header.version);
+  UNX_PutU16  (buf_, header.flags);
+  UNX_PutU16  (buf_, (uint16_t)( header.poll_hz        & 0xFFFF));
+  UNX_PutU16  (buf_, (uint16_t)((header.poll_hz >> 16) & 0xFFFF));
+  UNX_PutU16  (buf_, 0);
+  UNX_PutU16  (buf_, 0);
+
+  fp_     = fp;
+  first_  = true;
+  last_   = pad_state_s { };
+
+  flush (0);
+
+  return true;
+}
+
+void
+unx::InputRecorder::append (uint64_t usecs, const pad_state_s& state)
+{
+  if (fp_ == nullptr)
+    return;
+
+  if (first_)
+  {
+    last_us_    = usecs;
+    flushed_us_ = usecs;
+    first_      = false;
+  }
+
+  uint8_t changed = 0;
+
+  if (state.buttons       != last_.buttons)       changed |= Changed_Buttons;
+  if (state.left_trigger  != last_.left_trigger)  changed |= Changed_LT;
+  if (state.right_trigger != last_.right_trigger) changed |= Changed_RT;
+  if (state.thumb_lx      != last_.thumb_lx)      changed |= Changed_LX;
+  if (state.thumb_ly      != last_.thumb_ly)      changed |= Changed_LY;
+  if (state.thumb_rx      != last_.thumb_rx)      changed |= Changed_RX;
+  if (state.thumb_ry      != last_.thumb_ry)      changed |= Changed_RY;
+  if (state.connected     != last_.connected)     changed |= Changed_Connected;
+
+  buf_.push_back (changed);
+
+  UNX_PutVarint (buf_, usecs >= last_us_ ? usecs - last_us_ : 0);
+
+  if (changed & Changed_Buttons) UNX_PutU16    (buf_, state.buttons);
+  if (changed & Changed_LT)      buf_.push_back (state.left_trigger);
+  if (changed & Changed_RT)      buf_.push_back (state.right_trigger);
+  if (changed & Changed_LX)      UNX_PutU16    (buf_, (uint16_t)state.thumb_lx);
+  if (changed & Changed_LY)      UNX_PutU16    (buf_, (uint16_t)state.thumb_ly);
+  if (changed & Changed_RX)      UNX_PutU16    (buf_, (uint16_t)state.thumb_rx);
+  if (changed & Changed_RY)      UNX_PutU16    (buf_, (uint16_t)state.thumb_ry);
+
+  last_    = state;
+  last_us_ = usecs >= last_us_ ? usecs : last_us_;
+
+  if (buf_.size () >= 4096)
+    flush (usecs);
+  else
+    sync  (usecs);
+}
+
+void
+unx::InputRecorder::sync (uint64_t usecs)
+{
+  // Anything written earlier has already been fflush'd
+  if (buf_.empty ())
+    return;
+
+  if (usecs >= flushed_us_ + FlushInterval)
+    flush (usecs);
+}
+
+void
+unx::InputRecorder::write (void)
+{
+  if (fp_ != nullptr && (! buf_.empty ()))
+  {
+    fwrite (buf_.data (), 1, buf_.size (), fp_);
+    buf_.clear ();
+  }
+}
+
+void
+unx::InputRecorder::flush (uint64_t usecs)
+{
+  if (fp_ == nullptr)
+    return;
+
+  write  (   );
+  fflush (fp_);
+
+  flushed_us_ = usecs;
+}
+
+void
+unx::InputRecorder::close (void)
+{
+  if (fp_ != nullptr)
+  {
+    write  (   );
+    fclose (fp_);
+
+    fp_ = nullptr;
+  }
+}
+
+
+bool
+unx::InputReplay::load (FILE* fp)
+{
+  if (fp == nullptr)
+    return false;
+
+  std::vector <uint8_t> data;
+  uint8_t               chunk [4096];
+  size_t                read;
+
+  while ((read = fread (chunk, 1, sizeof chunk, fp)) > 0)
+    data.insert (data.end (), chunk, chunk + read);
+
+  fclose (fp);
+
+  return load (data.data (), data.size ());
+}
+
+bool
+unx::InputReplay::load (const uint8_t* data, size_t len)
+{
+  const size_t HeaderSize = 16;
+
+  if (len < HeaderSize || memcmp (data, "UNXR", 4) != 0)
+    return false;
+
+  header_            = replay_header_s { };
+  memcpy (header_.magic, data, 4);
+  header_.version    = (uint16_t)(data [4] | (data [5] << 8));
+  header_.flags      = (uint16_t)(data [6] | (data [7] << 8));
+  header_.poll_hz    = (uint32_t) data [8]        | ((uint32_t)data [9]  << 8) |
+                      ((uint32_t)data [10] << 16) | ((uint32_t)data [11] << 24);
+
+  if (header_.version != ReplayVersion)
+    return false;
+
+  data_.assign (data + HeaderSize, data + len);
+  rewind       ();
+
+  return true;
+}
+
+void
+unx::InputReplay::rewind (void)
+{
+  pos_    = 0;
+  time_   = 0;
+  state_  = pad_state_s { };
+  peeked_ = false;
+}
+
+bool
+unx::InputReplay::next (uint64_t* usecs, pad_state_s* state)
+{
+  if (peeked_)
+  {
+    peeked_ = false;
+    *usecs  = peek_us_;
+    *state  = peek_;
+
+    return true;
+  }
+
+  const size_t end = data_.size ();
+
+  if (pos_ >= end)
+    return false;
+
+  size_t        pos     = pos_;
+  const uint8_t changed = data_ [pos++];
+
+  uint64_t delta = 0;
+  int      shift = 0;
+
+  for (;;)
+  {
+    if (pos >= end || shift > 63)
+      return false;
+
+    const uint8_t byte = data_ [pos++];
+
+    delta |= (uint64_t)(byte & 0x7F) << shift;
+    shift += 7;
+
+    if (! (byte & 0x80))
+      break;
+  }
+
+  auto GetU16 = [&](uint16_t* out) -> bool
+  {
+    if (pos + 2 > end)
+      return false;
+
+    *out = (uint16_t)(data_ [pos] | (data_ [pos + 1] << 8));
+    pos += 2;
+
+    return true;
+  };
+
+  auto GetU8 = [&](uint8_t* out) -> bool
+  {
+    if (pos + 1 > end)
+      return false;
+
+    *out = data_ [pos++];
+
+    return true;
+  };
+
+  pad_state_s s = state_;
+  uint16_t    u = 0;
+
+  // A truncated record (e.g. the game crashed mid-write) ends the replay
+  if ((changed & Changed_Buttons) && (! GetU16 (&s.buttons)))       return false;
+  if ((changed & Changed_LT)      && (! GetU8  (&s.left_trigger)))  return false;
+  if ((changed & Changed_RT)      && (! GetU8  (&s.right_trigger))) return false;
+  if  (changed & Changed_LX) { if (! GetU16 (&u)) return false; s.thumb_lx = (int16_t)u; }
+  if  (changed & Changed_LY) { if (! GetU16 (&u)) return false; s.thumb_ly = (int16_t)u; }
+  if  (changed & Changed_RX) { if (! GetU16 (&u)) return false; s.thumb_rx = (int16_t)u; }
+  if  (changed & Changed_RY) { if (! GetU16 (&u)) return false; s.thumb_ry = (int16_t)u; }
+  if  (changed & Changed_Connected) s.connected = (! s.connected);
+
+  pos_   = pos;
+  time_ += delta;
+  state_ = s;
+
+  *usecs = time_;
+  *state = s;
+
+  return true;
+}
+
+bool
+unx::InputReplay::advance (uint64_t elapsed, pad_state_s* state)
+{
+  uint64_t    usecs = 0;
+  pad_state_s s;
+
+  while (next (&usecs, &s))
+  {
+    if (usecs > elapsed)
+    {
+      peeked_  = true;
+      peek_us_ = usecs;
+      peek_    = s;
+
+      return true;
+    }
+
+    *state = s;
+  }
+
+  return false;
+}
@@ -0,0 +1,150 @@
+/**
+ * This file is part of UnX.
+ *
+ * UnX is free software : you can redistribute it
+ * and/or modify it under the terms of the GNU General Public License
+ * as published by The Free Software Foundation, either version 3 of
+ * the License, or (at your option) any later version.
+ *
+ * UnX is distributed in the hope that it will be useful,
+ *
+ * But WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with UnX.
+ *
+ *   If not, see <http://www.gnu.org/licenses/>.
+ *
+**/
+#ifndef __UNX__REPLAY_H__
+#define __UNX__REPLAY_H__
+
+#include <cstdint>
+#include <cstdio>
+#include <vector>
+
+//
+// Gamepad capture / replay.
+//
+//   One record per poll: a byte saying which fields changed, the time since
+//     the previous poll (LEB128, microseconds) and then only the fields that
+//       changed. A pad sitting idle costs 2-3 bytes per poll.
+//
+//   Nothing in here knows about XInput or WinMM, so recordings can be played
+//     back outside of the game as well.
+//
+namespace unx
+{
+  struct pad_state_s {
+    uint16_t buttons       = 0;
+    uint8_t  left_trigger  = 0;
+    uint8_t  right_trigger = 0;
+    int16_t  thumb_lx      = 0;
+    int16_t  thumb_ly      = 0;
+    int16_t  thumb_rx      = 0;
+    int16_t  thumb_ry      = 0;
+    bool     connected     = false;
+  };
+
+  struct replay_header_s {
+    char     magic [4];   // "UNXR"
+    uint16_t version;
+    uint16_t flags;
+    uint32_t poll_hz;
+    uint32_t reserved;
+  };
+
+  static const uint16_t ReplayVersion     = 1;
+  static const uint16_t ReplayFlag_Legacy = 0x1; // Sampled through WinMM
+
+  //
+  // Combo matching as UNX_PollInput does it, so that a replay can drive it
+  //   outside of the game too: the buttons must be exactly the combo's, and
+  //     a combo that includes a trigger also needs that trigger held past
+  //       PadComboTrigger.
+  //
+  static const uint32_t PadCombo_LeftTrigger  = 0x10000; // XINPUT_GAMEPAD_LEFT_TRIGGER
+  static const uint32_t PadCombo_RightTrigger = 0x20000; // XINPUT_GAMEPAD_RIGHT_TRIGGER
+  static const uint8_t  PadComboTrigger       = 130;
+
+  inline bool
+  PadComboHeld (uint32_t combo, const pad_state_s& pad)
+  {
+    return
+      pad.connected && combo != 0                                                       &&
+      ((! (combo & PadCombo_LeftTrigger))  || pad.left_trigger  > PadComboTrigger) &&
+      ((! (combo & PadCombo_RightTrigger)) || pad.right_trigger > PadComboTrigger) &&
+      pad.buttons == (uint16_t)combo;
+  }
+
+  //
+  //   Records are buffered and reach the disk (fflush included) once 4 KiB
+  //     have built up or FlushInterval has passed, whichever comes first.
+  //       A process that never gets as far as close () (DLL detach does not
+  //         wait for the poll thread) loses at most that last interval.
+  //
+  class InputRecorder
+  {
+  public:
+    static const uint64_t FlushInterval = 1000000ULL; // usecs
+
+   ~InputRecorder (void) { close (); }
+
+    // Takes ownership of fp; the header is on disk when this returns
+    bool open    (FILE* fp, uint32_t poll_hz, uint16_t flags = 0);
+    void append  (uint64_t usecs, const pad_state_s& state);
+    void close   (void);
+
+    // Call periodically, even when nothing is appended, so that the tail of
+    //   the recording does not sit in memory indefinitely.
+    void sync    (uint64_t usecs);
+
+    bool is_open (void) const { return fp_ != nullptr; }
+
+  private:
+    void write   (void);
+    void flush   (uint64_t usecs);
+
+    FILE*                 fp_         = nullptr;
+    bool                  first_      = true;
+    uint64_t              last_us_    = 0;
+    uint64_t              flushed_us_ = 0;
+    pad_state_s           last_       = { };
+    std::vector <uint8_t> buf_;
+  };
+
+  class InputReplay
+  {
+  public:
+    // Reads (and closes) the entire file
+    bool     load     (FILE* fp);
+    bool     load     (const uint8_t* data, size_t len);
+
+    // Next recorded poll; usecs is relative to the start of the recording
+    bool     next     (uint64_t* usecs, pad_state_s* state);
+
+    // Applies every poll recorded up to elapsed; false once it runs out
+    bool     advance  (uint64_t elapsed, pad_state_s* state);
+
+    void     rewind   (void);
+
+    const replay_header_s&
+             header   (void) const { return header_; }
+
+  private:
+    std::vector <uint8_t> data_;
+    size_t                pos_     = 0;
+    uint64_t              time_    = 0;
+    pad_state_s           state_   = { };
+    replay_header_s       header_  = { };
+
+    // Decoded but not yet applied by advance ()
+    bool                  peeked_  = false;
+    uint64_t              peek_us_ = 0;
+    pad_state_s           peek_    = { };
+  };
+}
+
+#endif /* __UNX__REPLAY_H__ */
@@ -0,0 +1,254 @@
+/**
+ * This file is part of UnX.
+ *
+ * UnX is free software : you can redistribute it
+ * and/or modify it under the terms of the GNU General Public License
+ * as published by The Free Software Foundation, either version 3 of
+ * the License, or (at your option) any later version.
+ *
+ * UnX is distributed in the hope that it will be useful,
+ *
+ * But WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with UnX.
+ *
+ *   If not, see <http://www.gnu.org/licenses/>.
+ *
+**/
+#include "schema.h"
+#include "inifile.h"
+#include "numeric.h"
+
+#include <cwctype>
+
+bool
+unx::schema::Parse (const field_s& field, std::wstring_view text)
+{
+  using unx::num::result_e;
+
+  switch (field.type)
+  {
+    case type_e::String:
+      static_cast <std::wstring *> (field.value)->assign (text.data (), text.size ());
+      return true;
+
+    case type_e::Bool:
+    {
+      // Anything but 1 / true reads as false, as it always has
+      *static_cast <bool *> (field.value) =
+        ( text.size () == 1 && text [0] == L'1' ) ||
+        ( text.size () == 4 && towlower (text [0]) == L't' && towlower (text [1]) == L'r' &&
+                               towlower (text [2]) == L'u' && towlower (text [3]) == L'e' );
+      return true;
+    }
+
+    case type_e::Int:
+      return num::Parse    (text, *static_cast <int *>      (field.value)) == result_e::Ok;
+
+    case type_e::Int64:
+      return num::Parse    (text, *static_cast <int64_t *>  (field.value)) == result_e::Ok;
+
+    case type_e::Float:
+      return num::Parse    (text, *static_cast <float *>    (field.value)) == result_e::Ok;
+
+    case type_e::Hex:
+      return num::ParseHex (text, *static_cast <uint32_t *> (field.value)) == result_e::Ok;
+  }
+
+  return false;
+}
+
+void
+unx::schema::Format (const field_s& field, std::wstring& out)
+{
+  wchar_t str [num::MaxChars];
+  size_t  len = 0;
+
+  switch (field.type)
+  {
+    case type_e::String:
+      out = *static_cast <const std::wstring *> (field.value);
+      return;
+
+    case type_e::Bool:
+      out = *static_cast <const bool *> (field.value) ? L"true" : L"false";
+      return;
+
+    case type_e::Int:
+      len = num::Format    (*static_cast <const int *>      (field.value), str);
+      break;
+
+    case type_e::Int64:
+      len = num::Format    (*static_cast <const int64_t *>  (field.value), str);
+      break;
+
+    case type_e::Float:
+      len = num::Format    (*static_cast <const float *>    (field.value), str);
+      break;
+
+    case type_e::Hex:
+      len = num::FormatHex (*static_cast <const uint32_t *> (field.value), str);
+      break;
+  }
+
+  out.assign (str, len);
+}
+
+// Whether text parses to something other than what field holds right now
+static bool
+UNX_SchemaDiffers (const unx::schema::field_s& field, std::wstring_view text)
+{
+  using namespace unx::schema;
+
+  bool         b = false;
+  int          i = 0;
+  int64_t      l = 0;
+  float        f = 0.0f;
+  uint32_t     h = 0;
+  std::wstring s;
+
+  field_s parsed = field;
+
+  switch (field.type)
+  {
+    case type_e::Bool:   parsed.value = &b; break;
+    case type_e::Int:    parsed.value = &i; break;
+    case type_e::Int64:  parsed.value = &l; break;
+    case type_e::Float:  parsed.value = &f; break;
+    case type_e::Hex:    parsed.value = &h; break;
+    case type_e::String: parsed.value = &s; break;
+  }
+
+  if (! Parse (parsed, text))
+    return false;
+
+  switch (field.type)
+  {
+    case type_e::Bool:   return b != *static_cast <const bool *>         (field.value);
+    case type_e::Int:    return i != *static_cast <const int *>          (field.value);
+    case type_e::Int64:  return l != *static_cast <const int64_t *>      (field.value);
+    case type_e::Float:  return f != *static_cast <const float *>        (field.value);
+    case type_e::Hex:    return h != *static_cast <const uint32_t *>     (field.value);
+    case type_e::String: return s != *static_cast <const std::wstring *> (field.value);
+  }
+
+  return false;
+}
+
+
+size_t
+unx::schema::LoadFields (const field_s* fields, size_t count, INIFile* const* files, uint8_t skip)
+{
+  size_t found = 0;
+
+  // Tables are grouped by section, so most lookups can reuse the last one
+  const INIFile*      last_file    = nullptr;
+  const wchar_t*      last_name    = nullptr;
+  INIFile::section_id last_section = INIFile::npos;
+
+  for (size_t i = 0; i < count; i++)
+  {
+    const field_s& field = fields [i];
+    const INIFile* file  = files  [field.file];
+
+    if ((! (field.flags & Flag_Load)) || (field.flags & skip) || file == nullptr)
+      continue;
+
+    if (file != last_file || field.section != last_name)
+    {
+      last_file    = file;
+      last_name    = field.section;
+      last_section = file->find_section (field.section);
+    }
+
+    std::wstring_view text;
+
+    if ( last_section != INIFile::npos &&
+           file->find_value (last_section, field.key, text) &&
+           Parse (field, text) )
+    {
+      found++;
+    }
+  }
+
+  return found;
+}
+
+size_t
+unx::schema::StoreFields (const field_s* fields, size_t count, INIFile* const* files, uint8_t skip)
+{
+  size_t changed = 0;
+
+  INIFile*            last_file    = nullptr;
+  const wchar_t*      last_name    = nullptr;
+  INIFile::section_id last_section = INIFile::npos;
+
+  std::wstring text;
+
+  for (size_t i = 0; i < count; i++)
+  {
+    const field_s& field = fields [i];
+    INIFile*       file  = files  [field.file];
+
+    if ((! (field.flags & Flag_Store)) || (field.flags & skip) || file == nullptr)
+      continue;
+
+    if (file != last_file || field.section != last_name)
+    {
+      last_file    = file;
+      last_name    = field.section;
+      last_section = file->get_section (field.section);
+    }
+
+    Format (field, text);
+
+    if (file->set_value (last_section, field.key, text))
+      changed++;
+  }
+
+  return changed;
+}
+
+size_t
+unx::schema::LoadChanges ( const field_s* fields, size_t count, uint8_t file, const INIFile& incoming,
+                           uint8_t skip, std::vector <const field_s *>* changed )
+{
+  size_t applied = 0;
+
+  const wchar_t*      last_name    = nullptr;
+  INIFile::section_id last_section = INIFile::npos;
+
+  for (size_t i = 0; i < count; i++)
+  {
+    const field_s& field = fields [i];
+
+    if (field.file != file || (! (field.flags & Flag_Load)) || (field.flags & skip))
+      continue;
+
+    if (field.section != last_name)
+    {
+      last_name    = field.section;
+      last_section = incoming.find_section (field.section);
+    }
+
+    // A key that was removed keeps its current value, same as at startup
+    std::wstring_view text;
+
+    if ( last_section == INIFile::npos ||
+         (! incoming.find_value (last_section, field.key, text)) )
+      continue;
+
+    if (UNX_SchemaDiffers (field, text) && Parse (field, text))
+    {
+      if (changed != nullptr)
+        changed->push_back (&field);
+
+      applied++;
+    }
+  }
+
+  return applied;
+}
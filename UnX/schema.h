@@ -0,0 +1,140 @@
+/**
+ * This file is part of UnX.
+ *
+ * UnX is free software : you can redistribute it
+ * and/or modify it under the terms of the GNU General Public License
+ * as published by The Free Software Foundation, either version 3 of
+ * the License, or (at your option) any later version.
+ *
+ * UnX is distributed in the hope that it will be useful,
+ *
+ * But WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with UnX.
+ *
+ *   If not, see <http://www.gnu.org/licenses/>.
+ *
+**/
+#ifndef __UNX__SCHEMA_H__
+#define __UNX__SCHEMA_H__
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <string_view>
+#include <vector>
+
+//
+// Table-driven config load / store.
+//
+//   A schema is a constexpr array of fields, each naming the file, section,
+//     key and type of one setting together with the variable it lives in.
+//       Defaults are whatever that variable was initialized to; a key that
+//         is missing leaves it alone and the next store writes it out.
+//
+//   Loading and storing are plain loops over the table; the value text is
+//     converted in place, without any per-setting objects.
+//
+namespace unx
+{
+  class INIFile;
+
+  namespace schema
+  {
+    enum class type_e : uint8_t {
+      Bool,
+      Int,
+      Int64,
+      Float,
+      Hex,      // uint32_t, written as 0x%08x
+      String    // std::wstring
+    };
+
+    enum flags_e : uint8_t {
+      Flag_Load      = 0x01,
+      Flag_Store     = 0x02,
+      Flag_LoadStore = Flag_Load | Flag_Store,
+
+      // Free for the owner of a table, i.e. to skip game-specific settings
+      Flag_User      = 0x10
+    };
+
+    struct field_s {
+      uint8_t        file;      // Index into the INIFile array passed in
+      type_e         type;
+      uint8_t        flags;
+      const wchar_t* section;
+      const wchar_t* key;
+      void*          value;
+    };
+
+    constexpr field_s Field (uint8_t file, const wchar_t* section, const wchar_t* key,
+                             bool*         value, uint8_t flags = Flag_LoadStore) {
+      return field_s { file, type_e::Bool,   flags, section, key, value };
+    }
+    constexpr field_s Field (uint8_t file, const wchar_t* section, const wchar_t* key,
+                             int*          value, uint8_t flags = Flag_LoadStore) {
+      return field_s { file, type_e::Int,    flags, section, key, value };
+    }
+    constexpr field_s Field (uint8_t file, const wchar_t* section, const wchar_t* key,
+                             int64_t*      value, uint8_t flags = Flag_LoadStore) {
+      return field_s { file, type_e::Int64,  flags, section, key, value };
+    }
+    constexpr field_s Field (uint8_t file, const wchar_t* section, const wchar_t* key,
+                             float*        value, uint8_t flags = Flag_LoadStore) {
+      return field_s { file, type_e::Float,  flags, section, key, value };
+    }
+    constexpr field_s Field (uint8_t file, const wchar_t* section, const wchar_t* key,
+                             uint32_t*     value, uint8_t flags = Flag_LoadStore) {
+      return field_s { file, type_e::Hex,    flags, section, key, value };
+    }
+    constexpr field_s Field (uint8_t file, const wchar_t* section, const wchar_t* key,
+                             std::wstring* value, uint8_t flags = Flag_LoadStore) {
+      return field_s { file, type_e::String, flags, section, key, value };
+    }
+
+    //
+    // Fields whose flags intersect skip are left out; a null file skips
+    //   every field that belongs to it.
+    //
+    //   LoadFields returns the number of keys that were read (a value that
+    //     does not parse leaves its variable alone), StoreFields the number
+    //       of values that changed.
+    //
+    size_t LoadFields  (const field_s* fields, size_t count, INIFile* const* files, uint8_t skip = 0);
+    size_t StoreFields (const field_s* fields, size_t count, INIFile* const* files, uint8_t skip = 0);
+
+    template <size_t _N>
+    size_t Load  (const field_s (&fields)[_N], INIFile* const* files, uint8_t skip = 0) {
+      return LoadFields  (fields, _N, files, skip);
+    }
+
+    //
+    // Reloads the fields of one file from a fresh copy of it, assigning only
+    //   the values that differ from what their variables hold now; each of
+    //     those is appended to changed (if not null). Returns how many.
+    //
+    size_t LoadChanges (const field_s* fields, size_t count, uint8_t file, const INIFile& incoming,
+                        uint8_t skip = 0, std::vector <const field_s *>* changed = nullptr);
+
+    template <size_t _N>
+    size_t LoadChanges (const field_s (&fields)[_N], uint8_t file, const INIFile& incoming,
+                        uint8_t skip = 0, std::vector <const field_s *>* changed = nullptr) {
+      return LoadChanges (fields, _N, file, incoming, skip, changed);
+    }
+
+    template <size_t _N>
+    size_t Store (const field_s (&fields)[_N], INIFile* const* files, uint8_t skip = 0) {
+      return StoreFields (fields, _N, files, skip);
+    }
+
+    // False (and the variable untouched) if text is not a valid value
+    bool   Parse  (const field_s& field, std::wstring_view text);
+    void   Format (const field_s& field, std::wstring& out);
+  }
+}
+
+#endif /* __UNX__SCHEMA_H__ */
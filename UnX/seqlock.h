@@ -0,0 +1,95 @@
+/**
+ * This file is part of UnX.
+ *
+ * UnX is free software : you can redistribute it
+ * and/or modify it under the terms of the GNU General Public License
+ * as published by The Free Software Foundation, either version 3 of
+ * the License, or (at your option) any later version.
+ *
+ * UnX is distributed in the hope that it will be useful,
+ *
+ * But WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with UnX.
+ *
+ *   If not, see <http://www.gnu.org/licenses/>.
+ *
+**/
+#ifndef __UNX__SEQLOCK_H__
+#define __UNX__SEQLOCK_H__
+
+#include <atomic>
+#include <cstdint>
+#include <cstring>
+#include <type_traits>
+
+namespace unx
+{
+  //
+  // Single-writer sequence lock.
+  //
+  //   The writer never waits. Readers never take a lock; a reader that races
+  //     a write sees an odd (or changed) sequence number and tries again, up
+  //       to a fixed number of times so that the read side stays wait-free.
+  //
+  template <typename _T>
+  class SeqLock
+  {
+    static_assert ( std::is_trivially_copyable <_T>::value,
+                      "SeqLock payload must be trivially copyable" );
+
+  public:
+    void publish (const _T& val)
+    {
+      const uint32_t seq =
+        seq_.load (std::memory_order_relaxed);
+
+      seq_.store (seq + 1, std::memory_order_relaxed);
+      std::atomic_thread_fence (std::memory_order_release);
+
+      memcpy (&data_, &val, sizeof (_T));
+
+      seq_.store (seq + 2, std::memory_order_release);
+    }
+
+    // Returns false (and leaves out untouched) if every attempt raced a write
+    bool try_read (_T& out, int max_tries = 4) const
+    {
+      for (int i = 0; i < max_tries; i++)
+      {
+        const uint32_t begin =
+          seq_.load (std::memory_order_acquire);
+
+        if (begin & 1)
+          continue;
+
+        _T copy;
+        memcpy (&copy, &data_, sizeof (_T));
+
+        std::atomic_thread_fence (std::memory_order_acquire);
+
+        if (seq_.load (std::memory_order_relaxed) == begin)
+        {
+          out = copy;
+          return true;
+        }
+      }
+
+      return false;
+    }
+
+    // Even numbers only; changes every time something is published
+    uint32_t sequence (void) const {
+      return seq_.load (std::memory_order_acquire) & ~1U;
+    }
+
+  private:
+    std::atomic <uint32_t> seq_  { 0 };
+    _T                     data_ {   };
+  };
+}
+
+#endif /* __UNX__SEQLOCK_H__ */
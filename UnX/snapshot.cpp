@@ -0,0 +1,350 @@
+/**
+ * This file is part of UnX.
+ *
+ * UnX is free software : you can redistribute it
+ * and/or modify it under the terms of the GNU General Public License
+ * as published by The Free Software Foundation, either version 3 of
+ * the License, or (at your option) any later version.
+ *
+ * UnX is distributed in the hope that it will be useful,
+ *
+ * But WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with UnX.
+ *
+ *   If not, see <http://www.gnu.org/licenses/>.
+ *
+**/
+#include "snapshot.h"
+#include "inifile.h"
+
+#include <cstring>
+#include <cwchar>
+#include <string>
+
+using namespace unx::schema;
+
+namespace
+{
+  const uint32_t Magic   = 0x53584E55; // 'UNXS'
+  const uint16_t Version = 1;
+
+  struct header_s {
+    uint32_t magic;
+    uint16_t version;
+    uint8_t  wchar_size;
+    uint8_t  reserved;
+    uint32_t stamp_count;
+    uint32_t value_count;
+    uint64_t layout;
+  };
+
+  uint64_t
+  Hash (const void* data, size_t len, uint64_t hash = 0xcbf29ce484222325ULL)
+  {
+    const uint8_t* bytes = (const uint8_t *)data;
+
+    for (size_t i = 0; i < len; i++)
+    {
+      hash ^= bytes [i];
+      hash *= 0x100000001b3ULL;
+    }
+
+    return hash;
+  }
+
+  bool
+  Included (const field_s& field, uint8_t skip)
+  {
+    return (field.flags & Flag_Load) && (! (field.flags & skip));
+  }
+
+  size_t
+  FixedSize (type_e type)
+  {
+    switch (type)
+    {
+      case type_e::Bool:  return sizeof (uint8_t);
+      case type_e::Int:   return sizeof (int32_t);
+      case type_e::Int64: return sizeof (int64_t);
+      case type_e::Float: return sizeof (float);
+      case type_e::Hex:   return sizeof (uint32_t);
+      default:            return 0;
+    }
+  }
+
+  template <typename _T>
+  void
+  Put (std::vector <uint8_t>& out, const _T& val)
+  {
+    const uint8_t* bytes = (const uint8_t *)&val;
+    out.insert (out.end (), bytes, bytes + sizeof (_T));
+  }
+}
+
+unx::snapshot::stamp_s
+unx::snapshot::Stamp (const wchar_t* path)
+{
+  stamp_s stamp;
+
+  if (! INIFile::stat_file (path, stamp.size, stamp.mtime))
+    stamp = stamp_s { };
+
+  return stamp;
+}
+
+uint64_t
+unx::snapshot::Layout (const table_s* tables, size_t count, std::wstring_view salt)
+{
+  uint64_t hash =
+    Hash (salt.data (), salt.size () * sizeof (wchar_t));
+
+  for (size_t t = 0; t < count; t++)
+  {
+    const table_s& table = tables [t];
+
+    for (size_t i = 0; i < table.count; i++)
+    {
+      const field_s& field = table.fields [i];
+
+      if (! Included (field, table.skip))
+        continue;
+
+      const uint8_t kind [2] = { field.file, (uint8_t)field.type };
+
+      hash = Hash (kind,          sizeof kind,                                  hash);
+      hash = Hash (field.section, wcslen (field.section) * sizeof (wchar_t) + 1, hash);
+      hash = Hash (field.key,     wcslen (field.key)     * sizeof (wchar_t) + 1, hash);
+    }
+
+    // Keeps tables apart, so a field cannot move from one to the next unnoticed
+    hash = Hash (&t, sizeof t, hash);
+  }
+
+  return hash;
+}
+
+std::vector <uint8_t>
+unx::snapshot::Write ( const table_s* tables, size_t count, uint64_t layout,
+                       const stamp_s* stamps, size_t stamp_count )
+{
+  std::vector <uint8_t> out;
+  out.reserve (4096);
+
+  header_s header = { };
+
+  header.magic       = Magic;
+  header.version     = Version;
+  header.wchar_size  = (uint8_t)sizeof (wchar_t);
+  header.stamp_count = (uint32_t)stamp_count;
+  header.layout      = layout;
+
+  for (size_t t = 0; t < count; t++)
+  {
+    for (size_t i = 0; i < tables [t].count; i++)
+      header.value_count += Included (tables [t].fields [i], tables [t].skip);
+  }
+
+  Put (out, header);
+
+  for (size_t i = 0; i < stamp_count; i++)
+  {
+    Put (out, stamps [i].size);
+    Put (out, stamps [i].mtime);
+  }
+
+  for (size_t t = 0; t < count; t++)
+  {
+    const table_s& table = tables [t];
+
+    for (size_t i = 0; i < table.count; i++)
+    {
+      const field_s& field = table.fields [i];
+
+      if (! Included (field, table.skip))
+        continue;
+
+      switch (field.type)
+      {
+        case type_e::Bool:
+          Put (out, (uint8_t)*static_cast <const bool *>     (field.value));
+          break;
+        case type_e::Int:
+          Put (out, (int32_t)*static_cast <const int *>      (field.value));
+          break;
+        case type_e::Int64:
+          Put (out,          *static_cast <const int64_t *>  (field.value));
+          break;
+        case type_e::Float:
+          Put (out,          *static_cast <const float *>    (field.value));
+          break;
+        case type_e::Hex:
+          Put (out,          *static_cast <const uint32_t *> (field.value));
+          break;
+
+        case type_e::String:
+        {
+          const std::wstring& str =
+            *static_cast <const std::wstring *> (field.value);
+
+          Put (out, (uint32_t)str.size ());
+
+          out.insert ( out.end (), (const uint8_t *) str.data (),
+                                   (const uint8_t *)(str.data () + str.size ()) );
+        } break;
+      }
+    }
+  }
+
+  Put (out, Hash (out.data (), out.size ()));
+
+  return out;
+}
+
+unx::snapshot::result_e
+unx::snapshot::Read ( const uint8_t* data, size_t len,
+                      const table_s* tables, size_t count, uint64_t layout,
+                      const stamp_s* stamps, size_t stamp_count )
+{
+  header_s header;
+
+  if (data == nullptr || len < sizeof (header_s) + sizeof (uint64_t))
+    return result_e::Corrupt;
+
+  memcpy (&header, data, sizeof (header_s));
+
+  if (header.magic != Magic)
+    return result_e::Corrupt;
+
+  if ( header.version     != Version                  ||
+       header.wchar_size  != sizeof (wchar_t)         ||
+       header.layout      != layout                   ||
+       header.stamp_count != stamp_count )
+    return result_e::Stale;
+
+  const size_t body = len - sizeof (uint64_t);
+  size_t       pos  = sizeof (header_s);
+
+  if (body - pos < stamp_count * (sizeof (uint64_t) + sizeof (int64_t)))
+    return result_e::Corrupt;
+
+  uint64_t checksum;
+  memcpy (&checksum, data + body, sizeof (uint64_t));
+
+  if (checksum != Hash (data, body))
+    return result_e::Corrupt;
+
+  for (size_t i = 0; i < stamp_count; i++)
+  {
+    stamp_s stamp;
+
+    memcpy (&stamp.size,  data + pos, sizeof (uint64_t)); pos += sizeof (uint64_t);
+    memcpy (&stamp.mtime, data + pos, sizeof (int64_t));  pos += sizeof (int64_t);
+
+    if (stamp.size != stamps [i].size || stamp.mtime != stamps [i].mtime)
+      return result_e::Stale;
+  }
+
+  //
+  // Walk the values once without touching anything, so that a snapshot that
+  //   does not add up cannot leave the settings half-assigned.
+  //
+  const size_t values = pos;
+  uint32_t     seen   = 0;
+
+  for (size_t t = 0; t < count; t++)
+  {
+    for (size_t i = 0; i < tables [t].count; i++)
+    {
+      const field_s& field = tables [t].fields [i];
+
+      if (! Included (field, tables [t].skip))
+        continue;
+
+      size_t size = FixedSize (field.type);
+
+      if (field.type == type_e::String)
+      {
+        uint32_t chars;
+
+        if (body - pos < sizeof (uint32_t))
+          return result_e::Corrupt;
+
+        memcpy (&chars, data + pos, sizeof (uint32_t));
+
+        pos += sizeof (uint32_t);
+        size = (size_t)chars * sizeof (wchar_t);
+      }
+
+      if (body - pos < size)
+        return result_e::Corrupt;
+
+      pos += size;
+      seen++;
+    }
+  }
+
+  if (pos != body || seen != header.value_count)
+    return result_e::Corrupt;
+
+  pos = values;
+
+  for (size_t t = 0; t < count; t++)
+  {
+    for (size_t i = 0; i < tables [t].count; i++)
+    {
+      const field_s& field = tables [t].fields [i];
+
+      if (! Included (field, tables [t].skip))
+        continue;
+
+      switch (field.type)
+      {
+        case type_e::Bool:
+          *static_cast <bool *> (field.value) = data [pos] != 0;
+          break;
+
+        case type_e::Int:
+        {
+          int32_t val;
+          memcpy (&val, data + pos, sizeof (int32_t));
+          *static_cast <int *> (field.value) = val;
+        } break;
+
+        case type_e::Int64:
+          memcpy (field.value, data + pos, sizeof (int64_t));
+          break;
+        case type_e::Float:
+          memcpy (field.value, data + pos, sizeof (float));
+          break;
+        case type_e::Hex:
+          memcpy (field.value, data + pos, sizeof (uint32_t));
+          break;
+
+        case type_e::String:
+        {
+          uint32_t chars;
+          memcpy (&chars, data + pos, sizeof (uint32_t));
+
+          pos += sizeof (uint32_t);
+
+          std::wstring& str =
+            *static_cast <std::wstring *> (field.value);
+
+          str.resize (chars);
+          memcpy (&str [0], data + pos, (size_t)chars * sizeof (wchar_t));
+
+          pos += (size_t)chars * sizeof (wchar_t);
+        } break;
+      }
+
+      // Strings have moved pos along already
+      pos += FixedSize (field.type);
+    }
+  }
+
+  return result_e::Ok;
+}
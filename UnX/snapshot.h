@@ -0,0 +1,82 @@
+/**
+ * This file is part of UnX.
+ *
+ * UnX is free software : you can redistribute it
+ * and/or modify it under the terms of the GNU General Public License
+ * as published by The Free Software Foundation, either version 3 of
+ * the License, or (at your option) any later version.
+ *
+ * UnX is distributed in the hope that it will be useful,
+ *
+ * But WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with UnX.
+ *
+ *   If not, see <http://www.gnu.org/licenses/>.
+ *
+**/
+#ifndef __UNX__SNAPSHOT_H__
+#define __UNX__SNAPSHOT_H__
+
+#include "schema.h"
+
+#include <cstddef>
+#include <cstdint>
+#include <string_view>
+#include <vector>
+
+//
+// Binary snapshot of resolved settings.
+//
+//   The values of a set of schema tables, written after a normal (text)
+//     startup together with the size and write time of every INI they came
+//       from. As long as none of those files changed, the next startup can
+//         take the values from the snapshot with a single read and skip
+//           parsing the INIs altogether.
+//
+//   The snapshot is tied to the exact layout of the tables (and whatever
+//     else the caller mixes into the layout hash, i.e. the DLL version) and
+//       to the machine that wrote it; anything else reads as stale.
+//
+namespace unx
+{
+  namespace snapshot
+  {
+    struct table_s {
+      const schema::field_s* fields;
+      size_t                 count;
+      uint8_t                skip;    // Same meaning as for schema::Load
+    };
+
+    // A file that does not exist stamps as all zero
+    struct stamp_s {
+      uint64_t size  = 0;
+      int64_t  mtime = 0;
+    };
+
+    stamp_s  Stamp  (const wchar_t* path);
+
+    // Which fields are stored and how; salt is mixed in
+    uint64_t Layout (const table_s* tables, size_t count, std::wstring_view salt = { });
+
+    std::vector <uint8_t>
+             Write  (const table_s* tables, size_t count, uint64_t layout,
+                     const stamp_s* stamps, size_t stamp_count);
+
+    enum class result_e {
+      Ok,
+      Stale,    // Layout or one of the files changed
+      Corrupt
+    };
+
+    // Nothing is assigned unless the result is Ok
+    result_e Read   (const uint8_t* data, size_t len,
+                     const table_s* tables, size_t count, uint64_t layout,
+                     const stamp_s* stamps, size_t stamp_count);
+  }
+}
+
+#endif /* __UNX__SNAPSHOT_H__ */
@@ -0,0 +1,54 @@
+/**
+ * This file is part of UnX.
+ *
+ * UnX is free software : you can redistribute it
+ * and/or modify it under the terms of the GNU General Public License
+ * as published by The Free Software Foundation, either version 3 of
+ * the License, or (at your option) any later version.
+ *
+ * UnX is distributed in the hope that it will be useful,
+ *
+ * But WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with UnX.
+ *
+ *   If not, see <http://www.gnu.org/licenses/>.
+ *
+**/
+#ifndef __UNX__THREADS_H__
+#define __UNX__THREADS_H__
+
+#include <thread>
+
+#ifdef _WIN32
+# include <Windows.h>
+#endif
+
+namespace unx
+{
+  //
+  // Whether a thread that has not been joined yet has stopped running.
+  //
+  //   returned is the thread's own "I am done" flag. At process exit Windows
+  //     kills every other thread before DLLs detach, wherever it was, and
+  //       only its handle tells; nowhere else can a thread vanish like that.
+  //
+  inline bool
+  ThreadHasExited (std::thread& thread, bool returned)
+  {
+    if (returned || (! thread.joinable ()))
+      return true;
+
+#ifdef _WIN32
+    return
+      WaitForSingleObject ((HANDLE)thread.native_handle (), 0) == WAIT_OBJECT_0;
+#else
+    return false;
+#endif
+  }
+}
+
+#endif /* __UNX__THREADS_H__ */
@@ -0,0 +1,316 @@
+/**
+ * This file is part of UnX.
+ *
+ * UnX is free software : you can redistribute it
+ * and/or modify it under the terms of the GNU General Public License
+ * as published by The Free Software Foundation, either version 3 of
+ * the License, or (at your option) any later version.
+ *
+ * UnX is distributed in the hope that it will be useful,
+ *
+ * But WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with UnX.
+ *
+ *   If not, see <http://www.gnu.org/licenses/>.
+ *
+**/
+#include "trace.h"
+
+#include <chrono>
+#include <ctime>
+#include <cwchar>
+
+#ifdef _WIN32
+# include <Windows.h>
+#endif
+
+// Shared by every site in the process; 0 means "not assigned yet"
+static std::atomic <uint32_t> UNX_NextTraceId { 1 };
+
+uint64_t
+unx::trace::Now (void)
+{
+  return
+    (uint64_t)std::chrono::duration_cast <std::chrono::microseconds> (
+      std::chrono::system_clock::now ().time_since_epoch ()
+    ).count ();
+}
+
+static int32_t
+UNX_UTCBias (void)
+{
+#ifdef _WIN32
+  TIME_ZONE_INFORMATION tzi;
+
+  const DWORD zone =
+    GetTimeZoneInformation (&tzi);
+
+  LONG bias = tzi.Bias;
+
+  if (zone == TIME_ZONE_ID_DAYLIGHT) bias += tzi.DaylightBias;
+  if (zone == TIME_ZONE_ID_STANDARD) bias += tzi.StandardBias;
+
+  // Windows counts the other way around
+  return -(int32_t)bias;
+#else
+  time_t    now = time (nullptr);
+  struct tm local;
+
+  localtime_r (&now, &local);
+
+  return (int32_t)(local.tm_gmtoff / 60);
+#endif
+}
+
+
+void
+unx::trace::RecordBuilder::begin (record_e kind, uint8_t flags, uint32_t format, uint64_t time)
+{
+  record_s rec;
+
+  rec.size   = 0;
+  rec.kind   = kind;
+  rec.flags  = flags;
+  rec.format = format;
+  rec.time   = time;
+
+  pos_ = 0;
+  cut_ = false;
+
+  write (&rec, sizeof rec);
+}
+
+size_t
+unx::trace::RecordBuilder::finish (void)
+{
+  const uint16_t size = (uint16_t)pos_;
+
+  memcpy (buf_ + offsetof (record_s, size), &size, sizeof size);
+
+  return pos_;
+}
+
+bool
+unx::trace::RecordBuilder::write (const void* data, size_t len)
+{
+  if (cut_ || pos_ + len > cap_)
+  {
+    cut_ = true;
+    return false;
+  }
+
+  memcpy (buf_ + pos_, data, len);
+  pos_ += len;
+
+  return true;
+}
+
+// An argument that does not fit is left out whole, so the decoder never
+//   sees half of one
+void
+unx::trace::RecordBuilder::tagged (arg_e tag, const void* data, size_t len)
+{
+  if (cut_ || pos_ + 1 + len > cap_)
+  {
+    cut_ = true;
+    return;
+  }
+
+  const uint8_t t = tag;
+
+  write (&t,   1);
+  write (data, len);
+}
+
+void
+unx::trace::RecordBuilder::utf16 (const wchar_t* str, size_t len)
+{
+  // Reserve the length and fill it in once we know how much fit
+  const size_t   at    = pos_;
+        uint16_t units = 0;
+        size_t   i     = 0;
+
+  if (! write (&units, sizeof units))
+    return;
+
+  // UTF-16 already; copy what fits
+  if (sizeof (wchar_t) == 2)
+  {
+    i = (cap_ - pos_) / 2;
+
+    if (i > len)
+        i = len;
+
+    // Do not split a surrogate pair
+    if (i < len && i > 0 && (str [i - 1] & 0xFC00) == 0xD800)
+      --i;
+
+    memcpy (buf_ + pos_, str, i * 2);
+
+    pos_ += i * 2;
+    units = (uint16_t)i;
+  }
+
+  else for (; i < len; i++)
+  {
+    uint32_t cp = (uint32_t)str [i];
+
+    if (sizeof (wchar_t) > 2 && cp > 0xFFFF)
+    {
+      // Room for both halves or neither
+      if (pos_ + 4 > cap_)
+        break;
+
+      const uint16_t hi = (uint16_t)(0xD800 + ((cp - 0x10000) >> 10));
+      const uint16_t lo = (uint16_t)(0xDC00 + ((cp - 0x10000) & 0x3FF));
+
+      write (&hi, 2);
+      write (&lo, 2);
+
+      units += 2;
+    }
+
+    else
+    {
+      const uint16_t u = (uint16_t)cp;
+
+      if (! write (&u, 2))
+        break;
+
+      ++units;
+    }
+  }
+
+  // Keep whatever is after the string out of a record that was cut short
+  if (i != len)
+    cut_ = true;
+
+  memcpy (buf_ + at, &units, sizeof units);
+}
+
+void
+unx::trace::RecordBuilder::put (const wchar_t* v)
+{
+  if (v == nullptr)
+    v = L"(null)";
+
+  const uint8_t t = Arg_WString;
+
+  // Tag and length go in together (an empty string at worst)
+  if (cut_ || pos_ + 3 > cap_)
+  {
+    cut_ = true;
+    return;
+  }
+
+  write (&t, 1);
+  utf16 (v, wcslen (v));
+}
+
+void
+unx::trace::RecordBuilder::put (const char* v)
+{
+  if (v == nullptr)
+    v = "(null)";
+
+  const uint8_t t = Arg_String;
+
+  if (cut_ || pos_ + 3 > cap_)
+  {
+    cut_ = true;
+    return;
+  }
+
+  size_t len = strlen (v);
+
+  if (len > cap_ - pos_ - 3)
+  {
+    len  = cap_ - pos_ - 3;
+    cut_ = true;
+  }
+
+  const uint16_t bytes = (uint16_t)len;
+
+  memcpy (buf_ + pos_,     &t,     1);
+  memcpy (buf_ + pos_ + 1, &bytes, 2);
+  memcpy (buf_ + pos_ + 3, v,      len);
+
+  pos_ += 3 + len;
+}
+
+
+static void
+UNX_EncodeTraceRecord (const unx::LogWriter::line_s& line, std::vector <uint8_t>& out)
+{
+  out.insert (out.end (), line.bytes, line.bytes + line.len);
+}
+
+static void
+UNX_EncodeTraceDropped (uint64_t count, std::vector <uint8_t>& out)
+{
+  uint8_t                   buf [sizeof (unx::trace::record_s) + 1 + sizeof count];
+  unx::trace::RecordBuilder rec (buf, sizeof buf);
+
+  rec.begin (unx::trace::Record_Dropped, unx::trace::Flag_Timestamp | unx::trace::Flag_Newline,
+               0, unx::trace::Now ());
+  rec.put   (count);
+
+  out.insert (out.end (), buf, buf + rec.finish ());
+}
+
+static const unx::LogWriter::encoding_s
+UNX_TraceEncoding = { UNX_EncodeTraceRecord, UNX_EncodeTraceDropped };
+
+
+bool
+unx::trace::TraceLog::open (const wchar_t* path)
+{
+  if (! writer_.open (path, false, UNX_TraceEncoding))
+    return false;
+
+  header_s header = { };
+
+  memcpy (header.magic, "UNXT", 4);
+
+  header.version      = Version;
+  header.pointer_size = (uint8_t)sizeof (void *);
+  header.utc_bias     = UNX_UTCBias ();
+
+  // Nothing else can have been pushed yet, so this goes in first
+  return writer_.emplace ([&header](LogWriter::line_s& line)
+  {
+    memcpy (line.bytes, &header, sizeof header);
+    line.len = sizeof header;
+  });
+}
+
+uint32_t
+unx::trace::TraceLog::define (site_s& site)
+{
+  uint32_t id       =
+    UNX_NextTraceId.fetch_add (1, std::memory_order_relaxed);
+  uint32_t assigned = 0;
+
+  // Another thread got there first; its id (and definition) stands
+  if (! site.id.compare_exchange_strong (assigned, id, std::memory_order_acq_rel))
+    return assigned;
+
+  const uint64_t time = Now ();
+
+  // If this is dropped, the decoder prints the arguments without the text
+  writer_.emplace ([&](LogWriter::line_s& line)
+  {
+    RecordBuilder rec (line.bytes, sizeof (line.bytes));
+
+    rec.begin (Record_Format, 0, id, time);
+    rec.utf16 (site.format, wcslen (site.format));
+
+    line.len = (uint32_t)rec.finish ();
+  });
+
+  return id;
+}
@@ -0,0 +1,224 @@
+/**
+ * This file is part of UnX.
+ *
+ * UnX is free software : you can redistribute it
+ * and/or modify it under the terms of the GNU General Public License
+ * as published by The Free Software Foundation, either version 3 of
+ * the License, or (at your option) any later version.
+ *
+ * UnX is distributed in the hope that it will be useful,
+ *
+ * But WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with UnX.
+ *
+ *   If not, see <http://www.gnu.org/licenses/>.
+ *
+**/
+#ifndef __UNX__TRACE_H__
+#define __UNX__TRACE_H__
+
+#include "logwriter.h"
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <type_traits>
+
+//
+// Binary trace log.
+//
+//   A call site records the id of its (static) format string and the raw
+//     values of its arguments; nothing is formatted in the game. The first
+//       time a site is hit its format string goes into the file as well, so
+//         tools/trace_decode can render the text later without the DLL.
+//
+//   Strings are copied when they are recorded (as UTF-16, whatever the
+//     size of wchar_t), numbers are widened to 32 or 64 bits, and every
+//       value carries a type tag so a format / argument mismatch can not
+//         make the decoder read garbage.
+//
+namespace unx
+{
+  namespace trace
+  {
+    //
+    // File layout: header_s, then records. Every record starts with a
+    //   record_s; what follows depends on its kind.
+    //
+    //   Record_Format   UTF-16 format string (u16 length + code units)
+    //   Record_Event    Arguments, each a type tag + value; strings are
+    //                     stored like the format string
+    //   Record_Dropped  u64 number of records lost to a full queue
+    //
+    struct header_s {
+      char     magic [4];     // "UNXT"
+      uint16_t version;
+      uint8_t  pointer_size;  // Of the process that wrote it
+      uint8_t  reserved;
+      int32_t  utc_bias;      // Minutes to add to UTC for local time
+    };
+
+    static const uint16_t Version = 1;
+
+    enum record_e : uint8_t {
+      Record_Format  = 1,
+      Record_Event   = 2,
+      Record_Dropped = 3
+    };
+
+    enum flags_e : uint8_t {
+      Flag_Timestamp = 0x1,   // LogEx (true, ...)
+      Flag_Newline   = 0x2    // Log (...) ends the line itself
+    };
+
+    #pragma pack (push, 1)
+    struct record_s {
+      uint16_t size;          // Including this header
+      uint8_t  kind;
+      uint8_t  flags;
+      uint32_t format;        // Id; 0 for Record_Dropped
+      uint64_t time;          // Microseconds since 1970, UTC
+    };
+    #pragma pack (pop)
+
+    enum arg_e : uint8_t {
+      Arg_Int32,
+      Arg_UInt32,
+      Arg_Int64,
+      Arg_UInt64,
+      Arg_Double,
+      Arg_Pointer,            // Stored as u64
+      Arg_WString,            // Stored as UTF-16
+      Arg_String              // Bytes, as they were (usually ANSI)
+    };
+
+    //
+    // One per call site, normally declared static by UNX_TRACE. Ids are
+    //   handed out per process, so there is meant to be one trace file.
+    //
+    struct site_s {
+      const wchar_t* const   format;
+      std::atomic <uint32_t> id { 0 };
+
+      explicit site_s (const wchar_t* fmt) : format (fmt) { }
+    };
+
+    // Serializes one record into a fixed buffer; anything past the end is cut
+    class RecordBuilder
+    {
+    public:
+      RecordBuilder (uint8_t* buf, size_t capacity) : buf_ (buf), cap_ (capacity) { }
+
+      void   begin  (record_e kind, uint8_t flags, uint32_t format, uint64_t time);
+      size_t finish (void);
+
+      void   put    (int32_t            v) { tagged (Arg_Int32,   &v, sizeof v); }
+      void   put    (uint32_t           v) { tagged (Arg_UInt32,  &v, sizeof v); }
+      void   put    (int64_t            v) { tagged (Arg_Int64,   &v, sizeof v); }
+      void   put    (uint64_t           v) { tagged (Arg_UInt64,  &v, sizeof v); }
+      void   put    (double             v) { tagged (Arg_Double,  &v, sizeof v); }
+      void   put    (const wchar_t*     v);
+      void   put    (const char*        v);
+      void   put    (wchar_t*           v) { put ((const wchar_t *)v); }
+      void   put    (char*              v) { put ((const char    *)v); }
+      void   put    (const void*        v) { uint64_t p = (uintptr_t)v;
+                                             tagged (Arg_Pointer, &p, sizeof p); }
+
+      // Everything else that printf takes: integers of any width, enums,
+      //   bool, float, and pointers to anything that is not a string
+      template <typename _T>
+      void   put    (const _T& v)
+      {
+        if constexpr (std::is_pointer <_T>::value)
+          put ((const void *)v);
+
+        else if constexpr (std::is_floating_point <_T>::value)
+          put ((double)v);
+
+        else if constexpr (std::is_enum <_T>::value)
+          put ((typename std::underlying_type <_T>::type)v);
+
+        else
+        {
+          static_assert ( std::is_integral <_T>::value,
+                            "Not something a format string can print" );
+
+          if constexpr (sizeof (_T) > 4)
+          {
+            if constexpr (std::is_signed <_T>::value) put ((int64_t) v);
+            else                                      put ((uint64_t)v);
+          }
+
+          else
+          {
+            if constexpr (std::is_signed <_T>::value) put ((int32_t) v);
+            else                                      put ((uint32_t)v);
+          }
+        }
+      }
+
+      void   utf16  (const wchar_t* str, size_t len);
+
+      bool   truncated (void) const { return cut_; }
+
+    private:
+      bool   write  (const void* data, size_t len);
+      void   tagged (arg_e tag, const void* data, size_t len);
+
+      uint8_t* buf_;
+      size_t   cap_;
+      size_t   pos_ = 0;
+      bool     cut_ = false;
+    };
+
+    uint64_t Now (void);
+
+
+    //
+    // Same asynchronous writer as the text log, with records in place of
+    //   lines; record never blocks, never allocates and never formats.
+    //
+    class TraceLog
+    {
+    public:
+      bool open  (const wchar_t* path);
+      void close (void) { writer_.close (); }
+
+      template <typename... _Args>
+      bool record (site_s& site, uint8_t flags, const _Args&... args)
+      {
+        uint32_t id =
+          site.id.load (std::memory_order_acquire);
+
+        if (id == 0)
+          id = define (site);
+
+        const uint64_t time = Now ();
+
+        return writer_.emplace ([&](LogWriter::line_s& line)
+        {
+          RecordBuilder rec (line.bytes, sizeof (line.bytes));
+
+          rec.begin (Record_Event, flags, id, time);
+          (rec.put (args), ...);
+
+          line.len = (uint32_t)rec.finish ();
+        });
+      }
+
+      const LogWriter::stats_s& stats (void) const { return writer_.stats (); }
+
+    private:
+      uint32_t  define (site_s& site);
+
+      LogWriter writer_;
+    };
+  }
+}
+
+#endif /* __UNX__TRACE_H__ */
@@ -0,0 +1,106 @@
+/**
+ * This file is part of UnX.
+ *
+ * UnX is free software : you can redistribute it
+ * and/or modify it under the terms of the GNU General Public License
+ * as published by The Free Software Foundation, either version 3 of
+ * the License, or (at your option) any later version.
+ *
+ * UnX is distributed in the hope that it will be useful,
+ *
+ * But WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with UnX.
+ *
+ *   If not, see <http://www.gnu.org/licenses/>.
+ *
+**/
+#include "update.h"
+
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <memory>
+#include <mutex>
+#include <thread>
+
+bool
+unx::UpdateCheckDue (int64_t now, int64_t last_check, int64_t interval, bool update_was_available)
+{
+  if (interval < 0)
+    return false;
+
+  if (update_was_available || interval == 0)
+    return true;
+
+  // Never checked, or the clock went backwards since the last time
+  if (last_check <= 0 || last_check > now)
+    return true;
+
+  return (now - last_check) >= interval;
+}
+
+
+namespace
+{
+  struct update_check_s {
+    std::function <bool (void)>                 fetch;
+    std::function <void (unx::update_status_e)> complete;
+
+    std::mutex              lock;
+    std::condition_variable fetched_cv;
+    bool                    fetched  = false;
+    std::atomic <bool>      reported { false };
+
+    void report (unx::update_status_e status)
+    {
+      if (! reported.exchange (true))
+        complete (status);
+    }
+  };
+}
+
+void
+unx::CheckForUpdateAsync ( std::function <bool (void)>            fetch,
+                           std::function <void (update_status_e)> complete,
+                           uint32_t                               timeout_ms )
+{
+  auto check =
+    std::make_shared <update_check_s> ();
+
+  check->fetch    = std::move (fetch);
+  check->complete = std::move (complete);
+
+  std::thread ([check] (void)
+  {
+    const bool available =
+      check->fetch ();
+
+    check->report ( available ? update_status_e::Available :
+                                update_status_e::UpToDate );
+
+    {
+      std::lock_guard <std::mutex> guard (check->lock);
+      check->fetched = true;
+    }
+
+    check->fetched_cv.notify_all ();
+  }).detach ();
+
+  std::thread ([check, timeout_ms] (void)
+  {
+    std::unique_lock <std::mutex> guard (check->lock);
+
+    if (! check->fetched_cv.wait_for ( guard,
+                                         std::chrono::milliseconds (timeout_ms),
+                                           [&] { return check->fetched; } ))
+    {
+      guard.unlock ();
+
+      check->report (update_status_e::TimedOut);
+    }
+  }).detach ();
+}
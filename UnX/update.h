@@ -0,0 +1,56 @@
+/**
+ * This file is part of UnX.
+ *
+ * UnX is free software : you can redistribute it
+ * and/or modify it under the terms of the GNU General Public License
+ * as published by The Free Software Foundation, either version 3 of
+ * the License, or (at your option) any later version.
+ *
+ * UnX is distributed in the hope that it will be useful,
+ *
+ * But WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with UnX.
+ *
+ *   If not, see <http://www.gnu.org/licenses/>.
+ *
+**/
+#ifndef __UNX__UPDATE_H__
+#define __UNX__UPDATE_H__
+
+#include <cstdint>
+#include <functional>
+
+namespace unx
+{
+  enum class update_status_e : uint32_t {
+    UpToDate  = 0,
+    Available = 1,
+    TimedOut  = 2
+  };
+
+  //
+  // Whether the last check is stale enough to run another one.
+  //
+  //   Times are in seconds; interval < 0 disables checking and 0 checks every
+  //     time. A cached "update available" is always re-checked so the prompt
+  //       keeps showing up until the user updates.
+  //
+  bool UpdateCheckDue      (int64_t now, int64_t last_check, int64_t interval,
+                            bool    update_was_available);
+
+  //
+  // Runs fetch on a worker thread and calls complete exactly once, from a
+  //   worker thread: with the result, or with TimedOut if fetch has not
+  //     returned within timeout_ms. A fetch that times out is left to finish
+  //       on its own and its result is thrown away.
+  //
+  void CheckForUpdateAsync ( std::function <bool (void)>            fetch,
+                             std::function <void (update_status_e)> complete,
+                             uint32_t                               timeout_ms );
+}
+
+#endif /* __UNX__UPDATE_H__ */
@@ -28,8 +28,13 @@
 #include "hook.h"
 
 #include "cheat.h"
+#include "framepacer.h"
+#include "mailbox.h"
+#include "language.h"
+#include "update.h"
 
 #include <atlbase.h>
+#include <ctime>
 #include <dxgi.h>
 #include <d3d11.h>
 
@@ -89,15 +94,291 @@ using DetourWindowProc_pfn      = LRESULT (CALLBACK *)
       DetourWindowProc_Original = nullptr;
 
 
-volatile ULONG schedule_load = FALSE;
-volatile ULONG queue_death   = FALSE;
-
 unx::window_state_s
      unx::window   = { };
 
 bool shutting_down = false;
 bool last_active   = unx::window.active;
 
+
+//
+// Background framerate limit
+//
+//   Paced from the present hook; the wait is cut short as soon as the window
+//     is activated. The game pumps messages on its render thread, so the wake
+//       event alone is not enough, the foreground window is checked as well.
+//
+class UNX_PacerClock : public unx::FramePacer::clock_s
+{
+public:
+  UNX_PacerClock (void)
+  {
+    QueryPerformanceFrequency (&freq_);
+
+#ifndef CREATE_WAITABLE_TIMER_HIGH_RESOLUTION
+#define CREATE_WAITABLE_TIMER_HIGH_RESOLUTION 0x00000002
+#endif
+
+    // High resolution timers need Windows 10 1803+
+    hTimer_ =
+      CreateWaitableTimerExW ( nullptr, nullptr,
+                                 CREATE_WAITABLE_TIMER_MANUAL_RESET |
+                                 CREATE_WAITABLE_TIMER_HIGH_RESOLUTION,
+                                   TIMER_ALL_ACCESS );
+
+    if (hTimer_ == nullptr)
+      hTimer_ = CreateWaitableTimerW (nullptr, TRUE, nullptr);
+
+    hWake_ = CreateEventW (nullptr, FALSE, FALSE, nullptr);
+  }
+
+  uint64_t now (void) override
+  {
+    LARGE_INTEGER qpc;
+    QueryPerformanceCounter (&qpc);
+
+    return (uint64_t)(qpc.QuadPart / freq_.QuadPart) * 1000000ULL +
+           (uint64_t)(qpc.QuadPart % freq_.QuadPart) * 1000000ULL / freq_.QuadPart;
+  }
+
+  bool sleep (uint64_t until) override
+  {
+    static const uint64_t MaxSliceUs = 8000ULL;
+
+    if (unx::window.active || GetForegroundWindow () == unx::window.hwnd)
+      return false;
+
+    const uint64_t current = now ();
+
+    if (until <= current)
+      return true;
+
+    uint64_t slice = until - current;
+
+    if (slice > MaxSliceUs)
+        slice = MaxSliceUs;
+
+    LARGE_INTEGER due;
+                  due.QuadPart = -(LONGLONG)(slice * 10ULL); // 100 ns, relative
+
+    if ( hTimer_ == nullptr ||
+         (! SetWaitableTimer (hTimer_, &due, 0, nullptr, nullptr, FALSE)) )
+    {
+      Sleep ((DWORD)(slice / 1000ULL));
+      return true;
+    }
+
+    HANDLE hWait [2] = { hWake_, hTimer_ };
+
+    return
+      WaitForMultipleObjects (2, hWait, FALSE, INFINITE) != WAIT_OBJECT_0;
+  }
+
+  void wake (void) { SetEvent (hWake_); }
+
+private:
+  LARGE_INTEGER freq_;
+  HANDLE        hTimer_ = nullptr;
+  HANDLE        hWake_  = nullptr;
+};
+
+static UNX_PacerClock*
+UNX_GetPacerClock (void)
+{
+  static UNX_PacerClock clock;
+  return &clock;
+}
+
+//
+// Game commands
+//
+//   Requests from other threads (input executor, control panel, ...) that
+//     have to run on the render thread; drained once per frame.
+//
+extern uint64_t UNX_LatencyNow (void);
+extern bool     UNX_KillMeNow  (void);
+
+static unx::CommandMailbox <unx::GAME_CMD_COUNT> game_commands (UNX_LatencyNow);
+
+static const wchar_t* game_command_names [unx::GAME_CMD_COUNT] = {
+  L"Quick Load", L"Death", L"Apply Language", L"Update Checked", L"Reload Config"
+};
+
+static void
+UNX_GameCmd_QuickLoad (uint32_t)
+{
+  extern LPVOID __UNX_base_img_addr;
+
+  using LoadSave_pfn    = int (__stdcall *)(void);
+  using LoadSave2_pfn   = int (__cdecl   *)(int);
+  using LoadSave3_pfn   = int (__stdcall *)(void);
+  using LoadSaveXXX_pfn = int (__cdecl   *)(int);
+
+  ///LoadSave_pfn LoadSave =
+  ///  (LoadSave_pfn)
+  ///    ((intptr_t)__UNX_base_img_addr + 0x248910);
+  ///
+  ///LoadSave2_pfn LoadSave2 =
+  ///  (LoadSave2_pfn)
+  ///    ((intptr_t)__UNX_base_img_addr + 0x248890);
+  ///
+  ///LoadSave3_pfn LoadSave3 =
+  ///  (LoadSave3_pfn)
+  ///    ((intptr_t)__UNX_base_img_addr + 0x230DE0);
+
+  auto LoadSaveXXX =
+    (LoadSaveXXX_pfn)
+      ((intptr_t)__UNX_base_img_addr + 0x421870);
+
+  //*(int *)((intptr_t)__UNX_base_img_addr + 0xCE72D0) = 0;
+    *(int *)((intptr_t)__UNX_base_img_addr + 0x8CB994) = 1;
+
+  LoadSaveXXX (3);
+
+//  LoadSave  ();
+//  LoadSave2 (1);
+//  LoadSave2 (2);
+//  LoadSave3 ();
+}
+
+static void
+UNX_GameCmd_Death (uint32_t)
+{
+  UNX_WriteMem <uint8_t> (0xD2A8E2, 2);
+
+  UNX_KillMeNow ();
+}
+
+static void
+UNX_GameCmd_ApplyLanguage (uint32_t type)
+{
+  unx::LanguageManager::ApplyPatch ((asset_type_t)type);
+}
+
+static void
+UNX_GameCmd_UpdateChecked (uint32_t result)
+{
+  const auto status = (unx::update_status_e)result;
+
+  if (status == unx::update_status_e::TimedOut)
+  {
+    // Leave the cached result alone so that the next launch tries again
+    dll_log->Log (L"[ Version  ] Update check timed out");
+    return;
+  }
+
+  UNX_UpdateConfig ([&](unx_config_s& cfg) -> bool
+  {
+    cfg.system.last_update_check = _time64 (nullptr);
+    cfg.system.update_available  = (status == unx::update_status_e::Available);
+
+    return true;
+  });
+
+  UNX_QueueSaveConfig ();
+
+  if (config.system.update_available)
+  {
+    extern HMODULE hInjectorDLL;
+
+    SK_UpdateSoftware_pfn SK_UpdateSoftware =
+      (SK_UpdateSoftware_pfn)
+        GetProcAddress ( hInjectorDLL,
+                           "SK_UpdateSoftware" );
+
+    if (SK_UpdateSoftware != nullptr)
+        SK_UpdateSoftware (L"UnX");
+  }
+}
+
+static void
+UNX_GameCmd_ReloadConfig (uint32_t file)
+{
+  UNX_ReloadConfig (file);
+}
+
+//
+// Fetching version info can take seconds; it runs on its own thread and the
+//   result comes back through the command mailbox, so no frame waits on it.
+//
+static void
+UNX_StartUpdateCheck (void)
+{
+  extern HMODULE hInjectorDLL;
+
+  if (config.system.injector.find (L"SpecialK") != std::wstring::npos)
+    return;
+
+  SK_FetchVersionInfo_pfn SK_FetchVersionInfo =
+    (SK_FetchVersionInfo_pfn)
+      GetProcAddress ( hInjectorDLL,
+                         "SK_FetchVersionInfo" );
+
+  if ( SK_FetchVersionInfo                                == nullptr ||
+       GetProcAddress (hInjectorDLL, "SK_UpdateSoftware") == nullptr )
+    return;
+
+  const bool due =
+    unx::UpdateCheckDue ( _time64 (nullptr),
+                            config.system.last_update_check,
+                              (int64_t)config.system.update_interval * 3600LL,
+                                config.system.update_available );
+
+  if (! due)
+    return;
+
+  int timeout = config.system.update_timeout;
+
+  if (timeout < 1)
+      timeout = 1;
+
+  unx::CheckForUpdateAsync (
+    [SK_FetchVersionInfo] (void) -> bool
+    {
+      return SK_FetchVersionInfo (L"UnX");
+    },
+
+    [] (unx::update_status_e status)
+    {
+      unx::WindowManager::PostCommand ( unx::GAME_CMD_UPDATE_CHECKED,
+                                          (uint32_t)status );
+    },
+
+    (uint32_t)timeout * 1000UL
+  );
+}
+
+bool
+unx::WindowManager::PostCommand (game_command_e cmd, uint32_t arg)
+{
+  if (! game_commands.post (cmd, arg))
+  {
+    dll_log->Log ( L"[Window Mgr] Command mailbox full, dropped '%s'",
+                     game_command_names [cmd] );
+
+    return false;
+  }
+
+  return true;
+}
+
+static void
+UNX_PaceBackgroundFrame (void)
+{
+  static unx::FramePacer pacer (UNX_GetPacerClock ());
+
+  const float fps =
+    UNX_GetHotConfig ().background_fps;
+
+  if ( unx::window.active || shutting_down || fps <= 0.0f )
+  {
+    pacer.reset ();
+    return;
+  }
+
+  pacer.pace (fps);
+}
+
 LRESULT
 CALLBACK
 DetourWindowProc ( _In_  HWND   hWnd,
@@ -107,44 +388,8 @@ DetourWindowProc ( _In_  HWND   hWnd,
 {
   unx::window.hwnd = hWnd;
 
-  extern LPVOID __UNX_base_img_addr;
-
-  if (schedule_load)
-  {
-    schedule_load = false;
-
-    using LoadSave_pfn    = int (__stdcall *)(void);
-    using LoadSave2_pfn   = int (__cdecl   *)(int);
-    using LoadSave3_pfn   = int (__stdcall *)(void);
-    using LoadSaveXXX_pfn = int (__cdecl   *)(int);
-
-    ///LoadSave_pfn LoadSave =
-    ///  (LoadSave_pfn)
-    ///    ((intptr_t)__UNX_base_img_addr + 0x248910);
-    ///
-    ///LoadSave2_pfn LoadSave2 =
-    ///  (LoadSave2_pfn)
-    ///    ((intptr_t)__UNX_base_img_addr + 0x248890);
-    ///
-    ///LoadSave3_pfn LoadSave3 =
-    ///  (LoadSave3_pfn)
-    ///    ((intptr_t)__UNX_base_img_addr + 0x230DE0);
-
-    auto LoadSaveXXX =
-      (LoadSaveXXX_pfn)
-        ((intptr_t)__UNX_base_img_addr + 0x421870);
-
-    //*(int *)((intptr_t)__UNX_base_img_addr + 0xCE72D0) = 0;
-      *(int *)((intptr_t)__UNX_base_img_addr + 0x8CB994) = 1;
-
-    LoadSaveXXX (3);
-
-//    LoadSave  ();
-//    LoadSave2 (1);
-//    LoadSave2 (2);
-//    LoadSave3 ();
-  }
-
+  const unx_hot_config_s hot =
+    UNX_GetHotConfig ();
 
   if (GetActiveWindow () == hWnd)
     unx::window.active = true;
@@ -156,16 +401,19 @@ DetourWindowProc ( _In_  HWND   hWnd,
   // Setup the Cheat Manager on the first message received
   //   while the render window is active
   //
-  static volatile ULONG              __init_cheats = FALSE;
-  if ( unx::window.active &&
-     (! InterlockedCompareExchange (&__init_cheats, TRUE, FALSE)) )
+  //   (Only ever touched by the window thread; no need for an interlocked op)
+  //
+  static bool init_cheats = false;
+  if (unx::window.active && (! init_cheats))
   {
+    init_cheats = true;
+
     unx::CheatManager::Init ();
   }
 
 
   if (  uMsg == WM_DESTROY    || uMsg == WM_QUIT ||
-      (config.input.fast_exit && uMsg == WM_CLOSE)  )
+      (hot.fast_exit && uMsg == WM_CLOSE)  )
   {
     shutting_down = true;
 
@@ -198,19 +446,28 @@ DetourWindowProc ( _In_  HWND   hWnd,
 
     last_active = unx::window.active;
 
+    if (unx::window.active)
+      UNX_GetPacerClock ()->wake ();
+
     dll_log->Log ( L"[Window Mgr] Activation: %s",
                      unx::window.active ? L"ACTIVE" :
                                           L"INACTIVE" );
   }
 
 
-  if (config.input.trap_alt_tab)
+  if (hot.trap_alt_tab)
   {
     if ( uMsg == WM_NCACTIVATE )
       return 0;
   }
 
 
+  // A gamepad may have been plugged in / removed, don't wait for the next
+  //   scheduled poll to find out.
+  if (uMsg == WM_DEVICECHANGE)
+    unx::InputManager::NotifyDeviceChange ();
+
+
   if (uMsg == WM_TIMER)
   {
     switch (wParam)
@@ -228,7 +485,7 @@ DetourWindowProc ( _In_  HWND   hWnd,
 
 
 
-  if (config.input.fix_bg_input)
+  if (hot.fix_bg_input)
   {
     // Block keyboard input to the game while the console is visible
     if (! (unx::window.active)/* || background_render*/)
@@ -246,10 +503,10 @@ DetourWindowProc ( _In_  HWND   hWnd,
   // Block the menu key from messing with stuff*
   if ((uMsg == WM_SYSKEYDOWN || uMsg == WM_SYSKEYUP))
   {
-    if (wParam != VK_TAB || (! config.input.trap_alt_tab))
+    if (wParam != VK_TAB || (! hot.trap_alt_tab))
     {
       // Actually, just block Alt+F4
-      if (config.input.fast_exit && wParam == VK_F4)
+      if (hot.fast_exit && wParam == VK_F4)
         return DefWindowProc (hWnd, uMsg, wParam, lParam);
     }
   }
@@ -273,13 +530,14 @@ UNX_SummarizeCheats (DWORD dwTime);
 extern void
 UNX_PollInput (void);
 
-extern bool
-UNX_KillMeNow (void);
-
 void
 WINAPI
 SK_BeginBufferSwap_Detour (void)
 {
+  UNX_PaceBackgroundFrame ();
+
+  unx::InputManager::NotifyPresent ();
+
   UNX_PollInput ();
 
 
@@ -290,12 +548,7 @@ SK_BeginBufferSwap_Detour (void)
       SK_BeginBufferSwap_Original ();
 
 
-  if (InterlockedCompareExchange (&queue_death, FALSE, TRUE))
-  {
-    SK_GetCommandProcessor ()->ProcessCommandLine ("mem b D2A8E2 2 ");
-
-    UNX_KillMeNow ();
-  }
+  game_commands.drain ();
 
 
   if (SKX_DrawExternalOSD != nullptr)
@@ -307,32 +560,13 @@ SK_BeginBufferSwap_Detour (void)
   }
 
 
-  static volatile ULONG              __init = FALSE;
-  if (! InterlockedCompareExchange (&__init, 1, 0))
+  // Only ever called on the render thread
+  static bool init = false;
+  if (! init)
   {
-    extern HMODULE hInjectorDLL;
+    init = true;
 
-    SK_UpdateSoftware_pfn SK_UpdateSoftware =
-      (SK_UpdateSoftware_pfn)
-        GetProcAddress ( hInjectorDLL,
-                           "SK_UpdateSoftware" );
-
-    SK_FetchVersionInfo_pfn SK_FetchVersionInfo =
-      (SK_FetchVersionInfo_pfn)
-        GetProcAddress ( hInjectorDLL,
-                           "SK_FetchVersionInfo" );
-
-    if (config.system.injector.find (L"SpecialK") == std::wstring::npos)
-    {
-      if ( SK_FetchVersionInfo != nullptr &&
-           SK_UpdateSoftware   != nullptr )
-      {
-        if (SK_FetchVersionInfo (L"UnX"))
-        {
-          SK_UpdateSoftware (L"UnX");
-        }
-      }
-    }
+    UNX_StartUpdateCheck ();
   }
 }
 
@@ -370,20 +604,58 @@ UNX_InstallWindowHook (HWND hWnd)
 void
 unx::WindowManager::Init (void)
 {
-//  CommandProcessor* comm_proc = CommandProcessor::getInstance ();
+  game_commands.set_handler (GAME_CMD_QUICK_LOAD,     UNX_GameCmd_QuickLoad);
+  game_commands.set_handler (GAME_CMD_DEATH,          UNX_GameCmd_Death);
+  game_commands.set_handler (GAME_CMD_APPLY_LANGUAGE, UNX_GameCmd_ApplyLanguage);
+  game_commands.set_handler (GAME_CMD_UPDATE_CHECKED,  UNX_GameCmd_UpdateChecked);
+  game_commands.set_handler (GAME_CMD_RELOAD_CONFIG,   UNX_GameCmd_ReloadConfig);
+
+  CommandProcessor::getInstance ();
 }
 
 void
 unx::WindowManager::Shutdown (void)
 {
+  for (uint32_t cmd = 0; cmd < GAME_CMD_COUNT; cmd++)
+  {
+    const auto& stats = game_commands.stats (cmd);
+
+    if (stats.posted == 0)
+      continue;
+
+    dll_log->Log ( L"[Window Mgr] %-14s: %llu posted, %llu run, %llu coalesced, %llu dropped"
+                   L" - wait max %.2f ms, run avg %.2f ms / max %.2f ms",
+                     game_command_names [cmd],
+                       stats.posted.load (), stats.executed.load  (),
+                       stats.coalesced.load (), stats.dropped.load (),
+                         (double)stats.wait_max.load () / 1000.0,
+                         stats.executed ? (double)stats.run_total.load () /
+                                          (double)stats.executed.load () / 1000.0 : 0.0,
+                         (double)stats.run_max.load () / 1000.0 );
+  }
+
   unx::CheatManager::Shutdown ();
 }
 
 
-unx::WindowManager::CommandProcessor::CommandProcessor (void) = default;
 unx::WindowManager::CommandProcessor*
    unx::WindowManager::CommandProcessor::pCommProc            = nullptr;
 
+unx::WindowManager::CommandProcessor::CommandProcessor (void)
+{
+  // The foreground limit belongs to Special K's own limiter
+  foreground_fps_ = nullptr;
+  background_fps_ =
+    UNX_CreateVar (SK_IVariable::Float, &config.window.background_fps, this);
+
+  SK_ICommandProcessor* pCommandProc =
+    SK_GetCommandProcessor != nullptr ? SK_GetCommandProcessor () :
+                                        nullptr;
+
+  if (pCommandProc != nullptr && background_fps_ != nullptr)
+    pCommandProc->AddVariable ("Window.BackgroundFPS", background_fps_);
+}
+
 bool
   unx::WindowManager::
     CommandProcessor::OnVarChange (SK_IVariable* var, void* val)
@@ -393,6 +665,22 @@ bool
 
   bool known = false;
 
+  if (var == background_fps_ && val != nullptr)
+  {
+    float fps = *(float *)val;
+
+    if (fps < 0.0f)
+        fps = 0.0f;
+
+    UNX_UpdateConfig ([fps](unx_config_s& cfg) -> bool
+    {
+      cfg.window.background_fps = fps;
+      return true;
+    });
+
+    known = true;
+  }
+
   if (! known)
   {
     dll_log->Log ( L"[Window Mgr] UNKNOWN Variable Changed (%p --> %p)",
@@ -400,5 +688,5 @@ bool
                        val );
   }
 
-  return false;
+  return known;
 }
\ No newline at end of file
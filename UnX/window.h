@@ -23,6 +23,8 @@
 
 #include "command.h"
 
+#include <cstdint>
+
 namespace unx
 {
   // State for window activation faking
@@ -53,11 +55,25 @@ namespace unx
     bool    borderless = false;
   } extern window;
 
+  // Work that other threads hand to the render thread
+  enum game_command_e : uint32_t {
+    GAME_CMD_QUICK_LOAD     = 0, // Finish a quick load started from the menu
+    GAME_CMD_DEATH,              // Game Over outside of battle
+    GAME_CMD_APPLY_LANGUAGE,     // arg: asset_type_t
+    GAME_CMD_UPDATE_CHECKED,     // arg: update_status_e
+    GAME_CMD_RELOAD_CONFIG,      // arg: file id from UNX_WatchConfig
+
+    GAME_CMD_COUNT
+  };
+
   namespace WindowManager
   {
     void Init     ();
     void Shutdown ();
 
+    // Any thread; runs at the start of the next frame
+    bool PostCommand (game_command_e cmd, uint32_t arg = 0);
+
     class CommandProcessor : public SK_IVariableListener {
     public:
       CommandProcessor (void);
@@ -0,0 +1,106 @@
+/**
+ * This file is part of UnX.
+ *
+ * UnX is free software : you can redistribute it
+ * and/or modify it under the terms of the GNU General Public License
+ * as published by The Free Software Foundation, either version 3 of
+ * the License, or (at your option) any later version.
+ *
+ * UnX is distributed in the hope that it will be useful,
+ *
+ * But WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with UnX.
+ *
+ *   If not, see <http://www.gnu.org/licenses/>.
+ *
+**/
+#include "remap.h"
+#include "test.h"
+
+#include <cstdlib>
+
+using namespace unx::remap;
+
+//
+// Every raw value of several ranges, dead zones and curves: the end points
+//   land on 0 / 255, the precomputed press threshold agrees with LUT > 190,
+//     and the linear table stays within 1 of the old float math.
+//
+static void
+test_tables (void)
+{
+  static const int32_t ranges [][2] = {
+    { 0, 65535 }, { 0, 255 }, { -32768, 32767 }, { 100, 1000 }, { 0, 1 }
+  };
+
+  static const float dead_zones [] = { 0.0f, 0.1f, 0.5f };
+  static const float curves     [] = { 1.0f, 2.0f, 0.5f };
+
+  for (const auto& r : ranges)
+  for (float dz      : dead_zones)
+  for (float curve   : curves)
+  {
+    axis_table_s t;
+    BuildAxisTable (&t, r [0], r [1], dz, curve);
+
+    UNX_CHECK (AxisValue (t, r [0]) == 0);
+    UNX_CHECK (AxisValue (t, r [1]) == 255);
+
+    for (int64_t raw = r [0] - 5; raw <= r [1] + 5; raw++)
+    {
+      UNX_CHECK ( (AxisValue (t, (int32_t)raw) > 190) ==
+                   AxisPressed (t, (int32_t)raw) );
+    }
+
+    if (dz != 0.0f || curve != 1.0f)
+      continue;
+
+    for (int64_t raw = r [0]; raw <= r [1]; raw++)
+    {
+      const int legacy =
+        (int)(255.0f * ((float)(raw - r [0]) / (float)(r [1] - r [0])));
+
+      UNX_CHECK (std::abs (legacy - AxisValue (t, (int32_t)raw)) <= 1);
+    }
+  }
+}
+
+static void
+bench (void)
+{
+  constexpr int Iters = 20000000;
+
+  axis_table_s t;
+  BuildAxisTable (&t, 0, 65535);
+
+  volatile int sink = 0;
+
+  double start = UNX_TestSeconds ();
+
+  for (int i = 0; i < Iters; i++)
+    sink += AxisValue (t, i & 65535);
+
+  const double lut = (UNX_TestSeconds () - start) * 1e9 / Iters;
+
+  start = UNX_TestSeconds ();
+
+  for (int i = 0; i < Iters; i++)
+    sink += (int)(255.0f * ((float)(i & 65535) / 65535.0f));
+
+  const double flt = (UNX_TestSeconds () - start) * 1e9 / Iters;
+
+  std::printf ("axis value: %.2f ns (float %.2f ns)\n", lut, flt);
+}
+
+int
+main (void)
+{
+  test_tables ();
+  bench       ();
+
+  return 0;
+}
@@ -0,0 +1,191 @@
+/**
+ * This file is part of UnX.
+ *
+ * UnX is free software : you can redistribute it
+ * and/or modify it under the terms of the GNU General Public License
+ * as published by The Free Software Foundation, either version 3 of
+ * the License, or (at your option) any later version.
+ *
+ * UnX is distributed in the hope that it will be useful,
+ *
+ * But WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with UnX.
+ *
+ *   If not, see <http://www.gnu.org/licenses/>.
+ *
+**/
+#include <Windows.h>
+
+#include "command.h"
+#include "test.h"
+
+#include <cstring>
+#include <string>
+
+HMODULE hInjectorDLL = nullptr;
+
+SK_ICommandProcessor::SK_ICommandProcessor (void) { }
+
+struct int_var_s : SK_IVariable
+{
+  int value = 1;
+
+  VariableType getType         (void) const override { return Int; }
+  void*        getValuePointer (void) const override { return (void *)&value; }
+
+  void getValueString (char* szOut, uint32_t* dwLen) const override {
+    snprintf (szOut, *dwLen, "%d", value);
+  }
+};
+
+struct command_s : SK_ICommand
+{
+  std::string args;
+
+  SK_ICommandResult execute (const char* szArgs) override
+  {
+    args = szArgs;
+    return SK_ICommandResult ("mem", szArgs, "", 1);
+  }
+};
+
+// Counts lookups, and keeps the last line it was asked to process
+struct processor_s : SK_ICommandProcessor
+{
+  int_var_s   interval;
+  command_s   mem;
+  int         finds = 0;
+  std::string line;
+
+  SK_ICommand* FindCommand (const char* szCommand) const override
+  {
+    ++const_cast <processor_s *> (this)->finds;
+    return strcmp (szCommand, "mem") ? nullptr : const_cast <command_s *> (&mem);
+  }
+
+  const SK_IVariable* FindVariable (const char* szVariable) const override
+  {
+    ++const_cast <processor_s *> (this)->finds;
+    return strcmp (szVariable, "PresentationInterval") ? nullptr : &interval;
+  }
+
+  SK_ICommandResult ProcessCommandLine (const char* szCommandLine) override
+  {
+    line = szCommandLine;
+
+    int value;
+
+    if (sscanf (szCommandLine, "PresentationInterval %d", &value) == 1)
+      interval.value = value;
+
+    return SK_ICommandResult ("PresentationInterval", "", "", 1);
+  }
+
+  const SK_ICommand*  AddCommand     (const char*, SK_ICommand*)  override { return nullptr; }
+  bool                RemoveCommand  (const char*)                override { return false;   }
+  const SK_IVariable* AddVariable    (const char*, SK_IVariable*) override { return nullptr; }
+  bool                RemoveVariable (const char*)                override { return false;   }
+
+  SK_ICommandResult ProcessCommandFormatted (const char*, ...) override {
+    return SK_ICommandResult ("");
+  }
+};
+
+static processor_s processor;
+
+static SK_ICommandProcessor* __stdcall
+GetProcessor (void)
+{
+  return &processor;
+}
+
+static void
+test_before_sk (void)
+{
+  // SK has not handed over its command processor yet
+  unx::PreparedVariable early ("PresentationInterval");
+
+  int value = 0;
+
+  UNX_CHECK (! early.valid () && ! early.read (value));
+
+  SK_GetCommandProcessor = GetProcessor;
+
+  UNX_CHECK (early.read (value) && value == 1);
+}
+
+static void
+test_variable (void)
+{
+  unx::PreparedVariable interval ("PresentationInterval");
+  unx::PreparedVariable missing  ("Nope");
+
+  int   value = 0;
+  float wrong = 0.0f;
+
+  UNX_CHECK (  interval.read (value) && value == 1);
+  UNX_CHECK (! interval.read (wrong));
+
+  UNX_CHECK (interval.set (0));
+  UNX_CHECK (processor.interval.value == 0 && processor.line == "PresentationInterval 0");
+
+  UNX_CHECK (interval.setf ("%lux%lu", 640UL, 480UL));
+  UNX_CHECK (processor.line == "PresentationInterval 640x480");
+
+  UNX_CHECK (! missing.valid () && ! missing.set ("1"));
+}
+
+static void
+test_command (void)
+{
+  unx::PreparedCommand mem     ("mem");
+  unx::PreparedCommand missing ("nope");
+
+  UNX_CHECK (mem.executef ("s %x %x", 0x392930, 0x1deb));
+  UNX_CHECK (processor.mem.args == "s 392930 1deb");
+
+  UNX_CHECK (! missing.execute ("1"));
+}
+
+// Found names are looked up once; missing ones are tried again
+static void
+test_cached (void)
+{
+  static unx::PreparedVariable interval ("PresentationInterval");
+  static unx::PreparedCommand  mem      ("mem");
+
+  const int before = processor.finds;
+
+  int value;
+
+  for (int i = 0; i < 100; i++)
+  {
+    interval.read (value);
+    mem.execute   ("b 1 1");
+  }
+
+  UNX_CHECK (processor.finds - before == 2);
+
+  // SK may register it later
+  unx::PreparedVariable missing ("Nope");
+
+  missing.valid ();
+  missing.valid ();
+
+  UNX_CHECK (processor.finds - before == 4);
+}
+
+int
+main (void)
+{
+  test_before_sk ();
+  test_variable  ();
+  test_command   ();
+  test_cached    ();
+
+  return 0;
+}
@@ -0,0 +1,37 @@
+/**
+ * This file is part of UnX.
+ *
+ * UnX is free software : you can redistribute it
+ * and/or modify it under the terms of the GNU General Public License
+ * as published by The Free Software Foundation, either version 3 of
+ * the License, or (at your option) any later version.
+ *
+ * UnX is distributed in the hope that it will be useful,
+ *
+ * But WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with UnX.
+ *
+ *   If not, see <http://www.gnu.org/licenses/>.
+ *
+**/
+//
+// See Unknwn.h; nothing here loads anything.
+//
+#ifndef __UNX__TESTS_COMPAT_WINDOWS_H__
+#define __UNX__TESTS_COMPAT_WINDOWS_H__
+
+#include "Unknwn.h"
+
+typedef void* HMODULE;
+
+static inline void*
+GetProcAddress (HMODULE, const char*)
+{
+  return nullptr;
+}
+
+#endif /* __UNX__TESTS_COMPAT_WINDOWS_H__ */
@@ -0,0 +1,164 @@
+/**
+ * This file is part of UnX.
+ *
+ * UnX is free software : you can redistribute it
+ * and/or modify it under the terms of the GNU General Public License
+ * as published by The Free Software Foundation, either version 3 of
+ * the License, or (at your option) any later version.
+ *
+ * UnX is distributed in the hope that it will be useful,
+ *
+ * But WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with UnX.
+ *
+ *   If not, see <http://www.gnu.org/licenses/>.
+ *
+**/
+#include "configwatch.h"
+#include "inifile.h"
+#include "test.h"
+
+#include <atomic>
+#include <cstring>
+#include <filesystem>
+#include <string>
+#include <thread>
+#include <vector>
+
+using unx::ConfigWatcher;
+using unx::INIFile;
+
+namespace fs = std::filesystem;
+
+static std::atomic <int> reports     { 0 };
+static std::atomic <int> last_report { -1 };
+
+static void
+Changed (size_t file)
+{
+  reports++;
+  last_report = (int)file;
+}
+
+static std::vector <uint8_t>
+Bytes (const char* str)
+{
+  return std::vector <uint8_t> (str, str + strlen (str));
+}
+
+static bool
+WaitForReports (int count, int timeout_ms = 3000)
+{
+  for (int waited = 0; waited < timeout_ms && reports < count; waited += 10)
+    std::this_thread::sleep_for (std::chrono::milliseconds (10));
+
+  return reports >= count;
+}
+
+static void
+Quiet (void)
+{
+  std::this_thread::sleep_for (std::chrono::milliseconds (400));
+}
+
+int
+main (void)
+{
+  const fs::path dir =
+    fs::absolute ("configwatch_test.d");
+
+  fs::remove_all       (dir);
+  fs::create_directory (dir);
+
+  const std::wstring a = (dir / "UnX.ini").wstring ();
+  const std::wstring b = (dir / "UnX_Booster.ini").wstring ();
+
+  INIFile::write_file (a.c_str (), Bytes ("[A]\r\nx=1\r\n"));
+
+  ConfigWatcher watcher (Changed, 50);
+
+  UNX_CHECK (watcher.add (a) == 0);
+  UNX_CHECK (watcher.add (b) == 1);
+  UNX_CHECK (watcher.add (a) == 0);
+  UNX_CHECK (watcher.start ());
+
+  std::vector <uint8_t> data;
+
+  // An editor replacing the file
+  INIFile::write_file (a.c_str (), Bytes ("[A]\r\nx=2\r\n"));
+
+  UNX_CHECK (WaitForReports (1) && last_report == 0);
+  UNX_CHECK (  watcher.take (0, data) && data == Bytes ("[A]\r\nx=2\r\n"));
+  UNX_CHECK (! watcher.take (0, data));
+
+  // A file that did not exist at start
+  INIFile::write_file (b.c_str (), Bytes ("[B]\r\ny=1\r\n"));
+
+  UNX_CHECK (WaitForReports (2) && last_report == 1);
+
+  // Our own write is not reported, and neither is rewriting the same bytes
+  const std::vector <uint8_t> own = Bytes ("[A]\r\nx=3\r\n");
+
+  watcher.expect (a, own);
+  INIFile::write_file (a.c_str (), own);
+  Quiet ();
+  UNX_CHECK (reports == 2);
+
+  INIFile::write_file (a.c_str (), own);
+  Quiet ();
+  UNX_CHECK (reports == 2);
+
+  // Between expect () and the write landing, a scan woken by another file
+  //   must not report the old contents
+  const std::vector <uint8_t> own2 = Bytes ("[A]\r\nx=4\r\n");
+
+  watcher.expect (a, own2);
+  INIFile::write_file (b.c_str (), Bytes ("[B]\r\ny=2\r\n"));
+
+  UNX_CHECK (WaitForReports (3) && last_report == 1);
+  Quiet ();
+  UNX_CHECK (reports == 3);
+
+  INIFile::write_file (a.c_str (), own2);
+  Quiet ();
+  UNX_CHECK (reports == 3);
+
+  // Once it has landed, an edit back to the old contents is one
+  INIFile::write_file (a.c_str (), own);
+
+  UNX_CHECK (WaitForReports (4) && last_report == 0);
+
+  // A burst of edits is reported as few times as the debounce allows, and
+  //   take () returns the last one
+  const int before = reports;
+
+  for (int i = 0; i < 10; i++)
+  {
+    char text [64];
+    snprintf (text, sizeof (text), "[A]\r\nx=%d\r\n", 10 + i);
+
+    INIFile::write_file (a.c_str (), Bytes (text));
+    std::this_thread::sleep_for (std::chrono::milliseconds (5));
+  }
+
+  UNX_CHECK (WaitForReports (before + 1));
+  Quiet ();
+
+  UNX_CHECK (watcher.take (0, data) && data == Bytes ("[A]\r\nx=19\r\n"));
+
+  const auto s = watcher.stats ();
+
+  std::printf ( "burst of 10 edits: %d reports; wakeups %llu, changed %llu, expected %llu\n",
+                  reports - before, (unsigned long long)s.wakeups,
+                    (unsigned long long)s.changed, (unsigned long long)s.expected );
+
+  watcher.stop ();
+
+  fs::remove_all (dir);
+
+  return 0;
+}
@@ -0,0 +1,239 @@
+/**
+ * This file is part of UnX.
+ *
+ * UnX is free software : you can redistribute it
+ * and/or modify it under the terms of the GNU General Public License
+ * as published by The Free Software Foundation, either version 3 of
+ * the License, or (at your option) any later version.
+ *
+ * UnX is distributed in the hope that it will be useful,
+ *
+ * But WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with UnX.
+ *
+ *   If not, see <http://www.gnu.org/licenses/>.
+ *
+**/
+#include "configwriter.h"
+#include "test.h"
+
+#include <atomic>
+#include <map>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+using namespace std::chrono;
+
+static std::mutex                                                disk_lock;
+static std::map <std::wstring, std::vector <std::vector <uint8_t>>> disk;
+
+static std::atomic <int> fail_writes { 0 };
+static std::atomic <int> slow_ms     { 0 };
+static std::atomic <int> writing     { 0 };
+static std::atomic <int> overlapped  { 0 };
+
+static bool
+WriteStub (const std::wstring& path, const std::vector <uint8_t>& data)
+{
+  if (writing.fetch_add (1) != 0)
+    overlapped++;
+
+  if (slow_ms)
+    std::this_thread::sleep_for (milliseconds (slow_ms.load ()));
+
+  bool ok = false;
+
+  if (fail_writes > 0)
+    fail_writes--;
+
+  else
+  {
+    std::lock_guard <std::mutex> guard (disk_lock);
+    disk [path].push_back (data);
+    ok = true;
+  }
+
+  writing--;
+
+  return ok;
+}
+
+static std::vector <uint8_t>
+Bytes (int x)
+{
+  return std::vector <uint8_t> (1, (uint8_t)x);
+}
+
+static size_t
+Writes (const wchar_t* path)
+{
+  std::lock_guard <std::mutex> guard (disk_lock);
+  return disk [path].size ();
+}
+
+static void
+test_coalesce (void)
+{
+  unx::ConfigWriter writer (WriteStub, 100, 1000);
+
+  for (int i = 0; i < 20; i++)
+  {
+    writer.queue (L"a", Bytes (i));
+    std::this_thread::sleep_for (milliseconds (10));
+  }
+
+  writer.queue (L"b", Bytes (1));
+
+  std::this_thread::sleep_for (milliseconds (400));
+
+  UNX_CHECK (Writes (L"a") == 1 && disk [L"a"][0][0] == 19);
+  UNX_CHECK (Writes (L"b") == 1);
+
+  const auto s = writer.stats ();
+
+  UNX_CHECK (s.queued == 21 && s.coalesced == 19 && s.written == 2);
+  UNX_CHECK (writer.pending () == 0);
+}
+
+// A burst that never goes quiet is still written every max_delay
+static void
+test_max_delay (void)
+{
+  unx::ConfigWriter writer (WriteStub, 100, 300);
+
+  const auto start = steady_clock::now ();
+
+  while (steady_clock::now () - start < milliseconds (700))
+  {
+    writer.queue (L"a", Bytes (1));
+    std::this_thread::sleep_for (milliseconds (20));
+  }
+
+  std::printf ("writes during a 700 ms burst: %zu\n", Writes (L"a"));
+
+  UNX_CHECK (Writes (L"a") >= 2);
+}
+
+static void
+test_flush (void)
+{
+  {
+    unx::ConfigWriter writer (WriteStub, 10000, 10000);
+
+    writer.queue (L"a", Bytes (5));
+
+    UNX_CHECK (writer.flush   () == 1);
+    UNX_CHECK (writer.pending () == 0);
+
+    // The destructor writes whatever is left
+    writer.queue (L"a", Bytes (6));
+  }
+
+  UNX_CHECK (Writes (L"a") == 2 && disk [L"a"][1][0] == 6);
+}
+
+// A snapshot queued while an older one is being written is not forgotten
+static void
+test_newer_during_write (void)
+{
+  unx::ConfigWriter writer (WriteStub, 10, 100);
+
+  slow_ms = 200;
+
+  writer.queue (L"a", Bytes (1));
+  std::this_thread::sleep_for (milliseconds (100));
+  writer.queue (L"a", Bytes (2));
+  std::this_thread::sleep_for (milliseconds (150));
+
+  UNX_CHECK (writer.pending () == 1);
+
+  slow_ms = 0;
+
+  writer.flush ();
+
+  UNX_CHECK (disk [L"a"].back ()[0] == 2 && writer.pending () == 0);
+}
+
+// flush () behind a live but slow writer thread gives up instead of
+//   writing the same file next to it
+static void
+test_flush_timeout (void)
+{
+  unx::ConfigWriter writer (WriteStub, 10, 10);
+
+  slow_ms = 400;
+
+  writer.queue (L"a", Bytes (1));
+  std::this_thread::sleep_for (milliseconds (100));
+
+  UNX_CHECK (writer.flush (50) == 0);
+  UNX_CHECK (Writes (L"a") == 0);
+
+  slow_ms = 0;
+
+  std::this_thread::sleep_for (milliseconds (500));
+
+  UNX_CHECK (Writes (L"a") == 1 && writer.pending () == 0);
+  UNX_CHECK (overlapped == 0);
+}
+
+static void
+test_retry (void)
+{
+  unx::ConfigWriter writer (WriteStub, 20, 100);
+
+  fail_writes = 2;
+
+  writer.queue (L"a", Bytes (3));
+  std::this_thread::sleep_for (milliseconds (300));
+
+  UNX_CHECK (Writes (L"a") == 1 && writer.stats ().failed == 2);
+}
+
+static void
+test_threads (void)
+{
+  unx::ConfigWriter         writer (WriteStub, 5, 20);
+  std::vector <std::thread> threads;
+
+  for (int t = 0; t < 4; t++)
+  {
+    threads.emplace_back ([&writer, t]
+    {
+      for (int i = 0; i < 2000; i++)
+      {
+        writer.queue ((t & 1) ? L"x" : L"y", Bytes (i & 255));
+
+        if (i % 100 == 0)
+          writer.flush ();
+      }
+    });
+  }
+
+  for (auto& thread : threads)
+    thread.join ();
+
+  writer.flush ();
+
+  UNX_CHECK (writer.pending () == 0);
+  UNX_CHECK (overlapped == 0);
+}
+
+int
+main (void)
+{
+  test_coalesce           ();  disk.clear ();
+  test_max_delay          ();  disk.clear ();
+  test_flush              ();  disk.clear ();
+  test_newer_during_write ();  disk.clear ();
+  test_flush_timeout      ();  disk.clear ();
+  test_retry              ();  disk.clear ();
+  test_threads            ();
+
+  return 0;
+}
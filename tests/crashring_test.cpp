@@ -0,0 +1,270 @@
+/**
+ * This file is part of UnX.
+ *
+ * UnX is free software : you can redistribute it
+ * and/or modify it under the terms of the GNU General Public License
+ * as published by The Free Software Foundation, either version 3 of
+ * the License, or (at your option) any later version.
+ *
+ * UnX is distributed in the hope that it will be useful,
+ *
+ * But WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with UnX.
+ *
+ *   If not, see <http://www.gnu.org/licenses/>.
+ *
+**/
+#include "crashring.h"
+#include "inifile.h"
+#include "test.h"
+
+#include <csignal>
+#include <cstring>
+#include <fstream>
+#include <sstream>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include <sys/wait.h>
+#include <unistd.h>
+
+using unx::CrashRing;
+
+static std::string
+Slurp (const char* path)
+{
+  std::ifstream     in (path, std::ios::binary);
+  std::stringstream out;
+
+  out << in.rdbuf ();
+
+  return out.str ();
+}
+
+static void
+Line (CrashRing& ring, const std::wstring& text)
+{
+  ring.write (text.data (), text.size ());
+}
+
+// Runs body in a child process that dies without closing anything
+template <typename _Fn>
+static void
+Crash (_Fn&& body)
+{
+  const pid_t pid = fork ();
+
+  UNX_CHECK (pid != -1);
+
+  if (pid == 0)
+  {
+    body ();
+    kill (getpid (), SIGKILL);
+  }
+
+  waitpid (pid, nullptr, 0);
+}
+
+static void
+test_clean_exit (void)
+{
+  unlink ("crashring_test.ring");
+
+  {
+    CrashRing ring;
+
+    UNX_CHECK (ring.open (L"crashring_test.ring", 64 * 1024));
+    Line (ring, L"hello\n");
+    ring.close (true);
+  }
+
+  UNX_CHECK (CrashRing::Recover (L"crashring_test.ring", L"crashring_test.txt") == 0);
+}
+
+static void
+test_crash (void)
+{
+  Crash ([]
+  {
+    CrashRing ring;
+    ring.open (L"crashring_test.ring", 64 * 1024);
+
+    for (int i = 0; i < 10; i++)
+      Line (ring, L"line " + std::to_wstring (i) + L" \xe9\n");
+  });
+
+  UNX_CHECK (CrashRing::Recover (L"crashring_test.ring", L"crashring_test.txt") == 10);
+
+  const std::string text =
+    Slurp ("crashring_test.txt");
+
+  UNX_CHECK (text.find ("line 0 \xc3\xa9\n") == 0);
+  UNX_CHECK (text.find ("line 9")            != std::string::npos);
+
+  // The previous session is not part of it
+  UNX_CHECK (text.find ("hello") == std::string::npos);
+}
+
+//
+// 4 threads going around a small ring many times before the process is
+//   killed: every line that comes back is whole and in its thread's order.
+//
+static void
+test_wrap (void)
+{
+  Crash ([]
+  {
+    CrashRing ring;
+    ring.open (L"crashring_test.ring", 64 * 1024);
+
+    std::vector <std::thread> threads;
+
+    for (int t = 0; t < 4; t++)
+    {
+      threads.emplace_back ([&ring, t]
+      {
+        for (int i = 0; i < 5000; i++)
+        {
+          Line ( ring, L"T" + std::to_wstring (t) + L" " + std::to_wstring (i) + L" " +
+                         std::wstring (i % 50, L'x') + L"\n" );
+        }
+      });
+    }
+
+    for (auto& thread : threads)
+      thread.join ();
+  });
+
+  const size_t recovered =
+    CrashRing::Recover (L"crashring_test.ring", L"crashring_test.txt");
+
+  std::istringstream text (Slurp ("crashring_test.txt"));
+  std::string        line;
+
+  int    last [4] = { -1, -1, -1, -1 };
+  size_t lines    = 0;
+
+  while (std::getline (text, line))
+  {
+    int  t, i;
+    char xs [128] = "";
+
+    UNX_CHECK (sscanf (line.c_str (), "T%d %d %127s", &t, &i, xs) >= 2);
+    UNX_CHECK (t >= 0 && t < 4 && i > last [t]);
+    UNX_CHECK ((int)strlen (xs) == i % 50);
+
+    last [t] = i;
+    lines++;
+  }
+
+  std::printf ( "wrapped ring: %zu lines recovered, last %d %d %d %d\n",
+                  recovered, last [0], last [1], last [2], last [3] );
+
+  UNX_CHECK (lines == recovered);
+
+  // The thread that finished last has its final line in there
+  int finished = 0;
+
+  for (int t = 0; t < 4; t++)
+    finished += (last [t] == 4999);
+
+  UNX_CHECK (finished >= 1);
+}
+
+static void
+test_reopen_and_cut (void)
+{
+  // Opening with a different size starts over
+  {
+    CrashRing ring;
+
+    UNX_CHECK (ring.open (L"crashring_test.ring", 32 * 1024));
+    ring.close (false);
+  }
+
+  UNX_CHECK (CrashRing::Recover (L"crashring_test.ring", L"crashring_test.txt") == 0);
+
+  // A line longer than the ring is cut to fit
+  {
+    CrashRing ring;
+
+    ring.open (L"crashring_test.ring", 4096);
+    Line (ring, std::wstring (10000, L'y'));
+    ring.close (false);
+  }
+
+  UNX_CHECK (CrashRing::Recover (L"crashring_test.ring", L"crashring_test.txt") == 1);
+  UNX_CHECK (Slurp ("crashring_test.txt").size () < 4096);
+}
+
+// What a line costs: the ring vs. stdio that is just as durable (flushed)
+//   and stdio that loses its buffer in a crash
+static void
+bench (void)
+{
+  constexpr int Lines = 100000;
+
+  const std::wstring line =
+    L"12:34:56.789: [Button Map] Button          A: 'gamepads\\PlayStation\\A.dds' ( deadbeef :: \n";
+
+  std::vector <uint8_t> utf8;
+
+  double flushed = 0.0, buffered = 0.0, ring = 0.0;
+
+  for (int pass = 0; pass < 2; pass++)
+  {
+    FILE* fp = fopen ("crashring_bench.log", "wb");
+    UNX_CHECK (fp != nullptr);
+
+    const double t = UNX_TestSeconds ();
+
+    for (int i = 0; i < Lines; i++)
+    {
+      utf8.clear ();
+      unx::INIFile::encode_utf8 (line, utf8);
+
+      fwrite (utf8.data (), 1, utf8.size (), fp);
+
+      if (pass == 0)
+        fflush (fp);
+    }
+
+    fclose (fp);
+
+    (pass == 0 ? flushed : buffered) = UNX_TestSeconds () - t;
+  }
+
+  {
+    CrashRing r;
+    UNX_CHECK (r.open (L"crashring_bench.ring"));
+
+    const double t = UNX_TestSeconds ();
+
+    for (int i = 0; i < Lines; i++)
+      r.write (line.data (), line.size ());
+
+    ring = UNX_TestSeconds () - t;
+
+    r.close ();
+  }
+
+  std::printf ( "per line: stdio + fflush %.0f ns, stdio buffered %.0f ns, crash ring %.0f ns\n",
+                  flushed * 1e9 / Lines, buffered * 1e9 / Lines, ring * 1e9 / Lines );
+}
+
+int
+main (void)
+{
+  test_clean_exit     ();
+  test_crash          ();
+  test_wrap           ();
+  test_reopen_and_cut ();
+  bench               ();
+
+  return 0;
+}
@@ -0,0 +1,108 @@
+/**
+ * This file is part of UnX.
+ *
+ * UnX is free software : you can redistribute it
+ * and/or modify it under the terms of the GNU General Public License
+ * as published by The Free Software Foundation, either version 3 of
+ * the License, or (at your option) any later version.
+ *
+ * UnX is distributed in the hope that it will be useful,
+ *
+ * But WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with UnX.
+ *
+ *   If not, see <http://www.gnu.org/licenses/>.
+ *
+**/
+#include "framepacer.h"
+#include "test.h"
+
+//
+// A clock that only moves when told to; every third sleep wakes up half a
+//   millisecond early, and a sleep can be cut short by an "interrupt".
+//
+struct sim_clock_s : unx::FramePacer::clock_s
+{
+  uint64_t t            = 1000;
+  int      sleeps       = 0;
+  uint64_t interrupt_at = 0;
+
+  uint64_t now (void) override { return t; }
+
+  bool sleep (uint64_t until) override
+  {
+    ++sleeps;
+
+    if (interrupt_at != 0 && until > interrupt_at && t < interrupt_at)
+    {
+      t = interrupt_at;
+      return false;
+    }
+
+    t = until - (sleeps % 3 == 0 ? 500 : 0);
+
+    return true;
+  }
+};
+
+int
+main (void)
+{
+  sim_clock_s     clock;
+  unx::FramePacer pacer (&clock);
+
+  // 30 fps with 5 ms of work per frame; early wakeups must not add up
+  uint64_t first = 0,
+           last  = 0;
+
+  for (int i = 0; i < 301; i++)
+  {
+    pacer.pace (30.0f);
+
+    if (i == 0)
+      first = clock.t;
+
+    last     = clock.t;
+    clock.t += 5000;
+  }
+
+  const double fps = 300.0 / ((last - first) / 1e6);
+
+  std::printf ("30 fps limit, simulated: %.3f fps\n", fps);
+
+  UNX_CHECK (fps > 29.9 && fps < 30.1);
+
+  // A long stall does not turn into a burst of unpaced frames afterwards
+  clock.t += 500000;
+
+  UNX_CHECK (pacer.pace (30.0f) == 0);
+
+  const uint64_t waited = pacer.pace (30.0f);
+
+  UNX_CHECK (waited > 33000 - 10 && waited <= 33334);
+
+  // Unlimited
+  UNX_CHECK (pacer.pace (0.0f) == 0 && pacer.pace (0.0f) == 0);
+
+  // An interrupted sleep drops the schedule
+  pacer.pace (30.0f);
+
+  clock.interrupt_at = clock.t + 10000;
+
+  UNX_CHECK (pacer.pace (30.0f) == 10000);
+
+  clock.interrupt_at = 0;
+
+  UNX_CHECK (pacer.pace (30.0f) == 0);
+
+  // So does a new limit
+  pacer.pace (10.0f);
+
+  UNX_CHECK (pacer.pace (10.0f) == 100000);
+
+  return 0;
+}
@@ -0,0 +1,211 @@
+/**
+ * This file is part of UnX.
+ *
+ * UnX is free software : you can redistribute it
+ * and/or modify it under the terms of the GNU General Public License
+ * as published by The Free Software Foundation, either version 3 of
+ * the License, or (at your option) any later version.
+ *
+ * UnX is distributed in the hope that it will be useful,
+ *
+ * But WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with UnX.
+ *
+ *   If not, see <http://www.gnu.org/licenses/>.
+ *
+**/
+#include "inifile.h"
+#include "test.h"
+
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+using unx::INIFile;
+
+//
+// What iSK_INI did: a map of sections holding a map of keys, plus an
+//   ordered_keys vector that copies every key a second time.
+//
+struct map_ini_s {
+  struct section_s {
+    std::unordered_map <std::wstring, std::wstring> keys;
+    std::vector        <std::wstring>               ordered_keys;
+  };
+
+  std::unordered_map <std::wstring, section_s> sections;
+  std::vector        <std::wstring>            ordered;
+
+  void parse (const std::wstring& text)
+  {
+    section_s* sec = nullptr;
+    size_t     pos = 0;
+
+    while (pos < text.size ())
+    {
+      size_t eol = text.find (L'\n', pos);
+
+      if (eol == std::wstring::npos)
+          eol = text.size ();
+
+      std::wstring line = text.substr (pos, eol - pos);
+                   pos  = eol + 1;
+
+      while ((! line.empty ()) && (line.back () == L'\r' || line.back () == L' '))
+        line.pop_back ();
+
+      if (line.empty ())
+        continue;
+
+      if (line [0] == L'[')
+      {
+        std::wstring name = line.substr (1, line.find (L']') - 1);
+
+        if (! sections.count (name))
+          ordered.push_back (name);
+
+        sec = &sections [name];
+        continue;
+      }
+
+      size_t eq = line.find (L'=');
+
+      if (eq == std::wstring::npos || sec == nullptr)
+        continue;
+
+      std::wstring key = line.substr (0, eq);
+
+      if (sec->keys.emplace (key, line.substr (eq + 1)).second)
+        sec->ordered_keys.push_back (key);
+    }
+  }
+
+  std::wstring write (void)
+  {
+    std::wstring out;
+
+    for (const auto& name : ordered)
+    {
+      section_s& sec = sections [name];
+
+      out += L"[" + name + L"]\r\n";
+
+      for (const auto& key : sec.ordered_keys)
+        out += key + L"=" + sec.keys [key] + L"\r\n";
+
+      out += L"\r\n";
+    }
+
+    return out;
+  }
+};
+
+int
+main (void)
+{
+  constexpr int Sections = 2000;
+  constexpr int Keys     = 50;
+  constexpr int Rounds   = 3;
+
+  std::wstring text;
+
+  for (int s = 0; s < Sections; s++)
+  {
+    text += L"[Section." + std::to_wstring (s) + L"]\r\n";
+
+    for (int k = 0; k < Keys; k++)
+    {
+      text += L"Key"            + std::to_wstring (k)            +
+              L"=Value number " + std::to_wstring (s * Keys + k) + L"\r\n";
+    }
+
+    text += L"\r\n";
+  }
+
+  INIFile gen;
+  gen.import (text);
+
+  gen.set_encoding (INIFile::Encoding_UTF16LE);
+  const std::vector <uint8_t> utf16 = gen.serialize ();
+
+  gen.set_encoding (INIFile::Encoding_UTF8);
+  const std::vector <uint8_t> utf8  = gen.serialize ();
+
+  std::printf ( "synthetic INI: %d sections x %d keys, %.1f MiB UTF-16LE, %.1f MiB UTF-8\n",
+                  Sections, Keys, utf16.size () / 1048576.0, utf8.size () / 1048576.0 );
+
+  double parse8 = 0.0, parse16 = 0.0, lookup = 0.0, write = 0.0;
+  double map_parse = 0.0, map_lookup = 0.0, map_write = 0.0;
+
+  volatile size_t sink = 0;
+
+  for (int r = 0; r < Rounds; r++)
+  {
+    {
+      const double t = UNX_TestSeconds ();
+      INIFile f;
+      f.parse (utf8.data (), utf8.size ());
+      parse8 += UNX_TestSeconds () - t;
+    }
+
+    INIFile f;
+
+    double t = UNX_TestSeconds ();
+    f.parse (utf16.data (), utf16.size ());
+    parse16 += UNX_TestSeconds () - t;
+
+    t = UNX_TestSeconds ();
+    for (int s = 0; s < Sections; s += 7)
+    {
+      const INIFile::section_id id =
+        f.find_section (L"Section." + std::to_wstring (s));
+
+      for (int k = 0; k < Keys; k++)
+        sink += f.value (id, L"Key" + std::to_wstring (k)).size ();
+    }
+    lookup += UNX_TestSeconds () - t;
+
+    t = UNX_TestSeconds ();
+    sink += f.serialize ().size ();
+    write += UNX_TestSeconds () - t;
+
+    // The old engine was handed text that was already decoded
+    map_ini_s m;
+
+    t = UNX_TestSeconds ();
+    m.parse (text);
+    map_parse += UNX_TestSeconds () - t;
+
+    t = UNX_TestSeconds ();
+    for (int s = 0; s < Sections; s += 7)
+    {
+      auto& sec = m.sections [L"Section." + std::to_wstring (s)];
+
+      for (int k = 0; k < Keys; k++)
+        sink += sec.keys [L"Key" + std::to_wstring (k)].size ();
+    }
+    map_lookup += UNX_TestSeconds () - t;
+
+    t = UNX_TestSeconds ();
+    sink += m.write ().size ();
+    map_write += UNX_TestSeconds () - t;
+
+    // Both engines have to agree on what they read
+    UNX_CHECK (f.section_count () == m.ordered.size ());
+  }
+
+  const double ms = 1000.0 / Rounds;
+
+  std::printf ( "INIFile:            parse %.1f ms (UTF-8) / %.1f ms (UTF-16LE), "
+                "lookups %.1f ms, serialize %.1f ms\n",
+                  parse8 * ms, parse16 * ms, lookup * ms, write * ms );
+  std::printf ( "map + ordered_keys: parse %.1f ms (pre-decoded), "
+                "lookups %.1f ms, write %.1f ms\n",
+                  map_parse * ms, map_lookup * ms, map_write * ms );
+
+  return 0;
+}
@@ -0,0 +1,232 @@
+/**
+ * This file is part of UnX.
+ *
+ * UnX is free software : you can redistribute it
+ * and/or modify it under the terms of the GNU General Public License
+ * as published by The Free Software Foundation, either version 3 of
+ * the License, or (at your option) any later version.
+ *
+ * UnX is distributed in the hope that it will be useful,
+ *
+ * But WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with UnX.
+ *
+ *   If not, see <http://www.gnu.org/licenses/>.
+ *
+**/
+#include "inifile.h"
+#include "test.h"
+
+#include <atomic>
+#include <chrono>
+#include <filesystem>
+#include <new>
+#include <thread>
+
+using unx::INIFile;
+
+namespace fs = std::filesystem;
+
+// Counts heap allocations, to show that saving does not keep growing memory
+static std::atomic <uint64_t> allocations { 0 };
+
+void* operator new (size_t size)
+{
+  allocations++;
+
+  if (void* mem = std::malloc (size ? size : 1))
+    return mem;
+
+  throw std::bad_alloc ();
+}
+
+void operator delete (void* mem)         noexcept { std::free (mem); }
+void operator delete (void* mem, size_t) noexcept { std::free (mem); }
+
+static const wchar_t* const Path    = L"inifile_dirty_test.ini";
+static const char*    const PathA   =  "inifile_dirty_test.ini";
+static const char*    const TempA   =  "inifile_dirty_test.ini.tmp";
+
+static void
+test_dirty_tracking (void)
+{
+  fs::remove (PathA);
+  fs::remove (TempA);
+
+  INIFile f;
+
+  UNX_CHECK (! f.load  (Path));
+  UNX_CHECK (! f.dirty ());
+
+  // Creating a section just to read from it is not a change
+  const INIFile::section_id s = f.get_section (L"UnX.Input");
+
+  UNX_CHECK (! f.dirty ());
+
+  UNX_CHECK (f.set_value (s, L"FastExit", L"true"));
+  UNX_CHECK (f.dirty () && f.section_dirty (s));
+
+  UNX_CHECK (  f.save  (Path));
+  UNX_CHECK (! f.dirty ());
+  UNX_CHECK (! fs::exists (TempA));
+
+  // Setting the same value again changes nothing, and saving is skipped
+  const fs::file_time_type written = fs::last_write_time (PathA);
+
+  std::this_thread::sleep_for (std::chrono::milliseconds (20));
+
+  UNX_CHECK (! f.set_value (s, L"FastExit", L"true"));
+  UNX_CHECK (! f.dirty ());
+  UNX_CHECK (  f.save (Path));
+  UNX_CHECK (  fs::last_write_time (PathA) == written);
+
+  // A freshly loaded file is clean
+  INIFile g;
+
+  UNX_CHECK (  g.load  (Path));
+  UNX_CHECK (! g.dirty ());
+
+  const INIFile::section_id gs = g.find_section (L"UnX.Input");
+  const INIFile::section_id o  = g.get_section  (L"Other");
+
+  // Writes through a value reference are seen on the next check, and
+  //   writing the saved value back makes it clean again
+  std::wstring* ref = g.value_ref (gs, L"FastExit");
+
+  UNX_CHECK (! g.dirty ());
+
+  *ref = L"false";
+  UNX_CHECK (g.dirty () && g.section_dirty (gs) && (! g.section_dirty (o)));
+
+  *ref = L"true";
+  UNX_CHECK (! g.dirty ());
+
+  *ref = L"false";
+  g.mark_clean ();
+  UNX_CHECK (! g.dirty ());
+
+  *ref = L"x";
+  UNX_CHECK (g.dirty ());
+  g.mark_clean ();
+
+  UNX_CHECK (  g.add_key_value (o, L"K", L"V"));
+  UNX_CHECK (  g.section_dirty (o));
+  g.mark_clean ();
+
+  UNX_CHECK (! g.add_key_value (o, L"K", L"W"));
+  UNX_CHECK (! g.dirty ());
+
+  UNX_CHECK (g.remove_key (o, L"K"));
+  UNX_CHECK (g.dirty ());
+  g.mark_clean ();
+
+  // Renaming to the same name is what iParameter::store does every time
+  g.rename_section (o, L"Other");
+  UNX_CHECK (! g.dirty ());
+
+  g.rename_section (o, L"Other2");
+  UNX_CHECK (g.dirty ());
+  g.mark_clean ();
+
+  g.import (L"[UnX.Input]\nFastExit=x\n");
+  UNX_CHECK (! g.dirty ());
+
+  g.import (L"[UnX.Input]\nFastExit=y\n");
+  UNX_CHECK (g.dirty ());
+  g.mark_clean ();
+
+  UNX_CHECK (g.remove_section (L"UnX.Input"));
+  UNX_CHECK (g.dirty ());
+  g.mark_clean ();
+  UNX_CHECK (! g.dirty ());
+
+  fs::remove (PathA);
+}
+
+//
+// A save that cannot complete leaves the previous file alone and the INI
+//   dirty; the temp name is taken by a directory to make the write fail.
+//
+static void
+test_atomic_replace (void)
+{
+  fs::remove     (PathA);
+  fs::remove_all (TempA);
+
+  INIFile f;
+  const INIFile::section_id s = f.get_section (L"A");
+
+  f.set_value (s, L"k", L"1");
+  UNX_CHECK   (f.save (Path));
+
+  fs::create_directory (TempA);
+
+  f.set_value (s, L"k", L"2");
+
+  UNX_CHECK (! f.save  (Path));
+  UNX_CHECK (  f.dirty ());
+
+  INIFile before;
+  before.load (Path);
+  UNX_CHECK (before.value (before.find_section (L"A"), L"k") == L"1");
+
+  fs::remove (TempA);
+
+  UNX_CHECK (f.save (Path));
+
+  INIFile after;
+  after.load (Path);
+  UNX_CHECK (after.value (after.find_section (L"A"), L"k") == L"2");
+
+  fs::remove (PathA);
+}
+
+//
+// Watched values are compared against their last saved text; saving over
+//   and over must reuse that copy rather than keep adding new ones.
+//
+static void
+test_repeated_saves (void)
+{
+  INIFile f;
+
+  const INIFile::section_id s = f.get_section (L"Window");
+
+  std::wstring long_value (96, L'a');
+
+  f.set_value (s, L"Position", long_value);
+
+  std::wstring* ref = f.value_ref (s, L"Position");
+
+  // The first round may size things up
+  (*ref) [0] = L'b';
+  f.mark_clean ();
+
+  const uint64_t before = allocations.load ();
+
+  for (int i = 0; i < 10000; i++)
+  {
+    wchar_t& ch = (*ref) [i % ref->size ()];
+             ch = (ch == L'a') ? L'b' : L'a';
+
+    UNX_CHECK (f.dirty ());
+    f.mark_clean ();
+    UNX_CHECK (! f.dirty ());
+  }
+
+  UNX_CHECK (allocations.load () == before);
+}
+
+int
+main (void)
+{
+  test_dirty_tracking ();
+  test_atomic_replace ();
+  test_repeated_saves ();
+
+  return 0;
+}
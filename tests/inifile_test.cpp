@@ -0,0 +1,162 @@
+/**
+ * This file is part of UnX.
+ *
+ * UnX is free software : you can redistribute it
+ * and/or modify it under the terms of the GNU General Public License
+ * as published by The Free Software Foundation, either version 3 of
+ * the License, or (at your option) any later version.
+ *
+ * UnX is distributed in the hope that it will be useful,
+ *
+ * But WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with UnX.
+ *
+ *   If not, see <http://www.gnu.org/licenses/>.
+ *
+**/
+#include "inifile.h"
+#include "test.h"
+
+#include <cstring>
+#include <string>
+#include <vector>
+
+using unx::INIFile;
+
+static std::vector <uint8_t>
+Bytes (const char* text)
+{
+  return std::vector <uint8_t> (text, text + strlen (text));
+}
+
+static void
+test_parse_and_edit (void)
+{
+  const std::vector <uint8_t> data =
+    Bytes ( "[UnX.Input]\r\nFastExit = true\r\nGamepadSlot=-1\r\n; comment\r\n"
+            "[Other]\nKey=Caf\xc3\xa9 \xf0\x9f\x98\x80\n"
+            "[UnX.Input]\nFastExit=false\nNew=1\n" );
+
+  INIFile f;
+  f.parse (data.data (), data.size ());
+
+  UNX_CHECK (f.encoding      () == INIFile::Encoding_UTF8);
+  UNX_CHECK (f.section_count () == 2);
+
+  // A repeated section merges into the first; the first value of a key wins
+  const INIFile::section_id input = f.find_section (L"UnX.Input");
+
+  UNX_CHECK (input != INIFile::npos);
+  UNX_CHECK (f.value     (input, L"FastExit") == L"true");
+  UNX_CHECK (f.key_count (input)              == 3);
+
+  // Multi-byte and astral characters survive decoding
+  const INIFile::section_id other = f.find_section (L"Other");
+  const std::wstring        key   (f.value (other, L"Key"));
+
+  UNX_CHECK (key.size () == (sizeof (wchar_t) == 2 ? 7u : 6u));
+  UNX_CHECK (key [3] == 0xE9);
+
+  std::wstring* slot = f.value_ref (input, L"GamepadSlot");
+  *slot = L"2";
+
+  UNX_CHECK (f.value (input, L"GamepadSlot") == L"2");
+
+  UNX_CHECK (! f.add_key_value (input, L"FastExit", L"x"));
+  UNX_CHECK (  f.add_key_value (input, L"Added",    L"y"));
+
+  f.set_value (input, L"FastExit", L"no");
+  UNX_CHECK (f.value (input, L"FastExit") == L"no");
+
+  UNX_CHECK (  f.remove_key   (input, L"New"));
+  UNX_CHECK (! f.contains_key (input, L"New"));
+  UNX_CHECK (  f.contains_key (input, L"Added"));
+  UNX_CHECK (*slot == L"2");
+
+  f.import (L"[Other]\nKey=replaced\n[Third]\nA=B\n");
+
+  UNX_CHECK (f.value (other, L"Key") == L"replaced");
+  UNX_CHECK (f.section_count ()      == 3);
+
+  f.rename_section (other, L"Renamed");
+
+  UNX_CHECK (f.find_section (L"Other")   == INIFile::npos);
+  UNX_CHECK (f.find_section (L"Renamed") == other);
+
+  UNX_CHECK (f.remove_section (L"Third"));
+  UNX_CHECK (f.section_count () == 2);
+
+  // Every encoding round-trips byte for byte, keeping key order
+  for ( auto enc : { INIFile::Encoding_UTF8,    INIFile::Encoding_UTF8BOM,
+                     INIFile::Encoding_UTF16LE, INIFile::Encoding_UTF16BE } )
+  {
+    f.set_encoding (enc);
+
+    const std::vector <uint8_t> bytes = f.serialize ();
+
+    INIFile g;
+    g.parse (bytes.data (), bytes.size ());
+
+    UNX_CHECK (g.encoding  () == enc);
+    UNX_CHECK (g.serialize () == bytes);
+
+    const INIFile::section_id gs = g.find_section (L"UnX.Input");
+
+    UNX_CHECK (g.value (gs, L"GamepadSlot") == L"2");
+
+    std::vector <std::wstring> keys;
+    g.for_each_key (gs, [&] (std::wstring_view k, std::wstring_view) { keys.emplace_back (k); });
+
+    UNX_CHECK ((keys == std::vector <std::wstring> { L"FastExit", L"GamepadSlot", L"Added" }));
+  }
+
+  // Files
+  f.set_encoding (INIFile::Encoding_UTF16BE);
+
+  UNX_CHECK (f.write (L"inifile_test.ini"));
+
+  INIFile g;
+  UNX_CHECK (g.load (L"inifile_test.ini"));
+  UNX_CHECK (g.serialize () == f.serialize ());
+
+  INIFile missing;
+  UNX_CHECK (! missing.load (L"inifile_test.missing.ini"));
+  UNX_CHECK (missing.section_count () == 0);
+
+  remove ("inifile_test.ini");
+}
+
+static void
+test_astral_utf16 (void)
+{
+  const std::vector <uint8_t> data =
+    Bytes ("[S]\nK=\xf0\x9f\x98\x80\n");
+
+  INIFile f;
+  f.parse        (data.data (), data.size ());
+  f.set_encoding (INIFile::Encoding_UTF16LE);
+
+  const std::vector <uint8_t> le = f.serialize ();
+
+  INIFile g;
+  g.parse        (le.data (), le.size ());
+  g.set_encoding (INIFile::Encoding_UTF8);
+
+  const std::vector <uint8_t> u8 = g.serialize ();
+
+  UNX_CHECK ( std::string (u8.begin (), u8.end ()) ==
+                "[S]\r\nK=\xf0\x9f\x98\x80\r\n\r\n" );
+}
+
+int
+main (void)
+{
+  test_parse_and_edit ();
+  test_astral_utf16   ();
+
+  return 0;
+}
@@ -0,0 +1,205 @@
+/**
+ * This file is part of UnX.
+ *
+ * UnX is free software : you can redistribute it
+ * and/or modify it under the terms of the GNU General Public License
+ * as published by The Free Software Foundation, either version 3 of
+ * the License, or (at your option) any later version.
+ *
+ * UnX is distributed in the hope that it will be useful,
+ *
+ * But WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with UnX.
+ *
+ *   If not, see <http://www.gnu.org/licenses/>.
+ *
+**/
+#include "inifile.h"
+#include "test.h"
+
+#include <cstring>
+#include <string>
+#include <vector>
+
+using unx::INIFile;
+
+static void
+Parse (INIFile& ini, const char* text)
+{
+  ini.parse ((const uint8_t *)text, strlen (text));
+}
+
+static std::wstring
+Value (const INIFile& ini, const wchar_t* section, const wchar_t* key)
+{
+  return std::wstring (ini.value (ini.find_section (section), key));
+}
+
+static void
+test_handles (void)
+{
+  static const char* text = "[A]\nx=1\ny=2\n[B]\nz=3\n";
+
+  INIFile ini;
+  Parse (ini, text);
+
+  // The names are not copied; they have to outlive the handles
+  static const std::wstring a = L"A", b = L"B", c = L"C";
+  static const std::wstring x = L"x", q = L"q", z = L"z";
+
+  auto hx = ini.handle (a, x);
+  auto hq = ini.handle (a, q);
+  auto hc = ini.handle (c, z);
+  auto hz = ini.handle (b, z);
+
+  std::wstring_view v;
+
+  UNX_CHECK (  ini.find_value (hx, v) && v == L"1");
+  UNX_CHECK (! ini.find_value (hq, v));
+  UNX_CHECK (! ini.find_value (hc, v));
+
+  // A key added by name later is found through the handle
+  ini.set_value (ini.get_section (L"A"), L"q", L"7");
+  UNX_CHECK (ini.find_value (hq, v) && v == L"7");
+
+  // set_value through a handle creates the section and key
+  UNX_CHECK (ini.set_value (hc, L"9") && Value (ini, L"C", L"z") == L"9");
+  UNX_CHECK (ini.find_value (hc, v) && v == L"9");
+
+  UNX_CHECK (! ini.set_value (hx, L"1"));
+  UNX_CHECK (  ini.set_value (hx, L"5") && Value (ini, L"A", L"x") == L"5");
+
+  // Removing, renaming and reloading make handles look their key up again
+  ini.remove_key (ini.find_section (L"A"), L"x");
+  UNX_CHECK (! ini.find_value (hx, v));
+  ini.set_value (hx, L"6");
+  UNX_CHECK (Value (ini, L"A", L"x") == L"6");
+
+  ini.remove_section (L"B");
+  UNX_CHECK (! ini.find_value (hz, v));
+  ini.set_value (hz, L"8");
+  UNX_CHECK (Value (ini, L"B", L"z") == L"8");
+
+  ini.rename_section (ini.find_section (L"A"), L"AA");
+  UNX_CHECK (! ini.find_value (hq, v));
+
+  Parse (ini, text);
+  UNX_CHECK (ini.find_value (hx, v) && v == L"1");
+  UNX_CHECK (ini.find_value (hz, v) && v == L"3");
+}
+
+//
+// 240 settings in 12 sections, read and written the way iParameter did
+//   before it kept handles (by name, building a wstring for every call) and
+//     the way it does now.
+//
+static void
+bench (void)
+{
+  constexpr int Iters = 2000;
+
+  struct param_s {
+    std::wstring         section;
+    std::wstring         key;
+    std::wstring         value;
+    INIFile::key_handle_s handle;
+  };
+
+  std::string           text;
+  std::vector <param_s> params;
+
+  params.reserve (240);
+
+  for (int s = 0; s < 12; s++)
+  {
+    text += "[Section.Number" + std::to_string (s) + "]\n";
+
+    for (int k = 0; k < 20; k++)
+    {
+      text += "SomeSettingName" + std::to_string (k) + "=value" + std::to_string (k) + "\n";
+
+      params.push_back ( { L"Section.Number"  + std::to_wstring (s),
+                           L"SomeSettingName" + std::to_wstring (k) } );
+    }
+  }
+
+  INIFile ini;
+  Parse (ini, text.c_str ());
+
+  for (auto& p : params)
+    p.handle = ini.handle (p.section, p.key);
+
+  volatile size_t sink = 0;
+
+  double t = UNX_TestSeconds ();
+  for (int i = 0; i < Iters; i++)
+  {
+    for (auto& p : params)
+    {
+      const INIFile::section_id sec =
+        ini.get_section (std::wstring (p.section.c_str ()));
+
+      if (ini.contains_key (sec, std::wstring (p.key.c_str ())))
+        p.value = std::wstring (ini.value (sec, std::wstring (p.key.c_str ())));
+
+      sink += p.value.size ();
+    }
+  }
+  const double load_names = UNX_TestSeconds () - t;
+
+  t = UNX_TestSeconds ();
+  for (int i = 0; i < Iters; i++)
+  {
+    for (auto& p : params)
+    {
+      std::wstring_view v;
+
+      if (ini.find_value (p.handle, v))
+        p.value = std::wstring (v);
+
+      sink += p.value.size ();
+    }
+  }
+  const double load_handles = UNX_TestSeconds () - t;
+
+  t = UNX_TestSeconds ();
+  for (int i = 0; i < Iters; i++)
+  {
+    for (auto& p : params)
+    {
+      const INIFile::section_id sec =
+        ini.get_section (std::wstring (p.section.c_str ()));
+
+      ini.set_value (sec, std::wstring (p.key.c_str ()), std::wstring (p.value));
+    }
+  }
+  const double store_names = UNX_TestSeconds () - t;
+
+  t = UNX_TestSeconds ();
+  for (int i = 0; i < Iters; i++)
+  {
+    for (auto& p : params)
+      ini.set_value (p.handle, p.value);
+  }
+  const double store_handles = UNX_TestSeconds () - t;
+
+  const double n = 1e9 / ((double)Iters * params.size ());
+
+  std::printf ( "load:  names %.1f ns, handles %.1f ns per setting\n"
+                "store: names %.1f ns, handles %.1f ns per setting\n",
+                  load_names  * n, load_handles  * n,
+                  store_names * n, store_handles * n );
+}
+
+int
+main (void)
+{
+  test_handles ();
+  bench        ();
+
+  return 0;
+}
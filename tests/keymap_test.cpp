@@ -0,0 +1,76 @@
+/**
+ * This file is part of UnX.
+ *
+ * UnX is free software : you can redistribute it
+ * and/or modify it under the terms of the GNU General Public License
+ * as published by The Free Software Foundation, either version 3 of
+ * the License, or (at your option) any later version.
+ *
+ * UnX is distributed in the hope that it will be useful,
+ *
+ * But WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with UnX.
+ *
+ *   If not, see <http://www.gnu.org/licenses/>.
+ *
+**/
+#include "keymap.h"
+#include "test.h"
+
+static int hits [3];
+
+static void Bind0 (void) { hits [0]++; }
+static void Bind1 (void) { hits [1]++; }
+static void Bind2 (void) { hits [2]++; }
+
+static constexpr uint32_t
+Mask (uint32_t vk, uint32_t ctrl, uint32_t shift, uint32_t alt)
+{
+  return vk | (ctrl << 9) | (shift << 10) | (alt << 11);
+}
+
+using binding_s = unx::KeyDispatchTable::binding_s;
+
+static void
+test_lookup (void)
+{
+  static unx::KeyDispatchTable table;
+
+  const binding_s bindings [] = {
+    { Mask ('V', 1, 1, 0), Bind0 },
+    { Mask ('K', 1, 1, 1), Bind1 },
+    { Mask ('V', 1, 1, 0), Bind2 },  // Shadowed by the first one
+    { Mask (0,   1, 0, 0), Bind2 },
+    { 5000,                Bind2 }   // Out of range
+  };
+
+  UNX_CHECK (table.rebuild (bindings, 5) == 1);
+
+  UNX_CHECK (table.lookup (Mask ('V', 1, 1, 0)) == Bind0);
+  UNX_CHECK (table.lookup (Mask ('K', 1, 1, 1)) == Bind1);
+  UNX_CHECK (table.lookup (Mask ('V', 1, 0, 0)) == nullptr);
+  UNX_CHECK (table.lookup (9999)                == nullptr);
+
+  UNX_CHECK (  table.dispatch (Mask ('K', 1, 1, 1)) && hits [1] == 1);
+  UNX_CHECK (! table.dispatch (Mask ('Q', 1, 1, 0)));
+
+  // Rebuilds replace the whole table
+  const binding_s swapped [] = { { Mask ('V', 1, 1, 0), Bind2 } };
+
+  table.rebuild (swapped, 1);
+
+  UNX_CHECK (table.lookup (Mask ('V', 1, 1, 0)) == Bind2);
+  UNX_CHECK (table.lookup (Mask ('K', 1, 1, 1)) == nullptr);
+}
+
+int
+main (void)
+{
+  test_lookup ();
+
+  return 0;
+}
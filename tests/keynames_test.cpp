@@ -0,0 +1,53 @@
+/**
+ * This file is part of UnX.
+ *
+ * UnX is free software : you can redistribute it
+ * and/or modify it under the terms of the GNU General Public License
+ * as published by The Free Software Foundation, either version 3 of
+ * the License, or (at your option) any later version.
+ *
+ * UnX is distributed in the hope that it will be useful,
+ *
+ * But WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with UnX.
+ *
+ *   If not, see <http://www.gnu.org/licenses/>.
+ *
+**/
+#include "keynames.h"
+#include "test.h"
+
+//
+// Every canonical name resolves back to its own VK through the perfect hash,
+//   and near misses (case, empty) resolve to nothing.
+//
+int
+main (void)
+{
+  int names = 0;
+
+  for (int vk = 0; vk < 256; vk++)
+  {
+    const wchar_t* name =
+      unx::keys::CanonicalName ((uint8_t)vk);
+
+    if (name == nullptr)
+      continue;
+
+    UNX_CHECK (unx::keys::VirtualKeyFromName (name) == vk);
+
+    names++;
+  }
+
+  UNX_CHECK (names == 119);
+
+  UNX_CHECK (unx::keys::VirtualKeyFromName (L"")     == 0);
+  UNX_CHECK (unx::keys::VirtualKeyFromName (L"ctrl") == 0);
+  UNX_CHECK (unx::keys::VirtualKeyFromName (L"\\")   == 0xDC);
+
+  return 0;
+}
@@ -0,0 +1,125 @@
+/**
+ * This file is part of UnX.
+ *
+ * UnX is free software : you can redistribute it
+ * and/or modify it under the terms of the GNU General Public License
+ * as published by The Free Software Foundation, either version 3 of
+ * the License, or (at your option) any later version.
+ *
+ * UnX is distributed in the hope that it will be useful,
+ *
+ * But WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with UnX.
+ *
+ *   If not, see <http://www.gnu.org/licenses/>.
+ *
+**/
+#include "latency.h"
+#include "test.h"
+
+#include <algorithm>
+#include <random>
+#include <thread>
+#include <vector>
+
+using unx::LatencyHistogram;
+
+static void
+test_buckets (void)
+{
+  for (uint64_t v = 0; v < 5000000; v += (v < 1000 ? 1 : 997))
+  {
+    const int b = LatencyHistogram::bucket_for (v);
+
+    UNX_CHECK (b >= 0 && b < LatencyHistogram::NumBuckets);
+
+    const uint64_t lo = b ? LatencyHistogram::bucket_upper (b - 1) + 1 : 0;
+    const uint64_t hi =     LatencyHistogram::bucket_upper (b);
+
+    UNX_CHECK (v >= lo && v <= hi);
+  }
+
+  UNX_CHECK (LatencyHistogram::bucket_for (0xFFFFFFFFULL) <  LatencyHistogram::NumBuckets);
+  UNX_CHECK (LatencyHistogram::bucket_for (1ULL << 40)    == LatencyHistogram::NumBuckets - 1);
+}
+
+//
+// Percentiles of a log-normal sample against the exact ones; the histogram
+//   reports bucket upper bounds, so it may only err high, by at most 12.5%.
+//
+static void
+test_percentiles (void)
+{
+  static LatencyHistogram h;
+
+  std::mt19937                         rng (1);
+  std::lognormal_distribution <double> dist (8.0, 1.0);
+  std::vector <uint64_t>               sample;
+
+  for (int i = 0; i < 200000; i++)
+  {
+    const uint64_t us = (uint64_t)dist (rng);
+
+    sample.push_back (us);
+    h.record         (us);
+  }
+
+  std::sort (sample.begin (), sample.end ());
+
+  for (double p : { 0.5, 0.95, 0.99 })
+  {
+    const uint64_t exact = sample [(size_t)(p * sample.size ()) - 1];
+    const uint64_t est   = h.percentile (p);
+    const double   err   = (double)est / (double)exact - 1.0;
+
+    std::printf ( "p%.0f: exact %llu us, reported %llu us (%+.1f%%)\n",
+                    p * 100.0, (unsigned long long)exact,
+                      (unsigned long long)est, err * 100.0 );
+
+    UNX_CHECK (err >= 0.0 && err <= 0.13);
+  }
+
+  UNX_CHECK (h.max   () == sample.back ());
+  UNX_CHECK (h.count () == sample.size ());
+
+  h.reset ();
+
+  UNX_CHECK (h.percentile (0.5) == 0);
+}
+
+static void
+test_concurrent_writers (void)
+{
+  static LatencyHistogram h;
+
+  std::vector <std::thread> writers;
+
+  for (int i = 0; i < 4; i++)
+  {
+    writers.emplace_back ([]
+    {
+      for (int j = 0; j < 100000; j++)
+        h.record (j % 1000);
+    });
+  }
+
+  for (auto& t : writers)
+    t.join ();
+
+  UNX_CHECK (h.count () == 400000);
+  UNX_CHECK (h.max   () == 999);
+}
+
+int
+main (void)
+{
+  test_buckets            ();
+  test_percentiles        ();
+  test_concurrent_writers ();
+
+  return 0;
+}
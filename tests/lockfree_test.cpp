@@ -0,0 +1,130 @@
+/**
+ * This file is part of UnX.
+ *
+ * UnX is free software : you can redistribute it
+ * and/or modify it under the terms of the GNU General Public License
+ * as published by The Free Software Foundation, either version 3 of
+ * the License, or (at your option) any later version.
+ *
+ * UnX is distributed in the hope that it will be useful,
+ *
+ * But WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with UnX.
+ *
+ *   If not, see <http://www.gnu.org/licenses/>.
+ *
+**/
+#include "lockfree.h"
+#include "test.h"
+
+#include <thread>
+#include <vector>
+#include <atomic>
+
+struct event_s {
+  uint32_t producer;
+  uint32_t seq;
+  uint64_t payload;
+};
+
+static void
+test_full_ring (void)
+{
+  static unx::MPSCQueue <event_s, 8> q;
+
+  for (uint32_t i = 0; i < 8; i++)
+    UNX_CHECK (q.try_push ({ 0, i, i }));
+
+  UNX_CHECK (! q.try_push ({ 0, 8, 8 }));
+
+  event_s e;
+  for (uint32_t i = 0; i < 8; i++)
+  {
+    UNX_CHECK (q.try_pop (e) && e.seq == i);
+  }
+
+  UNX_CHECK (! q.try_pop (e));
+  UNX_CHECK (q.empty ());
+}
+
+//
+// Producers spin on a full ring, so every event has to come out exactly once
+//   and in the order its producer pushed it.
+//
+static void
+test_stress (void)
+{
+  constexpr uint32_t Producers = 8;
+  constexpr uint32_t Events    = 100000;
+
+  static unx::MPSCQueue <event_s, 1024> q;
+
+  std::atomic <uint64_t> full_spins { 0 };
+  std::vector <std::thread> producers;
+
+  const double start = UNX_TestSeconds ();
+
+  for (uint32_t p = 0; p < Producers; p++)
+  {
+    producers.emplace_back ([&, p]
+    {
+      uint64_t spins = 0;
+
+      for (uint32_t i = 0; i < Events; )
+      {
+        if (q.try_push ({ p, i, ((uint64_t)p << 32) | i }))
+          i++;
+        else
+        {
+          spins++;
+          std::this_thread::yield ();
+        }
+      }
+
+      full_spins += spins;
+    });
+  }
+
+  uint32_t next [Producers] = { };
+  uint64_t popped           = 0;
+  event_s  e;
+
+  while (popped < (uint64_t)Producers * Events)
+  {
+    if (! q.try_pop (e))
+      continue;
+
+    UNX_CHECK (e.producer < Producers);
+    UNX_CHECK (e.seq      == next [e.producer]);
+    UNX_CHECK (e.payload  == (((uint64_t)e.producer << 32) | e.seq));
+
+    next [e.producer]++;
+    popped++;
+  }
+
+  for (auto& t : producers)
+    t.join ();
+
+  UNX_CHECK (q.empty ());
+
+  const double secs = UNX_TestSeconds () - start;
+
+  std::printf ( "%u producers, %llu events in %.3f s (%.1f M/s), "
+                "%llu pushes found the ring full\n",
+                  Producers, (unsigned long long)popped, secs,
+                    popped / secs / 1e6,
+                      (unsigned long long)full_spins.load () );
+}
+
+int
+main (void)
+{
+  test_full_ring ();
+  test_stress    ();
+
+  return 0;
+}
@@ -0,0 +1,192 @@
+/**
+ * This file is part of UnX.
+ *
+ * UnX is free software : you can redistribute it
+ * and/or modify it under the terms of the GNU General Public License
+ * as published by The Free Software Foundation, either version 3 of
+ * the License, or (at your option) any later version.
+ *
+ * UnX is distributed in the hope that it will be useful,
+ *
+ * But WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with UnX.
+ *
+ *   If not, see <http://www.gnu.org/licenses/>.
+ *
+**/
+#include "logwriter.h"
+#include "test.h"
+
+#include <cstring>
+#include <cwchar>
+#include <string>
+#include <thread>
+#include <vector>
+
+using unx::LogWriter;
+
+//
+// 8 producers and a thread that keeps flushing, against the writer thread.
+//   Every line that was not dropped must reach the file exactly once, in
+//     the order its producer pushed it, and a drop must be reported.
+//
+static void
+test_producers (void)
+{
+  constexpr int Producers = 8;
+  constexpr int Lines     = 20000;
+
+  uint64_t pushed  = 0;
+  uint64_t dropped = 0;
+
+  {
+    LogWriter log;
+
+    UNX_CHECK (log.open (L"logwriter_test.log"));
+
+    std::vector <std::thread> producers;
+
+    for (int p = 0; p < Producers; p++)
+    {
+      producers.emplace_back ([&log, p]
+      {
+        for (int i = 0; i < Lines; i++)
+        {
+          LogWriter::line_s line;
+
+          line.len = (uint32_t)
+            swprintf (line.text, LogWriter::MaxLine, L"p%d %d \xe9\x6f22\U0001F600\n", p, i);
+
+          log.push (line);
+
+          if ((i & 1023) == 0)
+            std::this_thread::yield ();
+        }
+      });
+    }
+
+    // flush (0) finds the writer thread busy now and then; it has to give
+    //   up rather than drain next to it
+    std::thread flusher ([&log]
+    {
+      for (int i = 0; i < 100; i++)
+      {
+        log.flush ((i & 1) ? 0 : 2000);
+        std::this_thread::sleep_for (std::chrono::milliseconds (1));
+      }
+    });
+
+    for (auto& thread : producers)
+      thread.join ();
+
+    flusher.join ();
+
+    const std::wstring long_line =
+      std::wstring (1000, L'x') + L"\n";
+
+    log.push (long_line.c_str (), long_line.size ());
+
+    log.stop  ();
+    log.close ();
+
+    pushed  = log.stats ().pushed;
+    dropped = log.stats ().dropped;
+
+    UNX_CHECK (log.stats ().written   == pushed);
+    UNX_CHECK (log.stats ().truncated == 1);
+    UNX_CHECK (pushed + dropped == (uint64_t)Producers * Lines + 1);
+  }
+
+  FILE* fp = fopen ("logwriter_test.log", "rb");
+  UNX_CHECK (fp != nullptr);
+
+  std::vector <int> last (Producers, -1);
+
+  uint64_t lines   = 0;
+  uint64_t reports = 0;
+  char     buf [2048];
+
+  while (fgets (buf, sizeof (buf), fp))
+  {
+    int p, i;
+
+    if (sscanf (buf, "p%d %d", &p, &i) == 2)
+    {
+      UNX_CHECK (p >= 0 && p < Producers && i > last [p]);
+      UNX_CHECK (strstr (buf, "\xc3\xa9\xe6\xbc\xa2\xf0\x9f\x98\x80\n") != nullptr);
+
+      last [p] = i;
+      lines++;
+    }
+
+    else if (! strncmp (buf, "[  Logger  ]", 12))
+      reports++;
+
+    // The cut line has no newline of its own
+    else
+      UNX_CHECK (strlen (buf) == LogWriter::MaxLine);
+  }
+
+  fclose (fp);
+
+  std::printf ( "pushed %llu, dropped %llu, written %llu, drop reports %llu\n",
+                  (unsigned long long)pushed, (unsigned long long)dropped,
+                    (unsigned long long)lines,  (unsigned long long)reports );
+
+  UNX_CHECK (lines + 1 == pushed);
+  UNX_CHECK ((dropped != 0) == (reports != 0));
+}
+
+// Producers never wait for the file
+static void
+bench (void)
+{
+  constexpr int Iters = 200000;
+
+  LogWriter log;
+
+  UNX_CHECK (log.open (L"logwriter_bench.log"));
+
+  LogWriter::line_s line;
+  line.len = (uint32_t)swprintf (line.text, 64, L"[ Bench ] some typical log line %d\n", 42);
+
+  double worst = 0.0;
+
+  const double start = UNX_TestSeconds ();
+
+  for (int i = 0; i < Iters; i++)
+  {
+    const double t = UNX_TestSeconds ();
+
+    log.push (line);
+
+    const double took = UNX_TestSeconds () - t;
+
+    if (took > worst)
+      worst = took;
+  }
+
+  const double avg =
+    (UNX_TestSeconds () - start) / Iters;
+
+  log.stop  ();
+  log.close ();
+
+  std::printf ( "push: %.0f ns avg, %.1f us worst; %llu of %d dropped, %llu batches\n",
+                  avg * 1e9, worst * 1e6,
+                    (unsigned long long)log.stats ().dropped.load (), Iters,
+                      (unsigned long long)log.stats ().batches.load () );
+}
+
+int
+main (void)
+{
+  test_producers ();
+  bench          ();
+
+  return 0;
+}
@@ -0,0 +1,185 @@
+/**
+ * This file is part of UnX.
+ *
+ * UnX is free software : you can redistribute it
+ * and/or modify it under the terms of the GNU General Public License
+ * as published by The Free Software Foundation, either version 3 of
+ * the License, or (at your option) any later version.
+ *
+ * UnX is distributed in the hope that it will be useful,
+ *
+ * But WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with UnX.
+ *
+ *   If not, see <http://www.gnu.org/licenses/>.
+ *
+**/
+#include "mailbox.h"
+#include "test.h"
+
+#include <thread>
+#include <vector>
+
+static uint64_t
+UNX_TestClock (void)
+{
+  return (uint64_t)(UNX_TestSeconds () * 1e6);
+}
+
+static std::atomic <uint64_t> runs    [4];
+static std::atomic <uint64_t> arg_sum [4];
+
+template <int _N>
+static void
+Count (uint32_t arg)
+{
+  runs    [_N]++;
+  arg_sum [_N] += arg;
+}
+
+static void
+test_coalesce (void)
+{
+  static unx::CommandMailbox <4, 64> mailbox (UNX_TestClock);
+
+  mailbox.set_handler (1, Count <1>);
+
+  // The same command with the same argument runs once per drain
+  mailbox.post (1, 7);
+  mailbox.post (1, 7);
+  mailbox.post (1, 8);
+
+  UNX_CHECK (mailbox.drain () == 2);
+  UNX_CHECK (runs [1] == 2 && arg_sum [1] == 15);
+  UNX_CHECK (mailbox.stats (1).coalesced == 1);
+
+  UNX_CHECK (! mailbox.post (4));
+
+  // Coalescing is per argument, and the last one posted is the last to run
+  static uint32_t order [8];
+  static size_t   ran = 0;
+
+  mailbox.set_handler (2, [](uint32_t arg) { order [ran++] = arg; });
+
+  mailbox.post (2, 1);
+  mailbox.post (2, 2);
+  mailbox.post (2, 1);
+  mailbox.post (2, 2);
+  mailbox.post (2, 1);
+
+  UNX_CHECK (mailbox.drain () == 2);
+  UNX_CHECK (ran == 2 && order [0] == 2 && order [1] == 1);
+  UNX_CHECK (mailbox.stats (2).coalesced == 3);
+}
+
+//
+// A handler that posts its own command again runs on the next drain, not in
+//   a loop inside this one.
+//
+static unx::CommandMailbox <2, 8>* repost_mailbox = nullptr;
+static int                         reposts        = 0;
+
+static void
+Repost (uint32_t)
+{
+  reposts++;
+  repost_mailbox->post (0);
+}
+
+static void
+test_repost_from_handler (void)
+{
+  static unx::CommandMailbox <2, 8> mailbox (UNX_TestClock);
+
+  repost_mailbox = &mailbox;
+  mailbox.set_handler (0, Repost);
+
+  mailbox.post (0);
+
+  UNX_CHECK (mailbox.drain () == 1 && reposts == 1);
+  UNX_CHECK (mailbox.drain () == 1 && reposts == 2);
+}
+
+//
+// Several producers against one draining thread: every post is accounted
+//   for as run, coalesced or dropped, and nothing runs twice.
+//
+static void
+test_producers (void)
+{
+  constexpr int      Producers = 6;
+  constexpr uint32_t Posts     = 100000;
+
+  static unx::CommandMailbox <4, 64> mailbox (UNX_TestClock);
+
+  mailbox.set_handler (0, Count <0>);
+  mailbox.set_handler (1, Count <1>);
+  mailbox.set_handler (2, Count <2>);
+  mailbox.set_handler (3, Count <3>);
+
+  for (auto& r : runs)
+    r = 0;
+
+  std::atomic <bool> done { false };
+
+  std::thread consumer ([&]
+  {
+    while (! done.load ())
+      mailbox.drain ();
+
+    mailbox.drain ();
+  });
+
+  std::vector <std::thread> producers;
+
+  for (int p = 0; p < Producers; p++)
+  {
+    producers.emplace_back ([p]
+    {
+      for (uint32_t i = 0; i < Posts; i++)
+        mailbox.post (i & 3, p * 1000000 + i);
+    });
+  }
+
+  for (auto& t : producers)
+    t.join ();
+
+  done = true;
+  consumer.join ();
+
+  uint64_t posted = 0, executed = 0, coalesced = 0, dropped = 0, ran = 0;
+
+  for (int cmd = 0; cmd < 4; cmd++)
+  {
+    const auto& s = mailbox.stats (cmd);
+
+    posted    += s.posted;
+    executed  += s.executed;
+    coalesced += s.coalesced;
+    dropped   += s.dropped;
+    ran       += runs [cmd];
+  }
+
+  std::printf ( "posted %llu, executed %llu, coalesced %llu, dropped %llu\n",
+                  (unsigned long long)posted,    (unsigned long long)executed,
+                  (unsigned long long)coalesced, (unsigned long long)dropped );
+
+  UNX_CHECK (posted    == (uint64_t)Producers * Posts);
+  UNX_CHECK (executed  +  coalesced + dropped == posted);
+  UNX_CHECK (ran       == executed);
+  UNX_CHECK (mailbox.drain () == 0);
+}
+
+int
+main (void)
+{
+  test_coalesce            ();
+  test_repost_from_handler ();
+  test_producers           ();
+
+  return 0;
+}
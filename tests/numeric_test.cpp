@@ -0,0 +1,229 @@
+/**
+ * This file is part of UnX.
+ *
+ * UnX is free software : you can redistribute it
+ * and/or modify it under the terms of the GNU General Public License
+ * as published by The Free Software Foundation, either version 3 of
+ * the License, or (at your option) any later version.
+ *
+ * UnX is distributed in the hope that it will be useful,
+ *
+ * But WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with UnX.
+ *
+ *   If not, see <http://www.gnu.org/licenses/>.
+ *
+**/
+#include "numeric.h"
+#include "test.h"
+
+#include <cmath>
+#include <cstring>
+#include <cwchar>
+#include <random>
+#include <string>
+#include <vector>
+
+using namespace unx::num;
+
+static std::wstring
+FormatStr (float val)
+{
+  wchar_t str [MaxChars];
+  const size_t len = Format (val, str);
+
+  UNX_CHECK (str [len] == L'\0');
+
+  return std::wstring (str, len);
+}
+
+static std::wstring
+FormatHexStr (uint32_t val)
+{
+  wchar_t str [MaxChars];
+  return std::wstring (str, FormatHex (val, str));
+}
+
+static void
+test_format (void)
+{
+  // Whole numbers keep the ".0" the config files have always had
+  UNX_CHECK (FormatStr (8.0f)    == L"8.0");
+  UNX_CHECK (FormatStr (0.0f)    == L"0.0");
+  UNX_CHECK (FormatStr (0.1f)    == L"0.1");
+  UNX_CHECK (FormatStr (-1.125f) == L"-1.125");
+  UNX_CHECK (FormatStr (1e-7f)   == L"1e-07");
+
+  UNX_CHECK (FormatHexStr (0x6d553cf3) == L"0x6d553cf3");
+  UNX_CHECK (FormatHexStr (0)          == L"0x00000000");
+}
+
+static void
+test_parse (void)
+{
+  int i = 5;
+
+  UNX_CHECK (Parse (L" 42 ",        i) == result_e::Ok && i == 42);
+  UNX_CHECK (Parse (L"+7",          i) == result_e::Ok && i == 7);
+  UNX_CHECK (Parse (L"-2147483648", i) == result_e::Ok && i == INT32_MIN);
+
+  // out is only written on success
+  UNX_CHECK (Parse (L"2147483648",  i) == result_e::OutOfRange && i == INT32_MIN);
+  UNX_CHECK (Parse (L"12abc",       i) == result_e::Invalid);
+  UNX_CHECK (Parse (L"",            i) == result_e::Invalid);
+  UNX_CHECK (Parse (L"+-1",         i) == result_e::Invalid);
+  UNX_CHECK (Parse (L"\xff11",      i) == result_e::Invalid); // Fullwidth 1
+
+  int64_t l = 0;
+
+  UNX_CHECK (Parse (L"1700000000123",        l) == result_e::Ok && l == 1700000000123LL);
+  UNX_CHECK (Parse (L"99999999999999999999", l) == result_e::OutOfRange);
+
+  float f = 0.0f;
+
+  UNX_CHECK (Parse (L"8.0",  f) == result_e::Ok && f == 8.0f);
+  UNX_CHECK (Parse (L"1e5",  f) == result_e::Ok && f == 1e5f);
+  UNX_CHECK (Parse (L"1e99", f) == result_e::OutOfRange);
+  UNX_CHECK (Parse (L"8,5",  f) == result_e::Invalid);
+
+  uint32_t u = 0;
+
+  UNX_CHECK (ParseHex (L"0x6D553CF3",  u) == result_e::Ok && u == 0x6d553cf3);
+  UNX_CHECK (ParseHex (L"ff",          u) == result_e::Ok && u == 255);
+  UNX_CHECK (ParseHex (L"0x123456789", u) == result_e::OutOfRange);
+  UNX_CHECK (ParseHex (L"-1",          u) == result_e::Invalid);
+  UNX_CHECK (ParseHex (L"0x+5",        u) == result_e::Invalid);
+  UNX_CHECK (ParseHex (L"0x",          u) == result_e::Invalid);
+}
+
+// Everything written reads back bit for bit
+static void
+test_round_trip (void)
+{
+  std::mt19937 rng (1);
+
+  for (int k = 0; k < 500000; k++)
+  {
+    const uint32_t bits = rng ();
+    float          val;
+
+    memcpy (&val, &bits, sizeof (val));
+
+    if (! std::isfinite (val))
+      continue;
+
+    float back = 0.0f;
+
+    UNX_CHECK (Parse (FormatStr (val), back) == result_e::Ok);
+    UNX_CHECK (memcmp (&val, &back, sizeof (val)) == 0 || (val == 0.0f && back == 0.0f));
+  }
+
+  for (int k = 0; k < 500000; k++)
+  {
+    wchar_t str [MaxChars];
+
+    const int64_t val = ((int64_t)rng () << 32) | rng ();
+    int64_t       back;
+
+    size_t len = Format (val, str);
+
+    UNX_CHECK (Parse (std::wstring_view (str, len), back) == result_e::Ok && back == val);
+
+    const uint32_t hex = rng ();
+    uint32_t       hex_back;
+
+    len = FormatHex (hex, str);
+
+    UNX_CHECK (ParseHex (std::wstring_view (str, len), hex_back) == result_e::Ok && hex_back == hex);
+  }
+}
+
+// Against the swprintf / wcstod / wcstol calls the config code used before
+static void
+bench (void)
+{
+  constexpr int Iters = 1000000;
+
+  std::mt19937         rng (2);
+  std::vector <float>  vals (1024);
+
+  for (auto& val : vals)
+    val = (rng () % 100000) / 64.0f;
+
+  volatile size_t sink = 0;
+
+  double t = UNX_TestSeconds ();
+  for (int k = 0; k < Iters; k++)
+  {
+    wchar_t str [64];
+    swprintf (str, 64, L"%f", vals [k & 1023]);
+
+    size_t len = wcslen (str);
+
+    while (len > 2 && str [len - 1] == L'0' && str [len - 2] != L'.')
+      str [--len] = L'\0';
+
+    sink += len;
+  }
+  const double format_old = UNX_TestSeconds () - t;
+
+  t = UNX_TestSeconds ();
+  for (int k = 0; k < Iters; k++)
+  {
+    wchar_t str [MaxChars];
+    sink += Format (vals [k & 1023], str);
+  }
+  const double format_new = UNX_TestSeconds () - t;
+
+  t = UNX_TestSeconds ();
+  for (int k = 0; k < Iters; k++)
+    sink += (size_t)wcstod (L"16.25", nullptr);
+  const double float_old = UNX_TestSeconds () - t;
+
+  t = UNX_TestSeconds ();
+  for (int k = 0; k < Iters; k++)
+  {
+    float val = 0.0f;
+    Parse (L"16.25", val);
+    sink += (size_t)val;
+  }
+  const double float_new = UNX_TestSeconds () - t;
+
+  t = UNX_TestSeconds ();
+  for (int k = 0; k < Iters; k++)
+    sink += (size_t)wcstol (L"1700000", nullptr, 10);
+  const double int_old = UNX_TestSeconds () - t;
+
+  t = UNX_TestSeconds ();
+  for (int k = 0; k < Iters; k++)
+  {
+    int val = 0;
+    Parse (L"1700000", val);
+    sink += val;
+  }
+  const double int_new = UNX_TestSeconds () - t;
+
+  const double ns = 1e9 / Iters;
+
+  std::printf ( "float format: swprintf %.1f ns, to_chars %.1f ns\n"
+                "float parse:  wcstod   %.1f ns, from_chars %.1f ns\n"
+                "int parse:    wcstol   %.1f ns, from_chars %.1f ns\n",
+                  format_old * ns, format_new * ns,
+                  float_old  * ns, float_new  * ns,
+                  int_old    * ns, int_new    * ns );
+}
+
+int
+main (void)
+{
+  test_format     ();
+  test_parse      ();
+  test_round_trip ();
+  bench           ();
+
+  return 0;
+}
@@ -0,0 +1,177 @@
+/**
+ * This file is part of UnX.
+ *
+ * UnX is free software : you can redistribute it
+ * and/or modify it under the terms of the GNU General Public License
+ * as published by The Free Software Foundation, either version 3 of
+ * the License, or (at your option) any later version.
+ *
+ * UnX is distributed in the hope that it will be useful,
+ *
+ * But WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with UnX.
+ *
+ *   If not, see <http://www.gnu.org/licenses/>.
+ *
+**/
+#include "rcu.h"
+#include "test.h"
+
+#include <atomic>
+#include <cstdlib>
+#include <string>
+#include <thread>
+#include <vector>
+
+// Counts live copies, so that leaks and double frees show up
+static std::atomic <long> live { 0 };
+
+struct cfg_s {
+  int          a = 0;
+  long         b = 0;
+  std::wstring s = L"0";
+  float        f = 0.0f;
+
+  cfg_s (void)            { live++; }
+  cfg_s (const cfg_s& o) : a (o.a), b (o.b), s (o.s), f (o.f) { live++; }
+ ~cfg_s (void)            { live--; }
+
+  void set (int val)
+  {
+    a = val;
+    b = (long)val * 3;
+    s = std::to_wstring (val);
+    f = (float)val;
+  }
+
+  bool consistent (void) const {
+    return b == (long)a * 3 && s == std::to_wstring (a) && f == (float)a;
+  }
+};
+
+//
+// 12 readers on 8 slots, so some of them always go through the path for a
+//   full slot table, against three writers using publish and update.
+//
+static void
+test_stress (double seconds)
+{
+  {
+    unx::RCU <cfg_s, 8> rcu;
+
+    std::atomic <bool> stop   { false };
+    std::atomic <long> reads  { 0 };
+    std::atomic <long> writes { 0 };
+
+    std::vector <std::thread> threads;
+
+    for (int r = 0; r < 12; r++)
+    {
+      threads.emplace_back ([&]
+      {
+        long n = 0;
+
+        while (! stop)
+        {
+          auto view = rcu.read ();
+
+          UNX_CHECK (view->consistent ());
+
+          // Hold a guard across a yield now and then
+          if ((n & 255) == 0)
+            std::this_thread::yield ();
+
+          UNX_CHECK (view->consistent ());
+
+          n++;
+        }
+
+        reads += n;
+      });
+    }
+
+    for (int w = 0; w < 3; w++)
+    {
+      threads.emplace_back ([&, w]
+      {
+        long n = 0;
+
+        while (! stop)
+        {
+          if (w == 0)
+          {
+            auto next = std::make_unique <cfg_s> (*rcu.read ());
+                 next->set (next->a + 1000);
+
+            rcu.publish (std::move (next));
+          }
+
+          else
+          {
+            rcu.update ([](cfg_s& cfg) { cfg.set (cfg.a + 1); return true;  });
+            rcu.update ([](cfg_s&)     {                      return false; });
+          }
+
+          n++;
+        }
+
+        writes += n;
+      });
+    }
+
+    std::this_thread::sleep_for (std::chrono::duration <double> (seconds));
+    stop = true;
+
+    for (auto& thread : threads)
+      thread.join ();
+
+    const size_t left =
+      rcu.reclaim ();
+
+    std::printf ( "%ld reads, %ld writes; %zu retired left, %ld live\n",
+                    reads.load (), writes.load (), left, live.load () );
+
+    UNX_CHECK (left == 0 && live == 1);
+  }
+
+  UNX_CHECK (live == 0);
+}
+
+// Reclamation waits for a reader that still holds an old version
+static void
+test_reclaim (void)
+{
+  {
+    unx::RCU <cfg_s> rcu;
+
+    auto old = rcu.read ();
+
+    for (int i = 0; i < 10; i++)
+      rcu.update ([](cfg_s& cfg) { cfg.a++; return true; });
+
+    UNX_CHECK (rcu.reclaim () == 10 && old->a == 0);
+    UNX_CHECK (rcu.read ()->a == 10);
+
+    {
+      auto moved = std::move (old);
+      UNX_CHECK (moved->a == 0);
+    }
+
+    UNX_CHECK (rcu.reclaim () == 0);
+  }
+
+  UNX_CHECK (live == 0);
+}
+
+int
+main (int argc, char** argv)
+{
+  test_stress  (argc > 1 ? atof (argv [1]) : 1.0);
+  test_reclaim ();
+
+  return 0;
+}
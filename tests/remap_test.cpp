@@ -0,0 +1,176 @@
+/**
+ * This file is part of UnX.
+ *
+ * UnX is free software : you can redistribute it
+ * and/or modify it under the terms of the GNU General Public License
+ * as published by The Free Software Foundation, either version 3 of
+ * the License, or (at your option) any later version.
+ *
+ * UnX is distributed in the hope that it will be useful,
+ *
+ * But WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with UnX.
+ *
+ *   If not, see <http://www.gnu.org/licenses/>.
+ *
+**/
+#include "remap.h"
+#include "test.h"
+
+#include <cstring>
+#include <random>
+
+using namespace unx::remap;
+
+static void
+test_build (void)
+{
+  //           A   B   X   Y   LB  RB  LT  RT  LS  RS  START BACK
+  int map [] = { 1,  0, 20, 31, -2, -7, -1, -1,  8, 200, -9, 127 };
+
+  joy_remap_s r;
+  const uint32_t rejected = BuildJoyRemap (map, &r);
+
+  // 200 is past rgbButtons, -9 is past the last axis
+  UNX_CHECK (rejected == ((1UL << 9) | (1UL << 10)));
+
+  UNX_CHECK (r.far_count  == 3);
+  UNX_CHECK (r.axis_count == 2);
+  UNX_CHECK (r.shuffle [0] == 1 && r.shuffle [1] == 0);
+  UNX_CHECK (r.shuffle [9] == 9 && r.shuffle [10] == 10);
+
+  uint8_t buttons [MaxSourceButtons] = { };
+  int32_t axes    [MaxAxes]          = { 0, 0, 0, 0, 0, 65535 };
+
+  buttons [1]   = 0x80;
+  buttons [20]  = 0x80;
+  buttons [127] = 0x80;
+
+  ApplyJoyRemap (r, axes, buttons);
+
+  UNX_CHECK (buttons [0]  == 0x80);  // from 1
+  UNX_CHECK (buttons [1]  == 0x00);  // from 0
+  UNX_CHECK (buttons [2]  == 0x80);  // from 20
+  UNX_CHECK (buttons [3]  == 0x00);  // from 31
+  UNX_CHECK (buttons [4]  == 0x00);  // X axis released
+  UNX_CHECK (buttons [5]  == 0x80);  // Rz axis held
+  UNX_CHECK (buttons [11] == 0x80);  // from 127
+}
+
+static void
+test_simd_matches_scalar (void)
+{
+  std::mt19937 rng (28);
+
+  for (int round = 0; round < 2000; round++)
+  {
+    int map [MaxRemappedButtons];
+
+    for (int& m : map)
+      m = (int)(rng () % 40) - 8;
+
+    joy_remap_s r;
+    BuildJoyRemap (map, &r);
+    SetAxisRange  (&r, (int)(rng () % MaxAxes), -1000, 1000);
+
+    for (int t = 0; t < 50; t++)
+    {
+      uint8_t a [MaxSourceButtons], b [MaxSourceButtons];
+      int32_t axes [MaxAxes];
+
+      for (auto& x : a)    x = (uint8_t)rng ();
+      for (auto& x : axes) x = (int32_t)(rng () % 70000) - 2000;
+
+      memcpy (b, a, sizeof a);
+
+      ApplyJoyRemap        (r, axes, a);
+      ApplyJoyRemap_Scalar (r, axes, b);
+
+      UNX_CHECK (memcmp (a, b, sizeof a) == 0);
+    }
+  }
+
+  static const uint8_t blocked [] = { 1, 15, 28, 56, 184, 200, 203, 205, 208 };
+
+  key_mask_s mask;
+  BuildKeyMask (blocked, sizeof blocked, &mask);
+
+  for (int t = 0; t < 1000; t++)
+  {
+    uint8_t in [256], a [256], b [256];
+
+    for (auto& x : in) x = (uint8_t)rng ();
+
+    ApplyKeyMask        (mask, in, a, sizeof in);
+    ApplyKeyMask_Scalar (mask, in, b, sizeof in);
+
+    UNX_CHECK (memcmp (a, b, sizeof a) == 0);
+
+    for (uint8_t key : blocked)
+      UNX_CHECK (a [key] == 0);
+  }
+}
+
+template <typename _Fn>
+static double
+UNX_BenchNs (int iters, _Fn&& fn)
+{
+  const double start = UNX_TestSeconds ();
+
+  for (int i = 0; i < iters; i++)
+    fn (i);
+
+  return (UNX_TestSeconds () - start) * 1e9 / iters;
+}
+
+static void
+bench (void)
+{
+  constexpr int Iters = 2000000;
+
+  int map [] = { 1, 0, 2, 3, -2, -7, 6, 7, 8, 20, 11, 10 };
+
+  joy_remap_s r;
+  BuildJoyRemap (map, &r);
+
+  uint8_t buttons [MaxSourceButtons] = { };
+  int32_t axes    [MaxAxes]          = { };
+
+  volatile uint8_t sink = 0;
+
+  const double joy_simd = UNX_BenchNs (Iters, [&](int i) {
+    ApplyJoyRemap        (r, axes, buttons); sink += buttons [i & 15]; });
+  const double joy_scalar = UNX_BenchNs (Iters, [&](int i) {
+    ApplyJoyRemap_Scalar (r, axes, buttons); sink += buttons [i & 15]; });
+
+  static const uint8_t blocked [] = { 1, 15, 56, 184 };
+
+  key_mask_s mask;
+  BuildKeyMask (blocked, sizeof blocked, &mask);
+
+  uint8_t keys [256] = { };
+
+  const double key_simd = UNX_BenchNs (Iters, [&](int i) {
+    ApplyKeyMask        (mask, keys, keys, 256); sink += keys [i & 255]; });
+  const double key_scalar = UNX_BenchNs (Iters, [&](int i) {
+    ApplyKeyMask_Scalar (mask, keys, keys, 256); sink += keys [i & 255]; });
+
+  std::printf ( "joy remap: %.1f ns (scalar %.1f ns), SSSE3 %s\n"
+                "key mask:  %.1f ns (scalar %.1f ns)\n",
+                  joy_simd, joy_scalar, HasSSSE3 () ? "yes" : "no",
+                    key_simd, key_scalar );
+}
+
+int
+main (void)
+{
+  test_build               ();
+  test_simd_matches_scalar ();
+  bench                    ();
+
+  return 0;
+}
@@ -0,0 +1,378 @@
+/**
+ * This file is part of UnX.
+ *
+ * UnX is free software : you can redistribute it
+ * and/or modify it under the terms of the GNU General Public License
+ * as published by The Free Software Foundation, either version 3 of
+ * the License, or (at your option) any later version.
+ *
+ * UnX is distributed in the hope that it will be useful,
+ *
+ * But WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with UnX.
+ *
+ *   If not, see <http://www.gnu.org/licenses/>.
+ *
+**/
+#include "replay.h"
+#include "latency.h"
+#include "test.h"
+
+#include <random>
+#include <utility>
+#include <vector>
+
+using namespace unx;
+
+static const char* const RecordingPath = "replay_test.rec";
+
+static bool
+Same (const pad_state_s& a, const pad_state_s& b)
+{
+  return a.buttons       == b.buttons       && a.connected     == b.connected     &&
+         a.left_trigger  == b.left_trigger  && a.right_trigger == b.right_trigger &&
+         a.thumb_lx      == b.thumb_lx      && a.thumb_ly      == b.thumb_ly      &&
+         a.thumb_rx      == b.thumb_rx      && a.thumb_ry      == b.thumb_ry;
+}
+
+static std::vector <uint8_t>
+ReadFile (const char* path)
+{
+  std::vector <uint8_t> data;
+
+  if (FILE* fp = fopen (path, "rb"))
+  {
+    uint8_t chunk [4096];
+    size_t  read;
+
+    while ((read = fread (chunk, 1, sizeof chunk, fp)) > 0)
+      data.insert (data.end (), chunk, chunk + read);
+
+    fclose (fp);
+  }
+
+  return data;
+}
+
+using session_t = std::vector <std::pair <uint64_t, pad_state_s>>;
+
+static void
+Record (const session_t& session, uint32_t poll_hz)
+{
+  InputRecorder rec;
+
+  UNX_CHECK (rec.open (fopen (RecordingPath, "wb"), poll_hz, ReplayFlag_Legacy));
+
+  for (const auto& poll : session)
+    rec.append (poll.first, poll.second);
+
+  rec.close ();
+}
+
+static void
+test_round_trip (void)
+{
+  std::mt19937 rng (3);
+  session_t    session;
+  pad_state_s  s;
+  uint64_t     t = 123456789;
+
+  for (int i = 0; i < 50000; i++)
+  {
+    t += 3000 + rng () % 2000;
+
+    if (rng () % 10  == 0) s.buttons      = (uint16_t)rng ();
+    if (rng () % 20  == 0) s.left_trigger = (uint8_t) rng ();
+    if (rng () % 7   == 0) s.thumb_lx     = (int16_t) rng ();
+    if (rng () % 9   == 0) s.thumb_ry     = (int16_t) rng ();
+    if (rng () % 500 == 0) s.connected    = (! s.connected);
+
+    session.emplace_back (t, s);
+  }
+
+  Record (session, 250);
+
+  const std::vector <uint8_t> file =
+    ReadFile (RecordingPath);
+
+  InputReplay replay;
+
+  UNX_CHECK (replay.load (file.data (), file.size ()));
+  UNX_CHECK (replay.header ().poll_hz == 250);
+  UNX_CHECK (replay.header ().flags   == ReplayFlag_Legacy);
+
+  uint64_t    us;
+  pad_state_s out;
+  size_t      n = 0;
+
+  while (replay.next (&us, &out))
+  {
+    UNX_CHECK (n < session.size ());
+    UNX_CHECK (us == session [n].first - session [0].first);
+    UNX_CHECK (Same (out, session [n].second));
+
+    n++;
+  }
+
+  UNX_CHECK (n == session.size ());
+
+  // advance () lands on the last poll at or before each step
+  replay.rewind ();
+
+  uint64_t elapsed = 0;
+  size_t   idx     = 0;
+
+  for (bool more = true; more; )
+  {
+    elapsed += 4000;
+    more     = replay.advance (elapsed, &out);
+
+    while ( idx + 1 < session.size () &&
+            session [idx + 1].first - session [0].first <= elapsed )
+      idx++;
+
+    UNX_CHECK (Same (out, session [idx].second));
+  }
+
+  std::printf ( "%zu bytes for %zu polls (%.2f bytes / poll)\n",
+                  file.size (), session.size (),
+                    (double)file.size () / session.size () );
+
+  // A recording cut off mid-record ends early instead of misreading
+  InputReplay truncated;
+
+  UNX_CHECK (truncated.load (file.data (), file.size () - 1));
+
+  n = 0;
+  while (truncated.next (&us, &out))
+    n++;
+
+  UNX_CHECK (n < session.size ());
+  UNX_CHECK (! truncated.load (file.data (), 8));
+}
+
+//
+// Nothing may sit in the recorder's buffer for much longer than its flush
+//   interval, even if close () is never called.
+//
+static void
+test_timed_flush (void)
+{
+  InputRecorder rec;
+
+  UNX_CHECK (rec.open (fopen (RecordingPath, "wb"), 250));
+  UNX_CHECK (ReadFile (RecordingPath).size () == 16);
+
+  pad_state_s s;
+  uint64_t    t      = 0;
+  size_t      polls  = 0;
+
+  for (; t < InputRecorder::FlushInterval; t += 4000, polls++)
+  {
+    s.buttons = (uint16_t)(t / 100000);
+    rec.append (t, s);
+  }
+
+  UNX_CHECK (ReadFile (RecordingPath).size () == 16);
+
+  rec.append (t, s);
+  polls++;
+
+  UNX_CHECK (ReadFile (RecordingPath).size () > 16);
+
+  // Idle from here on; only sync () is called
+  rec.append (t + 4000, s);
+  polls++;
+
+  const size_t on_disk = ReadFile (RecordingPath).size ();
+
+  rec.sync (t + InputRecorder::FlushInterval / 2);
+  UNX_CHECK (ReadFile (RecordingPath).size () == on_disk);
+
+  rec.sync (t + InputRecorder::FlushInterval);
+
+  const std::vector <uint8_t> file =
+    ReadFile (RecordingPath);
+
+  UNX_CHECK (file.size () > on_disk);
+
+  InputReplay replay;
+  UNX_CHECK  (replay.load (file.data (), file.size ()));
+
+  uint64_t    us;
+  pad_state_s out;
+  size_t      n = 0;
+
+  while (replay.next (&us, &out))
+    n++;
+
+  UNX_CHECK (n == polls);
+
+  rec.close ();
+}
+
+
+//
+// The combo harness: a scripted session is recorded, then replayed a frame
+//   at a time into the same combo matching UNX_PollInput uses. Every press
+//     has to be seen exactly once, no later than the frame after it.
+//
+struct combo_s {
+  uint32_t buttons;
+  bool     state      = false;
+  bool     last_state = false;
+  int      presses    = 0;
+
+  bool poll (const pad_state_s& pad)
+  {
+    last_state = state;
+    state      = PadComboHeld (buttons, pad);
+
+    return state && (! last_state);
+  }
+};
+
+static void
+test_combo_replay (void)
+{
+  const uint32_t PollHz  = 250;
+  const uint64_t PollUs  = 1000000 / PollHz;
+  const uint64_t FrameUs = 16667;
+
+  combo_s combos [] = {
+    { 0x0020 | 0x1000              }, // Back + A
+    { 0x0100 | 0x0200 | 0x0010     }, // LB + RB + Start
+    { 0x0020 | PadCombo_LeftTrigger }, // Back + LT
+    { 0x0001                       }  // D-Pad Up
+  };
+
+  const int Combos = (int)(sizeof combos / sizeof combos [0]);
+
+  // 60 s at PollHz: stick noise throughout, a combo held for 100 ms every
+  //   500 ms, cycling through the list above.
+  std::mt19937 rng (33);
+  session_t    session;
+  int          scripted [Combos] = { };
+
+  std::vector <uint64_t> press_times;
+
+  for (uint64_t t = 0; t < 60000000; t += PollUs)
+  {
+    pad_state_s s;
+                s.connected = true;
+                s.thumb_lx  = (int16_t)(rng () % 2000) - 1000;
+                s.thumb_ly  = (int16_t)(rng () % 2000) - 1000;
+
+    const uint64_t phase = t % 500000;
+    const int      which = (int)(t / 500000) % Combos;
+
+    if (phase >= 200000 && phase < 300000)
+    {
+      s.buttons = (uint16_t)combos [which].buttons;
+
+      if (combos [which].buttons & PadCombo_LeftTrigger)
+        s.left_trigger = 200;
+
+      if (phase == 200000)
+      {
+        scripted    [which]++;
+        press_times.push_back (t);
+      }
+    }
+
+    // A trigger resting below the threshold must not complete a combo
+    else if (phase >= 400000 && phase < 420000 && which == 2)
+    {
+      s.buttons      = 0x0020;
+      s.left_trigger = PadComboTrigger;
+    }
+
+    session.emplace_back (t, s);
+  }
+
+  Record (session, PollHz);
+
+  const std::vector <uint8_t> file =
+    ReadFile (RecordingPath);
+
+  InputReplay replay;
+  UNX_CHECK  (replay.load (file.data (), file.size ()));
+
+  static LatencyHistogram latency;
+
+  pad_state_s pad;
+  size_t      next_press = 0;
+
+  for (uint64_t frame = FrameUs; ; frame += FrameUs)
+  {
+    const bool more =
+      replay.advance (frame, &pad);
+
+    for (auto& combo : combos)
+    {
+      if (combo.poll (pad))
+      {
+        combo.presses++;
+
+        UNX_CHECK (next_press < press_times.size ());
+        UNX_CHECK (frame >= press_times [next_press]);
+
+        latency.record (frame - press_times [next_press++]);
+      }
+    }
+
+    if (! more)
+      break;
+  }
+
+  for (int i = 0; i < Combos; i++)
+    UNX_CHECK (combos [i].presses == scripted [i]);
+
+  UNX_CHECK (latency.max () < FrameUs);
+
+  // Throughput: decode + match every recorded poll, no frame pacing
+  const int    Passes = 20;
+  const double start  = UNX_TestSeconds ();
+
+  uint64_t    us;
+  int         detected = 0;
+
+  for (int pass = 0; pass < Passes; pass++)
+  {
+    replay.rewind ();
+
+    while (replay.next (&us, &pad))
+    {
+      for (auto& combo : combos)
+        detected += combo.poll (pad);
+    }
+  }
+
+  const double secs  = UNX_TestSeconds () - start;
+  const double polls = (double)Passes * session.size ();
+
+  UNX_CHECK (detected == Passes * (int)press_times.size ());
+
+  std::printf ( "combo replay: %zu presses, latency p50 %llu us / max %llu us "
+                "at %llu us frames; %.1f M polls/s\n",
+                  press_times.size (),
+                    (unsigned long long)latency.percentile (0.5),
+                    (unsigned long long)latency.max        (   ),
+                      (unsigned long long)FrameUs, polls / secs / 1e6 );
+}
+
+int
+main (void)
+{
+  test_round_trip   ();
+  test_timed_flush  ();
+  test_combo_replay ();
+
+  remove (RecordingPath);
+
+  return 0;
+}
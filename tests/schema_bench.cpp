@@ -0,0 +1,207 @@
+/**
+ * This file is part of UnX.
+ *
+ * UnX is free software : you can redistribute it
+ * and/or modify it under the terms of the GNU General Public License
+ * as published by The Free Software Foundation, either version 3 of
+ * the License, or (at your option) any later version.
+ *
+ * UnX is distributed in the hope that it will be useful,
+ *
+ * But WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with UnX.
+ *
+ *   If not, see <http://www.gnu.org/licenses/>.
+ *
+**/
+#include "schema.h"
+#include "inifile.h"
+#include "test.h"
+
+#include <cstring>
+#include <memory>
+#include <string>
+#include <vector>
+
+using namespace unx;
+using namespace unx::schema;
+
+static struct {
+  bool         b [12] = { };
+  int          i [6]  = { };
+  int64_t      l      = 0;
+  float        f [6]  = { };
+  std::wstring s [5];
+} cfg;
+
+static constexpr field_s fields [] = {
+  Field (0, L"UnX.Display", L"DisableDPIScaling",   &cfg.b [0]),
+  Field (0, L"UnX.Window",  L"BackgroundFPS",       &cfg.f [0]),
+  Field (0, L"UnX.Render",  L"BypassIntel",         &cfg.b [1]),
+  Field (0, L"UnX.Input",   L"RemapDirectInput",    &cfg.b [2]),
+  Field (0, L"UnX.Input",   L"FixBackgroundInput",  &cfg.b [3]),
+  Field (0, L"UnX.Input",   L"BlockWindows",        &cfg.b [4]),
+  Field (0, L"UnX.Input",   L"GamepadSlot",         &cfg.i [0]),
+  Field (0, L"UnX.Input",   L"GamepadPollingRate",  &cfg.i [1]),
+  Field (0, L"UnX.Input",   L"FastExit",            &cfg.b [5]),
+  Field (0, L"UnX.Input",   L"TrapAltTab",          &cfg.b [6]),
+  Field (0, L"UnX.Textures", L"ResourceRoot",       &cfg.s [0]),
+  Field (0, L"UnX.Textures", L"Dump",               &cfg.b [7]),
+  Field (0, L"UnX.Textures", L"Inject",             &cfg.b [8]),
+  Field (0, L"UnX.System",  L"Version",             &cfg.s [1]),
+  Field (0, L"UnX.System",  L"UpdateCheckInterval", &cfg.i [2]),
+  Field (0, L"UnX.System",  L"UpdateCheckTimeout",  &cfg.i [3]),
+  Field (0, L"UnX.System",  L"LastUpdateCheck",     &cfg.l),
+  Field (1, L"Language.Master", L"Voice",           &cfg.s [2]),
+  Field (1, L"Language.Master", L"SoundEffects",    &cfg.s [3]),
+  Field (1, L"Language.Master", L"Video",           &cfg.s [4]),
+  Field (2, L"Boost.FFX",   L"EntirePartyEarnsAP",  &cfg.b [9]),
+  Field (2, L"SpeedHack.FFX", L"MaxSpeed",          &cfg.f [1]),
+  Field (2, L"SpeedHack.FFX", L"SpeedStep",         &cfg.f [2]),
+  Field (2, L"SpeedHack.FFX", L"SkipDialogAtSpeed", &cfg.f [3]),
+  Field (2, L"Fun.FFX",     L"PlayableSeymour",     &cfg.b [10]),
+};
+
+static const char* texts [] = {
+  "[UnX.Display]\nDisableDPIScaling=false\n[UnX.Window]\nBackgroundFPS=60.0\n"
+  "[UnX.Render]\nBypassIntel=true\n"
+  "[UnX.Input]\nRemapDirectInput=false\nFixBackgroundInput=true\nBlockWindows=true\n"
+  "GamepadSlot=2\nGamepadPollingRate=500\nFastExit=false\nTrapAltTab=true\n"
+  "[UnX.Textures]\nResourceRoot=UnX_Res\nDump=false\nInject=true\n"
+  "[UnX.System]\nVersion=0.8.1\nUpdateCheckInterval=12\nUpdateCheckTimeout=5\n"
+  "LastUpdateCheck=1700000000123\n",
+
+  "[Language.Master]\nVoice=us\nSoundEffects=us\nVideo=jp\n",
+
+  "[Boost.FFX]\nEntirePartyEarnsAP=true\n"
+  "[SpeedHack.FFX]\nMaxSpeed=16.5\nSpeedStep=4.0\nSkipDialogAtSpeed=2.25\n"
+  "[Fun.FFX]\nPlayableSeymour=true\n"
+};
+
+//
+// What UNX_LoadConfig did before: one heap-allocated, virtual parameter per
+//   setting, each converting its value through temporary wstrings.
+//
+struct parameter_s {
+  INIFile*     ini;
+  std::wstring section;
+  std::wstring key;
+
+  virtual ~parameter_s (void) { }
+  virtual void set_value_str (std::wstring str) = 0;
+
+  bool load (void)
+  {
+    const INIFile::section_id sec =
+      ini->find_section (section);
+
+    if (sec == INIFile::npos || (! ini->contains_key (sec, key)))
+      return false;
+
+    set_value_str (std::wstring (ini->value (sec, key)));
+
+    return true;
+  }
+};
+
+template <typename _T>
+struct typed_parameter_s : parameter_s {
+  _T* value;
+  void set_value_str (std::wstring str) override;
+};
+
+template <> void typed_parameter_s <bool>::set_value_str (std::wstring str) {
+  *value = (str == L"1" || str == L"true" || str == L"True");
+}
+template <> void typed_parameter_s <int>::set_value_str (std::wstring str) {
+  *value = (int)wcstol (str.c_str (), nullptr, 10);
+}
+template <> void typed_parameter_s <int64_t>::set_value_str (std::wstring str) {
+  *value = wcstoll (str.c_str (), nullptr, 10);
+}
+template <> void typed_parameter_s <float>::set_value_str (std::wstring str) {
+  *value = (float)wcstod (str.c_str (), nullptr);
+}
+template <> void typed_parameter_s <std::wstring>::set_value_str (std::wstring str) {
+  *value = str;
+}
+
+template <typename _T>
+static std::unique_ptr <parameter_s>
+MakeParameter (const field_s& field, INIFile* const* files)
+{
+  auto param = std::make_unique <typed_parameter_s <_T>> ();
+
+  param->ini     = files [field.file];
+  param->section = field.section;
+  param->key     = field.key;
+  param->value   = static_cast <_T *> (field.value);
+
+  return param;
+}
+
+static size_t
+LoadParameters (INIFile* const* files)
+{
+  std::vector <std::unique_ptr <parameter_s>> params;
+
+  for (const auto& field : fields)
+  {
+    switch (field.type)
+    {
+      case type_e::Bool:  params.push_back (MakeParameter <bool>         (field, files)); break;
+      case type_e::Int:   params.push_back (MakeParameter <int>          (field, files)); break;
+      case type_e::Int64: params.push_back (MakeParameter <int64_t>      (field, files)); break;
+      case type_e::Float: params.push_back (MakeParameter <float>        (field, files)); break;
+      default:            params.push_back (MakeParameter <std::wstring> (field, files)); break;
+    }
+  }
+
+  size_t found = 0;
+
+  for (auto& param : params)
+    found += param->load ();
+
+  return found;
+}
+
+int
+main (void)
+{
+  constexpr int Iters = 200000;
+
+  INIFile files [3];
+
+  for (int i = 0; i < 3; i++)
+    files [i].parse ((const uint8_t *)texts [i], strlen (texts [i]));
+
+  INIFile* ptrs [] = { &files [0], &files [1], &files [2] };
+
+  constexpr size_t Count = sizeof (fields) / sizeof (fields [0]);
+
+  // Both have to find every setting
+  UNX_CHECK (Load           (fields, ptrs) == Count);
+  UNX_CHECK (LoadParameters (ptrs)         == Count);
+  UNX_CHECK (cfg.l == 1700000000123LL && cfg.f [3] == 2.25f && cfg.s [2] == L"us");
+
+  volatile size_t sink = 0;
+
+  double t = UNX_TestSeconds ();
+  for (int i = 0; i < Iters; i++)
+    sink += Load (fields, ptrs);
+  const double schema = UNX_TestSeconds () - t;
+
+  t = UNX_TestSeconds ();
+  for (int i = 0; i < Iters; i++)
+    sink += LoadParameters (ptrs);
+  const double params = UNX_TestSeconds () - t;
+
+  std::printf ( "load %zu settings: schema %.2f us, parameters %.2f us\n",
+                  Count, schema * 1e6 / Iters, params * 1e6 / Iters );
+
+  return 0;
+}
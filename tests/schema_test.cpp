@@ -0,0 +1,204 @@
+/**
+ * This file is part of UnX.
+ *
+ * UnX is free software : you can redistribute it
+ * and/or modify it under the terms of the GNU General Public License
+ * as published by The Free Software Foundation, either version 3 of
+ * the License, or (at your option) any later version.
+ *
+ * UnX is distributed in the hope that it will be useful,
+ *
+ * But WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with UnX.
+ *
+ *   If not, see <http://www.gnu.org/licenses/>.
+ *
+**/
+#include "schema.h"
+#include "inifile.h"
+#include "test.h"
+
+#include <cstring>
+#include <string>
+#include <vector>
+
+using namespace unx;
+using namespace unx::schema;
+
+static const uint8_t Flag_FFX = Flag_User;
+
+static struct {
+  bool         dpi     = true;
+  float        bg_fps  = 30.0f;
+  int          slot    = -1;
+  int64_t      last    = 0;
+  uint32_t     mask    = 0;
+  std::wstring root    = L"UnX_Res";
+  std::wstring version = L"0.9";
+  std::wstring voice   = L"jp";
+  bool         ap      = false;
+  float        speed   = 8.0f;
+} cfg;
+
+static std::wstring current_version = L"1.0";
+
+static constexpr field_s fields [] = {
+  Field (0, L"UnX.Display", L"DisableDPIScaling", &cfg.dpi,     Flag_Load),
+  Field (0, L"UnX.Window",  L"BackgroundFPS",     &cfg.bg_fps),
+  Field (0, L"UnX.Input",   L"GamepadSlot",       &cfg.slot),
+  Field (0, L"UnX.Input",   L"BlockedKeys",       &cfg.mask),
+  Field (0, L"UnX.System",  L"LastUpdateCheck",   &cfg.last),
+  Field (0, L"UnX.System",  L"ResourceRoot",      &cfg.root),
+  Field (0, L"UnX.System",  L"Version",           &cfg.version, Flag_Load),
+  Field (0, L"UnX.System",  L"Version",           &current_version, Flag_Store),
+  Field (1, L"Language",    L"Voice",             &cfg.voice),
+  Field (2, L"Boost.FFX",   L"EntirePartyEarnsAP", &cfg.ap,     Flag_LoadStore | Flag_FFX),
+  Field (2, L"Boost.FFX",   L"MaxSpeed",          &cfg.speed,   Flag_LoadStore | Flag_FFX),
+};
+
+static void
+Parse (INIFile& ini, const char* text)
+{
+  ini.parse ((const uint8_t *)text, strlen (text));
+}
+
+static std::wstring
+Value (const INIFile& ini, const wchar_t* section, const wchar_t* key)
+{
+  return std::wstring (ini.value (ini.find_section (section), key));
+}
+
+static void
+test_load (void)
+{
+  INIFile main_ini, lang, boost;
+
+  Parse (main_ini, "[UnX.Display]\nDisableDPIScaling=FALSE\n"
+                   "[UnX.Window]\nBackgroundFPS=60.0\n"
+                   "[UnX.Input]\nGamepadSlot=2\nBlockedKeys=0x0000ff01\n"
+                   "[UnX.System]\nLastUpdateCheck=1700000000123\nResourceRoot=Res Dir\nVersion=0.8.1\n");
+  Parse (lang,     "[Language]\nVoice=us\n");
+  Parse (boost,    "[Boost.FFX]\nEntirePartyEarnsAP=true\nMaxSpeed=16.5\n");
+
+  INIFile* files [] = { &main_ini, &lang, &boost };
+
+  // Store-only Version is not read, the FFX fields are skipped
+  UNX_CHECK (Load (fields, files, Flag_FFX) == 8);
+
+  UNX_CHECK (! cfg.dpi && cfg.bg_fps == 60.0f && cfg.slot == 2 && cfg.mask == 0xff01);
+  UNX_CHECK (cfg.last == 1700000000123LL && cfg.root == L"Res Dir");
+  UNX_CHECK (cfg.version == L"0.8.1" && cfg.voice == L"us");
+  UNX_CHECK (! cfg.ap && cfg.speed == 8.0f);
+
+  UNX_CHECK (Load (fields, files) == 10);
+  UNX_CHECK (cfg.ap && cfg.speed == 16.5f);
+
+  // A value that does not parse leaves the variable alone
+  Parse (main_ini, "[UnX.Input]\nGamepadSlot=two\n");
+
+  UNX_CHECK (Load (fields, files, Flag_FFX) == 1 && cfg.slot == 2);
+}
+
+static void
+test_store (void)
+{
+  INIFile main_ini, lang, boost;
+
+  Parse (main_ini, "[UnX.Window]\nBackgroundFPS=60.0\n");
+
+  INIFile* files [] = { &main_ini, &lang, &boost };
+
+  main_ini.mark_clean ();
+
+  cfg.bg_fps = 60.0f;
+
+  // Everything but the load-only field and the skipped group is written
+  Store (fields, files, Flag_FFX);
+
+  UNX_CHECK (Value (main_ini, L"UnX.Window", L"BackgroundFPS") == L"60.0");
+  UNX_CHECK (Value (main_ini, L"UnX.System", L"Version")       == L"1.0");
+  UNX_CHECK (Value (main_ini, L"UnX.Input",  L"BlockedKeys")   == L"0x0000ff01");
+  UNX_CHECK (Value (lang,     L"Language",   L"Voice")         == L"us");
+  UNX_CHECK (main_ini.find_section (L"UnX.Display") == INIFile::npos);
+  UNX_CHECK (boost.section_count () == 0);
+
+  // Nothing changed since, so nothing does now
+  UNX_CHECK (Store (fields, files, Flag_FFX) == 0);
+
+  cfg.slot = 3;
+
+  UNX_CHECK (Store (fields, files, Flag_FFX) == 1);
+  UNX_CHECK (Value (main_ini, L"UnX.Input", L"GamepadSlot") == L"3");
+
+  // A null file skips its fields
+  INIFile* partial [] = { &main_ini, nullptr, nullptr };
+
+  cfg.voice = L"fr";
+
+  UNX_CHECK (Store (fields, partial) == 0);
+  UNX_CHECK (Value (lang, L"Language", L"Voice") == L"us");
+}
+
+static void
+test_load_changes (void)
+{
+  INIFile incoming;
+
+  Parse (incoming, "[UnX.Window]\nBackgroundFPS=60.0\n[UnX.Input]\nGamepadSlot=1\n");
+
+  cfg.bg_fps = 60.0f;
+  cfg.slot   = 3;
+
+  std::vector <const field_s *> changed;
+
+  UNX_CHECK (LoadChanges (fields, 0, incoming, 0, &changed) == 1);
+  UNX_CHECK (changed.size () == 1 && changed [0] == &fields [2] && cfg.slot == 1);
+}
+
+static void
+test_format (void)
+{
+  std::wstring text;
+
+  float   f     = 0.5f;
+  field_s field = Field (0, L"", L"", &f);
+
+  Format (field, text); UNX_CHECK (text == L"0.5");
+  f = 8.0f;
+  Format (field, text); UNX_CHECK (text == L"8.0");
+  f = -1.125f;
+  Format (field, text); UNX_CHECK (text == L"-1.125");
+
+  int64_t l = -9000000000LL;
+  Format (Field (0, L"", L"", &l), text);
+  UNX_CHECK (text == L"-9000000000");
+
+  bool b = false;
+  field  = Field (0, L"", L"", &b);
+
+  UNX_CHECK (schema::Parse (field, L"True") && b);
+  UNX_CHECK (schema::Parse (field, L"yes")  && ! b);
+  Format (field, text); UNX_CHECK (text == L"false");
+
+  uint32_t h = 0;
+  field      = Field (0, L"", L"", &h);
+
+  UNX_CHECK (  schema::Parse (field, L"0x1F") && h == 0x1f);
+  UNX_CHECK (  schema::Parse (field, L"20")   && h == 0x20);
+  UNX_CHECK (! schema::Parse (field, L"0xZ")  && h == 0x20);
+}
+
+int
+main (void)
+{
+  test_load         ();
+  test_store        ();
+  test_load_changes ();
+  test_format       ();
+
+  return 0;
+}
@@ -0,0 +1,170 @@
+/**
+ * This file is part of UnX.
+ *
+ * UnX is free software : you can redistribute it
+ * and/or modify it under the terms of the GNU General Public License
+ * as published by The Free Software Foundation, either version 3 of
+ * the License, or (at your option) any later version.
+ *
+ * UnX is distributed in the hope that it will be useful,
+ *
+ * But WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with UnX.
+ *
+ *   If not, see <http://www.gnu.org/licenses/>.
+ *
+**/
+#include "seqlock.h"
+#include "test.h"
+
+#include <atomic>
+#include <thread>
+#include <vector>
+
+//
+// Shaped like unx_hot_config_s; every field is derived from one counter, so
+//   a copy that mixes two publishes does not add up.
+//
+struct hot_s {
+  float background_fps  = 0.0f;
+  int   gamepad_slot    = 0;
+  int   gamepad_poll_hz = 0;
+
+  bool  remap_dinput8   = false;
+  bool  fast_exit       = false;
+  bool  fix_bg_input    = false;
+  bool  trap_alt_tab    = false;
+};
+
+static hot_s
+Make (int n)
+{
+  hot_s hot;
+
+  hot.background_fps  = (float)n;
+  hot.gamepad_slot    = n;
+  hot.gamepad_poll_hz = -n;
+  hot.remap_dinput8   = (n & 1) != 0;
+  hot.fast_exit       = (n & 1) == 0;
+  hot.fix_bg_input    = (n & 2) != 0;
+  hot.trap_alt_tab    = (n & 2) == 0;
+
+  return hot;
+}
+
+static bool
+Consistent (const hot_s& hot)
+{
+  const int n = hot.gamepad_slot;
+
+  return hot.background_fps  == (float)n     &&
+         hot.gamepad_poll_hz == -n           &&
+         hot.remap_dinput8   == ((n & 1) != 0) &&
+         hot.fast_exit       == ((n & 1) == 0) &&
+         hot.fix_bg_input    == ((n & 2) != 0) &&
+         hot.trap_alt_tab    == ((n & 2) == 0);
+}
+
+static void
+test_single_thread (void)
+{
+  unx::SeqLock <hot_s> lock;
+
+  const uint32_t before = lock.sequence ();
+
+  lock.publish (Make (5));
+
+  hot_s hot;
+
+  UNX_CHECK (lock.try_read (hot) && hot.gamepad_slot == 5 && Consistent (hot));
+  UNX_CHECK (lock.sequence () != before && (lock.sequence () & 1) == 0);
+}
+
+// One publisher (the SeqLock allows no more), several readers
+static void
+test_torn_reads (void)
+{
+  constexpr int    Readers = 3;
+  constexpr double Seconds = 0.5;
+
+  static unx::SeqLock <hot_s> lock;
+
+  lock.publish (Make (0));
+
+  std::atomic <bool>     done     { false };
+  std::atomic <uint64_t> reads    { 0 };
+  std::atomic <uint64_t> misses   { 0 };
+  std::atomic <uint64_t> torn     { 0 };
+  std::atomic <uint64_t> backward { 0 };
+
+  std::vector <std::thread> readers;
+
+  for (int r = 0; r < Readers; r++)
+  {
+    readers.emplace_back ([&]
+    {
+      int      last = 0;
+      uint64_t ok   = 0, miss = 0;
+
+      while (! done.load (std::memory_order_relaxed))
+      {
+        hot_s hot;
+
+        if (! lock.try_read (hot))
+        {
+          miss++;
+          continue;
+        }
+
+        if (! Consistent (hot))
+          torn++;
+
+        // Copies never go back in time
+        if (hot.gamepad_slot < last)
+          backward++;
+
+        last = hot.gamepad_slot;
+        ok++;
+      }
+
+      reads  += ok;
+      misses += miss;
+    });
+  }
+
+  // Long enough for the scheduler to preempt the publisher mid-write
+  const double end = UNX_TestSeconds () + Seconds;
+  int          n   = 0;
+
+  while (UNX_TestSeconds () < end)
+  {
+    for (int i = 0; i < 1000; i++)
+      lock.publish (Make (++n));
+  }
+
+  done = true;
+
+  for (auto& thread : readers)
+    thread.join ();
+
+  std::printf ( "%d publishes: %llu reads, %llu gave up after 4 tries\n",
+                  n, (unsigned long long)reads.load (),
+                    (unsigned long long)misses.load () );
+
+  UNX_CHECK (torn     == 0);
+  UNX_CHECK (backward == 0);
+  UNX_CHECK (reads    >  0);
+}
+
+int
+main (void)
+{
+  test_single_thread ();
+  test_torn_reads    ();
+
+  return 0;
+}
@@ -0,0 +1,212 @@
+/**
+ * This file is part of UnX.
+ *
+ * UnX is free software : you can redistribute it
+ * and/or modify it under the terms of the GNU General Public License
+ * as published by The Free Software Foundation, either version 3 of
+ * the License, or (at your option) any later version.
+ *
+ * UnX is distributed in the hope that it will be useful,
+ *
+ * But WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with UnX.
+ *
+ *   If not, see <http://www.gnu.org/licenses/>.
+ *
+**/
+#include "snapshot.h"
+#include "inifile.h"
+#include "test.h"
+
+#include <filesystem>
+#include <string>
+#include <vector>
+
+using namespace unx;
+using schema::Field;
+
+namespace fs = std::filesystem;
+
+static bool         b1 = false;
+static int          i1 = 0;
+static float        f1 = 0.0f;
+static std::wstring s1;
+static int64_t      l1 = 0;
+static bool         b2 = false;
+static std::wstring s2;
+
+static const schema::field_s fields1 [] = {
+  Field (0, L"A", L"b",          &b1),
+  Field (0, L"A", L"i",          &i1),
+  Field (0, L"A", L"f",          &f1),
+  Field (1, L"B", L"s",          &s1),
+  Field (1, L"B", L"l",          &l1, schema::Flag_Load | schema::Flag_User),
+  Field (0, L"A", L"store_only", &b2, schema::Flag_Store)
+};
+
+static const schema::field_s fields2 [] = {
+  Field (0, L"C", L"s2", &s2)
+};
+
+static const snapshot::table_s tables [] = {
+  { fields1, 6, 0 },
+  { fields2, 1, 0 }
+};
+
+static void
+test_snapshot (void)
+{
+  snapshot::stamp_s stamps [2];
+
+  stamps [0].size  = 10;
+  stamps [0].mtime = 1234;
+
+  const uint64_t layout =
+    snapshot::Layout (tables, 2, L"v1");
+
+  b1 = true; i1 = -42; f1 = 1.5f; s1 = L"h\xe9llo"; l1 = 1LL << 40; s2 = L""; b2 = true;
+
+  const std::vector <uint8_t> data =
+    snapshot::Write (tables, 2, layout, stamps, 2);
+
+  b1 = false; i1 = 0; f1 = 0.0f; s1.clear (); l1 = 0; s2 = L"x"; b2 = false;
+
+  // Store-only fields are not part of it
+  UNX_CHECK (snapshot::Read (data.data (), data.size (), tables, 2, layout, stamps, 2) == snapshot::result_e::Ok);
+  UNX_CHECK (b1 && i1 == -42 && f1 == 1.5f && s1 == L"h\xe9llo" && l1 == (1LL << 40));
+  UNX_CHECK (s2.empty () && ! b2);
+
+  // A different file stamp, salt or skip mask reads as stale
+  i1 = 7;
+
+  snapshot::stamp_s touched [2] = { stamps [0], stamps [1] };
+  touched [1].mtime = 1;
+
+  UNX_CHECK ( snapshot::Read (data.data (), data.size (), tables, 2, layout, touched, 2) ==
+                snapshot::result_e::Stale );
+  UNX_CHECK ( snapshot::Read (data.data (), data.size (), tables, 2, snapshot::Layout (tables, 2, L"v2"),
+                                stamps, 2) == snapshot::result_e::Stale );
+
+  const snapshot::table_s skipped [] = {
+    { fields1, 6, schema::Flag_User },
+    { fields2, 1, 0 }
+  };
+
+  const uint64_t skipped_layout =
+    snapshot::Layout (skipped, 2, L"v1");
+
+  UNX_CHECK (skipped_layout != layout);
+  UNX_CHECK ( snapshot::Read (data.data (), data.size (), skipped, 2, skipped_layout, stamps, 2) ==
+                snapshot::result_e::Stale );
+  UNX_CHECK (i1 == 7);
+
+  // Every truncation and every flipped byte is rejected without assigning
+  for (size_t len = 0; len < data.size (); len++)
+  {
+    UNX_CHECK ( snapshot::Read (data.data (), len, tables, 2, layout, stamps, 2) !=
+                  snapshot::result_e::Ok );
+  }
+
+  for (size_t i = 0; i < data.size (); i++)
+  {
+    std::vector <uint8_t> damaged = data;
+                          damaged [i] ^= 0x5a;
+
+    UNX_CHECK ( snapshot::Read (damaged.data (), damaged.size (), tables, 2, layout, stamps, 2) !=
+                  snapshot::result_e::Ok );
+  }
+
+  UNX_CHECK (i1 == 7 && ! s1.empty ());
+  UNX_CHECK (snapshot::Read (nullptr, 0, tables, 2, layout, stamps, 2) == snapshot::result_e::Corrupt);
+}
+
+static void
+test_stamp (void)
+{
+  fs::remove ("snapshot_test.ini");
+
+  INIFile::write_file (L"snapshot_test.ini", std::vector <uint8_t> (17, 'a'));
+
+  const snapshot::stamp_s stamp   = snapshot::Stamp (L"snapshot_test.ini");
+  const snapshot::stamp_s missing = snapshot::Stamp (L"snapshot_test_missing.ini");
+
+  UNX_CHECK (stamp.size   == 17 && stamp.mtime   != 0);
+  UNX_CHECK (missing.size == 0  && missing.mtime == 0);
+
+  fs::remove ("snapshot_test.ini");
+}
+
+// 60 settings, parsed and loaded from text vs. restored from a snapshot
+static void
+bench (void)
+{
+  constexpr int Iters = 20000;
+
+  static int          ints [40];
+  static std::wstring strs [20];
+  static std::wstring keys [60];
+
+  std::vector <schema::field_s> fields;
+  std::string                   text = "[S]\r\n";
+
+  for (int k = 0; k < 60; k++)
+  {
+    keys [k] = L"Key" + std::to_wstring (k);
+
+    if (k < 40)
+    {
+      fields.push_back (Field (0, L"S", keys [k].c_str (), &ints [k]));
+      text += "Key" + std::to_string (k) + "=" + std::to_string (k * 1234) + "\r\n";
+    }
+
+    else
+    {
+      fields.push_back (Field (0, L"S", keys [k].c_str (), &strs [k - 40]));
+      text += "Key" + std::to_string (k) + "=Some string value " + std::to_string (k) + "\r\n";
+    }
+  }
+
+  const std::vector <uint8_t> bytes (text.begin (), text.end ());
+  const snapshot::table_s     table [] = { { fields.data (), fields.size (), 0 } };
+  const snapshot::stamp_s     stamp;
+
+  const uint64_t              layout = snapshot::Layout (table, 1);
+  const std::vector <uint8_t> data   = snapshot::Write  (table, 1, layout, &stamp, 1);
+
+  double t = UNX_TestSeconds ();
+  for (int i = 0; i < Iters; i++)
+  {
+    INIFile ini;
+    ini.parse (bytes.data (), bytes.size ());
+
+    INIFile* files [] = { &ini };
+    schema::LoadFields (fields.data (), fields.size (), files);
+  }
+  const double from_text = UNX_TestSeconds () - t;
+
+  t = UNX_TestSeconds ();
+  for (int i = 0; i < Iters; i++)
+  {
+    UNX_CHECK ( snapshot::Read (data.data (), data.size (), table, 1, layout, &stamp, 1) ==
+                  snapshot::result_e::Ok );
+  }
+  const double from_snapshot = UNX_TestSeconds () - t;
+
+  std::printf ( "60 settings: text %.2f us, snapshot %.2f us (%zu vs %zu bytes)\n",
+                  from_text * 1e6 / Iters, from_snapshot * 1e6 / Iters,
+                    bytes.size (), data.size () );
+}
+
+int
+main (void)
+{
+  test_snapshot ();
+  test_stamp    ();
+  bench         ();
+
+  return 0;
+}
@@ -0,0 +1,49 @@
+/**
+ * This file is part of UnX.
+ *
+ * UnX is free software : you can redistribute it
+ * and/or modify it under the terms of the GNU General Public License
+ * as published by The Free Software Foundation, either version 3 of
+ * the License, or (at your option) any later version.
+ *
+ * UnX is distributed in the hope that it will be useful,
+ *
+ * But WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with UnX.
+ *
+ *   If not, see <http://www.gnu.org/licenses/>.
+ *
+**/
+#ifndef __UNX__TEST_H__
+#define __UNX__TEST_H__
+
+#include <cstdio>
+#include <cstdlib>
+#include <chrono>
+
+//
+// Just enough to fail a ctest run with a useful message; every test is its
+//   own executable and returns non-zero on the first broken expectation.
+//
+#define UNX_CHECK(expr)                                                     \
+  do {                                                                      \
+    if (! (expr)) {                                                         \
+      std::fprintf (stderr, "%s:%d: check failed: %s\n",                    \
+                      __FILE__, __LINE__, #expr);                           \
+      std::exit (1);                                                        \
+    }                                                                       \
+  } while (0)
+
+static inline double
+UNX_TestSeconds (void)
+{
+  using namespace std::chrono;
+
+  return duration <double> (steady_clock::now ().time_since_epoch ()).count ();
+}
+
+#endif /* __UNX__TEST_H__ */
@@ -0,0 +1,244 @@
+/**
+ * This file is part of UnX.
+ *
+ * UnX is free software : you can redistribute it
+ * and/or modify it under the terms of the GNU General Public License
+ * as published by The Free Software Foundation, either version 3 of
+ * the License, or (at your option) any later version.
+ *
+ * UnX is distributed in the hope that it will be useful,
+ *
+ * But WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with UnX.
+ *
+ *   If not, see <http://www.gnu.org/licenses/>.
+ *
+**/
+#include "trace.h"
+#include "test.h"
+
+#include <cctype>
+#include <cstdlib>
+#include <cstring>
+#include <cwchar>
+#include <string>
+#include <thread>
+#include <vector>
+
+using namespace unx::trace;
+
+// What UNX_LOG / UNX_LOG_EX expand to; log.h itself needs Windows
+#define UNX_TEST_TRACE(_Log, _Flags, _Format, ...)                             \
+  do {                                                                         \
+    static site_s _site (_Format);                                             \
+    (_Log).record (_site, _Flags, ##__VA_ARGS__);                              \
+  } while (0)
+
+enum class test_e : uint8_t { Seven = 7 };
+
+static std::vector <std::string>
+Decode (const char* trace)
+{
+  const std::string cmd =
+    std::string ("\"" UNX_TRACE_DECODE "\" ") + trace + " trace_test.log";
+
+  UNX_CHECK (std::system (cmd.c_str ()) == 0);
+
+  FILE* fp = fopen ("trace_test.log", "rb");
+  UNX_CHECK (fp != nullptr);
+
+  std::vector <std::string> lines;
+  std::string               line;
+  int                       ch;
+
+  while ((ch = fgetc (fp)) != EOF)
+  {
+    if (ch != '\n')
+    {
+      line += (char)ch;
+      continue;
+    }
+
+    // "hh:mm:ss.mmm: " depends on when the test ran
+    if ( line.size () > 14 && line [2] == ':' && line [5] == ':' &&
+         line [8] == '.'   && line [12] == ':' && isdigit ((unsigned char)line [0]) )
+      line.erase (0, 14);
+
+    lines.push_back (line);
+    line.clear ();
+  }
+
+  fclose (fp);
+
+  return lines;
+}
+
+static void
+test_round_trip (void)
+{
+  constexpr int Threads = 4;
+  constexpr int Records = 20000;
+
+  TraceLog log;
+
+  UNX_CHECK (log.open (L"trace_test.trace"));
+
+  const wchar_t* button = L"Cross";
+  const wchar_t* path   = L"gamepads/PlayStation/Cross.dds";
+
+  UNX_TEST_TRACE (log, Flag_Timestamp, L"[Button Map] Button %10s: '%#38s' ( %08x :: ",
+                    button, path, 0xdeadbeefU);
+  UNX_TEST_TRACE (log, 0, L"%08x )", 0x1234U);
+  UNX_TEST_TRACE (log, 0, L"\n");
+
+  // The string is copied when it is recorded, not when it is written
+  long idx     = 4;
+  char dst  [] = "Hello World";
+
+  UNX_TEST_TRACE (log, Flag_Timestamp, L"[ Language ] %s%li: %42hs ==> ", L"_VO_", idx, dst);
+  strcpy (dst, "Changed!!!!");
+  UNX_TEST_TRACE (log, 0, L"%hs\n", dst);
+
+  UNX_TEST_TRACE ( log, Flag_Timestamp | Flag_Newline,
+                     L"ptr %ph, neg %d, ull %llu, dbl %5.2f, enum %u, bool %d, ch %c, u8 %u, %%, %-6s|, %.3s|, %*d|",
+                       (void *)0x1000, -5, 18446744073709551615ULL, 3.14159, test_e::Seven, true,
+                         L'Z', (uint8_t)200, L"ab", L"abcdef", 4, 9 );
+
+  UNX_TEST_TRACE (log, Flag_Newline, L"emoji %s and too few %d %d", L"\U0001F600", 1);
+  UNX_TEST_TRACE (log, Flag_Newline, L"neg hex %08x", -1);
+
+  const std::wstring big (2000, L'x');
+  UNX_TEST_TRACE (log, Flag_Newline, L"big %s tail %d", big.c_str (), 5);
+
+  std::vector <std::thread> threads;
+
+  for (int t = 0; t < Threads; t++)
+  {
+    threads.emplace_back ([&log, t]
+    {
+      for (int i = 0; i < Records; i++)
+        UNX_TEST_TRACE (log, Flag_Newline, L"thread %d seq %d", t, i);
+    });
+  }
+
+  for (auto& thread : threads)
+    thread.join ();
+
+  log.close ();
+
+  const std::vector <std::string> lines =
+    Decode ("trace_test.trace");
+
+  UNX_CHECK (lines.size () >= 6);
+
+  // MSVC printf dialect: %s is wide, %hs narrow, %#38s is just padded
+  UNX_CHECK (lines [0] == "[Button Map] Button      Cross: '        gamepads/PlayStation/Cross.dds' ( deadbeef :: 00001234 )");
+  UNX_CHECK (lines [1] == "[ Language ] _VO_4:                                Hello World ==> Changed!!!!");
+  UNX_CHECK (lines [2] == "ptr 0000000000001000h, neg -5, ull 18446744073709551615, dbl  3.14, enum 7, bool 1, ch Z, u8 200, %, ab    |, abc|,    9|");
+  UNX_CHECK (lines [3] == "emoji \xf0\x9f\x98\x80 and too few 1 <missing>");
+  UNX_CHECK (lines [4] == "neg hex ffffffff");
+
+  // Cut to fit a queue cell; the arguments after it are lost, not garbled
+  UNX_CHECK (lines [5].compare (0, 8, "big xxxx") == 0);
+  UNX_CHECK (lines [5].size () < big.size ());
+  UNX_CHECK (lines [5].compare (lines [5].size () - 15, 15, " tail <missing>") == 0);
+
+  // Per-thread order survives; drops are reported
+  std::vector <int> last (Threads, -1);
+
+  size_t records = 0;
+  bool   report  = false;
+
+  for (size_t i = 6; i < lines.size (); i++)
+  {
+    int t, seq;
+
+    if (sscanf (lines [i].c_str (), "thread %d seq %d", &t, &seq) == 2)
+    {
+      UNX_CHECK (t >= 0 && t < Threads && seq > last [t]);
+
+      last [t] = seq;
+      records++;
+    }
+
+    else
+    {
+      UNX_CHECK (lines [i].find ("record(s) dropped") != std::string::npos);
+      report = true;
+    }
+  }
+
+  const uint64_t dropped = log.stats ().dropped;
+
+  std::printf ( "%zu of %d thread records decoded, %llu dropped\n",
+                  records, Threads * Records, (unsigned long long)dropped );
+
+  UNX_CHECK (records + dropped == (uint64_t)Threads * Records);
+  UNX_CHECK (report == (dropped != 0));
+}
+
+//
+// Cost on the calling thread: recording the [Button Map] line vs. just the
+//   swprintf the text log did for it. Batches stay below the point where a
+//     producer wakes the writer, and each one is written before the next.
+//
+static void
+bench (void)
+{
+  constexpr int Batches = 20;
+  constexpr int Batch   = 500;
+
+  TraceLog log;
+
+  UNX_CHECK (log.open (L"trace_bench.trace"));
+
+  static site_s site (L"[Button Map] Button %10ls: '%38ls' ( %08x :: ");
+
+  double record = 0.0, format = 0.0;
+
+  wchar_t buf [384];
+
+  for (int b = 0; b < Batches; b++)
+  {
+    double t = UNX_TestSeconds ();
+
+    for (int i = 0; i < Batch; i++)
+      log.record (site, Flag_Timestamp, L"Cross", L"gamepads/PlayStation/Cross.dds", (uint32_t)i);
+
+    record += UNX_TestSeconds () - t;
+
+    t = UNX_TestSeconds ();
+
+    for (int i = 0; i < Batch; i++)
+    {
+      swprintf ( buf, 384, L"[Button Map] Button %10ls: '%38ls' ( %08x :: ",
+                   L"Cross", L"gamepads/PlayStation/Cross.dds", (uint32_t)i );
+
+      UNX_CHECK (buf [0] == L'[');
+    }
+
+    format += UNX_TestSeconds () - t;
+
+    while (log.stats ().written < log.stats ().pushed)
+      std::this_thread::sleep_for (std::chrono::milliseconds (1));
+  }
+
+  log.close ();
+
+  std::printf ( "record %.0f ns, swprintf alone %.0f ns (%llu dropped)\n",
+                  record * 1e9 / (Batches * Batch), format * 1e9 / (Batches * Batch),
+                    (unsigned long long)log.stats ().dropped.load () );
+}
+
+int
+main (void)
+{
+  test_round_trip ();
+  bench           ();
+
+  return 0;
+}
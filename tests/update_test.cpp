@@ -0,0 +1,122 @@
+/**
+ * This file is part of UnX.
+ *
+ * UnX is free software : you can redistribute it
+ * and/or modify it under the terms of the GNU General Public License
+ * as published by The Free Software Foundation, either version 3 of
+ * the License, or (at your option) any later version.
+ *
+ * UnX is distributed in the hope that it will be useful,
+ *
+ * But WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with UnX.
+ *
+ *   If not, see <http://www.gnu.org/licenses/>.
+ *
+**/
+#include "update.h"
+#include "test.h"
+
+#include <chrono>
+#include <condition_variable>
+#include <mutex>
+#include <string>
+#include <thread>
+
+using unx::update_status_e;
+
+// Stand-in for SK_FetchVersionInfo: "downloads" the current package name
+//   after a delay and compares it to the installed one.
+static bool
+FetchAfter (const std::string& installed, int delay_ms)
+{
+  std::this_thread::sleep_for (std::chrono::milliseconds (delay_ms));
+
+  return installed != "UnX0_9_5.7z";
+}
+
+struct completion_s {
+  std::mutex              lock;
+  std::condition_variable done;
+  int                     calls  = 0;
+  update_status_e         status = update_status_e::UpToDate;
+
+  void set (update_status_e s)
+  {
+    std::lock_guard <std::mutex> guard (lock);
+
+    calls++;
+    status = s;
+
+    done.notify_all ();
+  }
+
+  update_status_e wait (void)
+  {
+    std::unique_lock <std::mutex> guard (lock);
+
+    done.wait (guard, [&] { return calls > 0; });
+
+    return status;
+  }
+};
+
+static void
+test_schedule (void)
+{
+  UNX_CHECK (! unx::UpdateCheckDue (1000,    0,   -1, true));
+  UNX_CHECK (  unx::UpdateCheckDue (1000,  999,    0, false));
+  UNX_CHECK (  unx::UpdateCheckDue (1000,    0, 3600, false));
+  UNX_CHECK (! unx::UpdateCheckDue (1000,  500, 3600, false));
+  UNX_CHECK (  unx::UpdateCheckDue (1000,  500, 3600, true));
+  UNX_CHECK (  unx::UpdateCheckDue (1000, 5000, 3600, false)); // Clock went back
+  UNX_CHECK (  unx::UpdateCheckDue (5000, 1400, 3600, false));
+}
+
+static void
+test_async (void)
+{
+  {
+    completion_s c;
+
+    unx::CheckForUpdateAsync ( []      { return FetchAfter ("UnX0_9_4.7z", 10); },
+                               [&c] (update_status_e s) { c.set (s); }, 1000 );
+
+    UNX_CHECK (c.wait () == update_status_e::Available);
+  }
+
+  {
+    completion_s c;
+
+    unx::CheckForUpdateAsync ( []      { return FetchAfter ("UnX0_9_5.7z", 10); },
+                               [&c] (update_status_e s) { c.set (s); }, 1000 );
+
+    UNX_CHECK (c.wait () == update_status_e::UpToDate);
+  }
+
+  // A slow fetch reports TimedOut once, and its late result is dropped
+  static completion_s slow;
+
+  unx::CheckForUpdateAsync ( []      { return FetchAfter ("UnX0_9_4.7z", 300); },
+                             [] (update_status_e s) { slow.set (s); }, 50 );
+
+  UNX_CHECK (slow.wait () == update_status_e::TimedOut);
+
+  std::this_thread::sleep_for (std::chrono::milliseconds (400));
+
+  std::lock_guard <std::mutex> guard (slow.lock);
+  UNX_CHECK (slow.calls == 1);
+}
+
+int
+main (void)
+{
+  test_schedule ();
+  test_async    ();
+
+  return 0;
+}
@@ -0,0 +1,554 @@
+/**
+ * This file is part of UnX.
+ *
+ * UnX is free software : you can redistribute it
+ * and/or modify it under the terms of the GNU General Public License
+ * as published by The Free Software Foundation, either version 3 of
+ * the License, or (at your option) any later version.
+ *
+ * UnX is distributed in the hope that it will be useful,
+ *
+ * But WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with UnX.
+ *
+ *   If not, see <http://www.gnu.org/licenses/>.
+ *
+**/
+
+//
+// Renders a binary trace (logs/UnX.trace, see UnX/trace.h) as the text the
+//   same calls would have written to UnX.log.
+//
+//   Does not need Windows or the DLL; build it with any C++17 compiler:
+//
+//     g++ -std=c++17 -O2 -o unx_trace_decode tools/trace_decode.cpp
+//     cl  /std:c++17 /EHsc /O2 tools\trace_decode.cpp
+//
+//   Usage: unx_trace_decode <UnX.trace> [output.log]
+//
+#include "../UnX/trace.h"
+
+#include <cstdio>
+#include <cstring>
+#include <ctime>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+using namespace unx::trace;
+
+namespace
+{
+  struct arg_s {
+    arg_e       tag;
+    uint64_t    bits = 0;   // Integers and pointers
+    double      real = 0.0;
+    std::string text;       // Strings, already UTF-8
+  };
+
+  void append_utf8 (std::string& out, uint32_t cp)
+  {
+    if (cp < 0x80)
+      out += (char)cp;
+    else if (cp < 0x800) {
+      out += (char)(0xC0 |  (cp >> 6));
+      out += (char)(0x80 |  (cp        & 0x3F));
+    }
+    else if (cp < 0x10000) {
+      out += (char)(0xE0 |  (cp >> 12));
+      out += (char)(0x80 | ((cp >> 6)  & 0x3F));
+      out += (char)(0x80 |  (cp        & 0x3F));
+    }
+    else {
+      out += (char)(0xF0 |  (cp >> 18));
+      out += (char)(0x80 | ((cp >> 12) & 0x3F));
+      out += (char)(0x80 | ((cp >> 6)  & 0x3F));
+      out += (char)(0x80 |  (cp        & 0x3F));
+    }
+  }
+
+  // Bounds-checked reader over one record
+  class reader_s
+  {
+  public:
+    reader_s (const uint8_t* data, size_t len) : p_ (data), end_ (data + len) { }
+
+    bool done (void) const { return p_ >= end_; }
+
+    template <typename _T>
+    bool get (_T& out)
+    {
+      if ((size_t)(end_ - p_) < sizeof (_T))
+        return false;
+
+      memcpy (&out, p_, sizeof (_T));
+      p_ += sizeof (_T);
+
+      return true;
+    }
+
+    bool utf16 (std::string& out)
+    {
+      uint16_t units;
+
+      if (! get (units) || (size_t)(end_ - p_) < units * 2u)
+        return false;
+
+      for (uint16_t i = 0; i < units; i++)
+      {
+        uint32_t cp = (uint32_t)p_ [i * 2] | ((uint32_t)p_ [i * 2 + 1] << 8);
+
+        if (cp >= 0xD800 && cp < 0xDC00 && i + 1 < units)
+        {
+          const uint32_t lo =
+            (uint32_t)p_ [i * 2 + 2] | ((uint32_t)p_ [i * 2 + 3] << 8);
+
+          if (lo >= 0xDC00 && lo < 0xE000)
+          {
+            cp = 0x10000 + ((cp - 0xD800) << 10) + (lo - 0xDC00);
+            i++;
+          }
+        }
+
+        append_utf8 (out, cp);
+      }
+
+      p_ += units * 2u;
+
+      return true;
+    }
+
+    // ANSI text; anything outside ASCII is passed through as Latin-1
+    bool bytes (std::string& out)
+    {
+      uint16_t len;
+
+      if (! get (len) || (size_t)(end_ - p_) < len)
+        return false;
+
+      for (uint16_t i = 0; i < len; i++)
+        append_utf8 (out, p_ [i]);
+
+      p_ += len;
+
+      return true;
+    }
+
+    bool arg (arg_s& out)
+    {
+      uint8_t tag;
+
+      if (! get (tag))
+        return false;
+
+      out.tag = (arg_e)tag;
+
+      switch (out.tag)
+      {
+        case Arg_Int32:   { int32_t  v; if (! get (v)) return false; out.bits = (uint64_t)(int64_t)v; } break;
+        case Arg_UInt32:  { uint32_t v; if (! get (v)) return false; out.bits = v;                    } break;
+        case Arg_Int64:
+        case Arg_UInt64:
+        case Arg_Pointer:               if (! get (out.bits)) return false;                           break;
+        case Arg_Double:                if (! get (out.real)) return false;                           break;
+        case Arg_WString:               return utf16 (out.text);
+        case Arg_String:                return bytes (out.text);
+        default:                        return false;
+      }
+
+      return true;
+    }
+
+  private:
+    const uint8_t* p_;
+    const uint8_t* end_;
+  };
+
+  size_t utf8_length (const std::string& s)
+  {
+    size_t n = 0;
+
+    for (unsigned char c : s)
+      n += (c & 0xC0) != 0x80;
+
+    return n;
+  }
+
+  // %s with width / precision counted in characters, like the CRT does
+  void put_string (std::string& out, std::string str, bool left, int width, int precision)
+  {
+    if (precision >= 0 && utf8_length (str) > (size_t)precision)
+    {
+      size_t n = 0, i = 0;
+
+      for (; i < str.size (); i++)
+        if ((str [i] & 0xC0) != 0x80 && n++ == (size_t)precision)
+          break;
+
+      str.resize (i);
+    }
+
+    const size_t len = utf8_length (str);
+    const size_t pad = width > 0 && (size_t)width > len ? width - len : 0;
+
+    if (! left) out.append (pad, ' ');
+    out += str;
+    if (  left) out.append (pad, ' ');
+  }
+
+  void render_arg (std::string& out, const arg_s& arg, char conv,
+                   const std::string& flags, int width, int precision,
+                   uint8_t pointer_size)
+  {
+    const bool left = flags.find ('-') != std::string::npos;
+
+    if (arg.tag == Arg_WString || arg.tag == Arg_String)
+    {
+      put_string (out, arg.text, left, width, precision);
+      return;
+    }
+
+    if (conv == 's' || conv == 'S')
+    {
+      // The call passed a number where the format wanted a string
+      put_string (out, "<" + std::to_string (arg.bits) + ">", left, width, -1);
+      return;
+    }
+
+    if (conv == 'c' || conv == 'C')
+    {
+      std::string ch;
+      append_utf8 (ch, (uint32_t)arg.bits);
+
+      put_string (out, ch, left, width, -1);
+      return;
+    }
+
+    std::string spec = "%" + flags;
+
+    if (width     >= 0) spec += std::to_string (width);
+    if (precision >= 0) spec += "." + std::to_string (precision);
+
+    char buf [512];
+
+    if (conv == 'p')
+    {
+      // The CRT prints pointers as zero-padded upper-case hex
+      snprintf ( buf, sizeof buf, "%0*llX", pointer_size * 2,
+                   (unsigned long long)arg.bits );
+      put_string (out, buf, left, width, -1);
+      return;
+    }
+
+    if (strchr ("fFeEgGaA", conv) != nullptr)
+    {
+      const double v = arg.tag == Arg_Double ? arg.real : (double)(int64_t)arg.bits;
+
+      snprintf (buf, sizeof buf, (spec + conv).c_str (), v);
+      out += buf;
+      return;
+    }
+
+    // Integers; the width of the value decides, not the length modifier
+    uint64_t v = arg.bits;
+
+    if (arg.tag == Arg_Double)
+      v = (uint64_t)(int64_t)arg.real;
+
+    const bool narrow =
+      arg.tag == Arg_Int32 || arg.tag == Arg_UInt32 ||
+      (arg.tag == Arg_Pointer && pointer_size == 4);
+
+    spec += "ll";
+
+    if (conv == 'd' || conv == 'i')
+    {
+      const long long s =
+        narrow ? (long long)(int32_t)v : (long long)v;
+
+      snprintf (buf, sizeof buf, (spec + conv).c_str (), s);
+    }
+
+    else
+    {
+      if (strchr ("uoxX", conv) == nullptr)
+        conv = 'u';
+
+      const unsigned long long u =
+        narrow ? (unsigned long long)(uint32_t)v : (unsigned long long)v;
+
+      snprintf (buf, sizeof buf, (spec + conv).c_str (), u);
+    }
+
+    out += buf;
+  }
+
+  //
+  // printf-style rendering, MSVC flavour: %s / %S / %hs / %ls are all just
+  //   "a string" here since the record says which kind it is.
+  //
+  void render (std::string& out, const std::string& fmt,
+               const std::vector <arg_s>& args, uint8_t pointer_size)
+  {
+    size_t next = 0;
+
+    auto int_arg = [&](void) -> int {
+      return next < args.size () ? (int)(int64_t)args [next++].bits : 0;
+    };
+
+    for (size_t i = 0; i < fmt.size (); i++)
+    {
+      if (fmt [i] != '%')
+      {
+        out += fmt [i];
+        continue;
+      }
+
+      if (++i >= fmt.size ())
+        break;
+
+      if (fmt [i] == '%')
+      {
+        out += '%';
+        continue;
+      }
+
+      std::string flags;
+
+      while (i < fmt.size () && strchr ("-+ #0", fmt [i]) != nullptr)
+      {
+        // '#' means nothing to a string; only keep it for numbers
+        flags += fmt [i++];
+      }
+
+      int width = -1, precision = -1;
+
+      if (i < fmt.size () && fmt [i] == '*')
+      {
+        width = int_arg ();
+        i++;
+
+        if (width < 0) { flags += '-'; width = -width; }
+      }
+      else
+      {
+        while (i < fmt.size () && fmt [i] >= '0' && fmt [i] <= '9')
+          width = (width < 0 ? 0 : width * 10) + (fmt [i++] - '0');
+      }
+
+      if (i < fmt.size () && fmt [i] == '.')
+      {
+        precision = 0;
+
+        if (++i < fmt.size () && fmt [i] == '*')
+        {
+          precision = int_arg ();
+          i++;
+        }
+        else
+        {
+          while (i < fmt.size () && fmt [i] >= '0' && fmt [i] <= '9')
+            precision = precision * 10 + (fmt [i++] - '0');
+        }
+      }
+
+      // Length modifiers, including Microsoft's I, I32, I64 and w
+      while (i < fmt.size () && strchr ("hlLqjztwI", fmt [i]) != nullptr)
+      {
+        if (fmt [i] == 'I' && i + 2 < fmt.size () &&
+            ( (fmt [i + 1] == '3' && fmt [i + 2] == '2') ||
+              (fmt [i + 1] == '6' && fmt [i + 2] == '4') ))
+          i += 2;
+
+        i++;
+      }
+
+      if (i >= fmt.size ())
+        break;
+
+      const char conv = fmt [i];
+
+      if (strchr (flags.c_str (), '#') != nullptr && strchr ("sScC", conv) != nullptr)
+        flags.erase (flags.find ('#'), 1);
+
+      if (next >= args.size ())
+      {
+        out += "<missing>";
+        continue;
+      }
+
+      render_arg (out, args [next++], conv, flags, width, precision, pointer_size);
+    }
+
+    // Arguments the format never used, e.g. because its definition was lost
+    for (; next < args.size (); next++)
+    {
+      out += next == 0 ? " <" : ", ";
+      const arg_e tag  = args [next].tag;
+      const char  conv = tag == Arg_Double  ? 'g' :
+                         tag == Arg_Pointer ? 'p' :
+                         tag == Arg_Int32   ||
+                         tag == Arg_Int64   ? 'd' : 'u';
+
+      render_arg (out, args [next], conv, "", -1, -1, pointer_size);
+      if (next + 1 == args.size ())
+        out += ">";
+    }
+  }
+
+  void timestamp (std::string& out, uint64_t us, int32_t bias)
+  {
+    const int64_t local_ms =
+      (int64_t)(us / 1000) + (int64_t)bias * 60 * 1000;
+
+    const int64_t day_ms =
+      ((local_ms % 86400000) + 86400000) % 86400000;
+
+    char buf [32];
+
+    snprintf ( buf, sizeof buf, "%02u:%02u:%02u.%03u: ",
+                 (unsigned)(day_ms / 3600000),
+                 (unsigned)(day_ms /   60000 % 60),
+                 (unsigned)(day_ms /    1000 % 60),
+                 (unsigned)(day_ms           % 1000) );
+
+    out += buf;
+  }
+}
+
+int
+main (int argc, char** argv)
+{
+  if (argc < 2)
+  {
+    fprintf (stderr, "Usage: %s <UnX.trace> [output.log]\n", argv [0]);
+    return 1;
+  }
+
+  FILE* in = fopen (argv [1], "rb");
+
+  if (in == nullptr)
+  {
+    fprintf (stderr, "Cannot open %s\n", argv [1]);
+    return 1;
+  }
+
+  std::vector <uint8_t> data;
+  uint8_t               chunk [65536];
+  size_t                read;
+
+  while ((read = fread (chunk, 1, sizeof chunk, in)) > 0)
+    data.insert (data.end (), chunk, chunk + read);
+
+  fclose (in);
+
+  header_s header;
+
+  if ( data.size () < sizeof header ||
+       memcmp (data.data (), "UNXT", 4) != 0 )
+  {
+    fprintf (stderr, "%s is not an UnX trace\n", argv [1]);
+    return 1;
+  }
+
+  memcpy (&header, data.data (), sizeof header);
+
+  if (header.version != Version)
+  {
+    fprintf (stderr, "Trace version %u is not supported\n", header.version);
+    return 1;
+  }
+
+  //
+  // Definitions first: a thread that lost the race to define a format can
+  //   record with it before the winner's definition reaches the file.
+  //
+  std::unordered_map <uint32_t, std::string> formats;
+  std::vector <std::pair <size_t, size_t>>   records;
+
+  for (size_t pos = sizeof header; pos + sizeof (record_s) <= data.size (); )
+  {
+    record_s rec;
+    memcpy (&rec, &data [pos], sizeof rec);
+
+    if (rec.size < sizeof rec || pos + rec.size > data.size ())
+    {
+      fprintf (stderr, "Trace is cut off at byte %zu\n", pos);
+      break;
+    }
+
+    if (rec.kind == Record_Format)
+    {
+      reader_s    r (&data [pos + sizeof rec], rec.size - sizeof rec);
+      std::string fmt;
+
+      if (r.utf16 (fmt))
+        formats [rec.format] = fmt;
+    }
+
+    else
+      records.emplace_back (pos, rec.size);
+
+    pos += rec.size;
+  }
+
+  std::string out;
+
+  for (const auto& [pos, size] : records)
+  {
+    record_s rec;
+    memcpy (&rec, &data [pos], sizeof rec);
+
+    reader_s            r (&data [pos + sizeof rec], size - sizeof rec);
+    std::vector <arg_s> args;
+    arg_s               arg;
+
+    while (! r.done () && r.arg (arg))
+    {
+      args.push_back (arg);
+      arg = arg_s ();
+    }
+
+    if (rec.flags & Flag_Timestamp)
+      timestamp (out, rec.time, header.utc_bias);
+
+    if (rec.kind == Record_Dropped)
+    {
+      out += "[  Trace   ] " +
+        std::to_string (args.empty () ? 0 : args [0].bits) +
+          " record(s) dropped, log was full";
+    }
+
+    else
+    {
+      auto fmt = formats.find (rec.format);
+
+      if (fmt != formats.end ())
+        render (out, fmt->second, args, header.pointer_size);
+      else
+        render (out, "<format " + std::to_string (rec.format) + ">", args, header.pointer_size);
+    }
+
+    if (rec.flags & Flag_Newline)
+      out += '\n';
+  }
+
+  FILE* dst = argc > 2 ? fopen (argv [2], "wb") : stdout;
+
+  if (dst == nullptr)
+  {
+    fprintf (stderr, "Cannot create %s\n", argv [2]);
+    return 1;
+  }
+
+  fwrite (out.data (), 1, out.size (), dst);
+
+  if (dst != stdout)
+    fclose (dst);
+
+  return 0;
+}